@@ -6,20 +6,25 @@ static constexpr uint32_t kMurmHash3SeedRoot = 0xFBA4C795;
 static constexpr uint32_t kMurmHash3Tweak = 0x3;
 static constexpr uint32_t kMurmHash3HashNum = 0x5;
 
+// hash functions are stateless, every filter of an algo shares one instance
+static std::shared_ptr<HashAlgo> hashAlgoOf(uint32_t algo)
+{
+    static const std::shared_ptr<HashAlgo> murmurHash3 =
+        std::make_shared<MurmurHash3Algo>(kMurmHash3HashNum, kMurmHash3SeedRoot, kMurmHash3Tweak);
+    static const std::shared_ptr<HashAlgo> none = std::make_shared<HashAlgo>(0);
+    return algo == 0 ? murmurHash3 : none;
+}
+
 BloomFilters::BloomFilters(uint32_t algo, uint32_t length):
-      m_full(false), m_empty(true), m_filters((length + 7)/8, 0)
+      m_full(false), m_empty(true), m_filters((length + 7)/8, 0), m_hashFunc(hashAlgoOf(algo))
 {
-    if (algo == 0) {
-        m_hashFunc = std::make_shared<MurmurHash3Algo>(kMurmHash3HashNum, kMurmHash3SeedRoot, kMurmHash3Tweak);
-    } else {
-        m_hashFunc = std::make_shared<HashAlgo>(0);
-    }
+    updateBitMask();
 }
 
 BloomFilters::BloomFilters(uint32_t algo, const std::string& content):
-      BloomFilters(algo, content.size() * 8)
+      m_full(false), m_empty(true), m_filters(content.begin(), content.end()), m_hashFunc(hashAlgoOf(algo))
 {
-    m_filters.assign(content.begin(), content.end());
+    updateBitMask();
     updateEmptyFull();
 }
 
@@ -39,15 +44,22 @@ void BloomFilters::insert(const std::string& key)
         return;
     }
 
-    auto hashes = m_hashFunc->getHashes(key);
-
-    if (hashes.empty()) {
+    uint32_t hashes[HashAlgo::kMaxHashNum];
+    uint32_t count = m_hashFunc->getHashes(key, hashes);
+    if (count == 0) {
+        if (m_hashFunc->hashNum() <= HashAlgo::kMaxHashNum) {
+            return;
+        }
+        for (const auto& i : m_hashFunc->getHashes(key)) {
+            uint32_t index = bitIndex(i);
+            m_filters[index >> 3] |= (1 << (7 & index));
+        }
+        m_empty = false;
         return;
     }
 
-    uint32_t index = 0;
-    for (const auto& i : hashes) {
-        index = i % (m_filters.size() * 8);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = bitIndex(hashes[i]);
         m_filters[index >> 3] |= (1 << (7 & index));
     }
 
@@ -64,15 +76,25 @@ bool BloomFilters::contains(const std::string& key) const
         return false;
     }
 
-    auto hashes = m_hashFunc->getHashes(key);
-
-    if (hashes.empty()) {
-        return false;
+    // hash indices live on the stack, the vector path only serves algos with more hashes
+    uint32_t hashes[HashAlgo::kMaxHashNum];
+    uint32_t count = m_hashFunc->getHashes(key, hashes);
+    if (count == 0) {
+        if (m_hashFunc->hashNum() <= HashAlgo::kMaxHashNum) {
+            return false;
+        }
+        auto slowHashes = m_hashFunc->getHashes(key);
+        for (const auto& i : slowHashes) {
+            uint32_t index = bitIndex(i);
+            if (!(m_filters[index >> 3] & (1 << (7 & index)))) {
+                return false;
+            }
+        }
+        return !slowHashes.empty();
     }
 
-    uint32_t index = 0;
-    for (const auto& i : hashes) {
-        index = i % (m_filters.size() * 8);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t index = bitIndex(hashes[i]);
         if (!(m_filters[index >> 3] & (1 << (7 & index)))) {
             return false;
         }
@@ -81,6 +103,13 @@ bool BloomFilters::contains(const std::string& key) const
     return true;
 }
 
+void BloomFilters::updateBitMask()
+{
+    m_bitCount = static_cast<uint32_t>(m_filters.size() * 8);
+    bool powerOfTwo = m_bitCount != 0 && (m_bitCount & (m_bitCount - 1)) == 0;
+    m_bitMask = powerOfTwo ? m_bitCount - 1 : 0;
+}
+
 void BloomFilters::updateEmptyFull()
 {
     bool full = true;
@@ -19,13 +19,23 @@ class BloomFilters {
         void update(const std::map<uint32_t,bool>& values);
         std::string getFiltersContent() const;
 
+        size_t size() const { return m_filters.size(); }
+
     private:
         void updateEmptyFull();
+        void updateBitMask();
+        uint32_t bitIndex(uint32_t hash) const
+        {
+            return m_bitMask != 0 ? (hash & m_bitMask) : (hash % m_bitCount);
+        }
 
     private:
         bool m_full = false;
         bool m_empty = true;
         std::vector<uint8_t> m_filters;
+        // m_bitCount - 1 when the bit count is a power of two, otherwise 0
+        uint32_t m_bitCount = 0;
+        uint32_t m_bitMask = 0;
         std::shared_ptr<HashAlgo> m_hashFunc = nullptr;
 };
 
@@ -0,0 +1,107 @@
+#include "contacts_filter_cache.h"
+
+#include "crypto/base64.h"
+#include "crypto/fnv.h"
+
+namespace bcm {
+
+constexpr size_t ContactsFilterCache::kShardCount;
+constexpr size_t ContactsFilterCache::kDefaultCapacityBytes;
+
+ContactsFilterCache::ContactsFilterCache(size_t capacityBytes)
+    : m_shardCapacity(capacityBytes / kShardCount)
+{
+}
+
+ContactsFilterCache::Shard& ContactsFilterCache::shardOf(const std::string& uid)
+{
+    return m_shards[std::hash<std::string>()(uid) % kShardCount];
+}
+
+std::string ContactsFilterCache::fingerprintOf(const std::string& version, const std::string& encodedContent)
+{
+    if (!version.empty()) {
+        return version;
+    }
+    return "#" + std::to_string(encodedContent.size()) + ":"
+        + std::to_string(FNV::hash(encodedContent.data(), encodedContent.size()));
+}
+
+std::shared_ptr<const BloomFilters> ContactsFilterCache::get(const std::string& uid, uint32_t algo,
+                                                             const std::string& version,
+                                                             const std::string& encodedContent)
+{
+    if (m_shardCapacity == 0) {
+        return std::make_shared<const BloomFilters>(algo, Base64::decode(encodedContent));
+    }
+
+    std::string fingerprint = fingerprintOf(version, encodedContent);
+    Shard& shard = shardOf(uid);
+    {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        auto it = shard.entries.find(uid);
+        if (it != shard.entries.end() && it->second->fingerprint == fingerprint && it->second->algo == algo) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->filters;
+        }
+    }
+
+    // decode outside the lock, concurrent misses of one uid may both decode
+    auto filters = std::make_shared<const BloomFilters>(algo, Base64::decode(encodedContent));
+    if (filters->size() > m_shardCapacity) {
+        return filters;
+    }
+
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.entries.find(uid);
+    if (it != shard.entries.end()) {
+        shard.bytes -= it->second->filters->size();
+        shard.lru.erase(it->second);
+        shard.entries.erase(it);
+    }
+    while (!shard.lru.empty() && shard.bytes + filters->size() > m_shardCapacity) {
+        const Entry& victim = shard.lru.back();
+        shard.bytes -= victim.filters->size();
+        shard.entries.erase(victim.uid);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(Entry{uid, fingerprint, algo, filters});
+    shard.entries.emplace(uid, shard.lru.begin());
+    shard.bytes += filters->size();
+    return filters;
+}
+
+void ContactsFilterCache::invalidate(const std::string& uid)
+{
+    Shard& shard = shardOf(uid);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.entries.find(uid);
+    if (it == shard.entries.end()) {
+        return;
+    }
+    shard.bytes -= it->second->filters->size();
+    shard.lru.erase(it->second);
+    shard.entries.erase(it);
+}
+
+size_t ContactsFilterCache::size() const
+{
+    size_t total = 0;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+size_t ContactsFilterCache::memoryUsage() const
+{
+    size_t total = 0;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        total += shard.bytes;
+    }
+    return total;
+}
+
+} // namespace bcm
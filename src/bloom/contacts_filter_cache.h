@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "bloom_filters.h"
+
+namespace bcm {
+
+// Decoded contacts filters keyed by uid. An entry is reused as long as the account
+// still carries the same filter version, so a filter is decoded once per update
+// instead of once per check. Shards are LRU lists bounded by the decoded size.
+class ContactsFilterCache {
+public:
+    // capacityBytes 0 disables the cache
+    explicit ContactsFilterCache(size_t capacityBytes);
+
+    static ContactsFilterCache& Instance()
+    {
+        static ContactsFilterCache g_instance(kDefaultCapacityBytes);
+        return g_instance;
+    }
+
+    // returns the filter decoded from encodedContent. version may be empty for filters
+    // stored before versions existed, a hash of the content stands in for it then
+    std::shared_ptr<const BloomFilters> get(const std::string& uid, uint32_t algo,
+                                            const std::string& version,
+                                            const std::string& encodedContent);
+    void invalidate(const std::string& uid);
+
+    size_t size() const;
+    size_t memoryUsage() const;
+
+private:
+    struct Entry {
+        std::string uid;
+        std::string fingerprint;
+        uint32_t algo;
+        std::shared_ptr<const BloomFilters> filters;
+    };
+
+    struct Shard {
+        mutable std::mutex mtx;
+        // most recently used first
+        std::list<Entry> lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+        size_t bytes = 0;
+    };
+
+    static constexpr size_t kShardCount = 16;
+    static constexpr size_t kDefaultCapacityBytes = 64 * 1024 * 1024;
+
+    Shard& shardOf(const std::string& uid);
+    static std::string fingerprintOf(const std::string& version, const std::string& encodedContent);
+
+private:
+    std::array<Shard, kShardCount> m_shards;
+    size_t m_shardCapacity;
+};
+
+} // namespace bcm
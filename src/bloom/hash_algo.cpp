@@ -3,6 +3,8 @@
 
 namespace bcm {
 
+constexpr uint32_t HashAlgo::kMaxHashNum;
+
 MurmurHash3Algo::MurmurHash3Algo(uint32_t hashNum, uint32_t rootSeed, uint32_t tweak)
     : HashAlgo(hashNum), m_tweak(tweak), m_rootSeed(rootSeed)
 {
@@ -17,4 +19,15 @@ std::vector<uint32_t> MurmurHash3Algo::getHashes(const std::string& key)
     return hashes;
 }
 
+uint32_t MurmurHash3Algo::getHashes(const std::string& key, uint32_t* hashes) const
+{
+    if (m_hashNum > kMaxHashNum) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < m_hashNum; ++i) {
+        hashes[i] = MurmurHash3::murmurHash3(i * m_rootSeed + m_tweak, key);
+    }
+    return m_hashNum;
+}
+
 } // namespace bcm
@@ -11,6 +11,9 @@ enum HashAlgoNum {
 
 class HashAlgo {
 public:
+    // upper bound of hashNum served by the fixed size getHashes
+    static constexpr uint32_t kMaxHashNum = 16;
+
     HashAlgo(uint32_t hashNum) : m_hashNum(hashNum)
     {
     }
@@ -24,6 +27,18 @@ public:
         return std::vector<uint32_t>();
     }
 
+    // writes the hashes of key to hashes[0, hashNum()), hashes holds kMaxHashNum
+    // entries. returns the number of hashes written
+    virtual uint32_t getHashes(const std::string&, uint32_t*) const
+    {
+        return 0;
+    }
+
+    uint32_t hashNum() const
+    {
+        return m_hashNum;
+    }
+
 protected:
     uint32_t m_hashNum;
 };
@@ -37,6 +52,7 @@ public:
     }
 
     virtual std::vector<uint32_t> getHashes(const std::string& key) override;
+    virtual uint32_t getHashes(const std::string& key, uint32_t* hashes) const override;
 
 private:
     uint32_t m_tweak = 0;
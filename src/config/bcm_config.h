@@ -20,6 +20,7 @@
 #include "group_config.h"
 #include "cache_config.h"
 #include "multi_device_config.h"
+#include "presence_config.h"
 
 namespace bcm {
 
@@ -31,6 +32,7 @@ struct BcmConfig {
     std::vector<RedisConfig> redis;    // redis for pub/sub
     std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig> > groupRedis; // redis for group info
     std::map<std::string, std::vector<RedisConfig>> onlineRedis;
+    RedisPoolConfig redisPool;  // pool of each redis in redis and groupRedis
     LbsConfig lbs;
     ChallengeConfig challenge;
     DispatcherConfig dispatcher;
@@ -43,6 +45,7 @@ struct BcmConfig {
     GroupConfig groupConfig;
     CacheConfig cacheConfig;
     MultiDeviceConfig multiDeviceConfig;
+    PresenceConfig presence;
 };
 
 inline void to_json(nlohmann::json& j, const BcmConfig& config)
@@ -54,6 +57,7 @@ inline void to_json(nlohmann::json& j, const BcmConfig& config)
                        {"redis", config.redis},
                        {"groupRedis", config.groupRedis},
                        {"onlineRedis", config.onlineRedis},
+                       {"redisPool", config.redisPool},
                        {"lbs", config.lbs},
                        {"challenge", config.challenge},
                        {"dispatcher", config.dispatcher},
@@ -65,7 +69,8 @@ inline void to_json(nlohmann::json& j, const BcmConfig& config)
                        {"s3Config", config.s3Config},
                        {"groupConfig", config.groupConfig},
                        {"multiDevice", config.multiDeviceConfig},
-                       {"cache", config.cacheConfig}};
+                       {"cache", config.cacheConfig},
+                       {"presence", config.presence}};
 
 }
 
@@ -78,6 +83,7 @@ inline void from_json(const nlohmann::json& j, BcmConfig& config)
     jsonable::toGeneric(j, "redis", config.redis);
     jsonable::toGeneric(j, "groupRedis", config.groupRedis);
     jsonable::toGeneric(j, "onlineRedis", config.onlineRedis);
+    jsonable::toGeneric(j, "redisPool", config.redisPool, jsonable::OPTIONAL);
     jsonable::toGeneric(j, "lbs", config.lbs);
     jsonable::toGeneric(j, "metrics", config.bcmMetricsConfig);
     jsonable::toGeneric(j, "challenge", config.challenge, jsonable::OPTIONAL);
@@ -90,6 +96,7 @@ inline void from_json(const nlohmann::json& j, BcmConfig& config)
     jsonable::toGeneric(j, "groupConfig", config.groupConfig);
     jsonable::toGeneric(j, "cache", config.cacheConfig, jsonable::OPTIONAL);
     jsonable::toGeneric(j, "multiDevice", config.multiDeviceConfig, jsonable::OPTIONAL);
+    jsonable::toGeneric(j, "presence", config.presence, jsonable::OPTIONAL);
 }
 
 }
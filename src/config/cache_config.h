@@ -6,17 +6,35 @@ namespace bcm {
 
 struct CacheConfig {
     uint64_t groupKeysLimit = 2 << 31;
+    // shards of the group keys cache, each one is locked on its own
+    uint64_t groupKeysShards = 16;
+    // bytes of group info and member roles cached by each node
+    uint64_t groupMetaLimit = 64 * 1024 * 1024;
+    // seconds a cached group info or member role is trusted without an event
+    int64_t groupMetaTtl = 30;
 };
 
 inline void to_json(nlohmann::json& j, const CacheConfig& config)
 {
     j = nlohmann::json{{
                                "groupKeysLimit",                   config.groupKeysLimit
+                       },
+                       {
+                               "groupKeysShards",                  config.groupKeysShards
+                       },
+                       {
+                               "groupMetaLimit",                   config.groupMetaLimit
+                       },
+                       {
+                               "groupMetaTtl",                     config.groupMetaTtl
                        }};
 }
 
 inline void from_json(const nlohmann::json& j, CacheConfig& config)
 {
     jsonable::toNumber(j, "groupKeysLimit", config.groupKeysLimit);
+    jsonable::toNumber(j, "groupKeysShards", config.groupKeysShards, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "groupMetaLimit", config.groupMetaLimit, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "groupMetaTtl", config.groupMetaTtl, jsonable::OPTIONAL);
 }
 }
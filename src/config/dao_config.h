@@ -1,9 +1,40 @@
 #pragma once
 
+#include <map>
 #include <utils/jsonable.h>
 
 namespace bcm {
 
+// overrides the channel settings for one dao rpc, keyed by "Service.method",
+// e.g. "AccountService.getAccount"
+struct DaoMethodConfig {
+    // in milliseconds, 0 for DaoConfig::timeout
+    int timeout{0};
+    // -1 for remote.retries
+    int retries{-1};
+    // sends a backup request once a call has run longer than this percentile of the
+    // recent latencies of the method, 0 never does. Only for idempotent reads
+    int hedgePercentile{0};
+    // lower bound of the backup request delay in milliseconds
+    int hedgeMinMs{1};
+};
+
+inline void to_json(nlohmann::json& j, const DaoMethodConfig& config)
+{
+    j = nlohmann::json{{"timeout", config.timeout},
+                       {"retries", config.retries},
+                       {"hedgePercentile", config.hedgePercentile},
+                       {"hedgeMinMs", config.hedgeMinMs}};
+}
+
+inline void from_json(const nlohmann::json& j, DaoMethodConfig& config)
+{
+    jsonable::toNumber(j, "timeout", config.timeout, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "retries", config.retries, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "hedgePercentile", config.hedgePercentile, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "hedgeMinMs", config.hedgeMinMs, jsonable::OPTIONAL);
+}
+
 struct DaoConfig {
     struct {
         std::string host;
@@ -29,8 +60,21 @@ struct DaoConfig {
         std::string balancer;
         std::string keyPath;
         std::string certPath;
+        std::map<std::string, DaoMethodConfig> methods;
+        // reports latency and hedging of every rpc through MetricsClient
+        bool metrics{false};
     } remote;
 
+    // embedded leveldb used when clientImpl is "local"
+    struct {
+        std::string path{"./dao_local"};
+        int cacheSizeMB{64};
+        int writeBufferMB{16};
+        // fsync every write, otherwise a crash may lose the last writes but never
+        // corrupts the database
+        bool sync{false};
+    } local;
+
     int timeout{3000};
     std::string clientImpl;
 };
@@ -56,7 +100,14 @@ inline void to_json(nlohmann::json& j, const DaoConfig& config)
                            {"retries", config.remote.retries},
                            {"balancer", config.remote.balancer},
                            {"keyPath", config.remote.keyPath},
-                           {"certPath", config.remote.certPath}}}, 
+                           {"certPath", config.remote.certPath},
+                           {"methods", config.remote.methods},
+                           {"metrics", config.remote.metrics}}},
+                       {"local", {
+                           {"path", config.local.path},
+                           {"cacheSizeMB", config.local.cacheSizeMB},
+                           {"writeBufferMB", config.local.writeBufferMB},
+                           {"sync", config.local.sync}}},
                        {"timeout", config.timeout},
                        {"clientImpl", config.clientImpl}};
 }
@@ -88,6 +139,15 @@ inline void from_json(const nlohmann::json& j, DaoConfig& config)
     jsonable::toString(remote, "balancer", config.remote.balancer);
     jsonable::toString(remote, "keyPath", config.remote.keyPath);
     jsonable::toString(remote, "certPath", config.remote.certPath);
+    jsonable::toGeneric(remote, "methods", config.remote.methods, jsonable::OPTIONAL);
+    jsonable::toBoolean(remote, "metrics", config.remote.metrics, jsonable::OPTIONAL);
+
+    nlohmann::json local;
+    jsonable::toGeneric(j, "local", local, jsonable::OPTIONAL);
+    jsonable::toString(local, "path", config.local.path, jsonable::OPTIONAL);
+    jsonable::toNumber(local, "cacheSizeMB", config.local.cacheSizeMB, jsonable::OPTIONAL);
+    jsonable::toNumber(local, "writeBufferMB", config.local.writeBufferMB, jsonable::OPTIONAL);
+    jsonable::toBoolean(local, "sync", config.local.sync, jsonable::OPTIONAL);
 
     jsonable::toNumber(j, "timeout", config.timeout);
     jsonable::toString(j, "clientImpl", config.clientImpl);
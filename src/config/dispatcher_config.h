@@ -6,16 +6,36 @@ namespace bcm {
 
 struct DispatcherConfig {
     int concurrency{8};
+    // lets idle worker threads take over message dispatching queued behind a busy one
+    bool workStealing{false};
+    // bytes of the pooled stacks of the dispatch fibers, 0 for the boost default
+    int fiberStackSize{0};
+    // connects doing their redis side effects at the same time, the others wait; 0 is unbounded
+    int maxConcurrentSubscribes{64};
+    // badge deletions and online notifications of connects are sent in pipelined batches,
+    // a batch not full waits this long for more
+    int connectBatchSize{500};
+    int connectBatchDelayInMilli{5};
 };
 
 inline void to_json(nlohmann::json& j, const DispatcherConfig& config)
 {
-    j = nlohmann::json{{"concurrency", config.concurrency}};
+    j = nlohmann::json{{"concurrency", config.concurrency},
+                       {"workStealing", config.workStealing},
+                       {"fiberStackSize", config.fiberStackSize},
+                       {"maxConcurrentSubscribes", config.maxConcurrentSubscribes},
+                       {"connectBatchSize", config.connectBatchSize},
+                       {"connectBatchDelayInMilli", config.connectBatchDelayInMilli}};
 }
 
 inline void from_json(const nlohmann::json& j, DispatcherConfig& config)
 {
     jsonable::toNumber(j, "concurrency", config.concurrency, jsonable::OPTIONAL);
+    jsonable::toBoolean(j, "workStealing", config.workStealing, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "fiberStackSize", config.fiberStackSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "maxConcurrentSubscribes", config.maxConcurrentSubscribes, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "connectBatchSize", config.connectBatchSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "connectBatchDelayInMilli", config.connectBatchDelayInMilli, jsonable::OPTIONAL);
 }
 
 }
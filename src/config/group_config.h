@@ -119,6 +119,20 @@ struct GroupConfig {
     GroupConfigExceptionInject groupConfigExceptionInject;
 #endif
     uint32_t keySwitchCandidateCount = 5;
+    // publish offline push notifications to the redis stream consumed by the offline server,
+    // enable only once every offline server of the partition consumes the stream
+    bool offlineMsgStream = false;
+    uint32_t offlineMsgStreamMaxLen = 1000000;
+    // offline notification keys per redis partition, the offline servers must read
+    // at least as many shards (offlineSvr.groupMsgShards)
+    uint32_t offlineMsgShards = 1;
+    // last_ack_mid of group members is written in bulk at this interval
+    int64_t ackFlushInterval = 1000;
+    // members written by one batch update
+    uint32_t ackFlushBatchSize = 200;
+    // 0 publishes group messages on a channel per group, otherwise on this many
+    // hashed bucket channels all nodes subscribe to. same value on every node
+    uint32_t channelBuckets = 0;
 };
 
 inline void to_json(nlohmann::json& j, const GroupConfig& e)
@@ -127,6 +141,12 @@ inline void to_json(nlohmann::json& j, const GroupConfig& e)
                        {"powerGroupMax", e.powerGroupMax},
                        {"normalGroupRefreshKeysMax", e.normalGroupRefreshKeysMax},
                        {"keySwitchCandidateCount", e.keySwitchCandidateCount},
+                       {"offlineMsgStream", e.offlineMsgStream},
+                       {"offlineMsgStreamMaxLen", e.offlineMsgStreamMaxLen},
+                       {"offlineMsgShards", e.offlineMsgShards},
+                       {"ackFlushInterval", e.ackFlushInterval},
+                       {"ackFlushBatchSize", e.ackFlushBatchSize},
+                       {"channelBuckets", e.channelBuckets},
 #ifdef GROUP_EXCEPTION_INJECT_TEST
                        {"groupConfigExceptionInject", e.groupConfigExceptionInject}
 #endif
@@ -139,6 +159,12 @@ inline void from_json(const nlohmann::json& j, GroupConfig& e)
     jsonable::toNumber(j, "powerGroupMax", e.powerGroupMax);
     jsonable::toNumber(j, "normalGroupRefreshKeysMax", e.normalGroupRefreshKeysMax);
     jsonable::toNumber(j, "keySwitchCandidateCount", e.keySwitchCandidateCount);
+    jsonable::toBoolean(j, "offlineMsgStream", e.offlineMsgStream, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "offlineMsgStreamMaxLen", e.offlineMsgStreamMaxLen, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "offlineMsgShards", e.offlineMsgShards, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "ackFlushInterval", e.ackFlushInterval, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "ackFlushBatchSize", e.ackFlushBatchSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "channelBuckets", e.channelBuckets, jsonable::OPTIONAL);
 #ifdef GROUP_EXCEPTION_INJECT_TEST
     jsonable::toGeneric(j, "groupConfigExceptionInject", e.groupConfigExceptionInject);
 #endif
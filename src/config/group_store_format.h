@@ -1,5 +1,6 @@
 #pragma once
 
+#include <set>
 #include <utils/jsonable.h>
 #include "offline_server_config.h"
 
@@ -11,6 +12,24 @@ namespace bcm {
     const std::string REDISDB_KEY_GROUP_REDIS_ACTIVE = "group_msg_active";
     const std::string REDISDB_KEY_APNS_UID_BADGE_PREFIX = "apns_badge_";
 
+    // redisdb stream of new group messages, consumed by the offline server
+    const std::string REDISDB_KEY_GROUP_MSG_STREAM = "group_msg_stream";
+    const std::string REDISDB_GROUP_MSG_STREAM_GROUP = "offline_push";
+    const std::string REDISDB_GROUP_MSG_STREAM_FIELD_MSG = "msg";
+    const std::string REDISDB_GROUP_MSG_STREAM_FIELD_MULTI = "multi";
+
+    // group_msg_list, group_multi_msg_list and group_msg_stream are split by gid in shards
+    // per partition; shard 0 keeps the plain key, one shard is the unsharded layout
+    inline uint32_t groupMsgShard(uint64_t gid, uint32_t shards)
+    {
+        return shards > 1 ? static_cast<uint32_t>(gid % shards) : 0;
+    }
+
+    inline std::string groupMsgShardKey(const std::string& key, uint32_t shard)
+    {
+        return shard == 0 ? key : key + "_" + std::to_string(shard);
+    }
+
     enum PushPeopleType {
         PUSHPEOPLETYPE_UNKNOWN = 0,
         PUSHPEOPLETYPE_TO_ALL = 1,
@@ -22,6 +41,42 @@ namespace bcm {
         NO_CONFIG = 1
     };
     
+    // "gid_mid_type" as "%020lu_%020lu_%02d", used as zset member, hash field and stream value
+    static constexpr size_t kGroupMsgFieldSize = 44;
+
+    inline std::string formatGroupMsgField(uint64_t gid, uint64_t mid, int32_t type)
+    {
+        char field[50];
+        snprintf(field, sizeof(field), "%020lu_%020lu_%02d", gid, mid, type);
+        return std::string(field);
+    }
+
+    inline bool parseGroupMsgField(const std::string& field, uint64_t& gid, uint64_t& mid, int32_t& type)
+    {
+        if (field.size() != kGroupMsgFieldSize || field[20] != '_' || field[41] != '_') {
+            return false;
+        }
+
+        auto parseDigits = [&field](size_t begin, size_t end, uint64_t& value) {
+            value = 0;
+            for (size_t i = begin; i < end; ++i) {
+                char c = field[i];
+                if (c < '0' || c > '9') {
+                    return false;
+                }
+                value = value * 10 + static_cast<uint64_t>(c - '0');
+            }
+            return true;
+        };
+
+        uint64_t pushType = 0;
+        if (!parseDigits(0, 20, gid) || !parseDigits(21, 41, mid) || !parseDigits(42, 44, pushType)) {
+            return false;
+        }
+        type = static_cast<int32_t>(pushType);
+        return true;
+    }
+
     struct GroupUserMessageIdInfo {
         uint64_t last_mid{0};
         // google cloud messaging
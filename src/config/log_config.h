@@ -10,6 +10,10 @@ struct LogConfig {
     std::string directory;
     bool console{false};
     bool autoflush{false};
+    // records buffered per producing thread before the overflow policy applies
+    int asyncBufferSize{8192};
+    // "block" waits for the background writer, "drop" discards the record
+    std::string overflowPolicy{"block"};
 };
 
 inline void to_json(nlohmann::json& j, const LogConfig& config)
@@ -17,7 +21,9 @@ inline void to_json(nlohmann::json& j, const LogConfig& config)
     j = nlohmann::json{{"level", config.level},
                        {"directory", config.directory},
                        {"console", config.console},
-                       {"autoflush", config.autoflush}};
+                       {"autoflush", config.autoflush},
+                       {"asyncBufferSize", config.asyncBufferSize},
+                       {"overflowPolicy", config.overflowPolicy}};
 }
 
 inline void from_json(const nlohmann::json& j, LogConfig& config)
@@ -26,6 +32,8 @@ inline void from_json(const nlohmann::json& j, LogConfig& config)
     jsonable::toString(j, "directory", config.directory);
     jsonable::toBoolean(j, "console", config.console);
     jsonable::toBoolean(j, "autoflush", config.autoflush);
+    jsonable::toNumber(j, "asyncBufferSize", config.asyncBufferSize, jsonable::OPTIONAL);
+    jsonable::toString(j, "overflowPolicy", config.overflowPolicy, jsonable::OPTIONAL);
 }
 
 
@@ -22,6 +22,20 @@ struct OfflineServerConfig {
     std::string redisPartition;
     bool    isPush;
     std::vector<std::string> pushType;
+    // consume new group messages from the redis stream, the zset is still polled for recovery
+    bool    groupMsgStream{false};
+    // grace period for online members to ack before a message is pushed offline
+    int32_t groupMsgStreamDelayMillis{5000};
+    int32_t groupMsgStreamBatchSize{300};
+    // shards of the group message keys per redis partition, at least groupConfig.offlineMsgShards
+    // of the im servers; they are read in parallel
+    int32_t groupMsgShards{1};
+    // accounts per dao call and dao calls in flight when fetching push info
+    int32_t accountBatchSize{20};
+    int32_t accountFetchConcurrency{8};
+    // uids kept in the push info cache, 0 disables it
+    int32_t pushInfoCacheSize{200000};
+    int32_t pushInfoCacheTtlSec{600};
 
     bool checkPushType(const std::string& checkingType)
     {
@@ -41,7 +55,15 @@ inline void to_json(nlohmann::json& j, const OfflineServerConfig& c)
                        {"eventThreadNumb", c.eventThreadNumb},
                        {"redisPartition", c.redisPartition},
                        {"isPush", c.isPush},
-                       {"pushType", c.pushType}};
+                       {"pushType", c.pushType},
+                       {"groupMsgStream", c.groupMsgStream},
+                       {"groupMsgStreamDelayMillis", c.groupMsgStreamDelayMillis},
+                       {"groupMsgStreamBatchSize", c.groupMsgStreamBatchSize},
+                       {"groupMsgShards", c.groupMsgShards},
+                       {"accountBatchSize", c.accountBatchSize},
+                       {"accountFetchConcurrency", c.accountFetchConcurrency},
+                       {"pushInfoCacheSize", c.pushInfoCacheSize},
+                       {"pushInfoCacheTtlSec", c.pushInfoCacheTtlSec}};
 }
 
 inline void from_json(const nlohmann::json& j, OfflineServerConfig& c)
@@ -52,6 +74,14 @@ inline void from_json(const nlohmann::json& j, OfflineServerConfig& c)
     jsonable::toString(j, "redisPartition", c.redisPartition);
     jsonable::toBoolean(j, "isPush", c.isPush);
     jsonable::toGeneric(j, "pushType", c.pushType);
+    jsonable::toBoolean(j, "groupMsgStream", c.groupMsgStream, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "groupMsgStreamDelayMillis", c.groupMsgStreamDelayMillis, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "groupMsgStreamBatchSize", c.groupMsgStreamBatchSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "groupMsgShards", c.groupMsgShards, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "accountBatchSize", c.accountBatchSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "accountFetchConcurrency", c.accountFetchConcurrency, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "pushInfoCacheSize", c.pushInfoCacheSize, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "pushInfoCacheTtlSec", c.pushInfoCacheTtlSec, jsonable::OPTIONAL);
 }
 
 } // namespace bcm
\ No newline at end of file
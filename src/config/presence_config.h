@@ -0,0 +1,40 @@
+#pragma once
+
+#include <utils/jsonable.h>
+
+namespace bcm {
+
+struct PresenceConfig {
+    bool enabled{false};
+    // channel on the online redis the im servers exchange their devices on
+    std::string channel{"presence"};
+    int64_t flushIntervalInMilli{200};
+    // every node resends all its devices at this interval, lost deltas are repaired by it
+    int64_t snapshotIntervalInMilli{30000};
+    // devices of a node not heard from for this long are dropped
+    int64_t nodeTimeoutInMilli{90000};
+    // devices per published message
+    int32_t maxBatch{4096};
+};
+
+inline void to_json(nlohmann::json& j, const PresenceConfig& config)
+{
+    j = nlohmann::json{{"enabled", config.enabled},
+                       {"channel", config.channel},
+                       {"flushIntervalInMilli", config.flushIntervalInMilli},
+                       {"snapshotIntervalInMilli", config.snapshotIntervalInMilli},
+                       {"nodeTimeoutInMilli", config.nodeTimeoutInMilli},
+                       {"maxBatch", config.maxBatch}};
+}
+
+inline void from_json(const nlohmann::json& j, PresenceConfig& config)
+{
+    jsonable::toBoolean(j, "enabled", config.enabled, jsonable::OPTIONAL);
+    jsonable::toString(j, "channel", config.channel, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "flushIntervalInMilli", config.flushIntervalInMilli, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "snapshotIntervalInMilli", config.snapshotIntervalInMilli, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "nodeTimeoutInMilli", config.nodeTimeoutInMilli, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "maxBatch", config.maxBatch, jsonable::OPTIONAL);
+}
+
+}
@@ -31,4 +31,34 @@ inline void from_json(const nlohmann::json& j, RedisConfig& config)
 	jsonable::toString(j, "regkey", config.regkey);
 }
 
-}
\ No newline at end of file
+// connection pool of each synchronous redis server
+struct RedisPoolConfig {
+    // open connections per server, 0 is unbounded
+    int32_t maxConns{64};
+    // borrowers waiting longer for a connection fail, 0 fails at once
+    int64_t maxWaitInMilli{1000};
+    // idle connections are closed after this long
+    int64_t maxIdleInMilli{60000};
+    // idle connections are pinged before being lent out after this long, 0 pings on every borrow
+    int64_t validateAfterInMilli{5000};
+};
+
+inline void to_json(nlohmann::json& j, const RedisPoolConfig& config)
+{
+    j = nlohmann::json{
+        {"maxConns", config.maxConns},
+        {"maxWaitInMilli", config.maxWaitInMilli},
+        {"maxIdleInMilli", config.maxIdleInMilli},
+        {"validateAfterInMilli", config.validateAfterInMilli},
+    };
+}
+
+inline void from_json(const nlohmann::json& j, RedisPoolConfig& config)
+{
+    jsonable::toNumber(j, "maxConns", config.maxConns, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "maxWaitInMilli", config.maxWaitInMilli, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "maxIdleInMilli", config.maxIdleInMilli, jsonable::OPTIONAL);
+    jsonable::toNumber(j, "validateAfterInMilli", config.validateAfterInMilli, jsonable::OPTIONAL);
+}
+
+}
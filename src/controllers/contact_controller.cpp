@@ -9,7 +9,7 @@
 #include <algorithm>
 #include "crypto/base64.h"
 #include "crypto/sha1.h"
-#include "bloom/bloom_filters.h"
+#include "bloom/contacts_filter_cache.h"
 #include "utils/sender_utils.h"
 #include "proto/contacts/friend.pb.h"
 #include "dispatcher/dispatch_address.h"
@@ -275,8 +275,10 @@ void ContactController::patchContactsFilters(HttpContext& context)
         return res.result(http::status::conflict);
     }
 
-    auto realContent = Base64::decode(filtersContent->content());
-    BloomFilters filters(filtersContent->algo(), realContent);
+    // patch a copy, the cached filter stays valid for the current version
+    BloomFilters filters(*ContactsFilterCache::Instance().get(account->uid(), filtersContent->algo(),
+                                                              filtersContent->version(),
+                                                              filtersContent->content()));
 
     std::map<uint32_t, bool> mValues;
 
@@ -9,6 +9,7 @@
 #include "dao/client.h"
 #include "crypto/sha1.h"
 #include "group/group_event.h"
+#include "group/group_meta_cache.h"
 #include "proto/dao/account.pb.h"
 #include "proto/dao/error_code.pb.h"
 #include "proto/group/message.pb.h"
@@ -21,12 +22,16 @@
 #include "store/accounts_manager.h"
 #include "crypto/base64.h"
 #include "http/custom_http_status.h"
-#include "bloom/bloom_filters.h"
+#include "bloom/contacts_filter_cache.h"
 #include "limiters/limiter_manager.h"
 #include "limiters/distributed_limiter.h"
 #include "limiters/dependency_limiter.h"
 #include "crypto/hex_encoder.h"
 
+#include <boost/fiber/all.hpp>
+#include <algorithm>
+#include <iterator>
+
 namespace bcm {
 namespace http = boost::beast::http;
 
@@ -42,6 +47,9 @@ static const std::string kDhKeysConfigKey = "special/dh_keys";
 static const std::string kGroupMemberJoinLimiterName = "GroupMemberJoinLimiter";
 static const std::string kGroupMemberJoinLimiterConfigKey = "special/group_member_join";
 constexpr int64_t kKeysCacheTtl = 600;
+// member accounts are loaded kAccountBatchSize per dao call, at most kAccountFetchConcurrency calls in flight
+constexpr size_t kAccountBatchSize = 50;
+constexpr int kAccountFetchConcurrency = 4;
 
 
 GroupManagerController::GroupManagerController(std::shared_ptr<bcm::GroupMsgService> groupMsgService,
@@ -61,6 +69,7 @@ GroupManagerController::GroupManagerController(std::shared_ptr<bcm::GroupMsgServ
     , m_multiDeviceConfig(multiDeviceCfg)
     , m_groupConfig(groupConfig)
     , m_keysCache(kKeysCacheTtl)
+    , m_accountFetchPool(kAccountFetchConcurrency)
 {
     // m_groupCreationLimiter
     auto ptr = LimiterManager::getInstance()->find(kGroupCreationLimiterName);
@@ -1219,6 +1228,8 @@ bool GroupManagerController::pubGroupSystemMessage(const std::string& uid, const
 
 bool GroupManagerController::publishGroupUserEvent(const uint64_t& gid, const std::string& uid, const InternalMessageType& type)
 {
+    GroupMetaCache::Instance()->onUserEvent(static_cast<int>(type), gid, uid);
+
     GroupEvent groupSystemEvent;
     groupSystemEvent.gid = gid;
     groupSystemEvent.uid = uid;
@@ -2733,38 +2744,96 @@ void GroupManagerController::onQueryMemberListOrdered(HttpContext& context)
     LOGT << "success to query group member list.(" << resBody.result.dump() << ")";
 }
 
-bool GroupManagerController::checkBidirectionalRelationship(Account* account, 
-    const std::vector<std::string>& members, http::response<http::string_body>& resp)
+bool GroupManagerController::getAccountsInBatches(const std::vector<std::string>& uids,
+                                                  std::vector<Account>& accounts,
+                                                  std::vector<std::string>& missedUids)
 {
-    if (account->has_contactsfilters()) {
-        const ContactsFilters& filterContent = account->contactsfilters();
-        std::string decodedContent = Base64::decode(filterContent.content());
-        BloomFilters bloomFilter(filterContent.algo(), decodedContent);
-        for (auto it = members.begin(); it != members.end(); ++it) {
-            if (!bloomFilter.contains(*it)) {
-                LOGE << "member " << *it << " is not a friend of " << account->uid();
+    if (uids.size() <= kAccountBatchSize) {
+        return uids.empty() || m_accountsManager->get(uids, accounts, missedUids);
+    }
+
+    struct AccountBatch {
+        std::vector<std::string> uids;
+        std::vector<Account> accounts;
+        std::vector<std::string> missedUids;
+        boost::fibers::promise<bool> done;
+    };
+
+    // batches run on the fetch pool while the calling fiber waits on their futures
+    std::vector<std::shared_ptr<AccountBatch>> batches;
+    std::vector<boost::fibers::future<bool>> results;
+    auto accountsManager = m_accountsManager;
+    for (size_t i = 0; i < uids.size(); i += kAccountBatchSize) {
+        auto batch = std::make_shared<AccountBatch>();
+        batch->uids.assign(uids.begin() + i, uids.begin() + std::min(uids.size(), i + kAccountBatchSize));
+        results.emplace_back(batch->done.get_future());
+        batches.emplace_back(batch);
+        m_accountFetchPool.execInPool([accountsManager, batch]() {
+            batch->done.set_value(accountsManager->get(batch->uids, batch->accounts, batch->missedUids));
+        });
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < batches.size(); ++i) {
+        if (!results[i].get()) {
+            ok = false;
+            continue;
+        }
+        std::move(batches[i]->accounts.begin(), batches[i]->accounts.end(), std::back_inserter(accounts));
+        missedUids.insert(missedUids.end(), batches[i]->missedUids.begin(), batches[i]->missedUids.end());
+    }
+    return ok;
+}
+
+bool GroupManagerController::checkMembersContactsFilter(Account* account, const std::vector<std::string>& members,
+                                                        http::response<http::string_body>& resp)
+{
+    std::vector<Account> memberAccounts;
+    std::vector<std::string> missedUids;
+    if (!getAccountsInBatches(members, memberAccounts, missedUids)) {
+        LOGE << "error loading member accounts of " << account->uid() << ", count: " << members.size();
+        resp.result(http::status::internal_server_error);
+        return false;
+    }
+    if (!missedUids.empty()) {
+        LOGE << "error loading account, uid: " << missedUids.front() << ", missed: " << missedUids.size();
+        resp.result(http::status::internal_server_error);
+        return false;
+    }
+
+    for (const auto& memberAccount : memberAccounts) {
+        if (memberAccount.has_contactsfilters()) {
+            const ContactsFilters& filterContent = memberAccount.contactsfilters();
+            auto bloomFilter = ContactsFilterCache::Instance().get(memberAccount.uid(), filterContent.algo(),
+                                                                   filterContent.version(), filterContent.content());
+            if (!bloomFilter->contains(account->uid())) {
+                LOGE << "member " << account->uid() << " is not a friend of " << memberAccount.uid();
                 // NOTE: "200 ok" is returned when this check failed since we want to 
                 // hide the truth from attackers.
                 resp.result(http::status::ok);
                 return false;
+            } else {
+                LOGD << "account " << account->uid() << " is a friend of " << memberAccount.uid()
+                        << ", let him join";
             }
+        } else {
+            LOGD << "account " << memberAccount.uid() << " does not have a contact filter";
         }
     }
 
-    for (auto it = members.begin(); it != members.end(); ++it) {
-        Account memberAccount;
-        dao::ErrorCode ec = m_accountsManager->get(*it, memberAccount);
-        if (ec != dao::ERRORCODE_SUCCESS) {
-            LOGE << "error loading account, uid: " << *it << ", ec: " << ec;
-            resp.result(http::status::internal_server_error);
-            return false;
-        }
-        if (memberAccount.has_contactsfilters()) {
-            const ContactsFilters& filterContent = memberAccount.contactsfilters();
-            std::string decodedContent = Base64::decode(filterContent.content());
-            BloomFilters bloomFilter(filterContent.algo(), decodedContent);
-            if (!bloomFilter.contains(account->uid())) {
-                LOGE << "member " << account->uid() << " is not a friend of " << *it;
+    return true;
+}
+
+bool GroupManagerController::checkBidirectionalRelationship(Account* account, 
+    const std::vector<std::string>& members, http::response<http::string_body>& resp)
+{
+    if (account->has_contactsfilters()) {
+        const ContactsFilters& filterContent = account->contactsfilters();
+        auto bloomFilter = ContactsFilterCache::Instance().get(account->uid(), filterContent.algo(),
+                                                               filterContent.version(), filterContent.content());
+        for (auto it = members.begin(); it != members.end(); ++it) {
+            if (!bloomFilter->contains(*it)) {
+                LOGE << "member " << *it << " is not a friend of " << account->uid();
                 // NOTE: "200 ok" is returned when this check failed since we want to 
                 // hide the truth from attackers.
                 resp.result(http::status::ok);
@@ -2773,7 +2842,7 @@ bool GroupManagerController::checkBidirectionalRelationship(Account* account,
         }
     }
 
-    return true;
+    return checkMembersContactsFilter(account, members, resp);
 }
 
 bool GroupManagerController::checkBidirectionalRelationshipBypassSubscribers(
@@ -2791,19 +2860,23 @@ bool GroupManagerController::checkBidirectionalRelationshipBypassSubscribers(
         return false;
     }
 
+    std::vector<std::string> checkMembers;
+    checkMembers.reserve(members.size());
+    for (auto it = members.begin(); it != members.end(); ++it) {
+        auto itRole = memberRoles.find(*it);
+        if (itRole != memberRoles.end() && itRole->second == GroupUser::ROLE_SUBSCRIBER) {
+            LOGD << "member " << *it << " is a subscriber, let him join";
+            continue;
+        }
+        checkMembers.push_back(*it);
+    }
+
     if (account->has_contactsfilters()) {
         const ContactsFilters& filterContent = account->contactsfilters();
-        std::string decodedContent = Base64::decode(filterContent.content());
-        BloomFilters bloomFilter(filterContent.algo(), decodedContent);
-        for (auto it = members.begin(); it != members.end(); ++it) {
-            auto itRole = memberRoles.find(*it);
-            if (itRole != memberRoles.end()) {
-                if (itRole->second == GroupUser::ROLE_SUBSCRIBER) {
-                    LOGD << "member " << *it << " is a subscriber, let him join";
-                    continue;
-                }
-            }
-            if (!bloomFilter.contains(*it)) {
+        auto bloomFilter = ContactsFilterCache::Instance().get(account->uid(), filterContent.algo(),
+                                                               filterContent.version(), filterContent.content());
+        for (auto it = checkMembers.begin(); it != checkMembers.end(); ++it) {
+            if (!bloomFilter->contains(*it)) {
                 LOGE << "member " << *it << " is not a friend of " << account->uid();
                 // NOTE: "200 ok" is returned when this check failed since we want to 
                 // hide the truth from attackers.
@@ -2818,40 +2891,7 @@ bool GroupManagerController::checkBidirectionalRelationshipBypassSubscribers(
         LOGD << "account " << account->uid() << " does not have a contact filter";
     }
 
-    for (auto it = members.begin(); it != members.end(); ++it) {
-        auto itRole = memberRoles.find(*it);
-        if (itRole != memberRoles.end()) {
-            if (itRole->second == GroupUser::ROLE_SUBSCRIBER) {
-                continue;
-            }
-        }
-        Account memberAccount;
-        dao::ErrorCode ec = m_accountsManager->get(*it, memberAccount);
-        if (ec != dao::ERRORCODE_SUCCESS) {
-            LOGE << "error loading account, uid: " << *it << ", ec: " << ec;
-            resp.result(http::status::internal_server_error);
-            return false;
-        }
-        if (memberAccount.has_contactsfilters()) {
-            const ContactsFilters& filterContent = memberAccount.contactsfilters();
-            std::string decodedContent = Base64::decode(filterContent.content());
-            BloomFilters bloomFilter(filterContent.algo(), decodedContent);
-            if (!bloomFilter.contains(account->uid())) {
-                LOGE << "member " << account->uid() << " is not a friend of " << *it;
-                // NOTE: "200 ok" is returned when this check failed since we want to 
-                // hide the truth from attackers.
-                resp.result(http::status::ok);
-                return false;
-            } else {
-                LOGD << "account " << account->uid() << " is a friend of " << *it 
-                        << ", let him join";
-            }
-        } else {
-            LOGD << "account " << memberAccount.uid() << " does not have a contact filter";
-        }
-    }
-
-    return true;
+    return checkMembersContactsFilter(account, checkMembers, resp);
 }
 
 void GroupManagerController::onSetGroupExtensionInfo(HttpContext& context)
@@ -20,6 +20,7 @@
 #include "group_manager_entities.h"
 #include "limiters/limiter.h"
 #include "dao/dao_cache/redis_cache.h"
+#include "group/io_ctx_executor.h"
 
 #ifdef UNIT_TEST
 #define private public
@@ -123,6 +124,11 @@ private:
  bool checkBidirectionalRelationshipBypassSubscribers(Account* account, uint64_t gid,
                                                       const std::vector<std::string>& members,
                                                       http::response<http::string_body>& resp);
+ // checks that account is in the contacts filter of every member
+ bool checkMembersContactsFilter(Account* account, const std::vector<std::string>& members,
+                                 http::response<http::string_body>& resp);
+ bool getAccountsInBatches(const std::vector<std::string>& uids, std::vector<Account>& accounts,
+                           std::vector<std::string>& missedUids);
 
  bool sendGroupKeysUpdateRequestWhenMemberChanges(const std::string& uid, uint64_t gid,
                                                   uint32_t groupMembersAfterChanges);
@@ -168,6 +174,7 @@ private:
     MultiDeviceConfig m_multiDeviceConfig;
     GroupConfig m_groupConfig;
     KeysCache m_keysCache;
+    IoCtxExecutor m_accountFetchPool;
 };
 
 } // namespace bcm
@@ -8,6 +8,7 @@
 #include "dao/client.h"
 #include "crypto/sha1.h"
 #include "group/group_event.h"
+#include "group/group_meta_cache.h"
 #include "proto/dao/account.pb.h"
 #include "proto/dao/error_code.pb.h"
 #include "proto/group/message.pb.h"
@@ -2122,6 +2123,9 @@ bool GroupManagerController::pubGroupSystemMessage(const std::string& uid,
 
     LOGD << "insert message success: " << newMid << ": " << groupMessage.Utf8DebugString();
 
+    // this node serves the writer's next request before the event comes back from redis
+    GroupMetaCache::Instance()->onSystemMessage(groupid, type, strText);
+
     nlohmann::json jsMessage = nlohmann::json{
                                     {"gid", groupid},
                                     {"mid", newMid},
@@ -9,6 +9,9 @@
 #include <metrics_client.h>
 
 #include "group/group_msg_service.h"
+#include "group/group_meta_cache.h"
+#include "group/group_ack_buffer.h"
+#include "group/group_msg_sub.h"
 #include "utils/time.h"
 #include "utils/log.h"
 #include "utils/account_helper.h"
@@ -61,8 +64,10 @@ std::ostream& operator<<(std::ostream& os, std::vector<std::string> stringlist)
 GroupMsgController::GroupMsgController(
     std::shared_ptr<GroupMsgService> groupMsgService,
     const EncryptSenderConfig& cfg,
-    const SizeCheckConfig& scCfg)
+    const SizeCheckConfig& scCfg,
+    std::shared_ptr<GroupAckBuffer> ackBuffer)
     : m_groupMsgService(groupMsgService)
+    , m_ackBuffer(ackBuffer)
     , m_groups(dao::ClientFactory::groups())
     , m_groupUsers(dao::ClientFactory::groupUsers())
     , m_groupMsgs(dao::ClientFactory::groupMsgs())
@@ -135,8 +140,8 @@ void GroupMsgController::sendMsg(HttpContext& context)
         return;
     }
 
-    Group groupInfo;
-    dao::ErrorCode ec = m_groups->get(req->gid, groupInfo);
+    GroupMetaCache::GroupMeta groupInfo;
+    dao::ErrorCode ec = GroupMetaCache::Instance()->getGroup(req->gid, groupInfo);
     if (ec != dao::ERRORCODE_SUCCESS) {
         LOGE << "get group info error: " << ec << ", gid: " << req->gid;
         resp.errorCode = 1;
@@ -150,9 +155,9 @@ void GroupMsgController::sendMsg(HttpContext& context)
     startTime = get_current_us();
 
     GroupMsg::Type groupMsgType = GroupMsg::TYPE_UNKNOWN;
-    if (groupInfo.broadcast() == 0 ) {
+    if (groupInfo.broadcast == 0) {
         groupMsgType = GroupMsg::TYPE_CHAT;
-    } else if (groupInfo.broadcast() > 0) {
+    } else if (groupInfo.broadcast > 0) {
         groupMsgType = GroupMsg::TYPE_CHANNEL;
     } else {
         resp.errorCode = 100402;
@@ -163,7 +168,7 @@ void GroupMsgController::sendMsg(HttpContext& context)
     }
 
     GroupUser::Role role;
-    ec = m_groupUsers->getMemberRole(req->gid, account->uid(), role);
+    ec = GroupMetaCache::Instance()->getMemberRole(req->gid, account->uid(), role);
     if (ec != dao::ERRORCODE_SUCCESS) {
         LOGE << "get member role error: " << ec << ", gid: " << req->gid 
              << ", uid: " << account->uid();
@@ -419,8 +424,8 @@ void GroupMsgController::getMsg(HttpContext& context)
          << ", gid: " << req->gid << ", from: " << req->from 
          << ", to: " << req->to;
 
-    bcm::Group groupInfo;
-    dao::ErrorCode ec = m_groups->get(req->gid, groupInfo);
+    GroupMetaCache::GroupMeta groupInfo;
+    dao::ErrorCode ec = GroupMetaCache::Instance()->getGroup(req->gid, groupInfo);
     if (ec == dao::ERRORCODE_NO_SUCH_DATA) {
         LOGE << "group not exist, gid: " << req->gid;
         resp.errorCode = 100405;
@@ -439,7 +444,7 @@ void GroupMsgController::getMsg(HttpContext& context)
     }
 
     GroupUser::Role role;
-    ec = m_groupUsers->getMemberRole(req->gid, account->uid(), role);
+    ec = GroupMetaCache::Instance()->getMemberRole(req->gid, account->uid(), role);
     if (ec == dao::ERRORCODE_NO_SUCH_DATA) {
         LOGE << "user, uid: " << account->uid() 
              << ", is not a member of group, gid: " << req->gid;
@@ -522,7 +527,7 @@ void GroupMsgController::ackMsg(HttpContext& context)
 
     GroupUser::Role role;
     dao::ErrorCode ec = 
-        m_groupUsers->getMemberRole(req->gid, account->uid(), role);
+        GroupMetaCache::Instance()->getMemberRole(req->gid, account->uid(), role);
     if (ec == dao::ERRORCODE_NO_SUCH_DATA) {
         LOGE << "user, uid: " << account->uid() 
              << ", is not a member of group, gid: " << req->gid;
@@ -542,21 +547,11 @@ void GroupMsgController::ackMsg(HttpContext& context)
         return;
     }
 
-    nlohmann::json data = {
-        {"last_ack_mid", req->lastMid}
-    };
-    ec = m_groupUsers->update(req->gid, account->uid(), data);
-    if (ec != dao::ERRORCODE_SUCCESS && dao::ERRORCODE_ALREADY_EXSITED != ec) {
-        LOGE << "update last_ack_mid error: " << ec << ", gid: " << req->gid
-             << ", uid: " << account->uid() << ", last mid: " << req->lastMid;
-        resp.errorCode = 1;
-        resp.errorMsg = "database error";
-        marker.setReturnCode(resp.errorCode);
-    } else {
-        LOGI << "last_ack_mid updated, gid: " << req->gid 
-             << ", uid: " << account->uid() << ", last mid: " << req->lastMid;
-        resp.errorCode = 0;
-    }
+    // written by the next flush of the buffer
+    m_ackBuffer->ack(req->gid, account->uid(), req->lastMid);
+    LOGT << "last_ack_mid buffered, gid: " << req->gid
+         << ", uid: " << account->uid() << ", last mid: " << req->lastMid;
+    resp.errorCode = 0;
 
     context.responseEntity = resp;
 }
@@ -615,11 +610,17 @@ void GroupMsgController::queryLastMid(HttpContext& context)
             marker.setReturnCode(resp.errorCode);
             return;
         }
+        // acks of this user still in the buffer are newer than the stored ones
+        std::map<uint64_t, uint64_t> pendingAcks = m_ackBuffer->pending(account->uid());
         for (const auto& itEntries : entries) {
             GLastMidEntry ent;
             ent.gid = itEntries.group.gid();
             ent.lastMid = itEntries.group.lastmid();
             ent.lastAckMid = itEntries.user.lastackmid();
+            auto pendingAck = pendingAcks.find(ent.gid);
+            if (pendingAck != pendingAcks.end() && pendingAck->second > ent.lastAckMid) {
+                ent.lastAckMid = pendingAck->second;
+            }
             resp.result.groups.emplace_back(std::move(ent));
         }
     }
@@ -654,7 +655,7 @@ void GroupMsgController::sendGroupChatMsg(const GroupMsg& msg)
         {"from_uid_extra", fromUidExtra}
     });
 
-    std::string topic = "group_" + std::to_string(msg.gid());
+    std::string topic = GroupMsgSub::groupChannel(msg.gid());
     std::string pubMsg = j.dump();
     OnlineRedisManager::Instance()->publish(topic, pubMsg, [topic, pubMsg](int status, const redis::Reply& reply) {
         if (REDIS_OK != status || !reply.isInteger()) {
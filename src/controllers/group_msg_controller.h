@@ -11,6 +11,7 @@ namespace bcm {
 class RedisClientSync;
 class GroupMsgService;
 class GroupMsg;
+class GroupAckBuffer;
 } // namespace bcm
 
 
@@ -23,7 +24,8 @@ class GroupMsgController
 public:
     GroupMsgController(std::shared_ptr<GroupMsgService> groupMsgService,
                        const EncryptSenderConfig& cfg,
-                       const SizeCheckConfig& scCfg);
+                       const SizeCheckConfig& scCfg,
+                       std::shared_ptr<GroupAckBuffer> ackBuffer);
 
     void addRoutes(HttpRouter& router) override;
 
@@ -40,6 +42,7 @@ private:
 
 private:
     std::shared_ptr<GroupMsgService> m_groupMsgService;
+    std::shared_ptr<GroupAckBuffer> m_ackBuffer;
 
     std::shared_ptr<dao::Groups> m_groups;
     std::shared_ptr<dao::GroupUsers> m_groupUsers;
@@ -8,7 +8,7 @@
 #include <fiber/fiber_pool.h>
 #include <store/accounts_manager.h>
 #include <metrics_client.h>
-#include "bloom/bloom_filters.h"
+#include "bloom/contacts_filter_cache.h"
 #include "features/bcm_features.h"
 #include <utils/sender_utils.h>
 #include "crypto/hex_encoder.h"
@@ -110,8 +110,10 @@ void MessageController::sendMessage(HttpContext& context)
     }
 
     if (filterStrangerMsg && !bSyncMessage) {
-        BloomFilters bloomFilters{destination.contactsfilters().algo(), Base64::decode(destination.contactsfilters().content())};
-        if (!bloomFilters.contains(source.uid())) {
+        const ContactsFilters& filterContent = destination.contactsfilters();
+        auto bloomFilters = ContactsFilterCache::Instance().get(destination.uid(), filterContent.algo(),
+                                                                filterContent.version(), filterContent.content());
+        if (!bloomFilters->contains(source.uid())) {
             MetricsClient::Instance()->markMicrosecondAndRetCode(kMetricsMessageServiceName,
                     "sendMessage", (nowInMicro() - dwStartTime), 1404);
             LOGI << "source uid blocked by destination: " << source.uid() << " -> " << destinationUid;
@@ -1,6 +1,7 @@
 #include <brpc/channel.h>
 
 #include "dao/client.h"
+#include "rpc_impl/dao_channel.h"
 #include "rpc_impl/contacts_rpc_impl.h"
 #include "rpc_impl/onetime_keys_rpc_impl.h"
 #include "rpc_impl/signup_challenges_rpc_impl.h"
@@ -17,6 +18,22 @@
 #include "rpc_impl/group_keys_rpc_impl.h"
 #include "rpc_impl/qr_code_group_users_rpc_impl.h"
 #include "rpc_impl/opaque_data_rpc_impl.h"
+#include "local_impl/accounts_local_impl.h"
+#include "local_impl/contacts_local_impl.h"
+#include "local_impl/signup_challenges_local_impl.h"
+#include "local_impl/stored_messages_local_impl.h"
+#include "local_impl/onetime_keys_local_impl.h"
+#include "local_impl/group_user_local_impl.h"
+#include "local_impl/groups_local_impl.h"
+#include "local_impl/group_msg_local_impl.h"
+#include "local_impl/limiters_local_impl.h"
+#include "local_impl/sys_messages_local_impl.h"
+#include "local_impl/utilities_local_impl.h"
+#include "local_impl/pending_group_user_local_impl.h"
+#include "local_impl/limiter_configurations_local_impl.h"
+#include "local_impl/group_keys_local_impl.h"
+#include "local_impl/qr_code_group_users_local_impl.h"
+#include "local_impl/opaque_data_local_impl.h"
 #include "dao_impl_creator.h"
 #include "utils/log.h"
 
@@ -26,7 +43,7 @@ namespace dao {
 
 // A Channel represents a communication line to a Server. Notice that
 // Channel is thread-safe and can be shared by all threads in your program.
-brpc::Channel channel;
+DaoChannel channel;
 
 bool initialize(const bcm::DaoConfig& config)
 {
@@ -39,6 +56,7 @@ bool initialize(const bcm::DaoConfig& config)
         options.max_retry = config.remote.retries;
         options.mutable_ssl_options()->client_cert.certificate = config.remote.certPath.c_str();
         options.mutable_ssl_options()->client_cert.private_key = config.remote.keyPath.c_str();
+        channel.configure(config);
 
         if (channel.Init(config.remote.hosts.c_str(), config.remote.balancer.c_str(), &options) != 0) {
             LOGE << "Fail to initialize channel";
@@ -108,6 +126,78 @@ bool initialize(const bcm::DaoConfig& config)
             return std::make_shared<OpaqueDataRpcImpl>(&channel);
         });
 
+    } else if (config.clientImpl == LOCAL) {
+        // every dao shares one embedded database, for single node deployments and load tests
+        std::shared_ptr<LocalStore> store = LocalStore::open(config);
+        if (store == nullptr) {
+            LOGE << "Fail to open local store at " << config.local.path;
+            return false;
+        }
+
+        DaoImplCreator<Accounts>::registerFunc([store] () {
+            return std::make_shared<AccountsLocalImpl>(store);
+        });
+
+        DaoImplCreator<Contacts>::registerFunc([store] () {
+            return std::make_shared<ContactsLocalImpl>(store);
+        });
+
+        DaoImplCreator<SignUpChallenges>::registerFunc([store] () {
+            return std::make_shared<SignupChallengesLocalImpl>(store);
+        });
+
+        DaoImplCreator<StoredMessages>::registerFunc([store] () {
+            return std::make_shared<StoredMessagesLocalImpl>(store);
+        });
+
+        DaoImplCreator<OnetimeKeys>::registerFunc([store] () {
+            return std::make_shared<OnetimeKeysLocalImpl>(store);
+        });
+
+        DaoImplCreator<GroupUsers>::registerFunc([store] () {
+            return std::make_shared<GroupUsersLocalImpl>(store);
+        });
+
+        DaoImplCreator<Groups>::registerFunc([store] () {
+            return std::make_shared<GroupsLocalImpl>(store);
+        });
+
+        DaoImplCreator<GroupMsgs>::registerFunc([store] () {
+            return std::make_shared<GroupMsgsLocalImpl>(store);
+        });
+
+        DaoImplCreator<Limiters>::registerFunc([store] () {
+            return std::make_shared<LimitersLocalImpl>(store);
+        });
+
+        DaoImplCreator<SysMsgs>::registerFunc([store] () {
+            return std::make_shared<SysMsgsLocalImpl>(store);
+        });
+
+        DaoImplCreator<MasterLease>::registerFunc([store] () {
+            return std::make_shared<MasterLeaseLocalImpl>(store);
+        });
+
+        DaoImplCreator<PendingGroupUsers>::registerFunc([store] () {
+            return std::make_shared<PendingGroupUsersLocalImpl>(store);
+        });
+
+        DaoImplCreator<LimiterConfigurations>::registerFunc([store] () {
+            return std::make_shared<LimiterConfigurationsLocalImpl>(store);
+        });
+
+        DaoImplCreator<GroupKeys>::registerFunc([store] () {
+            return std::make_shared<GroupKeysLocalImpl>(store);
+        });
+
+        DaoImplCreator<QrCodeGroupUsers>::registerFunc([store] () {
+            return std::make_shared<QrCodeGroupUsersLocalImpl>(store);
+        });
+
+        DaoImplCreator<OpaqueData>::registerFunc([store] () {
+            return std::make_shared<OpaqueDataLocalImpl>(store);
+        });
+
     } else {
         LOGE << "failed to initialize db interface";
         return false;
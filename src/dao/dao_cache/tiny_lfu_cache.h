@@ -0,0 +1,438 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef UNIT_TEST
+#define private public
+#define protected public
+#endif
+
+namespace bcm {
+namespace dao {
+
+// bytes of a protobuf message, the same measure FIFOCache uses
+template <class TVal>
+struct MessageByteSize {
+    size_t operator()(const TVal& value) const
+    {
+        return value.ByteSizeLong();
+    }
+};
+
+/*
+ * byte bounded W-TinyLFU cache. every shard keeps a small LRU window in front of a
+ * segmented LRU (probation + protected), an entry leaving the window only replaces
+ * the probation victim when a count-min sketch has seen it more often, so one-off
+ * lookups can not push out hot entries.
+ * values are shared and immutable, get hands out a reference instead of a copy.
+ */
+template <class TKey, class TVal, class TSize = MessageByteSize<TVal>, class THash = std::hash<TKey>>
+class TinyLFUCache {
+public:
+    typedef std::shared_ptr<const TVal> ValuePtr;
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t rejected{0};  // left the window and lost against the probation victim
+        uint64_t evicted{0};   // pushed out of the main space by a more frequent entry
+    };
+
+    static constexpr size_t kDefaultShards = 16;
+    // shards below this size leave too little room for the window and the victims
+    static constexpr size_t kMinShardBytes = 64 * 1024;
+    static constexpr size_t kWindowPercent = 1;
+    static constexpr size_t kProtectedPercent = 80;
+
+    explicit TinyLFUCache(size_t limit, size_t shards = kDefaultShards)
+        : m_limit(limit)
+    {
+        size_t n = 1;
+        while (n * 2 <= shards && limit / (n * 2) >= kMinShardBytes) {
+            n *= 2;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            m_shards.emplace_back(new Shard(limit / n));
+        }
+    }
+
+    ValuePtr get(const TKey& key)
+    {
+        size_t hash = m_hash(key);
+        Shard& shard = shardOf(hash);
+        std::lock_guard<std::mutex> l(shard.mtx);
+        shard.sketch.increment(hash);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            ++shard.stats.misses;
+            return nullptr;
+        }
+        ++shard.stats.hits;
+        shard.touch(it->second);
+        return it->second->value;
+    }
+
+    // for callers that need their own mutable copy
+    bool get(const TKey& key, TVal& value)
+    {
+        ValuePtr cached = get(key);
+        if (!cached) {
+            return false;
+        }
+        value = *cached;
+        return true;
+    }
+
+    bool set(const TKey& key, ValuePtr value)
+    {
+        if (!value) {
+            return false;
+        }
+        size_t size = m_size(*value);
+        size_t hash = m_hash(key);
+        Shard& shard = shardOf(hash);
+        if (size > shard.capacity) {
+            return false;
+        }
+        std::lock_guard<std::mutex> l(shard.mtx);
+        shard.sketch.increment(hash);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            shard.resize(it->second, size);
+            it->second->value = std::move(value);
+            shard.touch(it->second);
+        } else {
+            shard.window.push_front(Entry{key, hash, std::move(value), size, WINDOW});
+            shard.entries.emplace(key, shard.window.begin());
+            shard.windowSize += size;
+            shard.growSketch();
+        }
+        shard.evict();
+        return true;
+    }
+
+    bool set(const TKey& key, TVal value)
+    {
+        return set(key, std::make_shared<const TVal>(std::move(value)));
+    }
+
+    void erase(const TKey& key)
+    {
+        Shard& shard = shardOf(m_hash(key));
+        std::lock_guard<std::mutex> l(shard.mtx);
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            shard.remove(it->second);
+        }
+    }
+
+    // bytes held by all shards
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const auto& shard : m_shards) {
+            std::lock_guard<std::mutex> l(shard->mtx);
+            total += shard->used();
+        }
+        return total;
+    }
+
+    size_t count() const
+    {
+        size_t total = 0;
+        for (const auto& shard : m_shards) {
+            std::lock_guard<std::mutex> l(shard->mtx);
+            total += shard->entries.size();
+        }
+        return total;
+    }
+
+    Stats stats() const
+    {
+        Stats total;
+        for (const auto& shard : m_shards) {
+            std::lock_guard<std::mutex> l(shard->mtx);
+            total.hits += shard->stats.hits;
+            total.misses += shard->stats.misses;
+            total.rejected += shard->stats.rejected;
+            total.evicted += shard->stats.evicted;
+        }
+        return total;
+    }
+
+    size_t limit() const
+    {
+        return m_limit;
+    }
+
+private:
+    enum Segment { WINDOW, PROBATION, PROTECTED };
+
+    struct Entry {
+        TKey key;
+        size_t hash;
+        ValuePtr value;
+        size_t size;
+        Segment segment;
+    };
+
+    typedef std::list<Entry> EntryList;
+    typedef typename EntryList::iterator EntryIt;
+
+    // 4 rows of saturating 4 bit counters, halved after 10 * width increments so
+    // the popularity of the past fades out
+    class FrequencySketch {
+    public:
+        static constexpr size_t kRows = 4;
+        static constexpr uint8_t kMaxCount = 15;
+        static constexpr size_t kMinWidth = 64;
+        static constexpr size_t kMaxWidth = 1 << 22;
+
+        FrequencySketch()
+        {
+            reset(kMinWidth);
+        }
+
+        bool needsGrow(size_t entries) const
+        {
+            return entries > m_width && m_width < kMaxWidth;
+        }
+
+        // a wider sketch starts empty, the caller carries over what it needs
+        void grow(size_t entries)
+        {
+            size_t width = m_width;
+            while (width < entries * 2 && width < kMaxWidth) {
+                width *= 2;
+            }
+            reset(width);
+        }
+
+        void add(size_t hash, uint8_t count)
+        {
+            if (count > kMaxCount) {
+                count = kMaxCount;
+            }
+            for (size_t i = 0; i < kRows; ++i) {
+                uint8_t& counter = m_table[i * m_width + indexOf(hash, i)];
+                counter = std::max(counter, count);
+            }
+        }
+
+        void increment(size_t hash)
+        {
+            bool added = false;
+            for (size_t i = 0; i < kRows; ++i) {
+                uint8_t& counter = m_table[i * m_width + indexOf(hash, i)];
+                if (counter < kMaxCount) {
+                    ++counter;
+                    added = true;
+                }
+            }
+            if (added && ++m_additions >= 10 * m_width) {
+                for (auto& counter : m_table) {
+                    counter >>= 1;
+                }
+                m_additions /= 2;
+            }
+        }
+
+        uint8_t frequency(size_t hash) const
+        {
+            uint8_t freq = kMaxCount;
+            for (size_t i = 0; i < kRows; ++i) {
+                freq = std::min(freq, m_table[i * m_width + indexOf(hash, i)]);
+            }
+            return freq;
+        }
+
+    private:
+        void reset(size_t width)
+        {
+            m_width = width;
+            m_additions = 0;
+            m_table.assign(kRows * width, 0);
+        }
+
+        size_t indexOf(size_t hash, size_t row) const
+        {
+            static const uint64_t kSeeds[kRows] = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL,
+                                                   0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL};
+            uint64_t h = (static_cast<uint64_t>(hash) + kSeeds[row]) * kSeeds[row];
+            return static_cast<size_t>(h >> 32) & (m_width - 1);
+        }
+
+        size_t m_width{0};
+        size_t m_additions{0};
+        std::vector<uint8_t> m_table;
+    };
+
+    struct Shard {
+        explicit Shard(size_t bytes)
+            : capacity(bytes)
+            , windowCapacity(std::max<size_t>(bytes * kWindowPercent / 100, 1))
+            , protectedCapacity((bytes - windowCapacity) * kProtectedPercent / 100)
+        {
+        }
+
+        EntryList& listOf(Segment segment)
+        {
+            return segment == WINDOW ? window : (segment == PROBATION ? probation : protected_);
+        }
+
+        size_t& sizeOf(Segment segment)
+        {
+            return segment == WINDOW ? windowSize : (segment == PROBATION ? probationSize : protectedSize);
+        }
+
+        void move(EntryIt it, Segment to)
+        {
+            sizeOf(it->segment) -= it->size;
+            sizeOf(to) += it->size;
+            listOf(to).splice(listOf(to).begin(), listOf(it->segment), it);
+            it->segment = to;
+        }
+
+        void resize(EntryIt it, size_t size)
+        {
+            sizeOf(it->segment) -= it->size;
+            sizeOf(it->segment) += size;
+            it->size = size;
+        }
+
+        void remove(EntryIt it)
+        {
+            sizeOf(it->segment) -= it->size;
+            Segment segment = it->segment;
+            entries.erase(it->key);
+            listOf(segment).erase(it);
+        }
+
+        // an accessed probation entry is promoted, the protected tail makes room for it
+        void touch(EntryIt it)
+        {
+            if (it->segment == PROBATION) {
+                move(it, PROTECTED);
+            } else {
+                EntryList& list = listOf(it->segment);
+                list.splice(list.begin(), list, it);
+            }
+            demote();
+        }
+
+        // also called after a protected entry grows
+        void demote()
+        {
+            while (protectedSize > protectedCapacity && protected_.size() > 1) {
+                move(std::prev(protected_.end()), PROBATION);
+            }
+        }
+
+        // keep the counts of the resident entries, they are what victims are judged by
+        void growSketch()
+        {
+            if (!sketch.needsGrow(entries.size())) {
+                return;
+            }
+            std::vector<std::pair<size_t, uint8_t>> counts;
+            counts.reserve(entries.size());
+            for (const auto& item : entries) {
+                counts.emplace_back(item.second->hash, sketch.frequency(item.second->hash));
+            }
+            sketch.grow(entries.size());
+            for (const auto& count : counts) {
+                sketch.add(count.first, count.second);
+            }
+        }
+
+        EntryIt victim()
+        {
+            if (!probation.empty()) {
+                return std::prev(probation.end());
+            }
+            return std::prev(protected_.end());
+        }
+
+        // the window tail enters the main space if there is room, otherwise it has to
+        // be more frequent than every victim it pushes out
+        void evict()
+        {
+            while (windowSize > windowCapacity) {
+                EntryIt candidate = std::prev(window.end());
+                uint8_t freq = sketch.frequency(candidate->hash);
+                while (used() > capacity && !(probation.empty() && protected_.empty())) {
+                    EntryIt v = victim();
+                    if (freq <= sketch.frequency(v->hash)) {
+                        break;
+                    }
+                    remove(v);
+                    ++stats.evicted;
+                }
+                if (used() <= capacity) {
+                    move(candidate, PROBATION);
+                } else {
+                    remove(candidate);
+                    ++stats.rejected;
+                }
+            }
+
+            // a resident entry that grew leaves the shard over capacity with the window
+            // in bounds, the main space gives up its victims, the window tail comes last
+            while (used() > capacity && !(probation.empty() && protected_.empty())) {
+                remove(victim());
+                ++stats.evicted;
+            }
+            while (used() > capacity && !window.empty()) {
+                remove(std::prev(window.end()));
+                ++stats.evicted;
+            }
+        }
+
+        size_t used() const
+        {
+            return windowSize + probationSize + protectedSize;
+        }
+
+        mutable std::mutex mtx;
+        size_t capacity;
+        size_t windowCapacity;
+        size_t protectedCapacity;
+        size_t windowSize{0};
+        size_t probationSize{0};
+        size_t protectedSize{0};
+        EntryList window;
+        EntryList probation;
+        EntryList protected_;
+        std::unordered_map<TKey, EntryIt, THash> entries;
+        FrequencySketch sketch;
+        Stats stats;
+    };
+
+    Shard& shardOf(size_t hash)
+    {
+        // spread the hash before picking a shard, std::hash of integers is the identity
+        uint64_t h = static_cast<uint64_t>(hash) * 0x9e3779b97f4a7c15ULL;
+        return *m_shards[static_cast<size_t>(h >> 40) & (m_shards.size() - 1)];
+    }
+
+    size_t m_limit;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    TSize m_size;
+    THash m_hash;
+};
+
+}
+}
+
+#ifdef UNIT_TEST
+#undef private
+#undef protected
+#endif
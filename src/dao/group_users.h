@@ -30,6 +30,12 @@ struct UserGroupEntry {
     std::string owner;
 };
 
+struct GroupUserAck {
+    uint64_t gid;
+    std::string uid;
+    uint64_t lastAckMid;
+};
+
 /*
  * Accounts dao virtual base class
  */
@@ -168,6 +174,13 @@ public:
      */
     virtual ErrorCode updateIfEmpty(uint64_t gid, const std::string& uid, const nlohmann::json& upData) = 0;
 
+    /**
+     * @brief set last_ack_mid of many members at once
+     * @param acks - at most one entry per member
+     * @return - ERRORCODE_SUCCESS if every member was updated, members that left are skipped
+     */
+    virtual ErrorCode updateLastAckMidBatch(const std::vector<GroupUserAck>& acks) = 0;
+
     /**
      * @brief get members order by (create_time, uid)
      * @param gid 
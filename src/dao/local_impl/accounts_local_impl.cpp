@@ -0,0 +1,248 @@
+#include "accounts_local_impl.h"
+#include "group_user_local_impl.h"
+#include "onetime_keys_local_impl.h"
+#include "utils/log.h"
+
+#include <boost/core/ignore_unused.hpp>
+
+namespace bcm {
+namespace dao {
+
+// copies the fields named by their proto names from one message to another
+static bool copyFields(const google::protobuf::Message& from,
+                       google::protobuf::Message& to,
+                       const google::protobuf::RepeatedPtrField<std::string>& names)
+{
+    std::vector<const google::protobuf::FieldDescriptor*> fields;
+    for (const auto& name : names) {
+        const google::protobuf::FieldDescriptor* field = from.GetDescriptor()->FindFieldByName(name);
+        if (field == nullptr) {
+            LOGE << from.GetTypeName() << " has no field " << name;
+            return false;
+        }
+        fields.push_back(field);
+    }
+    std::unique_ptr<google::protobuf::Message> copy(from.New());
+    copy->CopyFrom(from);
+    to.GetReflection()->SwapFields(copy.get(), &to, fields);
+    return true;
+}
+
+// Keys carries the signed pre key and the one time key either whole or as the
+// public key alone
+static void setKeyField(bcm::Keys& keys, const std::string& name,
+                        const google::protobuf::Message& key, const std::string& publicKey)
+{
+    const google::protobuf::FieldDescriptor* field = keys.GetDescriptor()->FindFieldByLowercaseName(name);
+    if (field == nullptr) {
+        return;
+    }
+    if (field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+        keys.GetReflection()->MutableMessage(&keys, field)->CopyFrom(key);
+    } else if (field->cpp_type() == google::protobuf::FieldDescriptor::CPPTYPE_STRING) {
+        keys.GetReflection()->SetString(&keys, field, publicKey);
+    }
+}
+
+AccountsLocalImpl::AccountsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+std::string AccountsLocalImpl::keyOf(const std::string& uid)
+{
+    return LocalKey("acc").str(uid);
+}
+
+ErrorCode AccountsLocalImpl::create(const bcm::Account& account)
+{
+    std::string key = keyOf(account.uid());
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    std::string value;
+    ErrorCode ec = m_store->get(key, value);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        return ErrorCode::ERRORCODE_ALREADY_EXSITED;
+    }
+    if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        return ec;
+    }
+    return m_store->put(key, account);
+}
+
+ErrorCode AccountsLocalImpl::updateAccount(const bcm::Account& account, uint32_t flags)
+{
+    boost::ignore_unused(flags);
+    std::string key = keyOf(account.uid());
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    bcm::Account stored;
+    ErrorCode ec = m_store->get(key, stored);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return m_store->put(key, account);
+}
+
+bool AccountsLocalImpl::mergeDevice(const bcm::Account& account,
+                                    const bcm::DeviceField& modifyField,
+                                    bcm::Account& stored)
+{
+    const bcm::Device* device = nullptr;
+    for (const auto& d : account.devices()) {
+        if (d.id() == modifyField.id()) {
+            device = &d;
+            break;
+        }
+    }
+    if (device == nullptr) {
+        LOGE << "account " << account.uid() << " has no device " << modifyField.id();
+        return false;
+    }
+
+    bcm::Device* target = nullptr;
+    for (auto& d : *stored.mutable_devices()) {
+        if (d.id() == modifyField.id()) {
+            target = &d;
+            break;
+        }
+    }
+    if (modifyField.iscreate() || target == nullptr) {
+        if (target == nullptr) {
+            target = stored.add_devices();
+        }
+        *target = *device;
+        return true;
+    }
+    return copyFields(*device, *target, modifyField.modifyfields());
+}
+
+ErrorCode AccountsLocalImpl::updateAccount(const bcm::Account& account, const bcm::AccountField& modifyField)
+{
+    std::string key = keyOf(account.uid());
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    bcm::Account stored;
+    ErrorCode ec = m_store->get(key, stored);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+
+    if (!copyFields(account, stored, modifyField.modifyfields())) {
+        return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+    }
+    for (const auto& deviceField : modifyField.devices()) {
+        if (!mergeDevice(account, deviceField, stored)) {
+            return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+        }
+    }
+    if (modifyField.has_modifyfilters()) {
+        if (modifyField.modifyfilters().isclear()) {
+            stored.clear_contactsfilters();
+        }
+        if (!copyFields(account.contactsfilters(), *stored.mutable_contactsfilters(),
+                        modifyField.modifyfilters().modifyfields())) {
+            return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+        }
+    }
+    return m_store->put(key, stored);
+}
+
+ErrorCode AccountsLocalImpl::updateDevice(const bcm::Account& account, uint32_t deviceId)
+{
+    bcm::DeviceField modifyField;
+    modifyField.set_id(deviceId);
+    modifyField.set_iscreate(true);
+    return updateDevice(account, modifyField);
+}
+
+ErrorCode AccountsLocalImpl::updateDevice(const bcm::Account& account, const bcm::DeviceField& modifyField)
+{
+    std::string key = keyOf(account.uid());
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    bcm::Account stored;
+    ErrorCode ec = m_store->get(key, stored);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    if (!mergeDevice(account, modifyField, stored)) {
+        return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+    }
+    return m_store->put(key, stored);
+}
+
+ErrorCode AccountsLocalImpl::get(const std::string& uid, bcm::Account& account)
+{
+    return m_store->get(keyOf(uid), account);
+}
+
+ErrorCode AccountsLocalImpl::get(const std::vector<std::string>& uids,
+                                 std::vector<bcm::Account>& accounts,
+                                 std::vector<std::string>& missedUids)
+{
+    missedUids.clear();
+    for (const auto& uid : uids) {
+        bcm::Account account;
+        ErrorCode ec = m_store->get(keyOf(uid), account);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            accounts.emplace_back(std::move(account));
+        } else if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            missedUids.push_back(uid);
+        } else {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode AccountsLocalImpl::getKeys(const std::set<std::string>& uids, std::vector<bcm::Keys>& keys)
+{
+    OnetimeKeysLocalImpl onetimeKeys(m_store);
+    for (const auto& uid : uids) {
+        bcm::Account account;
+        ErrorCode ec = m_store->get(keyOf(uid), account);
+        if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            continue;
+        }
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+        for (const auto& device : account.devices()) {
+            if (device.id() != Device::MASTER_ID) {
+                continue;
+            }
+            bcm::Keys item;
+            item.set_uid(uid);
+            item.set_deviceid(device.id());
+            item.set_registrationid(device.registrationid());
+            item.set_identitykey(account.identitykey());
+            item.set_accountpublickey(account.publickey());
+            setKeyField(item, "signedprekey", device.signedprekey(), device.signedprekey().publickey());
+
+            // every key handed out is consumed, like a pre key fetch
+            bcm::OnetimeKey onetimeKey;
+            ec = onetimeKeys.get(uid, device.id(), onetimeKey);
+            if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+                setKeyField(item, "onetimekey", onetimeKey, onetimeKey.publickey());
+            } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+                return ec;
+            }
+            keys.emplace_back(std::move(item));
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode AccountsLocalImpl::getKeysByGid(uint64_t gid, std::vector<bcm::Keys>& keys)
+{
+    std::map<std::string, bcm::GroupUser::Role> roles;
+    ErrorCode ec = GroupUsersLocalImpl(m_store).getMemberRoles(gid, roles);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    std::set<std::string> uids;
+    for (const auto& item : roles) {
+        uids.insert(item.first);
+    }
+    return getKeys(uids, keys);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "dao/accounts.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class AccountsLocalImpl : public Accounts {
+public:
+    explicit AccountsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode create(const bcm::Account& account) override;
+
+    virtual ErrorCode updateAccount(const bcm::Account& account, uint32_t flags) override;
+
+    virtual ErrorCode updateAccount(const bcm::Account& account, const bcm::AccountField& modifyField) override;
+
+    virtual ErrorCode updateDevice(const bcm::Account& account, uint32_t deviceId) override;
+
+    virtual ErrorCode updateDevice(const bcm::Account& account, const bcm::DeviceField& modifyField) override;
+
+    virtual ErrorCode get(const std::string& uid, bcm::Account& account) override;
+
+    virtual ErrorCode get(const std::vector<std::string>& uids,
+                          std::vector<bcm::Account>& accounts,
+                          std::vector<std::string>& missedUids) override;
+
+    virtual ErrorCode getKeys(const std::set<std::string>& uids, std::vector<bcm::Keys>& keys) override;
+
+    virtual ErrorCode getKeysByGid(uint64_t gid, std::vector<bcm::Keys>& keys) override;
+
+private:
+    static std::string keyOf(const std::string& uid);
+    // applies modifyField of account to stored, false if account misses the device
+    static bool mergeDevice(const bcm::Account& account, const bcm::DeviceField& modifyField, bcm::Account& stored);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,89 @@
+#include "contacts_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+ContactsLocalImpl::ContactsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode ContactsLocalImpl::get(const std::string& uid, std::string& contacts)
+{
+    return m_store->get(LocalKey("ct").str(uid), contacts);
+}
+
+ErrorCode ContactsLocalImpl::getInParts(const std::string& uid, const std::vector<std::string>& parts,
+                                        std::map<std::string, std::string>& contacts)
+{
+    std::string prefix = LocalKey("ctp").str(uid);
+    if (parts.empty()) {
+        return m_store->scan(prefix, "", [&contacts, &prefix](const leveldb::Slice& key, const leveldb::Slice& value) {
+            contacts[LocalKey::tailString(key, prefix)] = value.ToString();
+            return true;
+        });
+    }
+
+    for (const auto& part : parts) {
+        std::string value;
+        ErrorCode ec = m_store->get(LocalKey("ctp").str(uid).str(part), value);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            contacts[part] = std::move(value);
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode ContactsLocalImpl::setInParts(const std::string& uid, const std::map<std::string, std::string>& contactsInPart)
+{
+    LocalStore::Batch batch;
+    for (const auto& item : contactsInPart) {
+        batch.Put(LocalKey("ctp").str(uid).str(item.first).key(), item.second);
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode ContactsLocalImpl::addFriendEvent(const std::string& uid,
+                                            FriendEventType eventType,
+                                            const std::string& eventData,
+                                            int64_t& eventId)
+{
+    uint64_t id = 0;
+    ErrorCode ec = m_store->nextId("friend_event", id);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    eventId = static_cast<int64_t>(id);
+    return m_store->put(LocalKey("fe").str(uid).u64(static_cast<uint64_t>(eventType)).u64(id), eventData);
+}
+
+ErrorCode ContactsLocalImpl::getFriendEvents(const std::string& uid,
+                                             FriendEventType eventType,
+                                             int count,
+                                             std::vector<FriendEvent>& events)
+{
+    std::string prefix = LocalKey("fe").str(uid).u64(static_cast<uint64_t>(eventType));
+    return m_store->scan(prefix, "", [&events, count](const leveldb::Slice& key, const leveldb::Slice& value) {
+        FriendEvent event;
+        event.id = static_cast<int64_t>(LocalKey::tailU64(key));
+        event.data = value.ToString();
+        events.emplace_back(std::move(event));
+        return static_cast<int>(events.size()) < count;
+    });
+}
+
+ErrorCode ContactsLocalImpl::delFriendEvents(const std::string& uid,
+                                             FriendEventType eventType,
+                                             const std::vector<int64_t>& idList)
+{
+    LocalStore::Batch batch;
+    for (auto id : idList) {
+        batch.Delete(LocalKey("fe").str(uid).u64(static_cast<uint64_t>(eventType)).u64(static_cast<uint64_t>(id)).key());
+    }
+    return m_store->write(batch);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "dao/contacts.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class ContactsLocalImpl : public Contacts {
+public:
+    explicit ContactsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode get(const std::string& uid, std::string& contacts) override;
+
+    // all parts of uid if parts is empty
+    virtual ErrorCode getInParts(const std::string& uid, const std::vector<std::string>& parts,
+                                 std::map<std::string, std::string>& contacts) override;
+
+    virtual ErrorCode setInParts(const std::string& uid, const std::map<std::string, std::string>& contactsInPart) override;
+
+    virtual ErrorCode addFriendEvent(const std::string& uid,
+                                     FriendEventType eventType,
+                                     const std::string& eventData,
+                                     int64_t& eventId) override;
+
+    virtual ErrorCode getFriendEvents(const std::string& uid,
+                                      FriendEventType eventType,
+                                      int count,
+                                      std::vector<FriendEvent>& events) override;
+
+    virtual ErrorCode delFriendEvents(const std::string& uid,
+                                      FriendEventType eventType,
+                                      const std::vector<int64_t>& idList) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
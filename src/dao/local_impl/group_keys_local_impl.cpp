@@ -0,0 +1,119 @@
+#include "group_keys_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+GroupKeysLocalImpl::GroupKeysLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey GroupKeysLocalImpl::versionKey(uint64_t gid, int64_t version)
+{
+    LocalKey key("gk");
+    key.u64(gid).i64(version);
+    return key;
+}
+
+ErrorCode GroupKeysLocalImpl::getLatest(uint64_t gid, bcm::GroupKeys& groupKeys)
+{
+    bool found = false;
+    ErrorCode ec = m_store->scanReverse(LocalKey("gk").u64(gid),
+                                        [&found, &groupKeys](const leveldb::Slice&, const leveldb::Slice& value) {
+        found = groupKeys.ParseFromArray(value.data(), static_cast<int>(value.size()));
+        return false;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return found ? ErrorCode::ERRORCODE_SUCCESS : ErrorCode::ERRORCODE_NO_SUCH_DATA;
+}
+
+ErrorCode GroupKeysLocalImpl::insert(const bcm::GroupKeys& groupKeys)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("gk").u64(groupKeys.gid())));
+    bcm::GroupKeys latest;
+    ErrorCode ec = getLatest(groupKeys.gid(), latest);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS && groupKeys.version() <= latest.version()) {
+        return ErrorCode::ERRORCODE_CAS_FAIL;
+    }
+    if (ec != ErrorCode::ERRORCODE_SUCCESS && ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        return ec;
+    }
+    return m_store->put(versionKey(groupKeys.gid(), groupKeys.version()), groupKeys);
+}
+
+ErrorCode GroupKeysLocalImpl::get(uint64_t gid,
+                                  const std::set<int64_t>& versions,
+                                  std::vector<bcm::GroupKeys>& groupKeys)
+{
+    for (auto version : versions) {
+        bcm::GroupKeys keys;
+        ErrorCode ec = m_store->get(versionKey(gid, version), keys);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            groupKeys.emplace_back(std::move(keys));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupKeysLocalImpl::getLatestMode(uint64_t gid, bcm::GroupKeys::GroupKeysMode& mode)
+{
+    bcm::GroupKeys latest;
+    ErrorCode ec = getLatest(gid, latest);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        mode = latest.mode();
+    }
+    return ec;
+}
+
+ErrorCode GroupKeysLocalImpl::getLatestModeBatch(const std::set<uint64_t>& gids,
+                                                 std::map<uint64_t, bcm::GroupKeys::GroupKeysMode>& result)
+{
+    for (auto gid : gids) {
+        bcm::GroupKeys latest;
+        ErrorCode ec = getLatest(gid, latest);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            result.emplace(gid, latest.mode());
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupKeysLocalImpl::clear(uint64_t gid)
+{
+    return m_store->delPrefix(LocalKey("gk").u64(gid));
+}
+
+ErrorCode GroupKeysLocalImpl::getLatestModeAndVersion(uint64_t gid, bcm::dao::rpc::LatestModeAndVersion& mv)
+{
+    bcm::GroupKeys latest;
+    ErrorCode ec = getLatest(gid, latest);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        mv.set_gid(gid);
+        mv.set_mode(latest.mode());
+        mv.set_version(latest.version());
+    }
+    return ec;
+}
+
+ErrorCode GroupKeysLocalImpl::getLatestGroupKeys(const std::set<uint64_t>& gids, std::vector<bcm::GroupKeys>& groupKeys)
+{
+    for (auto gid : gids) {
+        bcm::GroupKeys latest;
+        ErrorCode ec = getLatest(gid, latest);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            groupKeys.emplace_back(std::move(latest));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+}  // namespace dao
+}  // namespace bcm
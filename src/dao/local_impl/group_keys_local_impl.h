@@ -0,0 +1,42 @@
+#pragma once
+
+#include "dao/group_keys.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class GroupKeysLocalImpl : public GroupKeys {
+public:
+    explicit GroupKeysLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // ERRORCODE_CAS_FAIL unless the version is above the latest one of the group
+    virtual ErrorCode insert(const bcm::GroupKeys& groupKeys) override;
+
+    virtual ErrorCode get(uint64_t gid,
+                          const std::set<int64_t>& versions,
+                          std::vector<bcm::GroupKeys>& groupKeys) override;
+
+    virtual ErrorCode getLatestMode(uint64_t gid, bcm::GroupKeys::GroupKeysMode& mode) override;
+
+    virtual ErrorCode getLatestModeBatch(const std::set<uint64_t>& gid,
+                                         std::map<uint64_t, bcm::GroupKeys::GroupKeysMode>& result) override;
+
+    virtual ErrorCode clear(uint64_t gid) override;
+
+    virtual ErrorCode getLatestModeAndVersion(uint64_t gid, bcm::dao::rpc::LatestModeAndVersion& mv) override;
+
+    virtual ErrorCode getLatestGroupKeys(const std::set<uint64_t>& gids, std::vector<bcm::GroupKeys>& groupKeys) override;
+
+private:
+    // versions of a group are stored in ascending order, the latest one is the last row
+    static LocalKey versionKey(uint64_t gid, int64_t version);
+    ErrorCode getLatest(uint64_t gid, bcm::GroupKeys& groupKeys);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,120 @@
+#include "group_msg_local_impl.h"
+#include "groups_local_impl.h"
+#include "utils/time.h"
+
+#include <boost/core/ignore_unused.hpp>
+
+namespace bcm {
+namespace dao {
+
+GroupMsgsLocalImpl::GroupMsgsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey GroupMsgsLocalImpl::msgKey(uint64_t gid, uint64_t mid)
+{
+    LocalKey key("gmsg");
+    key.u64(gid).u64(mid);
+    return key;
+}
+
+ErrorCode GroupMsgsLocalImpl::append(bcm::GroupMsg& msg, LocalStore::Batch& batch)
+{
+    bcm::Group group;
+    ErrorCode ec = m_store->get(GroupsLocalImpl::groupKey(msg.gid()), group);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    group.set_lastmid(group.lastmid() + 1);
+    msg.set_mid(group.lastmid());
+    batch.Put(GroupsLocalImpl::groupKey(msg.gid()).key(), group.SerializeAsString());
+    batch.Put(msgKey(msg.gid(), msg.mid()).key(), msg.SerializeAsString());
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupMsgsLocalImpl::insert(const bcm::GroupMsg& msg, uint64_t& mid)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(GroupsLocalImpl::groupKey(msg.gid())));
+    bcm::GroupMsg stored(msg);
+    LocalStore::Batch batch;
+    ErrorCode ec = append(stored, batch);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    ec = m_store->write(batch);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        mid = stored.mid();
+    }
+    return ec;
+}
+
+ErrorCode GroupMsgsLocalImpl::get(uint64_t groupId, uint64_t mid, GroupMsg& msg)
+{
+    return m_store->get(msgKey(groupId, mid), msg);
+}
+
+ErrorCode GroupMsgsLocalImpl::batchGet(uint64_t groupId, uint64_t from, uint64_t to, uint64_t limit,
+                                       bcm::GroupUser::Role role, bool supportRrecall,
+                                       std::vector<bcm::GroupMsg>& msgs)
+{
+    boost::ignore_unused(role);
+
+    LocalKey prefix("gmsg");
+    prefix.u64(groupId);
+    ErrorCode parsed = ErrorCode::ERRORCODE_SUCCESS;
+    ErrorCode ec = m_store->scan(prefix, msgKey(groupId, from),
+                                 [&](const leveldb::Slice& key, const leveldb::Slice& value) {
+        if (LocalKey::tailU64(key) > to || (limit != 0 && msgs.size() >= limit)) {
+            return false;
+        }
+        bcm::GroupMsg msg;
+        if (!msg.ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            parsed = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            return false;
+        }
+        if (supportRrecall || msg.type() != bcm::GroupMsg::TYPE_RECALL) {
+            msgs.emplace_back(std::move(msg));
+        }
+        return true;
+    });
+    return ec != ErrorCode::ERRORCODE_SUCCESS ? ec : parsed;
+}
+
+ErrorCode GroupMsgsLocalImpl::recall(const std::string& sourceExtra, const std::string& uid,
+                                     uint64_t gid, uint64_t mid, uint64_t& newMid)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(GroupsLocalImpl::groupKey(gid)));
+    bcm::GroupMsg original;
+    ErrorCode ec = m_store->get(msgKey(gid, mid), original);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    original.set_status(bcm::GroupMsg::STATUS_RECALLED);
+
+    bcm::GroupMsg recalled;
+    recalled.set_gid(gid);
+    recalled.set_fromuid(uid);
+    recalled.set_text(nlohmann::json::object({{"recalled_mid", mid}}).dump());
+    recalled.set_type(bcm::GroupMsg::TYPE_RECALL);
+    recalled.set_status(bcm::GroupMsg::STATUS_NORMAL);
+    recalled.set_atall(0);
+    recalled.set_atlist("[]");
+    recalled.set_createtime(nowInMilli());
+    recalled.set_sourceextra(sourceExtra);
+
+    LocalStore::Batch batch;
+    batch.Put(msgKey(gid, mid).key(), original.SerializeAsString());
+    ec = append(recalled, batch);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    ec = m_store->write(batch);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        newMid = recalled.mid();
+    }
+    return ec;
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "dao/group_msgs.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class GroupMsgsLocalImpl : public GroupMsgs {
+public:
+    explicit GroupMsgsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // mids follow the lastmid of the group, which is advanced with the insert
+    virtual ErrorCode insert(const bcm::GroupMsg& msg, uint64_t& mid) override;
+
+    virtual ErrorCode get(uint64_t groupId, uint64_t mid, GroupMsg& msg) override;
+
+    // role is not used, every member sees the same messages
+    virtual ErrorCode batchGet(uint64_t groupId, uint64_t from, uint64_t to, uint64_t limit,
+                               bcm::GroupUser::Role role, bool supportRrecall,
+                               std::vector<bcm::GroupMsg>& msgs) override;
+
+    virtual ErrorCode recall(const std::string& sourceExtra, const std::string& uid,
+                             uint64_t gid, uint64_t mid, uint64_t& newMid) override;
+
+private:
+    static LocalKey msgKey(uint64_t gid, uint64_t mid);
+    // stores msg with the next mid of its group, the caller holds the row lock of the group
+    ErrorCode append(bcm::GroupMsg& msg, LocalStore::Batch& batch);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,356 @@
+#include "group_user_local_impl.h"
+#include "groups_local_impl.h"
+#include "utils/log.h"
+
+#include <algorithm>
+
+namespace bcm {
+namespace dao {
+
+GroupUsersLocalImpl::GroupUsersLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey GroupUsersLocalImpl::memberKey(uint64_t gid, const std::string& uid)
+{
+    LocalKey key("gu");
+    key.u64(gid).str(uid);
+    return key;
+}
+
+LocalKey GroupUsersLocalImpl::joinedKey(const std::string& uid, uint64_t gid)
+{
+    LocalKey key("ug");
+    key.str(uid).u64(gid);
+    return key;
+}
+
+void GroupUsersLocalImpl::addPut(const bcm::GroupUser& user, LocalStore::Batch& batch)
+{
+    batch.Put(memberKey(user.gid(), user.uid()).key(), user.SerializeAsString());
+    batch.Put(joinedKey(user.uid(), user.gid()).key(), leveldb::Slice());
+}
+
+ErrorCode GroupUsersLocalImpl::scanMembers(uint64_t gid, const std::string& startUid,
+                                           const std::function<bool(const bcm::GroupUser&)>& visitor)
+{
+    LocalKey prefix("gu");
+    prefix.u64(gid);
+    std::string start = startUid.empty() ? std::string() : memberKey(gid, startUid).key();
+    ErrorCode parsed = ErrorCode::ERRORCODE_SUCCESS;
+    ErrorCode ec = m_store->scan(prefix, start, [&](const leveldb::Slice&, const leveldb::Slice& value) {
+        bcm::GroupUser user;
+        if (!user.ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            parsed = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            return false;
+        }
+        return visitor(user);
+    });
+    return ec != ErrorCode::ERRORCODE_SUCCESS ? ec : parsed;
+}
+
+ErrorCode GroupUsersLocalImpl::insert(const bcm::GroupUser& user)
+{
+    LocalStore::Batch batch;
+    addPut(user, batch);
+    return m_store->write(batch);
+}
+
+ErrorCode GroupUsersLocalImpl::insertBatch(const std::vector<bcm::GroupUser>& users)
+{
+    LocalStore::Batch batch;
+    for (const auto& user : users) {
+        addPut(user, batch);
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode GroupUsersLocalImpl::getMemberRole(uint64_t gid, const std::string& uid, bcm::GroupUser::Role& role)
+{
+    bcm::GroupUser user;
+    ErrorCode ec = m_store->get(memberKey(gid, uid), user);
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        role = user.role();
+    }
+    return ec;
+}
+
+ErrorCode GroupUsersLocalImpl::getMemberRoles(uint64_t gid, std::map<std::string, bcm::GroupUser::Role>& userRoles)
+{
+    return scanMembers(gid, "", [&userRoles](const bcm::GroupUser& user) {
+        userRoles.emplace(user.uid(), user.role());
+        return true;
+    });
+}
+
+ErrorCode GroupUsersLocalImpl::delMember(uint64_t gid, const std::string& uid)
+{
+    return delMemberBatch(gid, {uid});
+}
+
+ErrorCode GroupUsersLocalImpl::delMemberBatch(uint64_t gid, const std::vector<std::string>& uids)
+{
+    LocalStore::Batch batch;
+    for (const auto& uid : uids) {
+        batch.Delete(memberKey(gid, uid).key());
+        batch.Delete(joinedKey(uid, gid).key());
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode GroupUsersLocalImpl::getMemberBatch(uint64_t gid, const std::vector<std::string>& uids,
+                                              std::vector<bcm::GroupUser>& users)
+{
+    for (const auto& uid : uids) {
+        bcm::GroupUser user;
+        ErrorCode ec = m_store->get(memberKey(gid, uid), user);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            users.emplace_back(std::move(user));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupUsersLocalImpl::getMemberRangeByRolesBatch(uint64_t gid,
+                                                          const std::vector<bcm::GroupUser::Role>& roles,
+                                                          std::vector<bcm::GroupUser>& users)
+{
+    return scanMembers(gid, "", [&roles, &users](const bcm::GroupUser& user) {
+        if (std::find(roles.begin(), roles.end(), user.role()) != roles.end()) {
+            users.push_back(user);
+        }
+        return true;
+    });
+}
+
+ErrorCode GroupUsersLocalImpl::getMemberRangeByRolesBatchWithOffset(uint64_t gid,
+                                                                    const std::vector<bcm::GroupUser::Role>& roles,
+                                                                    const std::string& startUid, int count,
+                                                                    std::vector<bcm::GroupUser>& users)
+{
+    return scanMembers(gid, startUid, [&](const bcm::GroupUser& user) {
+        if (users.size() >= static_cast<size_t>(std::max(count, 0))) {
+            return false;
+        }
+        if (user.uid() != startUid && std::find(roles.begin(), roles.end(), user.role()) != roles.end()) {
+            users.push_back(user);
+        }
+        return true;
+    });
+}
+
+ErrorCode GroupUsersLocalImpl::getJoinedGroups(const std::string& uid, std::vector<uint64_t>& gids)
+{
+    return m_store->scan(LocalKey("ug").str(uid), "", [&gids](const leveldb::Slice& key, const leveldb::Slice&) {
+        gids.push_back(LocalKey::tailU64(key));
+        return true;
+    });
+}
+
+ErrorCode GroupUsersLocalImpl::getJoinedGroupsList(const std::string& uid, std::vector<UserGroupDetail>& groups)
+{
+    std::vector<uint64_t> gids;
+    ErrorCode ec = getJoinedGroups(uid, gids);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    for (auto gid : gids) {
+        UserGroupDetail detail;
+        ec = getGroupDetailByGid(gid, uid, detail);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            groups.emplace_back(std::move(detail));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupUsersLocalImpl::getGroupDetailByGid(uint64_t gid, const std::string& uid, UserGroupDetail& detail)
+{
+    ErrorCode ec = m_store->get(GroupsLocalImpl::groupKey(gid), detail.group);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    ec = m_store->get(memberKey(gid, uid), detail.user);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return queryGroupMemberInfoByGid(gid, detail.counter);
+}
+
+ErrorCode GroupUsersLocalImpl::getGroupDetailByGidBatch(const std::vector<uint64_t>& gids,
+                                                        const std::string& uid,
+                                                        std::vector<UserGroupEntry>& entries)
+{
+    for (auto gid : gids) {
+        UserGroupDetail detail;
+        ErrorCode ec = getGroupDetailByGid(gid, uid, detail);
+        if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            continue;
+        }
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+        entries.emplace_back();
+        entries.back().group = std::move(detail.group);
+        entries.back().user = std::move(detail.user);
+        entries.back().owner = std::move(detail.counter.owner);
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupUsersLocalImpl::getGroupOwner(uint64_t gid, std::string& owner)
+{
+    GroupCounter counter;
+    ErrorCode ec = queryGroupMemberInfoByGid(gid, counter);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    if (counter.owner.empty()) {
+        return ErrorCode::ERRORCODE_NO_SUCH_DATA;
+    }
+    owner = counter.owner;
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupUsersLocalImpl::getMember(uint64_t gid, const std::string& uid, bcm::GroupUser& user)
+{
+    return m_store->get(memberKey(gid, uid), user);
+}
+
+ErrorCode GroupUsersLocalImpl::queryGroupMemberInfoByGid(uint64_t gid, GroupCounter& counter)
+{
+    counter.owner.clear();
+    counter.memberCnt = 0;
+    counter.subscriberCnt = 0;
+    return scanMembers(gid, "", [&counter](const bcm::GroupUser& user) {
+        if (user.role() == bcm::GroupUser::ROLE_OWNER) {
+            counter.owner = user.uid();
+        }
+        if (user.role() == bcm::GroupUser::ROLE_SUBSCRIBER) {
+            ++counter.subscriberCnt;
+        } else {
+            ++counter.memberCnt;
+        }
+        return true;
+    });
+}
+
+ErrorCode GroupUsersLocalImpl::queryGroupMemberInfoByGid(uint64_t gid,
+                                                         GroupCounter& counter,
+                                                         const std::string& querier,
+                                                         bcm::GroupUser::Role& querierRole,
+                                                         const std::string& nextOwner,
+                                                         bcm::GroupUser::Role& nextOwnerRole)
+{
+    querierRole = bcm::GroupUser::ROLE_UNDEFINE;
+    nextOwnerRole = bcm::GroupUser::ROLE_UNDEFINE;
+    ErrorCode ec = queryGroupMemberInfoByGid(gid, counter);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    ec = getMemberRole(gid, querier, querierRole);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS && ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        return ec;
+    }
+    ec = getMemberRole(gid, nextOwner, nextOwnerRole);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS && ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        return ec;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode GroupUsersLocalImpl::updateMember(uint64_t gid, const std::string& uid,
+                                            const nlohmann::json& upData, bool onlyIfEmpty)
+{
+    std::string key = memberKey(gid, uid);
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    bcm::GroupUser user;
+    ErrorCode ec = m_store->get(key, user);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    int changed = applyJsonFields(upData, user, onlyIfEmpty);
+    if (changed < 0) {
+        LOGE << "invalid group user update: " << upData.dump() << ", gid: " << gid << ", uid: " << uid;
+        return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+    }
+    if (changed == 0 && onlyIfEmpty) {
+        return ErrorCode::ERRORCODE_ALREADY_EXSITED;
+    }
+    return m_store->put(key, user);
+}
+
+ErrorCode GroupUsersLocalImpl::update(uint64_t gid, const std::string& uid, const nlohmann::json& upData)
+{
+    return updateMember(gid, uid, upData, false);
+}
+
+ErrorCode GroupUsersLocalImpl::updateIfEmpty(uint64_t gid, const std::string& uid, const nlohmann::json& upData)
+{
+    return updateMember(gid, uid, upData, true);
+}
+
+ErrorCode GroupUsersLocalImpl::updateLastAckMidBatch(const std::vector<GroupUserAck>& acks)
+{
+    ErrorCode result = ErrorCode::ERRORCODE_SUCCESS;
+    for (const auto& ack : acks) {
+        std::string key = memberKey(ack.gid, ack.uid);
+        std::lock_guard<std::mutex> l(m_store->rowLock(key));
+        bcm::GroupUser user;
+        ErrorCode ec = m_store->get(key, user);
+        if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            continue;
+        }
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            user.set_lastackmid(ack.lastAckMid);
+            ec = m_store->put(key, user);
+        }
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            result = ec;
+        }
+    }
+    return result;
+}
+
+ErrorCode GroupUsersLocalImpl::getMembersOrderByCreateTime(uint64_t gid,
+                                                           const std::vector<bcm::GroupUser::Role>& roles,
+                                                           const std::string& startUid,
+                                                           int64_t createTime,
+                                                           int count,
+                                                           std::vector<bcm::GroupUser>& users)
+{
+    // members are keyed by uid, so every member of the group is looked at
+    std::vector<bcm::GroupUser> candidates;
+    ErrorCode ec = scanMembers(gid, "", [&](const bcm::GroupUser& user) {
+        if (std::find(roles.begin(), roles.end(), user.role()) == roles.end()) {
+            return true;
+        }
+        int64_t userCreateTime = static_cast<int64_t>(user.createtime());
+        if (userCreateTime > createTime || (userCreateTime == createTime && user.uid() > startUid)) {
+            candidates.push_back(user);
+        }
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+
+    auto order = [](const bcm::GroupUser& a, const bcm::GroupUser& b) {
+        if (a.createtime() != b.createtime()) {
+            return a.createtime() < b.createtime();
+        }
+        return a.uid() < b.uid();
+    };
+    size_t n = std::min(candidates.size(), static_cast<size_t>(std::max(count, 0)));
+    std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), order);
+    users.insert(users.end(), candidates.begin(), candidates.begin() + n);
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "dao/group_users.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class GroupUsersLocalImpl : public GroupUsers {
+public:
+    explicit GroupUsersLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode insert(const bcm::GroupUser& user) override;
+
+    virtual ErrorCode insertBatch(const std::vector<bcm::GroupUser>& users) override;
+
+    virtual ErrorCode getMemberRole(uint64_t gid, const std::string& uid, bcm::GroupUser::Role& role) override;
+
+    virtual ErrorCode getMemberRoles(uint64_t gid, std::map<std::string, bcm::GroupUser::Role>& userRoles) override;
+
+    virtual ErrorCode delMember(uint64_t gid, const std::string& uid) override;
+
+    virtual ErrorCode delMemberBatch(uint64_t gid, const std::vector<std::string>& uids) override;
+
+    virtual ErrorCode getMemberBatch(uint64_t gid, const std::vector<std::string>& uids,
+                                     std::vector<bcm::GroupUser>& users) override;
+
+    virtual ErrorCode getMemberRangeByRolesBatch(uint64_t gid,
+                                                 const std::vector<bcm::GroupUser::Role>& roles,
+                                                 std::vector<bcm::GroupUser>& users) override;
+
+    virtual ErrorCode getMemberRangeByRolesBatchWithOffset(uint64_t gid,
+                                                           const std::vector<bcm::GroupUser::Role>& roles,
+                                                           const std::string& startUid, int count,
+                                                           std::vector<bcm::GroupUser>& users) override;
+
+    virtual ErrorCode getJoinedGroupsList(const std::string& uid, std::vector<UserGroupDetail>& groups) override;
+
+    virtual ErrorCode getJoinedGroups(const std::string& uid, std::vector<uint64_t>& gids) override;
+
+    virtual ErrorCode getGroupDetailByGid(uint64_t gid, const std::string& uid, UserGroupDetail& detail) override;
+
+    virtual ErrorCode getGroupDetailByGidBatch(const std::vector<uint64_t>& gids,
+                                               const std::string& uid,
+                                               std::vector<UserGroupEntry>& entries) override;
+
+    virtual ErrorCode getGroupOwner(uint64_t gid, std::string& owner) override;
+
+    virtual ErrorCode getMember(uint64_t gid, const std::string& uid, bcm::GroupUser& user) override;
+
+    virtual ErrorCode queryGroupMemberInfoByGid(uint64_t gid, GroupCounter& counter) override;
+
+    virtual ErrorCode queryGroupMemberInfoByGid(uint64_t gid,
+                                                GroupCounter& counter,
+                                                const std::string& querier,
+                                                bcm::GroupUser::Role& querierRole,
+                                                const std::string& nextOwner,
+                                                bcm::GroupUser::Role& nextOwnerRole) override;
+
+    virtual ErrorCode update(uint64_t gid, const std::string& uid, const nlohmann::json& upData) override;
+
+    // ERRORCODE_ALREADY_EXSITED if every column of upData already has a value
+    virtual ErrorCode updateIfEmpty(uint64_t gid, const std::string& uid, const nlohmann::json& upData) override;
+
+    virtual ErrorCode updateLastAckMidBatch(const std::vector<GroupUserAck>& acks) override;
+
+    virtual ErrorCode getMembersOrderByCreateTime(uint64_t gid,
+                                                  const std::vector<bcm::GroupUser::Role>& roles,
+                                                  const std::string& startUid,
+                                                  int64_t createTime,
+                                                  int count,
+                                                  std::vector<bcm::GroupUser>& users) override;
+
+private:
+    // members of a group live under "gu/gid", the groups of a user are indexed under "ug/uid"
+    static LocalKey memberKey(uint64_t gid, const std::string& uid);
+    static LocalKey joinedKey(const std::string& uid, uint64_t gid);
+
+    // visits the members of gid in uid order, from startUid on if it is not empty
+    ErrorCode scanMembers(uint64_t gid, const std::string& startUid,
+                          const std::function<bool(const bcm::GroupUser&)>& visitor);
+    ErrorCode updateMember(uint64_t gid, const std::string& uid, const nlohmann::json& upData, bool onlyIfEmpty);
+    static void addPut(const bcm::GroupUser& user, LocalStore::Batch& batch);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
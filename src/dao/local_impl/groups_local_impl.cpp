@@ -0,0 +1,87 @@
+#include "groups_local_impl.h"
+#include "utils/log.h"
+
+namespace bcm {
+namespace dao {
+
+GroupsLocalImpl::GroupsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey GroupsLocalImpl::groupKey(uint64_t gid)
+{
+    LocalKey key("grp");
+    key.u64(gid);
+    return key;
+}
+
+ErrorCode GroupsLocalImpl::create(const bcm::Group& group, uint64_t& gid)
+{
+    ErrorCode ec = m_store->nextId("gid", gid);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    bcm::Group stored(group);
+    stored.set_gid(gid);
+    return m_store->put(groupKey(gid), stored);
+}
+
+ErrorCode GroupsLocalImpl::get(uint64_t gid, bcm::Group& group)
+{
+    return m_store->get(groupKey(gid), group);
+}
+
+ErrorCode GroupsLocalImpl::update(uint64_t gid, const nlohmann::json& upData)
+{
+    std::string key = groupKey(gid);
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    bcm::Group group;
+    ErrorCode ec = m_store->get(key, group);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    if (applyJsonFields(upData, group) < 0) {
+        LOGE << "invalid group update: " << upData.dump() << ", gid: " << gid;
+        return ErrorCode::ERRORCODE_PARAM_INCORRECT;
+    }
+    return m_store->put(key, group);
+}
+
+ErrorCode GroupsLocalImpl::del(uint64_t gid)
+{
+    std::string key = groupKey(gid);
+    std::lock_guard<std::mutex> l(m_store->rowLock(key));
+    ErrorCode ec = m_store->delPrefix(LocalKey("gext").u64(gid));
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return m_store->del(key);
+}
+
+ErrorCode GroupsLocalImpl::setGroupExtensionInfo(const uint64_t gid, const std::map<std::string, std::string>& info)
+{
+    LocalStore::Batch batch;
+    for (const auto& item : info) {
+        batch.Put(LocalKey("gext").u64(gid).str(item.first).key(), item.second);
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode GroupsLocalImpl::getGroupExtensionInfo(const uint64_t gid, const std::set<std::string>& extensionKeys,
+                                                 std::map<std::string, std::string>& info)
+{
+    for (const auto& extensionKey : extensionKeys) {
+        std::string value;
+        ErrorCode ec = m_store->get(LocalKey("gext").u64(gid).str(extensionKey), value);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            info.emplace(extensionKey, std::move(value));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+}  // namespace dao
+}  // namespace bcm
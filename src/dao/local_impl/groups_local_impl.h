@@ -0,0 +1,35 @@
+#pragma once
+
+#include "dao/groups.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class GroupsLocalImpl : public Groups {
+public:
+    explicit GroupsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode create(const bcm::Group& group, uint64_t& gid) override;
+
+    virtual ErrorCode get(uint64_t gid, bcm::Group& group) override;
+
+    virtual ErrorCode update(uint64_t gid, const nlohmann::json& upData) override;
+
+    virtual ErrorCode del(uint64_t gid) override;
+
+    virtual ErrorCode setGroupExtensionInfo(const uint64_t gid, const std::map<std::string, std::string>& info) override;
+
+    virtual ErrorCode getGroupExtensionInfo(const uint64_t gid, const std::set<std::string>& extensionKeys,
+                                            std::map<std::string, std::string>& info) override;
+
+    // the row of a group, writers of the group hold its row lock
+    static LocalKey groupKey(uint64_t gid);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
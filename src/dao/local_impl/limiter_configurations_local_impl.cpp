@@ -0,0 +1,73 @@
+#include "limiter_configurations_local_impl.h"
+#include "utils/log.h"
+
+#include <sstream>
+
+namespace bcm {
+namespace dao {
+
+// rules are stored as "period:count", the same as in the dao server
+static bool toLimitRule(const std::string& value, LimitRule& rule)
+{
+    std::istringstream iss(value);
+    char separator = 0;
+    iss >> rule.period >> separator >> rule.count;
+    return !iss.fail() && separator == ':';
+}
+
+static std::string fromLimitRule(const LimitRule& rule)
+{
+    std::ostringstream oss;
+    oss << rule.period << ":" << rule.count;
+    return oss.str();
+}
+
+LimiterConfigurationsLocalImpl::LimiterConfigurationsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode LimiterConfigurationsLocalImpl::load(LimiterConfigs& configs)
+{
+    LocalKey prefix("limcfg");
+    return m_store->scan(prefix, "", [&configs, &prefix](const leveldb::Slice& key, const leveldb::Slice& value) {
+        LimitRule rule;
+        if (toLimitRule(value.ToString(), rule)) {
+            configs.emplace(LocalKey::tailString(key, prefix), rule);
+        } else {
+            LOGE << "invalid limiter configuration: " << value.ToString();
+        }
+        return true;
+    });
+}
+
+ErrorCode LimiterConfigurationsLocalImpl::get(const std::set<std::string>& keys, LimiterConfigs& configs)
+{
+    for (const auto& key : keys) {
+        std::string value;
+        ErrorCode ec = m_store->get(LocalKey("limcfg").str(key), value);
+        if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            continue;
+        }
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+        LimitRule rule;
+        if (toLimitRule(value, rule)) {
+            configs.emplace(key, rule);
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LimiterConfigurationsLocalImpl::set(const LimiterConfigs& configs)
+{
+    LocalStore::Batch batch;
+    for (const auto& item : configs) {
+        batch.Put(LocalKey("limcfg").str(item.first).key(), fromLimitRule(item.second));
+    }
+    return m_store->write(batch);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "dao/limiter_configurations.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class LimiterConfigurationsLocalImpl : public LimiterConfigurations {
+public:
+    explicit LimiterConfigurationsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode load(LimiterConfigs& configs) override;
+
+    virtual ErrorCode get(const std::set<std::string>& keys, LimiterConfigs& configs) override;
+
+    virtual ErrorCode set(const LimiterConfigs& configs) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
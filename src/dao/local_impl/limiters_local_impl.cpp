@@ -0,0 +1,36 @@
+#include "limiters_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+LimitersLocalImpl::LimitersLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode LimitersLocalImpl::getLimiters(const std::set<std::string>& keys,
+                                         std::map<std::string, bcm::Limiter>& limiters)
+{
+    for (const auto& key : keys) {
+        bcm::Limiter limiter;
+        ErrorCode ec = m_store->get(LocalKey("lim").str(key), limiter);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            limiters.emplace(key, std::move(limiter));
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LimitersLocalImpl::setLimiters(const std::map<std::string, bcm::Limiter>& limiters)
+{
+    LocalStore::Batch batch;
+    for (const auto& item : limiters) {
+        batch.Put(LocalKey("lim").str(item.first).key(), item.second.SerializeAsString());
+    }
+    return m_store->write(batch);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dao/limiters.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class LimitersLocalImpl : public Limiters {
+public:
+    explicit LimitersLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode getLimiters(const std::set<std::string>& keys,
+                                  std::map<std::string, bcm::Limiter>& limiters) override;
+
+    virtual ErrorCode setLimiters(const std::map<std::string, bcm::Limiter>& limiters) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
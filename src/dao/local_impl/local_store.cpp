@@ -0,0 +1,285 @@
+#include "local_store.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <boost/algorithm/string/erase.hpp>
+
+namespace bcm {
+namespace dao {
+
+constexpr size_t LocalStore::kRowLocks;
+
+std::shared_ptr<LocalStore> LocalStore::open(const DaoConfig& config)
+{
+    std::shared_ptr<LocalStore> store(new LocalStore(config));
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.block_cache = store->m_cache.get();
+    options.filter_policy = store->m_filterPolicy.get();
+    options.write_buffer_size = static_cast<size_t>(config.local.writeBufferMB) << 20;
+
+    leveldb::DB* db = nullptr;
+    leveldb::Status status = leveldb::DB::Open(options, config.local.path, &db);
+    if (!status.ok()) {
+        LOGE << "failed to open local dao database " << config.local.path << ": " << status.ToString();
+        return nullptr;
+    }
+    store->m_db.reset(db);
+    LOGI << "local dao database opened: " << config.local.path;
+    return store;
+}
+
+LocalStore::LocalStore(const DaoConfig& config)
+    : m_cache(leveldb::NewLRUCache(static_cast<size_t>(config.local.cacheSizeMB) << 20))
+    , m_filterPolicy(leveldb::NewBloomFilterPolicy(10))
+{
+    m_writeOptions.sync = config.local.sync;
+}
+
+LocalStore::~LocalStore()
+{
+    m_db.reset();
+}
+
+ErrorCode LocalStore::get(const std::string& key, std::string& value)
+{
+    leveldb::Status status = m_db->Get(leveldb::ReadOptions(), key, &value);
+    if (status.IsNotFound()) {
+        return ErrorCode::ERRORCODE_NO_SUCH_DATA;
+    }
+    if (!status.ok()) {
+        LOGE << "local dao get failed: " << status.ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::get(const std::string& key, google::protobuf::Message& msg)
+{
+    std::string value;
+    ErrorCode ec = get(key, value);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    if (!msg.ParseFromString(value)) {
+        LOGE << "local dao failed to parse " << msg.GetTypeName();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::put(const std::string& key, const std::string& value)
+{
+    leveldb::Status status = m_db->Put(m_writeOptions, key, value);
+    if (!status.ok()) {
+        LOGE << "local dao put failed: " << status.ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::put(const std::string& key, const google::protobuf::Message& msg)
+{
+    return put(key, msg.SerializeAsString());
+}
+
+ErrorCode LocalStore::del(const std::string& key)
+{
+    leveldb::Status status = m_db->Delete(m_writeOptions, key);
+    if (!status.ok()) {
+        LOGE << "local dao delete failed: " << status.ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::write(Batch& batch)
+{
+    leveldb::Status status = m_db->Write(m_writeOptions, &batch);
+    if (!status.ok()) {
+        LOGE << "local dao write failed: " << status.ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::scan(const std::string& prefix, const std::string& start, const Visitor& visitor)
+{
+    std::unique_ptr<leveldb::Iterator> it(m_db->NewIterator(leveldb::ReadOptions()));
+    for (it->Seek(start.empty() ? prefix : start); it->Valid() && it->key().starts_with(prefix); it->Next()) {
+        if (!visitor(it->key(), it->value())) {
+            break;
+        }
+    }
+    if (!it->status().ok()) {
+        LOGE << "local dao scan failed: " << it->status().ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::scanReverse(const std::string& prefix, const Visitor& visitor)
+{
+    std::unique_ptr<leveldb::Iterator> it(m_db->NewIterator(leveldb::ReadOptions()));
+    // LocalKey prefixes end with a separator or a 0 terminator, never with 0xff
+    std::string end = prefix;
+    end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+    it->Seek(end);
+    if (it->Valid()) {
+        it->Prev();
+    } else {
+        it->SeekToLast();
+    }
+    for (; it->Valid() && it->key().starts_with(prefix); it->Prev()) {
+        if (!visitor(it->key(), it->value())) {
+            break;
+        }
+    }
+    if (!it->status().ok()) {
+        LOGE << "local dao scan failed: " << it->status().ToString();
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode LocalStore::delPrefix(const std::string& prefix)
+{
+    Batch batch;
+    ErrorCode ec = scan(prefix, "", [&batch](const leveldb::Slice& key, const leveldb::Slice&) {
+        batch.Delete(key);
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return write(batch);
+}
+
+ErrorCode LocalStore::nextId(const std::string& name, uint64_t& id)
+{
+    std::string key = LocalKey("seq").str(name);
+    std::lock_guard<std::mutex> l(rowLock(key));
+    std::string value;
+    ErrorCode ec = get(key, value);
+    if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        id = 1;
+    } else if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        id = std::stoull(value) + 1;
+    } else {
+        return ec;
+    }
+    return put(key, std::to_string(id));
+}
+
+std::mutex& LocalStore::rowLock(const std::string& key)
+{
+    return m_rowLocks[std::hash<std::string>()(key) % kRowLocks];
+}
+
+LocalKey::LocalKey(const char* table)
+    : m_key(table)
+{
+    m_key.push_back('/');
+}
+
+LocalKey& LocalKey::u64(uint64_t value)
+{
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        m_key.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+    return *this;
+}
+
+LocalKey& LocalKey::i64(int64_t value)
+{
+    // flip the sign bit so negative values sort first
+    return u64(static_cast<uint64_t>(value) ^ (1ULL << 63));
+}
+
+LocalKey& LocalKey::str(const std::string& value)
+{
+    m_key.append(value);
+    m_key.push_back('\0');
+    return *this;
+}
+
+std::string LocalKey::tailString(const leveldb::Slice& key, const std::string& prefix)
+{
+    if (key.size() <= prefix.size()) {
+        return "";
+    }
+    return std::string(key.data() + prefix.size(), key.size() - prefix.size() - 1);
+}
+
+uint64_t LocalKey::tailU64(const leveldb::Slice& key)
+{
+    uint64_t value = 0;
+    if (key.size() < sizeof(value)) {
+        return value;
+    }
+    const char* p = key.data() + key.size() - sizeof(value);
+    for (size_t i = 0; i < sizeof(value); ++i) {
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    }
+    return value;
+}
+
+int applyJsonFields(const nlohmann::json& data, google::protobuf::Message& msg, bool onlyIfEmpty)
+{
+    using google::protobuf::FieldDescriptor;
+
+    const google::protobuf::Descriptor* descriptor = msg.GetDescriptor();
+    const google::protobuf::Reflection* reflection = msg.GetReflection();
+    int changed = 0;
+    for (auto it = data.begin(); it != data.end(); ++it) {
+        std::string name = it.key();
+        boost::algorithm::erase_all(name, "_");
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        const FieldDescriptor* field = descriptor->FindFieldByLowercaseName(name);
+        if (field == nullptr || field->is_repeated()) {
+            LOGE << msg.GetTypeName() << " has no column " << it.key();
+            return -1;
+        }
+        if (onlyIfEmpty && reflection->HasField(msg, field)) {
+            continue;
+        }
+
+        const nlohmann::json& value = it.value();
+        try {
+            switch (field->cpp_type()) {
+            case FieldDescriptor::CPPTYPE_INT32:
+                reflection->SetInt32(&msg, field, value.get<int32_t>());
+                break;
+            case FieldDescriptor::CPPTYPE_INT64:
+                reflection->SetInt64(&msg, field, value.get<int64_t>());
+                break;
+            case FieldDescriptor::CPPTYPE_UINT32:
+                reflection->SetUInt32(&msg, field, value.get<uint32_t>());
+                break;
+            case FieldDescriptor::CPPTYPE_UINT64:
+                reflection->SetUInt64(&msg, field, value.get<uint64_t>());
+                break;
+            case FieldDescriptor::CPPTYPE_BOOL:
+                reflection->SetBool(&msg, field, value.is_boolean() ? value.get<bool>() : value.get<int>() != 0);
+                break;
+            case FieldDescriptor::CPPTYPE_STRING:
+                reflection->SetString(&msg, field, value.get<std::string>());
+                break;
+            case FieldDescriptor::CPPTYPE_ENUM:
+                reflection->SetEnumValue(&msg, field, value.get<int>());
+                break;
+            default:
+                LOGE << msg.GetTypeName() << " column " << it.key() << " can not be set from json";
+                return -1;
+            }
+        } catch (const std::exception& e) {
+            LOGE << msg.GetTypeName() << " column " << it.key() << ": " << e.what();
+            return -1;
+        }
+        ++changed;
+    }
+    return changed;
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <google/protobuf/message.h>
+#include <leveldb/cache.h>
+#include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/write_batch.h>
+#include <nlohmann/json.hpp>
+
+#include "config/dao_config.h"
+#include "proto/dao/error_code.pb.h"
+
+namespace bcm {
+namespace dao {
+
+// leveldb database behind the LOCAL dao implementations, each implementation keeps
+// its rows under its own table prefix built with LocalKey. Single reads and writes
+// are atomic, read-modify-write sequences hold the row lock of the row they change.
+class LocalStore {
+public:
+    typedef leveldb::WriteBatch Batch;
+    // return false to stop the scan
+    typedef std::function<bool(const leveldb::Slice& key, const leveldb::Slice& value)> Visitor;
+
+    static std::shared_ptr<LocalStore> open(const DaoConfig& config);
+
+    ~LocalStore();
+
+    // ERRORCODE_NO_SUCH_DATA if key does not exist
+    ErrorCode get(const std::string& key, std::string& value);
+    ErrorCode get(const std::string& key, google::protobuf::Message& msg);
+
+    ErrorCode put(const std::string& key, const std::string& value);
+    ErrorCode put(const std::string& key, const google::protobuf::Message& msg);
+    ErrorCode del(const std::string& key);
+    ErrorCode write(Batch& batch);
+
+    // visits the rows under prefix in key order, from start on if it is not empty
+    ErrorCode scan(const std::string& prefix, const std::string& start, const Visitor& visitor);
+    // visits the rows under prefix in reverse key order
+    ErrorCode scanReverse(const std::string& prefix, const Visitor& visitor);
+    // deletes every row under prefix
+    ErrorCode delPrefix(const std::string& prefix);
+
+    // persistent sequence, the first id is 1
+    ErrorCode nextId(const std::string& name, uint64_t& id);
+
+    // serializes read-modify-write sequences on key, locks are striped so hold only
+    // one at a time
+    std::mutex& rowLock(const std::string& key);
+
+private:
+    LocalStore(const DaoConfig& config);
+
+private:
+    static constexpr size_t kRowLocks = 64;
+
+    // the db is closed first, it uses the cache and the filter policy
+    std::unique_ptr<leveldb::Cache> m_cache;
+    std::unique_ptr<const leveldb::FilterPolicy> m_filterPolicy;
+    std::unique_ptr<leveldb::DB> m_db;
+    leveldb::WriteOptions m_writeOptions;
+    std::array<std::mutex, kRowLocks> m_rowLocks;
+};
+
+// Keys whose byte order follows their parts, so rows of a table come out of a scan
+// in the order of their ids: integers are fixed width big endian, strings are 0
+// terminated.
+class LocalKey {
+public:
+    explicit LocalKey(const char* table);
+
+    LocalKey& u64(uint64_t value);
+    LocalKey& i64(int64_t value);
+    LocalKey& str(const std::string& value);
+
+    const std::string& key() const
+    {
+        return m_key;
+    }
+
+    operator const std::string&() const
+    {
+        return m_key;
+    }
+
+    // the string part at the end of a key under prefix
+    static std::string tailString(const leveldb::Slice& key, const std::string& prefix);
+    // the integer part at the end of a key
+    static uint64_t tailU64(const leveldb::Slice& key);
+
+private:
+    std::string m_key;
+};
+
+// Applies a json object of column names to the fields of msg, "last_ack_mid" sets
+// the field lastAckMid. Fields already holding a non default value are skipped when
+// onlyIfEmpty. Returns the number of fields changed, -1 if a column has no field or
+// a value of the wrong type.
+int applyJsonFields(const nlohmann::json& data, google::protobuf::Message& msg, bool onlyIfEmpty = false);
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,121 @@
+#include "onetime_keys_local_impl.h"
+
+#include <set>
+#include <boost/core/ignore_unused.hpp>
+
+namespace bcm {
+namespace dao {
+
+OnetimeKeysLocalImpl::OnetimeKeysLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey OnetimeKeysLocalImpl::devicePrefix(const std::string& uid, uint32_t deviceId)
+{
+    LocalKey key("otk");
+    key.str(uid).u64(deviceId);
+    return key;
+}
+
+ErrorCode OnetimeKeysLocalImpl::pop(const std::string& uid, uint32_t deviceId, bcm::OnetimeKey& key)
+{
+    std::string found;
+    ErrorCode ec = m_store->scan(devicePrefix(uid, deviceId), "",
+                                 [&found, &key](const leveldb::Slice& k, const leveldb::Slice& value) {
+        if (key.ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            found = k.ToString();
+        }
+        return false;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    if (found.empty()) {
+        return ErrorCode::ERRORCODE_NO_SUCH_DATA;
+    }
+    return m_store->del(found);
+}
+
+ErrorCode OnetimeKeysLocalImpl::get(const std::string& uid, std::vector<bcm::OnetimeKey>& keys)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("otk").str(uid)));
+
+    std::set<uint32_t> devices;
+    ErrorCode ec = m_store->scan(LocalKey("otk").str(uid), "",
+                                 [&devices](const leveldb::Slice& k, const leveldb::Slice&) {
+        // the device id sits right before the key id
+        leveldb::Slice device(k.data(), k.size() - sizeof(uint64_t));
+        devices.insert(static_cast<uint32_t>(LocalKey::tailU64(device)));
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+
+    for (auto deviceId : devices) {
+        bcm::OnetimeKey key;
+        ec = pop(uid, deviceId, key);
+        if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+            keys.push_back(key);
+        } else if (ec != ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            return ec;
+        }
+    }
+    return keys.empty() ? ErrorCode::ERRORCODE_NO_SUCH_DATA : ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode OnetimeKeysLocalImpl::get(const std::string& uid, uint32_t deviceId, bcm::OnetimeKey& key)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("otk").str(uid)));
+    return pop(uid, deviceId, key);
+}
+
+ErrorCode OnetimeKeysLocalImpl::getCount(const std::string& uid, uint32_t deviceId, uint32_t& count)
+{
+    count = 0;
+    return m_store->scan(devicePrefix(uid, deviceId), "", [&count](const leveldb::Slice&, const leveldb::Slice&) {
+        ++count;
+        return true;
+    });
+}
+
+ErrorCode OnetimeKeysLocalImpl::set(const std::string& uid, uint32_t deviceId,
+                                    const std::vector<bcm::OnetimeKey>& keys,
+                                    const std::string& identityKey,
+                                    const bcm::SignedPreKey& signedPreKey)
+{
+    boost::ignore_unused(identityKey, signedPreKey);
+
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("otk").str(uid)));
+    LocalStore::Batch batch;
+    ErrorCode ec = m_store->scan(devicePrefix(uid, deviceId), "", [&batch](const leveldb::Slice& k, const leveldb::Slice&) {
+        batch.Delete(k);
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    for (const auto& key : keys) {
+        bcm::OnetimeKey stored(key);
+        stored.set_uid(uid);
+        stored.set_deviceid(deviceId);
+        batch.Put(devicePrefix(uid, deviceId).u64(key.keyid()).key(), stored.SerializeAsString());
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode OnetimeKeysLocalImpl::clear(const std::string& uid)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("otk").str(uid)));
+    return m_store->delPrefix(LocalKey("otk").str(uid));
+}
+
+ErrorCode OnetimeKeysLocalImpl::clear(const std::string& uid, uint32_t deviceId)
+{
+    std::lock_guard<std::mutex> l(m_store->rowLock(LocalKey("otk").str(uid)));
+    return m_store->delPrefix(devicePrefix(uid, deviceId));
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "dao/onetime_keys.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class OnetimeKeysLocalImpl : public OnetimeKeys {
+public:
+    explicit OnetimeKeysLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode get(const std::string& uid, std::vector<bcm::OnetimeKey>& keys) override;
+
+    virtual ErrorCode get(const std::string& uid, uint32_t deviceId, bcm::OnetimeKey& key) override;
+
+    virtual ErrorCode getCount(const std::string& uid, uint32_t deviceId, uint32_t& count) override;
+
+    // identityKey and signedPreKey are kept with the account, which the caller updates
+    virtual ErrorCode set(const std::string& uid, uint32_t deviceId,
+                          const std::vector<bcm::OnetimeKey>& keys,
+                          const std::string& identityKey,
+                          const bcm::SignedPreKey& signedPreKey) override;
+
+    virtual ErrorCode clear(const std::string& uid) override;
+
+    virtual ErrorCode clear(const std::string& uid, uint32_t deviceId) override;
+
+private:
+    static LocalKey devicePrefix(const std::string& uid, uint32_t deviceId);
+    // pops the first key of the device, the caller holds the lock of the uid
+    ErrorCode pop(const std::string& uid, uint32_t deviceId, bcm::OnetimeKey& key);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
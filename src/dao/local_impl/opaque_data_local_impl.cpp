@@ -0,0 +1,22 @@
+#include "opaque_data_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+OpaqueDataLocalImpl::OpaqueDataLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode OpaqueDataLocalImpl::setOpaque(const std::string& key, const std::string& value)
+{
+    return m_store->put(LocalKey("op").str(key), value);
+}
+
+ErrorCode OpaqueDataLocalImpl::getOpaque(const std::string& key, std::string& value)
+{
+    return m_store->get(LocalKey("op").str(key), value);
+}
+
+}  // namespace dao
+}  // namespace bcm
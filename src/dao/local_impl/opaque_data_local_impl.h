@@ -0,0 +1,23 @@
+#pragma once
+
+#include "dao/opaque_data.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class OpaqueDataLocalImpl : public OpaqueData {
+public:
+    explicit OpaqueDataLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode setOpaque(const std::string& key, const std::string& value) override;
+
+    virtual ErrorCode getOpaque(const std::string& key, std::string& value) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,60 @@
+#include "pending_group_user_local_impl.h"
+
+#include <algorithm>
+
+namespace bcm {
+namespace dao {
+
+PendingGroupUsersLocalImpl::PendingGroupUsersLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode PendingGroupUsersLocalImpl::set(const PendingGroupUser& user)
+{
+    return m_store->put(LocalKey("pgu").u64(user.gid()).str(user.uid()), user);
+}
+
+ErrorCode PendingGroupUsersLocalImpl::query(uint64_t gid,
+                                            const std::string& startUid,
+                                            int count,
+                                            std::vector<PendingGroupUser>& result)
+{
+    LocalKey prefix("pgu");
+    prefix.u64(gid);
+    std::string start = startUid.empty() ? std::string() : LocalKey("pgu").u64(gid).str(startUid).key();
+    size_t limit = static_cast<size_t>(std::max(count, 0));
+    ErrorCode parsed = ErrorCode::ERRORCODE_SUCCESS;
+    ErrorCode ec = m_store->scan(prefix, start, [&](const leveldb::Slice& key, const leveldb::Slice& value) {
+        if (result.size() >= limit) {
+            return false;
+        }
+        if (!start.empty() && key == start) {
+            return true;
+        }
+        result.emplace_back();
+        if (!result.back().ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            parsed = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            return false;
+        }
+        return true;
+    });
+    return ec != ErrorCode::ERRORCODE_SUCCESS ? ec : parsed;
+}
+
+ErrorCode PendingGroupUsersLocalImpl::del(uint64_t gid, std::set<std::string> uids)
+{
+    LocalStore::Batch batch;
+    for (const auto& uid : uids) {
+        batch.Delete(LocalKey("pgu").u64(gid).str(uid).key());
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode PendingGroupUsersLocalImpl::clear(uint64_t gid)
+{
+    return m_store->delPrefix(LocalKey("pgu").u64(gid));
+}
+
+}  // namespace dao
+}  // namespace bcm
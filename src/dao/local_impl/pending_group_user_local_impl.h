@@ -0,0 +1,31 @@
+#pragma once
+
+#include "dao/pending_group_users.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class PendingGroupUsersLocalImpl : public PendingGroupUsers {
+public:
+    explicit PendingGroupUsersLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode set(const PendingGroupUser& user) override;
+
+    // users after startUid in uid order
+    virtual ErrorCode query(uint64_t gid,
+                            const std::string& startUid,
+                            int count,
+                            std::vector<PendingGroupUser>& result) override;
+
+    virtual ErrorCode del(uint64_t gid, std::set<std::string> uids) override;
+
+    virtual ErrorCode clear(uint64_t gid) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
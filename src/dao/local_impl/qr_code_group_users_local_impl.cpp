@@ -0,0 +1,49 @@
+#include "qr_code_group_users_local_impl.h"
+#include "utils/time.h"
+
+namespace bcm {
+namespace dao {
+
+QrCodeGroupUsersLocalImpl::QrCodeGroupUsersLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+// a row is the expiry time in milliseconds followed by the user
+ErrorCode QrCodeGroupUsersLocalImpl::set(const bcm::QrCodeGroupUser& user, int64_t ttl)
+{
+    int64_t expireAt = nowInMilli() + ttl * 1000;
+    std::string value(reinterpret_cast<const char*>(&expireAt), sizeof(expireAt));
+    if (!user.AppendToString(&value)) {
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return m_store->put(LocalKey("qr").u64(user.gid()).str(user.uid()), value);
+}
+
+ErrorCode QrCodeGroupUsersLocalImpl::get(uint64_t gid, const std::string& uid, bcm::QrCodeGroupUser& user)
+{
+    LocalKey key("qr");
+    key.u64(gid).str(uid);
+    std::string value;
+    ErrorCode ec = m_store->get(key, value);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+
+    int64_t expireAt = 0;
+    if (value.size() < sizeof(expireAt)) {
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    std::copy(value.data(), value.data() + sizeof(expireAt), reinterpret_cast<char*>(&expireAt));
+    if (expireAt <= nowInMilli()) {
+        m_store->del(key);
+        return ErrorCode::ERRORCODE_NO_SUCH_DATA;
+    }
+    if (!user.ParseFromArray(value.data() + sizeof(expireAt), static_cast<int>(value.size() - sizeof(expireAt)))) {
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+}  // namespace dao
+}  // namespace bcm
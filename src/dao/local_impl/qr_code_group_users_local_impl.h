@@ -0,0 +1,24 @@
+#pragma once
+
+#include "dao/qr_code_group_users.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class QrCodeGroupUsersLocalImpl : public QrCodeGroupUsers {
+public:
+    explicit QrCodeGroupUsersLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // ttl in seconds, an expired user is dropped by the next get
+    virtual ErrorCode set(const bcm::QrCodeGroupUser& user, int64_t ttl) override;
+
+    virtual ErrorCode get(uint64_t gid, const std::string& uid, bcm::QrCodeGroupUser& user) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
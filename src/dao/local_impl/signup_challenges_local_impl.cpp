@@ -0,0 +1,27 @@
+#include "signup_challenges_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+SignupChallengesLocalImpl::SignupChallengesLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode SignupChallengesLocalImpl::get(const std::string& uid, bcm::SignUpChallenge& challenge)
+{
+    return m_store->get(LocalKey("suc").str(uid), challenge);
+}
+
+ErrorCode SignupChallengesLocalImpl::set(const std::string& uid, const bcm::SignUpChallenge& challenge)
+{
+    return m_store->put(LocalKey("suc").str(uid), challenge);
+}
+
+ErrorCode SignupChallengesLocalImpl::del(const std::string& uid)
+{
+    return m_store->del(LocalKey("suc").str(uid));
+}
+
+}  // namespace dao
+}  // namespace bcm
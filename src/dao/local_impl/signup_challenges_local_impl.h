@@ -0,0 +1,25 @@
+#pragma once
+
+#include "dao/sign_up_challenges.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class SignupChallengesLocalImpl : public SignUpChallenges {
+public:
+    explicit SignupChallengesLocalImpl(std::shared_ptr<LocalStore> store);
+
+    virtual ErrorCode get(const std::string& uid, bcm::SignUpChallenge& challenge) override;
+
+    virtual ErrorCode set(const std::string& uid, const bcm::SignUpChallenge& challenge) override;
+
+    virtual ErrorCode del(const std::string& uid) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,179 @@
+#include "stored_messages_local_impl.h"
+
+#include <map>
+#include <set>
+
+namespace bcm {
+namespace dao {
+
+StoredMessagesLocalImpl::StoredMessagesLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+LocalKey StoredMessagesLocalImpl::msgPrefix(const std::string& destination, uint32_t deviceId)
+{
+    LocalKey key("sm");
+    key.str(destination).u64(deviceId);
+    return key;
+}
+
+LocalKey StoredMessagesLocalImpl::deviceIndexKey(const std::string& destination, uint64_t id)
+{
+    LocalKey key("smd");
+    key.str(destination).u64(id);
+    return key;
+}
+
+LocalKey StoredMessagesLocalImpl::countKey(const std::string& destination, uint32_t deviceId)
+{
+    LocalKey key("smc");
+    key.str(destination).u64(deviceId);
+    return key;
+}
+
+ErrorCode StoredMessagesLocalImpl::count(const std::string& destination, uint32_t deviceId, uint32_t& count)
+{
+    std::string value;
+    ErrorCode ec = m_store->get(countKey(destination, deviceId), value);
+    if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+        count = 0;
+        return ErrorCode::ERRORCODE_SUCCESS;
+    }
+    if (ec == ErrorCode::ERRORCODE_SUCCESS) {
+        count = static_cast<uint32_t>(std::stoul(value));
+    }
+    return ec;
+}
+
+ErrorCode StoredMessagesLocalImpl::set(const bcm::StoredMessage& msg, uint32_t& unreadMsgCount)
+{
+    uint64_t id = 0;
+    ErrorCode ec = m_store->nextId("stored_message", id);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    bcm::StoredMessage stored(msg);
+    stored.set_id(id);
+
+    // the count of a destination device only changes under its lock
+    std::string counter = countKey(msg.destination(), msg.destinationdeviceid());
+    std::lock_guard<std::mutex> l(m_store->rowLock(counter));
+    ec = count(msg.destination(), msg.destinationdeviceid(), unreadMsgCount);
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    ++unreadMsgCount;
+
+    LocalStore::Batch batch;
+    batch.Put(msgPrefix(msg.destination(), msg.destinationdeviceid()).u64(id).key(), stored.SerializeAsString());
+    batch.Put(deviceIndexKey(msg.destination(), id).key(), std::to_string(msg.destinationdeviceid()));
+    batch.Put(counter, std::to_string(unreadMsgCount));
+    return m_store->write(batch);
+}
+
+ErrorCode StoredMessagesLocalImpl::get(const std::string& destination,
+                                       uint32_t destinationDeviceId,
+                                       uint32_t maxCount,
+                                       std::vector<bcm::StoredMessage>& msgs)
+{
+    ErrorCode parsed = ErrorCode::ERRORCODE_SUCCESS;
+    ErrorCode ec = m_store->scan(msgPrefix(destination, destinationDeviceId), "",
+                                 [&msgs, &parsed, maxCount](const leveldb::Slice&, const leveldb::Slice& value) {
+        if (msgs.size() >= maxCount) {
+            return false;
+        }
+        msgs.emplace_back();
+        if (!msgs.back().ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            parsed = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            return false;
+        }
+        return true;
+    });
+    return ec != ErrorCode::ERRORCODE_SUCCESS ? ec : parsed;
+}
+
+ErrorCode StoredMessagesLocalImpl::del(const std::string& destination, const std::vector<uint64_t>& msgId)
+{
+    // group the ids by device so each count is adjusted once
+    std::map<uint32_t, std::vector<uint64_t>> byDevice;
+    for (auto id : msgId) {
+        std::string value;
+        ErrorCode ec = m_store->get(deviceIndexKey(destination, id), value);
+        if (ec == ErrorCode::ERRORCODE_NO_SUCH_DATA) {
+            continue;
+        }
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+        byDevice[static_cast<uint32_t>(std::stoul(value))].push_back(id);
+    }
+
+    for (const auto& item : byDevice) {
+        std::string counter = countKey(destination, item.first);
+        std::lock_guard<std::mutex> l(m_store->rowLock(counter));
+        uint32_t unread = 0;
+        ErrorCode ec = count(destination, item.first, unread);
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+
+        LocalStore::Batch batch;
+        for (auto id : item.second) {
+            batch.Delete(msgPrefix(destination, item.first).u64(id).key());
+            batch.Delete(deviceIndexKey(destination, id).key());
+        }
+        unread = unread > item.second.size() ? unread - static_cast<uint32_t>(item.second.size()) : 0;
+        batch.Put(counter, std::to_string(unread));
+        ec = m_store->write(batch);
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+    }
+    return ErrorCode::ERRORCODE_SUCCESS;
+}
+
+ErrorCode StoredMessagesLocalImpl::clear(const std::string& destination)
+{
+    // "sm/" keys of a destination share this prefix across devices
+    LocalKey prefix("sm");
+    prefix.str(destination);
+
+    std::set<uint32_t> devices;
+    ErrorCode ec = m_store->scan(LocalKey("smc").str(destination), "",
+                                 [&devices](const leveldb::Slice& key, const leveldb::Slice&) {
+        devices.insert(static_cast<uint32_t>(LocalKey::tailU64(key)));
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    for (auto deviceId : devices) {
+        ec = clear(destination, deviceId);
+        if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+            return ec;
+        }
+    }
+    return m_store->delPrefix(prefix);
+}
+
+ErrorCode StoredMessagesLocalImpl::clear(const std::string& destination, uint32_t destinationDeviceId)
+{
+    std::string counter = countKey(destination, destinationDeviceId);
+    std::lock_guard<std::mutex> l(m_store->rowLock(counter));
+    LocalStore::Batch batch;
+    ErrorCode ec = m_store->scan(msgPrefix(destination, destinationDeviceId), "",
+                                 [&batch, &destination](const leveldb::Slice& key, const leveldb::Slice&) {
+        batch.Delete(key);
+        batch.Delete(deviceIndexKey(destination, LocalKey::tailU64(key)).key());
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    batch.Delete(counter);
+    return m_store->write(batch);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "dao/stored_messages.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class StoredMessagesLocalImpl : public StoredMessages {
+public:
+    explicit StoredMessagesLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // unreadMsgCount counts the messages stored for the destination device
+    virtual ErrorCode set(const bcm::StoredMessage& msg, uint32_t& unreadMsgCount) override;
+
+    virtual ErrorCode get(const std::string& destination,
+                          uint32_t destinationDeviceId,
+                          uint32_t maxCount,
+                          std::vector<bcm::StoredMessage>& msgs) override;
+
+    virtual ErrorCode del(const std::string& destination, const std::vector<uint64_t>& msgId) override;
+
+    virtual ErrorCode clear(const std::string& destination) override;
+
+    virtual ErrorCode clear(const std::string& destination, uint32_t destinationDeviceId) override;
+
+private:
+    // messages of a destination device in id order, plus an index from id to device
+    // for del and a message count per device
+    static LocalKey msgPrefix(const std::string& destination, uint32_t deviceId);
+    static LocalKey deviceIndexKey(const std::string& destination, uint64_t id);
+    static LocalKey countKey(const std::string& destination, uint32_t deviceId);
+
+    ErrorCode count(const std::string& destination, uint32_t deviceId, uint32_t& count);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,77 @@
+#include "sys_messages_local_impl.h"
+
+namespace bcm {
+namespace dao {
+
+SysMsgsLocalImpl::SysMsgsLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+}
+
+ErrorCode SysMsgsLocalImpl::get(const std::string& destination,
+                                std::vector<bcm::SysMsg>& msgs,
+                                uint32_t maxMsgSize)
+{
+    ErrorCode parsed = ErrorCode::ERRORCODE_SUCCESS;
+    ErrorCode ec = m_store->scanReverse(LocalKey("sys").str(destination),
+                                        [&](const leveldb::Slice&, const leveldb::Slice& value) {
+        if (msgs.size() >= maxMsgSize) {
+            return false;
+        }
+        msgs.emplace_back();
+        if (!msgs.back().ParseFromArray(value.data(), static_cast<int>(value.size()))) {
+            parsed = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            return false;
+        }
+        return true;
+    });
+    return ec != ErrorCode::ERRORCODE_SUCCESS ? ec : parsed;
+}
+
+ErrorCode SysMsgsLocalImpl::del(const std::string& destination, uint64_t msgId)
+{
+    return m_store->del(LocalKey("sys").str(destination).u64(msgId));
+}
+
+ErrorCode SysMsgsLocalImpl::delBatch(const std::string& destination, const std::vector<uint64_t>& msgIds)
+{
+    LocalStore::Batch batch;
+    for (auto msgId : msgIds) {
+        batch.Delete(LocalKey("sys").str(destination).u64(msgId).key());
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode SysMsgsLocalImpl::delBatch(const std::string& destination, uint64_t maxMid)
+{
+    LocalStore::Batch batch;
+    ErrorCode ec = m_store->scan(LocalKey("sys").str(destination), "",
+                                 [&batch, maxMid](const leveldb::Slice& key, const leveldb::Slice&) {
+        if (LocalKey::tailU64(key) > maxMid) {
+            return false;
+        }
+        batch.Delete(key);
+        return true;
+    });
+    if (ec != ErrorCode::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    return m_store->write(batch);
+}
+
+ErrorCode SysMsgsLocalImpl::insert(const bcm::SysMsg& msg)
+{
+    return m_store->put(LocalKey("sys").str(msg.destination()).u64(msg.sysmsgid()), msg);
+}
+
+ErrorCode SysMsgsLocalImpl::insertBatch(const std::vector<bcm::SysMsg>& msgs)
+{
+    LocalStore::Batch batch;
+    for (const auto& msg : msgs) {
+        batch.Put(LocalKey("sys").str(msg.destination()).u64(msg.sysmsgid()).key(), msg.SerializeAsString());
+    }
+    return m_store->write(batch);
+}
+
+}  // namespace dao
+}  // namespace bcm
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "dao/sys_msgs.h"
+#include "local_store.h"
+#include <memory>
+
+namespace bcm {
+namespace dao {
+
+class SysMsgsLocalImpl : public SysMsgs {
+public:
+    explicit SysMsgsLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // msgs come out in descending sysmsgid order
+    virtual ErrorCode get(const std::string& destination,
+                          std::vector<bcm::SysMsg>& msgs,
+                          uint32_t maxMsgSize = kMaxSysMsgSize) override;
+
+    virtual ErrorCode del(const std::string& destination, uint64_t msgId) override;
+
+    virtual ErrorCode delBatch(const std::string& destination, const std::vector<uint64_t>& msgIds) override;
+
+    virtual ErrorCode delBatch(const std::string& destination, uint64_t maxMid) override;
+
+    virtual ErrorCode insert(const bcm::SysMsg& msg) override;
+
+    virtual ErrorCode insertBatch(const std::vector<bcm::SysMsg>& msgs) override;
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+};
+
+}  // namespace dao
+}  // namespace bcm
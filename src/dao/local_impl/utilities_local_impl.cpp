@@ -0,0 +1,73 @@
+#include "utilities_local_impl.h"
+#include "utils/time.h"
+
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+
+namespace bcm {
+namespace dao {
+
+MasterLeaseLocalImpl::MasterLeaseLocalImpl(std::shared_ptr<LocalStore> store)
+    : m_store(std::move(store))
+{
+    // same as MasterLeaseRpcImpl, every instance holds leases under its own random id
+    boost::uuids::basic_random_generator<boost::mt19937> random_generator;
+    m_holder = boost::uuids::to_string(random_generator());
+}
+
+// a lease row is "holder:expireAt"
+bool MasterLeaseLocalImpl::holderOf(const std::string& key, std::string& holder, int64_t& expireAt)
+{
+    std::string value;
+    if (m_store->get(LocalKey("lease").str(key), value) != ErrorCode::ERRORCODE_SUCCESS) {
+        return false;
+    }
+    auto pos = value.rfind(':');
+    if (pos == std::string::npos) {
+        return false;
+    }
+    holder = value.substr(0, pos);
+    expireAt = std::stoll(value.substr(pos + 1));
+    return expireAt > nowInMilli();
+}
+
+ErrorCode MasterLeaseLocalImpl::acquire(const std::string& key, uint32_t ttlMs, bool renew)
+{
+    LocalKey row("lease");
+    row.str(key);
+    std::lock_guard<std::mutex> l(m_store->rowLock(row));
+    std::string holder;
+    int64_t expireAt = 0;
+    bool held = holderOf(key, holder, expireAt);
+    if (renew ? (!held || holder != m_holder) : (held && holder != m_holder)) {
+        return ErrorCode::ERRORCODE_CAS_FAIL;
+    }
+    return m_store->put(row, m_holder + ":" + std::to_string(nowInMilli() + ttlMs));
+}
+
+ErrorCode MasterLeaseLocalImpl::getLease(const std::string& key, uint32_t ttlMs)
+{
+    return acquire(key, ttlMs, false);
+}
+
+ErrorCode MasterLeaseLocalImpl::renewLease(const std::string& key, uint32_t ttlMs)
+{
+    return acquire(key, ttlMs, true);
+}
+
+ErrorCode MasterLeaseLocalImpl::releaseLease(const std::string& key)
+{
+    LocalKey row("lease");
+    row.str(key);
+    std::lock_guard<std::mutex> l(m_store->rowLock(row));
+    std::string holder;
+    int64_t expireAt = 0;
+    if (holderOf(key, holder, expireAt) && holder != m_holder) {
+        return ErrorCode::ERRORCODE_CAS_FAIL;
+    }
+    return m_store->del(row);
+}
+
+}  // namespace dao
+}  // namespace bcm
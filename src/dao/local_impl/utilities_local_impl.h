@@ -0,0 +1,33 @@
+#pragma once
+
+#include "dao/utilities.h"
+#include "local_store.h"
+#include <memory>
+#include <string>
+
+namespace bcm {
+namespace dao {
+
+class MasterLeaseLocalImpl : public MasterLease {
+public:
+    explicit MasterLeaseLocalImpl(std::shared_ptr<LocalStore> store);
+
+    // ERRORCODE_CAS_FAIL while another holder owns an unexpired lease
+    virtual ErrorCode getLease(const std::string& key, uint32_t ttlMs) override;
+
+    virtual ErrorCode renewLease(const std::string& key, uint32_t ttlMs) override;
+
+    virtual ErrorCode releaseLease(const std::string& key) override;
+
+private:
+    // holder of key and the time its lease expires in milliseconds, false if nobody holds it
+    bool holderOf(const std::string& key, std::string& holder, int64_t& expireAt);
+    ErrorCode acquire(const std::string& key, uint32_t ttlMs, bool renew);
+
+private:
+    std::shared_ptr<LocalStore> m_store;
+    std::string m_holder;
+};
+
+}  // namespace dao
+}  // namespace bcm
@@ -7,6 +7,7 @@
 #include "utils/log.h"
 
 #include "accounts_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "../../proto/brpc/rpc_account.pb.h"
 #include "../../proto/dao/device.pb.h"
 #include "../../proto/dao/account.pb.h"
@@ -39,7 +40,9 @@ ErrorCode AccountsRpcImp::create(const bcm::Account& account)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.create(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.create(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "account create uid: " << account.uid() << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -73,7 +76,9 @@ ErrorCode AccountsRpcImp::updateAccount(const bcm::Account& account, uint32_t fl
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateAccount(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateAccount(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "updateAccount uid: " << account.uid() << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -107,7 +112,9 @@ ErrorCode AccountsRpcImp::updateDevice(const bcm::Account& account, uint32_t dev
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateDevice(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateDevice(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "update account device uid: " << account.uid() << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -139,7 +146,9 @@ ErrorCode AccountsRpcImp::updateAccount(const bcm::Account& account, const bcm::
     
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateAccount(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateAccount(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "updateAccount uid: " << account.uid() << ", ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -172,7 +181,9 @@ ErrorCode AccountsRpcImp::updateDevice(const bcm::Account& account, const bcm::D
     
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateDevice(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateDevice(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "update account device uid: " << account.uid() << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -204,7 +215,9 @@ ErrorCode AccountsRpcImp::get(const std::string& uid, bcm::Account& account)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getAccount(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getAccount(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "get account uid: " << uid << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -241,7 +254,9 @@ ErrorCode AccountsRpcImp::get(const std::vector<std::string>& uids,
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMultiAccounts(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMultiAccounts(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << ", uid count: " << uids.size()
@@ -285,7 +300,9 @@ ErrorCode AccountsRpcImp::getKeys(const std::set<std::string>& uids, std::vector
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getKeys(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getKeys(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << ", uid count: " << uids.size()
@@ -318,7 +335,9 @@ ErrorCode AccountsRpcImp::getKeysByGid(uint64_t gid, std::vector<bcm::Keys>& key
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getKeysByGid(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getKeysByGid(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << ", gid: " << gid;
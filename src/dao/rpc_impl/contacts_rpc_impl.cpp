@@ -1,4 +1,5 @@
 #include "contacts_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 #include <map>
@@ -25,7 +26,9 @@ ErrorCode ContactsRpcImp::get(const std::string& uid, std::string& contacts)
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getContact(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getContact(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -66,7 +69,9 @@ ErrorCode ContactsRpcImp::getInParts(const std::string& uid, const std::vector<s
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getInParts(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getInParts(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << " uid: " << uid << ", ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -110,7 +115,9 @@ ErrorCode ContactsRpcImp::setInParts(const std::string& uid, const std::map<std:
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setInParts(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setInParts(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << " uid: " << uid << "ErrorCode: " << cntl.ErrorCode()
                  << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -141,7 +148,9 @@ ErrorCode ContactsRpcImp::addFriendEvent(const std::string& uid,
     request.set_data(eventData);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setFriendship(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setFriendship(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << " uid: " << uid << ", ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -172,7 +181,9 @@ ErrorCode ContactsRpcImp::getFriendEvents(const std::string& uid,
     request.set_count(count);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.queryFriendship(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.queryFriendship(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << " uid: " << uid << ", ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -209,7 +220,9 @@ ErrorCode ContactsRpcImp::delFriendEvents(const std::string& uid,
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.delFriendship(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.delFriendship(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << " uid: " << uid << ", ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -0,0 +1,172 @@
+#include "dao_channel.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <metrics_client.h>
+
+namespace bcm {
+namespace dao {
+
+using namespace metrics;
+
+static constexpr char kMetricsDaoServiceName[] = "dao";
+
+DaoChannel::MethodState::MethodState(const std::string& name, const DaoMethodConfig& config)
+    : name(name)
+    , config(config)
+    , latency(config.hedgePercentile)
+{
+}
+
+int64_t DaoChannel::MethodState::backupRequestMs() const
+{
+    if (config.hedgePercentile <= 0) {
+        return -1;
+    }
+    int64_t percentileUs = latency.percentileUs();
+    if (percentileUs < 0) {
+        return -1;
+    }
+    return std::max<int64_t>(percentileUs / 1000, config.hedgeMinMs);
+}
+
+// records the call before handing the result to the caller
+class DaoChannel::RecordingClosure : public google::protobuf::Closure {
+public:
+    RecordingClosure(DaoChannel& channel, MethodState& state, brpc::Controller& cntl,
+                     int64_t backupRequestMs, google::protobuf::Closure* done)
+        : m_channel(channel)
+        , m_state(state)
+        , m_cntl(cntl)
+        , m_backupRequestMs(backupRequestMs)
+        , m_done(done)
+    {
+    }
+
+    void Run() override
+    {
+        m_channel.record(m_state, m_cntl, m_backupRequestMs);
+        google::protobuf::Closure* done = m_done;
+        delete this;
+        done->Run();
+    }
+
+private:
+    DaoChannel& m_channel;
+    MethodState& m_state;
+    brpc::Controller& m_cntl;
+    int64_t m_backupRequestMs;
+    google::protobuf::Closure* m_done;
+};
+
+void DaoChannel::configure(const DaoConfig& config)
+{
+    m_configs = config.remote.methods;
+    m_metrics = config.remote.metrics;
+    for (const auto& item : m_configs) {
+        LOGI << "dao method " << item.first << ": timeout " << item.second.timeout
+             << ", retries " << item.second.retries << ", hedge percentile " << item.second.hedgePercentile;
+    }
+}
+
+DaoChannel::MethodState& DaoChannel::stateOf(const google::protobuf::MethodDescriptor* method)
+{
+    std::lock_guard<std::mutex> l(m_mutex);
+    auto it = m_states.find(method);
+    if (it != m_states.end()) {
+        return *it->second;
+    }
+
+    std::string name = method->service()->name() + "." + method->name();
+    auto config = m_configs.find(name);
+    std::unique_ptr<MethodState> state(
+        new MethodState(name, config == m_configs.end() ? DaoMethodConfig() : config->second));
+    MethodState& result = *state;
+    m_states.emplace(method, std::move(state));
+    return result;
+}
+
+void DaoChannel::CallMethod(const google::protobuf::MethodDescriptor* method,
+                            google::protobuf::RpcController* controller,
+                            const google::protobuf::Message* request,
+                            google::protobuf::Message* response,
+                            google::protobuf::Closure* done)
+{
+    MethodState& state = stateOf(method);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    if (state.config.timeout > 0) {
+        cntl->set_timeout_ms(state.config.timeout);
+    }
+    if (state.config.retries >= 0) {
+        cntl->set_max_retry(state.config.retries);
+    }
+    int64_t backupRequestMs = state.backupRequestMs();
+    if (backupRequestMs > 0) {
+        cntl->set_backup_request_ms(backupRequestMs);
+        // the backup request takes one of the retries
+        if (cntl->max_retry() < 1) {
+            cntl->set_max_retry(1);
+        }
+    }
+
+    if (done == nullptr) {
+        brpc::Channel::CallMethod(method, controller, request, response, nullptr);
+        record(state, *cntl, backupRequestMs);
+        return;
+    }
+    brpc::Channel::CallMethod(method, controller, request, response,
+                              new RecordingClosure(*this, state, *cntl, backupRequestMs, done));
+}
+
+void DaoChannel::record(MethodState& state, brpc::Controller& cntl, int64_t backupRequestMs)
+{
+    int64_t latencyUs = cntl.latency_us();
+    bool failed = cntl.Failed();
+    bool hedged = backupRequestMs > 0 && cntl.has_backup_request();
+    bool hedgeMaybeWon = hedged && !failed && latencyUs <= 2 * backupRequestMs * 1000;
+
+    state.calls.fetch_add(1, std::memory_order_relaxed);
+    if (failed) {
+        state.failures.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        state.latency.add(latencyUs);
+    }
+    if (hedged) {
+        state.hedged.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (hedgeMaybeWon) {
+        state.hedgeWinsUpperBound.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (m_metrics) {
+        MetricsClient::Instance()->markMicrosecondAndRetCode(kMetricsDaoServiceName, state.name,
+                                                             latencyUs, cntl.ErrorCode());
+        if (hedged) {
+            MetricsClient::Instance()->counterAdd("o_dao_hedged_" + state.name, 1);
+        }
+        if (hedgeMaybeWon) {
+            MetricsClient::Instance()->counterAdd("o_dao_hedge_won_upper_bound_" + state.name, 1);
+        }
+    }
+}
+
+bool DaoChannel::stats(const std::string& name, MethodStats& stats)
+{
+    std::lock_guard<std::mutex> l(m_mutex);
+    for (const auto& item : m_states) {
+        const MethodState& state = *item.second;
+        if (state.name != name) {
+            continue;
+        }
+        stats.calls = state.calls.load();
+        stats.failures = state.failures.load();
+        stats.hedged = state.hedged.load();
+        stats.hedgeWinsUpperBound = state.hedgeWinsUpperBound.load();
+        stats.backupRequestMs = state.backupRequestMs();
+        return true;
+    }
+    return false;
+}
+
+}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <brpc/channel.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "config/dao_config.h"
+#include "latency_window.h"
+
+namespace bcm {
+namespace dao {
+
+// brpc channel of the dao client. Before a call goes out it applies the timeout,
+// retries and backup request delay configured for its method in
+// DaoConfig::remote.methods, and when the call ends it records the latency of the
+// method, which drives the backup request delay of hedged methods.
+//
+// brpc answers a hedged call with whichever request finishes first, and its controller
+// only tells that a backup was sent, not which request answered. hedgeWinsUpperBound
+// counts the hedged calls that succeeded within one backup delay after the backup was
+// sent. It is an upper bound of the backup wins: an original answering in that window
+// is counted too.
+class DaoChannel : public brpc::Channel {
+public:
+    struct MethodStats {
+        uint64_t calls{0};
+        uint64_t failures{0};
+        uint64_t hedged{0};
+        uint64_t hedgeWinsUpperBound{0};
+        // current backup request delay, -1 if the method is not hedged yet
+        int64_t backupRequestMs{-1};
+    };
+
+    // before any call
+    void configure(const DaoConfig& config);
+
+    void CallMethod(const google::protobuf::MethodDescriptor* method,
+                    google::protobuf::RpcController* controller,
+                    const google::protobuf::Message* request,
+                    google::protobuf::Message* response,
+                    google::protobuf::Closure* done) override;
+
+    // name is "Service.method", false if the method has not been called
+    bool stats(const std::string& name, MethodStats& stats);
+
+private:
+    struct MethodState {
+        MethodState(const std::string& name, const DaoMethodConfig& config);
+
+        int64_t backupRequestMs() const;
+
+        std::string name;
+        DaoMethodConfig config;
+        LatencyWindow latency;
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> hedged{0};
+        std::atomic<uint64_t> hedgeWinsUpperBound{0};
+    };
+
+    class RecordingClosure;
+
+    MethodState& stateOf(const google::protobuf::MethodDescriptor* method);
+    void record(MethodState& state, brpc::Controller& cntl, int64_t backupRequestMs);
+
+private:
+    std::map<std::string, DaoMethodConfig> m_configs;
+    bool m_metrics{false};
+    std::mutex m_mutex;
+    std::unordered_map<const google::protobuf::MethodDescriptor*, std::unique_ptr<MethodState>> m_states;
+};
+
+}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <boost/fiber/future.hpp>
+#include <google/protobuf/service.h>
+
+namespace bcm {
+namespace dao {
+
+// Completion of an asynchronous brpc call. brpc runs the closure on one of its own
+// threads when the call ends, so wait() suspends only the calling fiber and leaves
+// the worker thread under it free for other fibers. Outside of a fiber wait() blocks
+// the thread like a synchronous call.
+//
+//     FiberRpcDone done;
+//     stub.method(&cntl, &request, &response, done.closure());
+//     done.wait();
+//
+// cntl, request and response must stay alive until wait() returns.
+class FiberRpcDone {
+public:
+    FiberRpcDone()
+        : m_closure(new PromiseClosure())
+        , m_future(m_closure->promise.get_future())
+    {
+    }
+
+    // hand to exactly one stub call, brpc runs it once whether the call succeeds or not
+    google::protobuf::Closure* closure()
+    {
+        return m_closure;
+    }
+
+    void wait()
+    {
+        m_future.wait();
+    }
+
+private:
+    // owns the promise, so the waiting side may go away as soon as it is fulfilled
+    struct PromiseClosure : public google::protobuf::Closure {
+        void Run() override
+        {
+            promise.set_value();
+            delete this;
+        }
+
+        boost::fibers::promise<void> promise;
+    };
+
+    PromiseClosure* m_closure;
+    boost::fibers::future<void> m_future;
+};
+
+}
+}
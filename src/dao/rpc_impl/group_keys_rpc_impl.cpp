@@ -1,4 +1,5 @@
 #include "group_keys_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 namespace bcm {
@@ -27,7 +28,9 @@ ErrorCode GroupKeysRpcImpl::insert(const bcm::GroupKeys& groupKeys)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setGroupKeys(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setGroupKeys(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -55,11 +58,11 @@ ErrorCode GroupKeysRpcImpl::get(uint64_t gid, const std::set<int64_t>& versions,
     int64_t max = 0;
     bool needCache = true;
     for (const auto& v : versions) {
-        bcm::GroupKeys keys;
-        if (!CacheManager::getInstance()->get(gid, v, keys)) {
+        auto cached = CacheManager::getInstance()->get(gid, v);
+        if (!cached) {
             noneCachedVersions.emplace(v);
         } else {
-            groupKeys.emplace_back(std::move(keys));
+            groupKeys.emplace_back(*cached);
         }
         if (max < v) {
             max = v;
@@ -85,7 +88,9 @@ ErrorCode GroupKeysRpcImpl::get(uint64_t gid, const std::set<int64_t>& versions,
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupKeys(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupKeys(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -143,7 +148,9 @@ ErrorCode GroupKeysRpcImpl::clear(uint64_t gid)
     request.set_gid(gid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clear(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clear(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -188,7 +195,9 @@ ErrorCode GroupKeysRpcImpl::getLatestGroupKeys(const std::set<uint64_t>& gids, s
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getLatestGroupKeys(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getLatestGroupKeys(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -222,7 +231,9 @@ ErrorCode GroupKeysRpcImpl::getLatestModeAndVersionBatch(const std::set<uint64_t
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getLatestModeAndVersionBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getLatestModeAndVersionBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -249,13 +260,13 @@ GroupKeysRpcImpl::CacheManager* GroupKeysRpcImpl::CacheManager::getInstance()
     return &instance;
 }
 
-bool GroupKeysRpcImpl::CacheManager::get(uint64_t gid, int64_t version, bcm::GroupKeys& keys)
+std::shared_ptr<const bcm::GroupKeys> GroupKeysRpcImpl::CacheManager::get(uint64_t gid, int64_t version)
 {
     if (m_bypass) {
-        return false;
+        return nullptr;
     }
     std::string k = cacheKey(gid, version);
-    return m_caches.get(k, keys);
+    return m_caches.get(k);
 }
 
 bool GroupKeysRpcImpl::CacheManager::set(uint64_t gid, int64_t version, const bcm::GroupKeys& keys)
@@ -3,7 +3,7 @@
 #include <atomic>
 #include "dao/group_keys.h"
 #include "proto/brpc/rpc_group_keys.pb.h"
-#include "dao/dao_cache/fifo_cache.h"
+#include "dao/dao_cache/tiny_lfu_cache.h"
 #include "config/bcm_options.h"
 
 #ifdef UNIT_TEST
@@ -39,18 +39,19 @@ protected:
     class CacheManager {
     public:
         static CacheManager* getInstance();
-        bool get(uint64_t gid, int64_t version, bcm::GroupKeys& keys);
+        std::shared_ptr<const bcm::GroupKeys> get(uint64_t gid, int64_t version);
         bool set(uint64_t gid, int64_t version, const bcm::GroupKeys& keys);
 
         bool getBypass() const;
         void setBypass(bool bypass);
     
     private:
-        CacheManager() : m_caches(bcm::BcmOptions::getInstance()->getConfig().cacheConfig.groupKeysLimit),
+        CacheManager() : m_caches(bcm::BcmOptions::getInstance()->getConfig().cacheConfig.groupKeysLimit,
+                                  bcm::BcmOptions::getInstance()->getConfig().cacheConfig.groupKeysShards),
                          m_bypass(false) {}
         std::string cacheKey(uint64_t gid, int64_t version);
     private:
-        FIFOCache<std::string, bcm::GroupKeys> m_caches;
+        TinyLFUCache<std::string, bcm::GroupKeys> m_caches;
         bool m_bypass;
     };
 
@@ -7,6 +7,7 @@
 #include "utils/log.h"
 
 #include "group_msg_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "proto/brpc/rpc_group_msg.pb.h"
 
 namespace bcm {
@@ -34,7 +35,9 @@ ErrorCode GroupMsgsRpcImp::insert(const bcm::GroupMsg& msg, uint64_t& mid)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insert(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insert(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -73,7 +76,9 @@ ErrorCode GroupMsgsRpcImp::get(uint64_t groupId, uint64_t mid, GroupMsg& msg)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.get(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.get(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -115,7 +120,9 @@ ErrorCode GroupMsgsRpcImp::batchGet(uint64_t groupId, uint64_t from, uint64_t to
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.batchGet(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.batchGet(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -161,7 +168,9 @@ ErrorCode GroupMsgsRpcImp::recall(const std::string& sourceExtra,
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.recall(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.recall(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -4,6 +4,7 @@
 #include "utils/log.h"
 
 #include "group_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "../../proto/brpc/rpc_group.pb.h"
 
 
@@ -37,7 +38,9 @@ ErrorCode GroupsRpcImp::create(const bcm::Group& group, uint64_t& gid)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.createGroup(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.createGroup(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                 << " , req: " << request.Utf8DebugString();
@@ -75,7 +78,9 @@ ErrorCode GroupsRpcImp::get(uint64_t gid, bcm::Group& group)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupInfoById(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupInfoById(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -116,7 +121,9 @@ ErrorCode GroupsRpcImp::update(uint64_t gid, const nlohmann::json& upData)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateGroup(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateGroup(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -149,7 +156,9 @@ ErrorCode GroupsRpcImp::del(uint64_t gid)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.deleteGroup(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.deleteGroup(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -186,7 +195,9 @@ ErrorCode GroupsRpcImp::setGroupExtensionInfo(const uint64_t gid, const std::map
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setGroupExtensionInfo(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setGroupExtensionInfo(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
@@ -223,7 +234,9 @@ ErrorCode GroupsRpcImp::getGroupExtensionInfo(const uint64_t gid, const std::set
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupExtensionInfo(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupExtensionInfo(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode())
                  << " , req: " << request.Utf8DebugString();
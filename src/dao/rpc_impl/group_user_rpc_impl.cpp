@@ -1,5 +1,6 @@
 #include "utils/log.h"
 #include "group_user_rpc_impl.h"
+#include "fiber_rpc_done.h"
 
 namespace bcm {
 namespace dao {
@@ -26,7 +27,9 @@ ErrorCode GroupUsersRpcImpl::insert(const bcm::GroupUser& user)
     *p = user;
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insert(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insert(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -57,7 +60,9 @@ ErrorCode GroupUsersRpcImpl::insertBatch(const std::vector<bcm::GroupUser>& user
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insertBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insertBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -86,7 +91,9 @@ ErrorCode GroupUsersRpcImpl::getMemberRole(uint64_t gid, const std::string& uid,
     *p = uid;
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMemberRoles(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMemberRoles(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -125,7 +132,9 @@ ErrorCode GroupUsersRpcImpl::getMemberRoles(uint64_t gid, std::map <std::string,
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMemberRoles(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMemberRoles(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -160,7 +169,9 @@ ErrorCode GroupUsersRpcImpl::delMember(uint64_t gid, const std::string& uid)
     *p = uid;
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.delMemberBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.delMemberBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -191,7 +202,9 @@ ErrorCode GroupUsersRpcImpl::delMemberBatch(uint64_t gid, const std::vector <std
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.delMemberBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.delMemberBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -224,7 +237,9 @@ ErrorCode GroupUsersRpcImpl::getMemberBatch(uint64_t gid,
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMemberInfoBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMemberInfoBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -260,7 +275,9 @@ ErrorCode GroupUsersRpcImpl::getMemberRangeByRolesBatch(uint64_t gid,
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMemberRangeByRolesBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMemberRangeByRolesBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -291,7 +308,9 @@ ErrorCode GroupUsersRpcImpl::getJoinedGroupsList(const std::string& uid, std::ve
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getJoinedGroupsList(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getJoinedGroupsList(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -328,7 +347,9 @@ ErrorCode GroupUsersRpcImpl::getJoinedGroups(const std::string& uid, std::vector
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getJoinedGroups(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getJoinedGroups(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -360,7 +381,9 @@ ErrorCode GroupUsersRpcImpl::getGroupDetailByGid(uint64_t gid, const std::string
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupDetailByGid(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupDetailByGid(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -393,7 +416,9 @@ ErrorCode GroupUsersRpcImpl::getGroupOwner(uint64_t gid, std::string& owner)
     request.set_groupid(gid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupOwner(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupOwner(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -423,7 +448,9 @@ ErrorCode GroupUsersRpcImpl::getMember(uint64_t gid, const std::string& uid, bcm
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMember(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMember(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -452,7 +479,9 @@ ErrorCode GroupUsersRpcImpl::queryGroupMemberInfoByGid(uint64_t gid, GroupCounte
     request.set_groupid(gid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.queryGroupCountInfoByGid(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.queryGroupCountInfoByGid(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -490,7 +519,9 @@ ErrorCode GroupUsersRpcImpl::queryGroupMemberInfoByGid(uint64_t gid,
     request.set_nextowner(nextOwner);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.queryGroupMemberInfoByGid(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.queryGroupMemberInfoByGid(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -525,7 +556,9 @@ ErrorCode GroupUsersRpcImpl::update(uint64_t gid, const std::string& uid, const
     request.set_jsonfield(upData.dump());
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.update(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.update(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -559,7 +592,9 @@ ErrorCode GroupUsersRpcImpl::getMemberRangeByRolesBatchWithOffset(uint64_t gid,
     request.set_count(count);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMemberRangeByRolesPage(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMemberRangeByRolesPage(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -594,7 +629,9 @@ ErrorCode GroupUsersRpcImpl::getGroupDetailByGidBatch(const std::vector<uint64_t
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getGroupDetailByGidBatch(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getGroupDetailByGidBatch(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -631,7 +668,9 @@ ErrorCode GroupUsersRpcImpl::updateIfEmpty(uint64_t gid, const std::string& uid,
     request.set_jsonfield(upData.dump());
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.updateIfEmpty(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.updateIfEmpty(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -644,6 +683,58 @@ ErrorCode GroupUsersRpcImpl::updateIfEmpty(uint64_t gid, const std::string& uid,
     }
 }
 
+ErrorCode GroupUsersRpcImpl::updateLastAckMidBatch(const std::vector<GroupUserAck>& acks)
+{
+    if (stub.channel() == nullptr) {
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    // the dao service has no batch update, every member of the batch is still one update
+    // rpc. they are in flight at once so the batch waits one round trip, but the dao qps
+    // only drops by the acks merged in the buffer
+    struct Call {
+        bcm::dao::rpc::UpdateGroupUserReq request;
+        bcm::dao::rpc::UpdateGroupUserResp response;
+        brpc::Controller cntl;
+        FiberRpcDone done;
+    };
+    std::vector<std::unique_ptr<Call>> calls;
+    calls.reserve(acks.size());
+    try {
+        for (const auto& ack : acks) {
+            std::unique_ptr<Call> call(new Call());
+            call->request.set_groupid(ack.gid);
+            call->request.set_uid(ack.uid);
+            call->request.set_jsonfield(nlohmann::json{{"last_ack_mid", ack.lastAckMid}}.dump());
+            call->cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
+            stub.update(&call->cntl, &call->request, &call->response, call->done.closure());
+            calls.emplace_back(std::move(call));
+        }
+    } catch (const std::exception& ex) {
+        LOGE << ex.what();
+        for (auto& call : calls) {
+            call->done.wait();
+        }
+        return ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    ErrorCode result = ErrorCode::ERRORCODE_SUCCESS;
+    for (auto& call : calls) {
+        call->done.wait();
+        if (call->cntl.Failed()) {
+            LOGE << "ErrorCode: " << call->cntl.ErrorCode() << ", ErrorText: " << berror(call->cntl.ErrorCode());
+            result = ErrorCode::ERRORCODE_INTERNAL_ERROR;
+            continue;
+        }
+        ErrorCode ec = static_cast<ErrorCode>(call->response.rescode());
+        if (ec != ErrorCode::ERRORCODE_SUCCESS && ec != ErrorCode::ERRORCODE_NO_SUCH_DATA
+            && ec != ErrorCode::ERRORCODE_ALREADY_EXSITED) {
+            result = ec;
+        }
+    }
+    return result;
+}
+
 ErrorCode GroupUsersRpcImpl::getMembersOrderByCreateTime(uint64_t gid,
                                                          const std::vector<bcm::GroupUser::Role>& roles,
                                                          const std::string& startUid,
@@ -667,7 +758,9 @@ ErrorCode GroupUsersRpcImpl::getMembersOrderByCreateTime(uint64_t gid,
     request.set_count(count);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getMembersOrderByCreateTime(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getMembersOrderByCreateTime(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -61,6 +61,8 @@ public:
 
     virtual ErrorCode updateIfEmpty(uint64_t gid, const std::string& uid, const nlohmann::json& upData) override;
 
+    virtual ErrorCode updateLastAckMidBatch(const std::vector<GroupUserAck>& acks) override;
+
     virtual ErrorCode getMembersOrderByCreateTime(uint64_t gid,
                                                   const std::vector<bcm::GroupUser::Role>& roles,
                                                   const std::string& startUid,
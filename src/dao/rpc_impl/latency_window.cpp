@@ -0,0 +1,38 @@
+#include "latency_window.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace bcm {
+namespace dao {
+
+constexpr size_t LatencyWindow::kSize;
+constexpr size_t LatencyWindow::kRefresh;
+constexpr size_t LatencyWindow::kMinSamples;
+
+LatencyWindow::LatencyWindow(int percentile)
+    : m_percentile(std::min(std::max(percentile, 1), 100))
+{
+}
+
+void LatencyWindow::add(int64_t latencyUs)
+{
+    std::lock_guard<std::mutex> l(m_mutex);
+    m_samples[m_count % kSize] = latencyUs;
+    ++m_count;
+    if (m_count >= kMinSamples && m_count % kRefresh == 0) {
+        refresh();
+    }
+}
+
+void LatencyWindow::refresh()
+{
+    std::vector<int64_t> samples(m_samples.begin(), m_samples.begin() + std::min(m_count, kSize));
+    size_t rank = (samples.size() * static_cast<size_t>(m_percentile) + 99) / 100;
+    auto nth = samples.begin() + (std::max<size_t>(rank, 1) - 1);
+    std::nth_element(samples.begin(), nth, samples.end());
+    m_percentileUs.store(*nth, std::memory_order_relaxed);
+}
+
+}
+}
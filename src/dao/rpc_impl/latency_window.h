@@ -0,0 +1,42 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace bcm {
+namespace dao {
+
+// Latencies of the last kSize calls of one rpc and a percentile of them. The
+// percentile is recomputed every kRefresh samples, so reading it is a single load.
+class LatencyWindow {
+public:
+    static constexpr size_t kSize = 1024;
+    static constexpr size_t kRefresh = 64;
+    // fewer samples say nothing about the tail
+    static constexpr size_t kMinSamples = 128;
+
+    explicit LatencyWindow(int percentile);
+
+    void add(int64_t latencyUs);
+
+    // -1 until kMinSamples calls have been seen
+    int64_t percentileUs() const
+    {
+        return m_percentileUs.load(std::memory_order_relaxed);
+    }
+
+private:
+    void refresh();
+
+private:
+    int m_percentile;
+    std::mutex m_mutex;
+    std::array<int64_t, kSize> m_samples;
+    size_t m_count{0};
+    std::atomic<int64_t> m_percentileUs{-1};
+};
+
+}
+}
@@ -1,6 +1,7 @@
 
 #include <boost/algorithm/string/split.hpp>
 #include "limiter_configurations_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 namespace bcm {
@@ -49,7 +50,9 @@ ErrorCode LimiterConfigurationRpcImpl::load(LimiterConfigs& configs)
     request.set_limit(0);
 
     try {
-        stub.pageGetKVPairs(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.pageGetKVPairs(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -86,7 +89,9 @@ ErrorCode LimiterConfigurationRpcImpl::get(const std::set<std::string>& keys, Li
     }
 
     try {
-        stub.getKVPairs(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getKVPairs(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -127,7 +132,9 @@ ErrorCode LimiterConfigurationRpcImpl::set(const LimiterConfigs& configs)
     }
 
     try {
-        stub.setKVPairs(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setKVPairs(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -1,4 +1,5 @@
 #include "limiters_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 #include <map>
@@ -27,7 +28,9 @@ ErrorCode LimitersRpcImpl::getLimiters(const std::set<std::string>& keys, std::m
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getLimiter(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getLimiter(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -70,7 +73,9 @@ ErrorCode LimitersRpcImpl::setLimiters(const std::map<std::string, bcm::Limiter>
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setLimiter(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setLimiter(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -1,4 +1,5 @@
 #include "onetime_keys_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 #include "../../proto/brpc/rpc_onetime_key.pb.h"
 
@@ -27,7 +28,9 @@ ErrorCode OnetimeKeysRpcImpl::get(const std::string& uid, uint32_t deviceId, bcm
     request.set_deviceid(deviceId);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getOneTimeKeyByDevice(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getOneTimeKeyByDevice(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -56,7 +59,9 @@ ErrorCode OnetimeKeysRpcImpl::get(const std::string& uid, std::vector <bcm::Onet
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getOneTimeKeyByUser(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getOneTimeKeyByUser(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -102,7 +107,9 @@ ErrorCode OnetimeKeysRpcImpl::set(const std::string& uid, uint32_t deviceId,
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setOneTimeKey(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setOneTimeKey(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -130,7 +137,9 @@ ErrorCode OnetimeKeysRpcImpl::getCount(const std::string& uid, uint32_t deviceId
     request.set_deviceid(deviceId);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getOneTimeKeyCount(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getOneTimeKeyCount(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -165,7 +174,9 @@ ErrorCode OnetimeKeysRpcImpl::clear(const std::string& uid)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clearOneTypeKey(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clearOneTypeKey(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "OnetimeKeysRpcImpl::clear uid: " << uid
                  << " ,ErrorCode: " << cntl.ErrorCode()
@@ -203,7 +214,9 @@ ErrorCode OnetimeKeysRpcImpl::clear(const std::string& uid, uint32_t deviceId)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clearOneTypeKey(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clearOneTypeKey(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "OnetimeKeysRpcImpl::clear uid: " << uid
                  << " ,deviceId: " << deviceId
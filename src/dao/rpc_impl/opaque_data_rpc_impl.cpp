@@ -1,4 +1,5 @@
 #include "opaque_data_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 namespace bcm {
@@ -27,7 +28,9 @@ ErrorCode OpaqueDataRpcImpl::setOpaque(
     request.set_value(value);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_acq_rel));
     try {
-        stub.setOpaque(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setOpaque(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -54,7 +57,9 @@ ErrorCode OpaqueDataRpcImpl::getOpaque(
     request.set_key(key);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_acq_rel));
     try {
-        stub.getOpaque(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getOpaque(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
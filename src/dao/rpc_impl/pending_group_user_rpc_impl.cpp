@@ -1,4 +1,5 @@
 #include "pending_group_user_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 #include <map>
@@ -29,7 +30,9 @@ ErrorCode PendingGroupUserRpcImpl::set(const PendingGroupUser& user)
     *ppgu = user;
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insert(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insert(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -61,7 +64,9 @@ ErrorCode PendingGroupUserRpcImpl::query(uint64_t gid,
     request.set_count(count);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.query(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.query(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -94,7 +99,9 @@ ErrorCode PendingGroupUserRpcImpl::del(uint64_t gid, std::set<std::string> uids)
     }
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.del(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.del(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -121,7 +128,9 @@ ErrorCode PendingGroupUserRpcImpl::clear(uint64_t gid)
     request.set_gid(gid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clear(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clear(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -1,4 +1,5 @@
 #include "qr_code_group_users_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 namespace bcm {
@@ -25,7 +26,9 @@ ErrorCode QrCodeGroupUsersRpcImpl::get(uint64_t gid, const std::string& uid, bcm
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
 
     try {
-        stub.getQrCodeGroupUser(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getQrCodeGroupUser(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -57,7 +60,9 @@ ErrorCode QrCodeGroupUsersRpcImpl::set(const bcm::QrCodeGroupUser& user, int64_t
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
 
     try {
-        stub.setQrCodeGroupUser(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setQrCodeGroupUser(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
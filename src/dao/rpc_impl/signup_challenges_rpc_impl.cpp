@@ -1,4 +1,5 @@
 #include "signup_challenges_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 #include <map>
@@ -25,7 +26,9 @@ ErrorCode SignupChallengesRpcImpl::get(const std::string& uid, bcm::SignUpChalle
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.getSignUpChallenge(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getSignUpChallenge(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -60,7 +63,9 @@ ErrorCode SignupChallengesRpcImpl::set(const std::string& uid, const bcm::SignUp
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.setSignUpChallenge(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.setSignUpChallenge(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -85,7 +90,9 @@ ErrorCode SignupChallengesRpcImpl::del(const std::string& uid)
     request.set_uid(uid);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.delSignUpChallenge(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.delSignUpChallenge(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -6,6 +6,7 @@
 #include "utils/log.h"
 
 #include "stored_messages_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "../../proto/brpc/rpc_stored_message.pb.h"
 
 
@@ -34,7 +35,9 @@ ErrorCode StoredMessagesRpcImp::set(const bcm::StoredMessage& msg , uint32_t& un
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.set(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.set(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "StoredMessagesRpcImp set destination: " << msg.destination() << ",ErrorCode: "
                  << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
@@ -66,7 +69,9 @@ ErrorCode StoredMessagesRpcImp::clear(const std::string& destination)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clearMessageByDest(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clearMessageByDest(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "StoredMessagesRpcImp clear destination: " << destination
                  << ",ErrorCode: "
@@ -98,7 +103,9 @@ ErrorCode StoredMessagesRpcImp::clear(const std::string& destination, uint32_t d
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.clearMessageByDevice(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.clearMessageByDevice(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "StoredMessagesRpcImp clear destination: " << destination
                 << ",deviceId: " << destinationDeviceId << ",ErrorCode: "
@@ -132,7 +139,9 @@ ErrorCode StoredMessagesRpcImp::get(const std::string& destination, uint32_t des
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.load(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.load(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "StoredMessagesRpcImp get destination: " << destination
                  << ", deviceId: " << destinationDeviceId << ",ErrorCode: "
@@ -173,7 +182,9 @@ ErrorCode StoredMessagesRpcImp::del(const std::string& destination, const std::v
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.delMessageById(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.delMessageById(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "StoredMessagesRpcImp del destination: " << destination
                  << ",ErrorCode: " << cntl.ErrorCode()
@@ -6,6 +6,7 @@
 #include "utils/log.h"
 
 #include "sys_messages_rpc_impl.h"
+#include "fiber_rpc_done.h"
 
 
 namespace bcm {
@@ -36,7 +37,9 @@ ErrorCode SysMsgsRpcImpl::get(
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.get(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.get(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl get destination: " << destination
                  << ", maxMsgSize: " << maxMsgSize
@@ -80,7 +83,9 @@ ErrorCode SysMsgsRpcImpl::del(
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.batchDelete(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.batchDelete(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl del destination: " << destination
                  << ", msgId: " << msgId
@@ -120,7 +125,9 @@ ErrorCode SysMsgsRpcImpl::delBatch(
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.batchDelete(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.batchDelete(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl delBatch destination: " << destination
                  << ", ErrorCode: " << cntl.ErrorCode()
@@ -155,7 +162,9 @@ ErrorCode SysMsgsRpcImpl::delBatch(const std::string& destination, uint64_t maxM
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.cleanSysMsg(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.cleanSysMsg(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl delBatch destination: " << destination
                  << ", maxMid: " << maxMid
@@ -191,7 +200,9 @@ ErrorCode SysMsgsRpcImpl::insert(const bcm::SysMsg& msg)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insert(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insert(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl insert destination: " << msg.destination()
                  << ", msgid: " << msg.sysmsgid()
@@ -229,7 +240,9 @@ ErrorCode SysMsgsRpcImpl::insertBatch(const  std::vector<bcm::SysMsg>& msgs)
 
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_relaxed));
     try {
-        stub.insert(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.insert(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "SysMsgsRpcImpl insertBatch "
                  << ", ErrorCode: " << cntl.ErrorCode()
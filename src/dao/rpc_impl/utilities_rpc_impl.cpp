@@ -1,4 +1,5 @@
 #include "utilities_rpc_impl.h"
+#include "fiber_rpc_done.h"
 #include "utils/log.h"
 
 #include <sstream>
@@ -45,7 +46,9 @@ ErrorCode MasterLeaseRpcImpl::getLease(
     request.set_ttlms(ttlMs);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_acq_rel));
     try {
-        stub.getLease(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.getLease(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -78,7 +81,9 @@ ErrorCode MasterLeaseRpcImpl::renewLease(
     request.set_ttlms(ttlMs);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_acq_rel));
     try {
-        stub.renewLease(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.renewLease(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -114,7 +119,9 @@ ErrorCode MasterLeaseRpcImpl::releaseLease(
     request.set_value(local_lease_value);
     cntl.set_log_id(logId.fetch_add(1, std::memory_order_acq_rel));
     try {
-        stub.releaseLease(&cntl, &request, &response, nullptr);
+        FiberRpcDone done;
+        stub.releaseLease(&cntl, &request, &response, done.closure());
+        done.wait();
         if (cntl.Failed()) {
             LOGE << "ErrorCode: " << cntl.ErrorCode() << ", ErrorText: " << berror(cntl.ErrorCode());
             return ErrorCode::ERRORCODE_INTERNAL_ERROR;
@@ -0,0 +1,168 @@
+#include "connect_throttle.h"
+
+#include <set>
+
+#include "redis/hiredis_client.h"
+#include "redis/redis_manager.h"
+#include "utils/log.h"
+#include "utils/thread_utils.h"
+#include "../config/group_store_format.h"
+
+namespace bcm {
+
+ConnectThrottle::ConnectThrottle(const DispatcherConfig& config)
+    : m_maxConcurrent(config.maxConcurrentSubscribes)
+    , m_batchSize(config.connectBatchSize > 0 ? static_cast<size_t>(config.connectBatchSize) : 1)
+    , m_batchDelay(config.connectBatchDelayInMilli > 0 ? config.connectBatchDelayInMilli : 0)
+    , m_sender(&ConnectThrottle::sendLoop, this)
+{
+}
+
+ConnectThrottle::~ConnectThrottle()
+{
+    stop();
+}
+
+void ConnectThrottle::acquire()
+{
+    std::unique_lock<boost::fibers::mutex> l(m_slotMutex);
+    ++m_admitted;
+    if (m_maxConcurrent > 0 && m_concurrent >= m_maxConcurrent) {
+        ++m_waited;
+        m_slotCond.wait(l, [this]() { return m_concurrent < m_maxConcurrent; });
+    }
+    ++m_concurrent;
+    m_peakConcurrent = std::max(m_peakConcurrent, static_cast<uint32_t>(m_concurrent));
+}
+
+void ConnectThrottle::release()
+{
+    {
+        std::lock_guard<boost::fibers::mutex> l(m_slotMutex);
+        --m_concurrent;
+    }
+    m_slotCond.notify_one();
+}
+
+void ConnectThrottle::notifyConnected(const DispatchAddress& address, const std::string& notify)
+{
+    bool wakeUp = false;
+    {
+        std::lock_guard<std::mutex> l(m_queueMutex);
+        m_queue.push_back(Connected{address, notify});
+        ++m_stats.queued;
+        m_stats.peakPending = std::max(m_stats.peakPending, m_queue.size());
+        // the sender waits for the first one of a batch and for a full batch only
+        wakeUp = (m_queue.size() == 1 || m_queue.size() >= m_batchSize);
+    }
+    if (wakeUp) {
+        m_queueCond.notify_one();
+    }
+}
+
+void ConnectThrottle::flush()
+{
+    std::unique_lock<std::mutex> l(m_queueMutex);
+    m_queueCond.notify_one();
+    m_idleCond.wait(l, [this]() { return m_queue.empty() && !m_sending; });
+}
+
+void ConnectThrottle::stop()
+{
+    {
+        std::lock_guard<std::mutex> l(m_queueMutex);
+        if (m_stopped) {
+            return;
+        }
+        m_stopped = true;
+    }
+    m_queueCond.notify_one();
+    m_sender.join();
+    m_idleCond.notify_all();
+}
+
+ConnectThrottle::Stats ConnectThrottle::stats() const
+{
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> l(m_queueMutex);
+        stats = m_stats;
+        stats.pending = m_queue.size();
+    }
+    std::lock_guard<boost::fibers::mutex> l(m_slotMutex);
+    stats.admitted = m_admitted;
+    stats.waited = m_waited;
+    stats.peakConcurrent = m_peakConcurrent;
+    return stats;
+}
+
+void ConnectThrottle::sendLoop()
+{
+    setCurrentThreadName("dispatch.connect");
+
+    std::unique_lock<std::mutex> l(m_queueMutex);
+    for (;;) {
+        m_queueCond.wait(l, [this]() { return m_stopped || !m_queue.empty(); });
+        if (m_queue.empty()) {
+            // stopped, everything is sent
+            break;
+        }
+        if (m_queue.size() < m_batchSize && !m_stopped) {
+            m_queueCond.wait_for(l, m_batchDelay, [this]() {
+                return m_stopped || m_queue.size() >= m_batchSize;
+            });
+        }
+
+        size_t count = std::min(m_batchSize, m_queue.size());
+        std::vector<Connected> batch(std::make_move_iterator(m_queue.begin()),
+                                     std::make_move_iterator(m_queue.begin() + count));
+        m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+        m_sending = true;
+        l.unlock();
+
+        bool ok = send(batch);
+
+        l.lock();
+        m_sending = false;
+        ++m_stats.batches;
+        if (ok) {
+            m_stats.sent += batch.size();
+        } else {
+            ++m_stats.failedBatches;
+        }
+        if (m_queue.empty()) {
+            m_idleCond.notify_all();
+        }
+    }
+}
+
+bool ConnectThrottle::send(const std::vector<Connected>& batch)
+{
+    std::set<std::string> uids;
+    std::vector<RedisDbCmd> dels;
+    std::vector<std::string> channels;
+    std::vector<std::string> messages;
+    for (const auto& item : batch) {
+        const std::string& uid = item.address.getUid();
+        // the devices of a uid share the counter
+        if (uids.insert(uid).second) {
+            dels.push_back(RedisDbCmd::keyCmd(uid, {"DEL", REDISDB_KEY_APNS_UID_BADGE_PREFIX + uid}));
+        }
+        channels.push_back(item.address.getSerializedForOnlineNotify());
+        messages.push_back(item.notify);
+    }
+
+    bool ok = true;
+    std::vector<RedisCmdResult> results;
+    if (!RedisDbManager::Instance()->pipeline(dels, results)) {
+        LOGE << "failed to delete the push counters of " << dels.size() << " connected uids";
+        ok = false;
+    }
+    if (!RedisClientSync::Instance()->ppublish(channels, messages)) {
+        LOGW << "failed to publish the connect notify of " << channels.size() << " devices";
+        ok = false;
+    }
+    return ok;
+}
+
+}
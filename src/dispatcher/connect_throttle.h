@@ -0,0 +1,109 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/fiber/all.hpp>
+
+#include "dispatch_address.h"
+#include "config/dispatcher_config.h"
+
+namespace bcm {
+
+/*
+ * admission control for the redis side effects of connecting devices.
+ * at most maxConcurrentSubscribes connects run their side effects at once, the
+ * others wait in line, yielding their fiber. the deletion of the push badge counter
+ * and the online notification the apns qos manager listens to are queued and sent
+ * by one thread in pipelined batches, a reconnect storm costs a round trip per batch
+ * and redis instead of two per device.
+ */
+class ConnectThrottle {
+public:
+    struct Stats {
+        uint64_t admitted{0};
+        // admissions which had to wait for a slot
+        uint64_t waited{0};
+        uint32_t peakConcurrent{0};
+        uint64_t queued{0};
+        uint64_t sent{0};
+        uint64_t batches{0};
+        uint64_t failedBatches{0};
+        size_t pending{0};
+        size_t peakPending{0};
+    };
+
+    explicit ConnectThrottle(const DispatcherConfig& config);
+    ~ConnectThrottle();
+
+    // holds a slot of the budget for its scope, also when the scope is left by an exception
+    class Slot {
+    public:
+        explicit Slot(ConnectThrottle& throttle)
+            : m_throttle(throttle)
+        {
+            m_throttle.acquire();
+        }
+
+        ~Slot()
+        {
+            m_throttle.release();
+        }
+
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+    private:
+        ConnectThrottle& m_throttle;
+    };
+
+    // takes a slot of the budget, waits for one if all are taken
+    void acquire();
+    void release();
+
+    // queues the badge deletion and the online notification of a connected device
+    void notifyConnected(const DispatchAddress& address, const std::string& notify);
+
+    // returns once everything queued before is sent
+    void flush();
+    // sends what is queued and stops the sending thread
+    void stop();
+
+    Stats stats() const;
+
+private:
+    struct Connected {
+        DispatchAddress address;
+        std::string notify;
+    };
+
+    void sendLoop();
+    bool send(const std::vector<Connected>& batch);
+
+private:
+    int m_maxConcurrent;
+    size_t m_batchSize;
+    std::chrono::milliseconds m_batchDelay;
+
+    mutable boost::fibers::mutex m_slotMutex;
+    boost::fibers::condition_variable m_slotCond;
+    int m_concurrent{0};
+    uint64_t m_admitted{0};
+    uint64_t m_waited{0};
+    uint32_t m_peakConcurrent{0};
+
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueCond;
+    std::condition_variable m_idleCond;
+    std::deque<Connected> m_queue;
+    bool m_sending{false};
+    bool m_stopped{false};
+    Stats m_stats;
+    std::thread m_sender;
+};
+
+}
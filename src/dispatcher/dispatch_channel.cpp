@@ -1,4 +1,5 @@
 #include "dispatch_channel.h"
+#include "stored_message_drainer.h"
 #include <proto/websocket/websocket_protocol.pb.h>
 #include <proto/dao/stored_message.pb.h>
 #include <metrics_client.h>
@@ -23,6 +24,8 @@ using namespace metrics;
 
 static constexpr char kMetricsWebsocketServiceName[] = "websocket";
 static constexpr uint32_t kMaxCountDispatchOnce = 50;
+// stored messages sent to a session and not acknowledged yet
+static constexpr uint32_t kMaxUnackedStoredMessages = 200;
 
 DispatchChannel::DispatchChannel(asio::io_context& ioc, DispatchAddress address,
                                  std::shared_ptr<WebsocketSession> wsClient,
@@ -231,7 +234,8 @@ void DispatchChannel::dispatch(std::function<bool (WebsocketRequestMessage& requ
                                                    const std::vector<boost::any>& passing)> after)
 {
     auto self = shared_from_this();
-    FiberPool::post(m_ioc, [self, before, after]() {
+    // only talks to the websocket session through fiber aware calls, free to migrate
+    FiberPool::postMigratable(m_ioc, [self, before, after]() {
         std::vector<boost::any> passing;
         WebsocketRequestMessage requestMessage;
         if (!before(requestMessage, passing)) {
@@ -408,137 +412,111 @@ void DispatchChannel::sendStoredMessages()
         return;
     }
 
+    // one drain at a time, a request coming in meanwhile makes the running one read again
+    m_drainRequested = true;
+    bool draining = false;
+    if (!m_draining.compare_exchange_strong(draining, true)) {
+        return;
+    }
+
     auto self = shared_from_this();
+    // only talks to the websocket session through fiber aware calls, free to migrate
+    FiberPool::postMigratable(m_ioc, [self]() {
+        do {
+            self->m_drainRequested = false;
+            self->drainStoredMessages();
+            self->m_draining = false;
+        } while (self->m_drainRequested && !self->m_draining.exchange(true));
+    });
+}
 
-    auto prepareRequest = [self](WebsocketRequestMessage& request, std::vector<boost::any>& passing) {
-        const auto& account = boost::any_cast<Account>(self->m_wsClient->getAuthenticated());
-        auto authDevice = AccountsManager::getAuthDevice(account);
-        if (!authDevice) {
-            return false;
-        }
-        auto& device = *authDevice;
-        bool hasMore = false;
-        int64_t startTime = nowInMicro();
+void DispatchChannel::drainStoredMessages()
+{
+    const auto& account = boost::any_cast<Account>(m_wsClient->getAuthenticated());
+    auto authDevice = AccountsManager::getAuthDevice(account);
+    if (!authDevice) {
+        return;
+    }
+    std::string signalingKey = authDevice->signalingkey();
 
-        auto dispatchManager = self->m_dispatchManager.lock();
-        if (dispatchManager == nullptr) {
-            LOGW << "dispatch manager is destroyed";
-            return false;
-        }
+    auto dispatchManager = m_dispatchManager.lock();
+    if (dispatchManager == nullptr) {
+        LOGW << "dispatch manager is destroyed";
+        return;
+    }
 
-        LOGD << "prepare stored messages for " << self->m_address;
+    LOGD << "drain stored messages for " << m_address;
 
-        std::vector<StoredMessage> messages;
-        auto ret = dispatchManager->getMessagesManager().get(account.uid(),
-                                                             account.authdeviceid(),
-                                                             kMaxCountDispatchOnce,
-                                                             messages,
-                                                             hasMore);
-        if (!ret) {
-            return false;
+    auto self = shared_from_this();
+    auto filter = [self](const StoredMessage& message) {
+        if (!self->isMessageStaleAndClientObsolete(message)) {
+            return StoredMessageDrainer::SEND;
         }
-
-        if (messages.empty()) {
-            LOGT << "not stored message to push for " << self->m_address;
-            self->sendEmpty();
-            return false;
+        if (self->sendReceipt(MessagesManager::convert(message), "STALE")) {
+            return StoredMessageDrainer::DROP;
         }
+        return StoredMessageDrainer::KEEP;
+    };
 
+    auto sender = [self, signalingKey](const std::vector<StoredMessage>& batch) -> StoredMessageDrainer::Ack {
+        int64_t startTime = nowInMicro();
         Mailbox mailbox;
-        std::vector<uint64_t> toDeleteMessagesIds;
-        std::vector<uint64_t> toSendMessagesIds;
-        for (auto& message : messages) {
-            auto&& envelope = MessagesManager::convert(message);
-
-            if (self->isMessageStaleAndClientObsolete(message)) {
-                if (self->sendReceipt(envelope, "STALE")) {
-                    toDeleteMessagesIds.push_back(message.id());
-                }
-                continue;
-            }
-            toSendMessagesIds.push_back(message.id());
-            *mailbox.add_envelopes() = envelope;
-        }
-
-        if (!toDeleteMessagesIds.empty()) {
-            dispatchManager->getMessagesManager().del(account.uid(), toDeleteMessagesIds);
-        }
-
-        if (mailbox.envelopes().empty()) {
-            LOGI << "not fresh stored message to push for " << self->m_address;
-            self->sendEmpty();
-            return false;
+        for (const auto& message : batch) {
+            *mailbox.add_envelopes() = MessagesManager::convert(message);
         }
 
         std::string payload;
-        ret = self->encrypt(device.signalingkey(), mailbox.SerializeAsString(), payload);
-        if (!ret) {
-            LOGE << "encrypt failed for " << self->m_address
-                 << ", signaling key is " << device.signalingkey();
-            return false;
+        if (!self->encrypt(signalingKey, mailbox.SerializeAsString(), payload)) {
+            LOGE << "encrypt failed for " << self->m_address << ", signaling key is " << signalingKey;
+            return nullptr;
         }
 
+        WebsocketRequestMessage request;
         request.set_verb("PUT");
         request.set_path("/api/v1/messages");
         request.set_body(std::move(payload));
 
-        LOGD << "prepare " << mailbox.envelopes().size() << "stored messages for " << self->m_address;
-
-        passing.clear();
-        passing.emplace_back(hasMore);
-        passing.emplace_back(std::move(mailbox));
-        passing.emplace_back(std::move(toSendMessagesIds));
-        passing.emplace_back(startTime);
-        return true;
-    };
-
-
-    auto handleResponse = [self](const WebsocketResponseMessage& response, const std::vector<boost::any>& passing) {
-        const auto& account = boost::any_cast<Account>(self->m_wsClient->getAuthenticated());
-        auto authDevice = AccountsManager::getAuthDevice(account);
-        if (!authDevice) {
-            return false;
-        }
-        auto& device = *authDevice;
-        auto hasMore = boost::any_cast<bool>(passing[0]);
-        auto mailbox = boost::any_cast<Mailbox>(passing[1]);
-        auto sentMessagesIds = boost::any_cast<std::vector<uint64_t>>(passing[2]);
-        auto startTime = boost::any_cast<int64_t>(passing[3]);
-
-        if (http::to_status_class(response.status()) == http::status_class::successful) {
-            auto dispatchManager = self->m_dispatchManager.lock();
-            if (dispatchManager == nullptr) {
-                LOGW << "dispatch manager is destroyed";
-                return false;
-            }
-
-            dispatchManager->getMessagesManager().del(account.uid(), sentMessagesIds);
-
-            MetricsClient::Instance()->markMicrosecondAndRetCode(kMetricsWebsocketServiceName, "sendStoredMessages",
-                                                                 (nowInMicro() - startTime), 0);
-
-            LOGD << "success to dispatch offline messages,"
-                 << " to :" << account.uid() << "." << device.id()
-                 << ", duration(micro): " << nowInMicro() - startTime;
-
-            if (hasMore) {
-                self->sendStoredMessages();
-            } else {
-                self->sendEmpty();
+        auto responsePromise = std::make_shared<fibers::promise<WebsocketResponseMessage>>();
+        auto responseFuture = std::make_shared<fibers::future<WebsocketResponseMessage>>(
+            responsePromise->get_future());
+        self->m_wsClient->sendRequest(request, responsePromise);
+
+        return [self, responseFuture, startTime]() {
+            WebsocketResponseMessage response = responseFuture->get();
+            if (http::to_status_class(response.status()) == http::status_class::successful) {
+                MetricsClient::Instance()->markMicrosecondAndRetCode(kMetricsWebsocketServiceName,
+                                                                     "sendStoredMessages",
+                                                                     (nowInMicro() - startTime), 0);
+                return true;
             }
-        } else {
             MetricsClient::Instance()->markMicrosecondAndRetCode(kMetricsWebsocketServiceName, "sendStoredMessages",
                                                                  (nowInMicro() - startTime), 1);
-
-            LOGD << "failed to dispatch offline messages,"
-                 << " to :" << account.uid() << "." << device.id()
+            LOGD << "failed to dispatch offline messages to " << self->m_address
                  << ", duration(micro): " << nowInMicro() - startTime
                  << ", status: " << response.status();
-        }
-        return true;
+            return false;
+        };
     };
 
-    dispatch(prepareRequest, handleResponse);
+    StoredMessageDrainer::Options options;
+    options.batchSize = kMaxCountDispatchOnce;
+    options.maxUnacked = kMaxUnackedStoredMessages;
+    options.pageSize = kMaxUnackedStoredMessages;
+    options.deleteBatch = kMaxUnackedStoredMessages;
+    StoredMessageDrainer drainer(dispatchManager->getMessagesManager(), account.uid(), account.authdeviceid(),
+                                 options);
+    int64_t startTime = nowInMicro();
+    bool drained = drainer.drain(sender, filter);
+
+    const auto& stats = drainer.stats();
+    LOGD << (drained ? "drained" : "stopped draining") << " stored messages for " << m_address
+         << ", sent: " << stats.sent << ", dropped: " << stats.dropped << ", batches: " << stats.batches
+         << ", reads: " << stats.reads << ", deletes: " << stats.deletes
+         << ", duration(micro): " << nowInMicro() - startTime;
+
+    if (drained) {
+        sendEmpty();
+    }
 }
 
 void DispatchChannel::sendStoredMessagesLegacy()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include "idispatcher.h"
 #include "dispatch_address.h"
 #include "dispatch_manager.h"
@@ -40,6 +41,7 @@ private:
 
     void sendP2pMessage(const Envelope& envelope, boost::optional<uint64_t> storageId, bool remain);
     void sendStoredMessages();
+    void drainStoredMessages();
     void sendStoredMessagesLegacy();
     bool sendReceipt(const Envelope& envelope, const std::string& payload);
     void sendEmpty();
@@ -59,6 +61,8 @@ private:
     std::shared_ptr<WebsocketSession> m_wsClient;
     std::weak_ptr<DispatchManager> m_dispatchManager;
     EncryptSenderConfig m_encryptSenderConfig;
+    std::atomic<bool> m_draining{false};
+    std::atomic<bool> m_drainRequested{false};
 };
 
 }
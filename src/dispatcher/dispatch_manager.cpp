@@ -15,12 +15,14 @@ DispatchManager::DispatchManager(DispatcherConfig config,
                                  std::shared_ptr<OfflineDispatcher> offlineDispatcher,
                                  std::shared_ptr<dao::Contacts> contacts,
                                  EncryptSenderConfig& cfg)
-        : m_bridge(1)
-        , m_workerPool(static_cast<size_t>(config.concurrency))
+        : m_bridge(1, false, static_cast<size_t>(std::max(config.fiberStackSize, 0)))
+        , m_workerPool(static_cast<size_t>(config.concurrency), config.workStealing,
+                       static_cast<size_t>(std::max(config.fiberStackSize, 0)))
         , m_offlineDispatcher(std::move(offlineDispatcher))
         , m_messagesManager(std::move(messagesManager))
         , m_contacts(std::move(contacts))
         , m_encryptSenderConfig(cfg)
+        , m_connectThrottle(config)
 {
 }
 
@@ -37,6 +39,7 @@ void DispatchManager::start()
 void DispatchManager::stop()
 {
     m_messageDispatching = false;
+    m_connectThrottle.stop();
     m_bridge.stop();
 }
 
@@ -98,33 +101,38 @@ uint64_t DispatchManager::subscribe(const DispatchAddress& address,
 
     auto oldDispatcher = replaceDispatcher(address, newDispatcher);
 
-    // sending a connected message, another server should recive it and kick off the obsolete connection
-    PubSubMessage message;
-    message.set_type(PubSubMessage::CONNECTED);
-    message.set_content(std::to_string(newDispatcher->getIdentity()));
-    std::string connectNotify = message.SerializeAsString();
-    
-    publish(address, connectNotify);
-    
-    if (!RedisDbManager::Instance()->del(address.getUid(), bcm::REDISDB_KEY_APNS_UID_BADGE_PREFIX + address.getUid())) {
-        LOGE << "delete RedisDbManager push counter false, uid: " << address.getUid();
-    }
-    
-    if (!RedisClientSync::Instance()->publishRes(
-            address.getSerializedForOnlineNotify(), connectNotify)) {
-        LOGW << "failed to publish connect notify to address: " 
-             << address.getSerializedForOnlineNotify();
-    }
+    {
+        // the redis side effects of a reconnect storm go through the budget
+        ConnectThrottle::Slot slot(m_connectThrottle);
+
+        // sending a connected message, another server should recive it and kick off the obsolete connection
+        PubSubMessage message;
+        message.set_type(PubSubMessage::CONNECTED);
+        message.set_content(std::to_string(newDispatcher->getIdentity()));
+        std::string connectNotify = message.SerializeAsString();
+
+        // not waited for, the channel of this connection ignores its own identity
+        DispatchAddress kicked = address;
+        OnlineRedisManager::Instance()->publish(address.getUid(), address.getSerialized(), connectNotify,
+                    [kicked](int status, const redis::Reply& reply) {
+                        if (REDIS_OK != status || !reply.isInteger()) {
+                            LOGE << "failed to publish connected message.(" << kicked << ")";
+                        }
+                    });
+
+        // the push counter deletion and the connect notify are sent in batches
+        m_connectThrottle.notifyConnected(address, connectNotify);
+
+        if (OnlineRedisManager::Instance()->subscribe(address.getUid(), address.getSerialized(), this)) {
+            LOGI << "success to subscribe dispatch channel.(" << address << " " << newDispatcher << ")";
+        } else {
+            LOGE << "failed to subscribe dispatch channel.(" << address << " " << newDispatcher << ")";
+            // will resubscribe if connected.
+        }
 
-    if (OnlineRedisManager::Instance()->subscribe(address.getUid(), address.getSerialized(), this)) {
-        LOGI << "success to subscribe dispatch channel.(" << address << " " << newDispatcher << ")";
-    } else {
-        LOGE << "failed to subscribe dispatch channel.(" << address << " " << newDispatcher << ")";
-        // will resubscribe if connected.
+        onUserStatusChange(address, true);
     }
 
-    onUserStatusChange(address, true);
-
     if (oldDispatcher) {
         LOGI << "unsubscribe old dispatch channel.(" << address << " " << oldDispatcher << ")";
         oldDispatcher->onDispatchUnsubscribed(true);
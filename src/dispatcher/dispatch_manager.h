@@ -5,6 +5,7 @@
 #include "idispatcher.h"
 #include "dispatch_address.h"
 #include "offline_dispatcher.h"
+#include "connect_throttle.h"
 #include "config/encrypt_sender.h"
 #include <redis/iasync_redis_event.h>
 #include <fiber/fiber_pool.h>
@@ -55,6 +56,7 @@ public:
     bool publish(const DispatchAddress& address, const std::string& message);
     void kick(const DispatchAddress& address);
     bool hasLocalSubscription(const DispatchAddress& address);
+    ConnectThrottle::Stats getConnectStats() const { return m_connectThrottle.stats(); }
 
     OfflineDispatcher& getOfflineDispatcher() { return *m_offlineDispatcher; }
     MessagesManager& getMessagesManager() { return *m_messagesManager; }
@@ -135,6 +137,7 @@ private:
     std::vector<Message> m_messageQueue;
     bool m_messageDispatching{false};
     EncryptSenderConfig m_encryptSenderConfig;
+    ConnectThrottle m_connectThrottle;
 };
 
 }
@@ -0,0 +1,454 @@
+#include "presence_index.h"
+
+#include <algorithm>
+#include <boost/core/ignore_unused.hpp>
+#include <hiredis/hiredis.h>
+
+#include "redis/online_redis_manager.h"
+#include "redis/reply.h"
+#include "utils/log.h"
+#include "utils/time.h"
+
+namespace bcm {
+
+constexpr size_t PresenceIndex::kShardBits;
+
+// version, type, generation, node name length
+static const size_t kHeaderSize = 5;
+static const uint8_t kVersion = 1;
+// uid hash, device id and, in deltas, the online flag
+static const size_t kRecordSize = 12;
+static const size_t kDeltaRecordSize = kRecordSize + 1;
+
+static void putUint(std::string& out, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+static uint64_t getUint(const char* in, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+PresenceIndex::PresenceIndex(const PresenceConfig& config, const std::string& selfNode,
+                             Publisher publisher)
+    : m_config(config)
+    , m_selfName(selfNode)
+    , m_publisher(std::move(publisher))
+    // a restarted server does not reuse the generation its old devices were sent with
+    , m_gen(static_cast<uint16_t>(nowInMilli()))
+{
+    if (m_config.maxBatch <= 0) {
+        m_config.maxBatch = 1;
+    }
+    if (!m_selfName.empty()) {
+        std::lock_guard<std::mutex> l(m_nodesMtx);
+        m_selfNode = nodeIdLocked(m_selfName);
+        m_nodes[m_selfNode].alive = true;
+    }
+}
+
+void PresenceIndex::start()
+{
+    if (m_publisher == nullptr) {
+        OnlineRedisManager::Instance()->subscribe(m_config.channel, this);
+    }
+}
+
+void PresenceIndex::stop()
+{
+    if (m_selfNode != PresenceTable::kInvalidNode) {
+        publish(header(kLeave, m_gen));
+    }
+    if (m_publisher == nullptr) {
+        OnlineRedisManager::Instance()->unsubscribe(m_config.channel);
+    }
+}
+
+bool PresenceIndex::isReady() const
+{
+    int64_t subscribedAt = m_subscribedAt;
+    return subscribedAt > 0
+           && nowInMilli() - subscribedAt >= m_config.snapshotIntervalInMilli + m_config.flushIntervalInMilli;
+}
+
+uint64_t PresenceIndex::hashUid(const std::string& uid)
+{
+    // FNV-1a, every server must hash the same way
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : uid) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+PresenceIndex::Shard& PresenceIndex::shardOf(uint64_t uidHash)
+{
+    return m_shards[uidHash >> (64 - kShardBits)];
+}
+
+const PresenceIndex::Shard& PresenceIndex::shardOf(uint64_t uidHash) const
+{
+    return m_shards[uidHash >> (64 - kShardBits)];
+}
+
+bool PresenceIndex::isOnline(const std::string& uid) const
+{
+    uint64_t uidHash = hashUid(uid);
+    const Shard& shard = shardOf(uidHash);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    return shard.table.contains(uidHash);
+}
+
+bool PresenceIndex::isOnline(const DispatchAddress& address) const
+{
+    uint64_t uidHash = hashUid(address.getUid());
+    const Shard& shard = shardOf(uidHash);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    return shard.table.find(uidHash, address.getDeviceid()) != PresenceTable::kInvalidNode;
+}
+
+std::string PresenceIndex::locate(const DispatchAddress& address) const
+{
+    uint64_t uidHash = hashUid(address.getUid());
+    uint16_t node = PresenceTable::kInvalidNode;
+    {
+        const Shard& shard = shardOf(uidHash);
+        std::lock_guard<std::mutex> l(shard.mtx);
+        node = shard.table.find(uidHash, address.getDeviceid());
+    }
+    if (node == PresenceTable::kInvalidNode) {
+        return "";
+    }
+    std::lock_guard<std::mutex> l(m_nodesMtx);
+    return m_nodes[node].name;
+}
+
+PresenceIndex::Stats PresenceIndex::stats() const
+{
+    Stats stats;
+    stats.memory = sizeof(*this);
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        stats.devices += shard.table.size();
+        stats.memory += shard.table.memoryUsage();
+    }
+    {
+        std::lock_guard<std::mutex> l(m_nodesMtx);
+        for (const auto& node : m_nodes) {
+            if (node.alive) {
+                ++stats.nodes;
+            }
+        }
+    }
+    stats.localDevices = m_localDevices;
+    stats.messagesSent = m_messagesSent;
+    stats.messagesReceived = m_messagesReceived;
+    stats.messagesDropped = m_messagesDropped;
+    return stats;
+}
+
+uint16_t PresenceIndex::nodeIdLocked(const std::string& name)
+{
+    auto it = m_nodeIds.find(name);
+    if (it != m_nodeIds.end()) {
+        return it->second;
+    }
+    // ids are never reused, a server coming back keeps its id
+    if (m_nodes.size() >= PresenceTable::kInvalidNode) {
+        return PresenceTable::kInvalidNode;
+    }
+    auto id = static_cast<uint16_t>(m_nodes.size());
+    m_nodes.push_back(Node{name, 0, false});
+    m_nodeIds.emplace(name, id);
+    return id;
+}
+
+void PresenceIndex::onUserOnline(const DispatchAddress& user)
+{
+    change(user, true);
+}
+
+void PresenceIndex::onUserOffline(const DispatchAddress& user)
+{
+    change(user, false);
+}
+
+void PresenceIndex::change(const DispatchAddress& address, bool online)
+{
+    if (m_selfNode == PresenceTable::kInvalidNode) {
+        return;
+    }
+
+    uint64_t uidHash = hashUid(address.getUid());
+    bool changed = false;
+    {
+        Shard& shard = shardOf(uidHash);
+        std::lock_guard<std::mutex> l(shard.mtx);
+        changed = online ? shard.table.add(uidHash, address.getDeviceid(), m_selfNode, m_gen)
+                         : shard.table.remove(uidHash, address.getDeviceid(), m_selfNode);
+    }
+    // a replaced connection of the same device is not a change
+    if (!changed) {
+        return;
+    }
+    if (online) {
+        ++m_localDevices;
+    } else {
+        --m_localDevices;
+    }
+
+    std::lock_guard<std::mutex> l(m_pendingMtx);
+    m_pending.push_back(Change{uidHash, address.getDeviceid(), online});
+}
+
+void PresenceIndex::onSubscribe(const std::string& chan)
+{
+    if (chan != m_config.channel) {
+        return;
+    }
+    // also after a reconnection, the messages in between are lost
+    m_subscribedAt = nowInMilli();
+    LOGI << "presence index subscribed: " << chan;
+}
+
+void PresenceIndex::onUnsubscribe(const std::string& chan)
+{
+    if (chan != m_config.channel) {
+        return;
+    }
+    m_subscribedAt = 0;
+    LOGI << "presence index unsubscribed: " << chan;
+}
+
+void PresenceIndex::onError(int code)
+{
+    LOGE << "presence index subscription error: " << code;
+}
+
+void PresenceIndex::onMessage(const std::string& chan, const std::string& msg)
+{
+    if (chan != m_config.channel) {
+        return;
+    }
+    ++m_messagesReceived;
+    if (!apply(msg)) {
+        ++m_messagesDropped;
+        LOGW << "presence index dropped a malformed message, size: " << msg.size();
+    }
+}
+
+bool PresenceIndex::apply(const std::string& msg)
+{
+    if (msg.size() < kHeaderSize || static_cast<uint8_t>(msg[0]) != kVersion) {
+        return false;
+    }
+    auto type = static_cast<uint8_t>(msg[1]);
+    auto gen = static_cast<uint16_t>(getUint(msg.data() + 2, 2));
+    size_t nameSize = static_cast<uint8_t>(msg[4]);
+    if (msg.size() < kHeaderSize + nameSize) {
+        return false;
+    }
+    std::string name = msg.substr(kHeaderSize, nameSize);
+    if (name.empty()) {
+        return false;
+    }
+    if (name == m_selfName) {
+        return true;
+    }
+
+    const char* records = msg.data() + kHeaderSize + nameSize;
+    size_t recordsSize = msg.size() - kHeaderSize - nameSize;
+    size_t recordSize = (type == kDelta) ? kDeltaRecordSize : kRecordSize;
+    if (recordsSize % recordSize != 0) {
+        return false;
+    }
+
+    uint16_t node = PresenceTable::kInvalidNode;
+    {
+        std::lock_guard<std::mutex> l(m_nodesMtx);
+        node = nodeIdLocked(name);
+        if (node == PresenceTable::kInvalidNode) {
+            LOGE << "presence index has too many nodes, ignore: " << name;
+            return false;
+        }
+        m_nodes[node].lastSeen = nowInMilli();
+        m_nodes[node].alive = (type != kLeave);
+    }
+
+    switch (type) {
+        case kDelta:
+        case kSnapshot:
+            for (const char* p = records; p < records + recordsSize; p += recordSize) {
+                bool online = (type == kSnapshot) || (p[0] != 0);
+                const char* record = (type == kDelta) ? p + 1 : p;
+                uint64_t uidHash = getUint(record, 8);
+                auto deviceId = static_cast<uint32_t>(getUint(record + 8, 4));
+                Shard& shard = shardOf(uidHash);
+                std::lock_guard<std::mutex> l(shard.mtx);
+                if (online) {
+                    shard.table.add(uidHash, deviceId, node, gen);
+                } else {
+                    shard.table.remove(uidHash, deviceId, node);
+                }
+            }
+            return true;
+        case kSnapshotEnd: {
+            // whatever the node did not resend with this generation is gone
+            size_t purged = 0;
+            for (auto& shard : m_shards) {
+                std::lock_guard<std::mutex> l(shard.mtx);
+                purged += shard.table.purge(node, gen);
+            }
+            if (purged > 0) {
+                LOGI << "presence index purged " << purged << " stale devices of " << name;
+            }
+            return true;
+        }
+        case kLeave:
+            LOGI << "presence index node left: " << name;
+            dropNode(node);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void PresenceIndex::run()
+{
+    int64_t start = nowInMilli();
+    flush();
+    if (m_selfNode != PresenceTable::kInvalidNode && start >= m_nextSnapshotAt) {
+        publishSnapshot();
+        m_nextSnapshotAt = start + m_config.snapshotIntervalInMilli;
+    }
+    expireNodes(start);
+    m_execTime = nowInMilli() - start;
+}
+
+int64_t PresenceIndex::lastExecTimeInMilli()
+{
+    return m_execTime;
+}
+
+std::string PresenceIndex::header(MessageType type, uint16_t gen) const
+{
+    std::string out;
+    out.reserve(kHeaderSize + m_selfName.size());
+    out.push_back(static_cast<char>(kVersion));
+    out.push_back(static_cast<char>(type));
+    putUint(out, gen, 2);
+    // register keys are ip:port, far below the limit
+    size_t nameSize = std::min<size_t>(m_selfName.size(), UINT8_MAX);
+    out.push_back(static_cast<char>(nameSize));
+    out.append(m_selfName, 0, nameSize);
+    return out;
+}
+
+void PresenceIndex::publish(const std::string& message)
+{
+    ++m_messagesSent;
+    if (m_publisher != nullptr) {
+        m_publisher(m_config.channel, message);
+        return;
+    }
+    OnlineRedisManager::Instance()->publish(m_config.channel, message,
+        [](int status, const redis::Reply& reply) {
+            boost::ignore_unused(reply);
+            if (REDIS_OK != status) {
+                // the next snapshot repairs it
+                LOGW << "presence index failed to publish, status: " << status;
+            }
+        });
+}
+
+void PresenceIndex::flush()
+{
+    std::vector<Change> pending;
+    {
+        std::lock_guard<std::mutex> l(m_pendingMtx);
+        pending.swap(m_pending);
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    auto batch = static_cast<size_t>(m_config.maxBatch);
+    for (size_t begin = 0; begin < pending.size(); begin += batch) {
+        size_t end = std::min(begin + batch, pending.size());
+        std::string message = header(kDelta, m_gen);
+        message.reserve(message.size() + (end - begin) * kDeltaRecordSize);
+        for (size_t i = begin; i < end; ++i) {
+            message.push_back(pending[i].online ? 1 : 0);
+            putUint(message, pending[i].uidHash, 8);
+            putUint(message, pending[i].deviceId, 4);
+        }
+        publish(message);
+    }
+}
+
+void PresenceIndex::publishSnapshot()
+{
+    // deltas queued from now on carry the new generation as well
+    uint16_t gen = ++m_gen;
+    auto batch = static_cast<size_t>(m_config.maxBatch);
+
+    std::vector<std::string> messages;
+    std::string message = header(kSnapshot, gen);
+    size_t records = 0;
+    for (auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        shard.table.forEach(m_selfNode, [&](uint64_t uidHash, uint32_t deviceId) {
+            putUint(message, uidHash, 8);
+            putUint(message, deviceId, 4);
+            if (++records == batch) {
+                messages.push_back(std::move(message));
+                message = header(kSnapshot, gen);
+                records = 0;
+            }
+        });
+    }
+    if (records > 0) {
+        messages.push_back(std::move(message));
+    }
+    messages.push_back(header(kSnapshotEnd, gen));
+    for (const auto& m : messages) {
+        publish(m);
+    }
+}
+
+void PresenceIndex::expireNodes(int64_t now)
+{
+    std::vector<uint16_t> expired;
+    {
+        std::lock_guard<std::mutex> l(m_nodesMtx);
+        for (size_t i = 0; i < m_nodes.size(); ++i) {
+            Node& node = m_nodes[i];
+            if (i != m_selfNode && node.alive && now - node.lastSeen > m_config.nodeTimeoutInMilli) {
+                LOGW << "presence index node timeout: " << node.name;
+                node.alive = false;
+                expired.push_back(static_cast<uint16_t>(i));
+            }
+        }
+    }
+    for (uint16_t node : expired) {
+        dropNode(node);
+    }
+}
+
+void PresenceIndex::dropNode(uint16_t node)
+{
+    for (auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        shard.table.removeNode(node);
+    }
+}
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dispatch_manager.h"
+#include "presence_table.h"
+#include "config/presence_config.h"
+#include "fiber/fiber_timer.h"
+#include "redis/async_conn.h"
+
+namespace bcm {
+
+/*
+ * in memory view of the devices online in the cluster, answers "is online" and
+ * "which im server" without a redis round trip.
+ * every im server follows the connects and disconnects of its own devices and
+ * publishes them in batches on a channel of the online redis, the other servers
+ * and observers (the offline server) apply them to their copy. each server resends
+ * all its devices at snapshotIntervalInMilli, devices missing from it are dropped,
+ * so lost messages and crashed servers are repaired within an interval or a
+ * nodeTimeoutInMilli.
+ * uids are kept as 64-bit hashes, a hash collision reports an offline uid online.
+ */
+class PresenceIndex : public DispatchManager::IUserStatusListener
+                    , public redis::AsyncConn::ISubscriptionHandler
+                    , public FiberTimer::Task {
+public:
+    typedef std::function<void(const std::string& channel, const std::string& message)> Publisher;
+
+    struct Stats {
+        uint64_t devices{0};
+        uint64_t localDevices{0};
+        uint32_t nodes{0};
+        uint64_t messagesSent{0};
+        uint64_t messagesReceived{0};
+        uint64_t messagesDropped{0};
+        uint64_t memory{0};
+    };
+
+    // selfNode names this im server to the others, an empty one only follows the
+    // cluster. messages go to the online redis unless a publisher is given
+    PresenceIndex(const PresenceConfig& config, const std::string& selfNode,
+                  Publisher publisher = nullptr);
+
+    // subscribes the channel on the online redis
+    void start();
+    // tells the others to drop the devices of this server
+    void stop();
+
+    // false until an interval of snapshots was received after subscribing, the
+    // answers may miss devices before
+    bool isReady() const;
+
+    bool isOnline(const std::string& uid) const;
+    bool isOnline(const DispatchAddress& address) const;
+    // im server of the device, empty if it is offline
+    std::string locate(const DispatchAddress& address) const;
+
+    Stats stats() const;
+
+    static uint64_t hashUid(const std::string& uid);
+
+    // DispatchManager::IUserStatusListener
+    void onUserOnline(const DispatchAddress& user) override;
+    void onUserOffline(const DispatchAddress& user) override;
+
+    // redis::AsyncConn::ISubscriptionHandler
+    void onSubscribe(const std::string& chan) override;
+    void onUnsubscribe(const std::string& chan) override;
+    void onMessage(const std::string& chan, const std::string& msg) override;
+    void onError(int code) override;
+
+    // FiberTimer::Task, publishes the pending changes and the snapshots
+    void run() override;
+    int64_t lastExecTimeInMilli() override;
+
+private:
+    enum MessageType : uint8_t {
+        kDelta = 1,
+        kSnapshot = 2,
+        kSnapshotEnd = 3,
+        kLeave = 4,
+    };
+
+    struct Change {
+        uint64_t uidHash;
+        uint32_t deviceId;
+        bool online;
+    };
+
+    struct Node {
+        std::string name;
+        int64_t lastSeen{0};
+        bool alive{false};
+    };
+
+    struct Shard {
+        mutable std::mutex mtx;
+        PresenceTable table;
+    };
+
+    static constexpr size_t kShardBits = 6;
+
+    Shard& shardOf(uint64_t uidHash);
+    const Shard& shardOf(uint64_t uidHash) const;
+
+    // lock held
+    uint16_t nodeIdLocked(const std::string& name);
+
+    void change(const DispatchAddress& address, bool online);
+    void flush();
+    void publishSnapshot();
+    void expireNodes(int64_t now);
+    void dropNode(uint16_t node);
+
+    std::string header(MessageType type, uint16_t gen) const;
+    void publish(const std::string& message);
+    bool apply(const std::string& msg);
+
+private:
+    PresenceConfig m_config;
+    std::string m_selfName;
+    uint16_t m_selfNode{PresenceTable::kInvalidNode};
+    Publisher m_publisher;
+
+    std::array<Shard, 1 << kShardBits> m_shards;
+
+    mutable std::mutex m_nodesMtx;
+    std::unordered_map<std::string, uint16_t> m_nodeIds;
+    std::vector<Node> m_nodes;
+
+    std::mutex m_pendingMtx;
+    std::vector<Change> m_pending;
+
+    std::atomic<uint16_t> m_gen;
+    std::atomic<int64_t> m_subscribedAt{0};
+    int64_t m_nextSnapshotAt{0};
+    int64_t m_execTime{0};
+
+    std::atomic<uint64_t> m_localDevices{0};
+    std::atomic<uint64_t> m_messagesSent{0};
+    std::atomic<uint64_t> m_messagesReceived{0};
+    std::atomic<uint64_t> m_messagesDropped{0};
+};
+
+}
@@ -0,0 +1,159 @@
+#include "presence_table.h"
+
+namespace bcm {
+
+const uint16_t PresenceTable::kInvalidNode;
+
+static const size_t kInitialSlots = 256;
+
+PresenceTable::PresenceTable()
+    : m_slots(kInitialSlots, Slot{0, 0, kInvalidNode, 0})
+{
+}
+
+size_t PresenceTable::home(uint64_t uidHash) const
+{
+    // the low bits of FNV are poorly mixed and the high ones pick the shard of the owner
+    uidHash ^= uidHash >> 29;
+    uidHash *= 0xbf58476d1ce4e5b9ULL;
+    uidHash ^= uidHash >> 32;
+    return static_cast<size_t>(uidHash) & (m_slots.size() - 1);
+}
+
+bool PresenceTable::add(uint64_t uidHash, uint32_t deviceId, uint16_t node, uint16_t gen)
+{
+    size_t mask = m_slots.size() - 1;
+    size_t pos = home(uidHash);
+    for (; m_slots[pos].node != kInvalidNode; pos = (pos + 1) & mask) {
+        Slot& slot = m_slots[pos];
+        if (slot.uidHash == uidHash && slot.deviceId == deviceId && slot.node == node) {
+            slot.gen = gen;
+            return false;
+        }
+    }
+    m_slots[pos] = Slot{uidHash, deviceId, node, gen};
+    ++m_size;
+
+    // keep the load factor under 0.75, probe runs stay short
+    if (m_size * 4 > m_slots.size() * 3) {
+        rehash(m_slots.size() * 2);
+    }
+    return true;
+}
+
+bool PresenceTable::remove(uint64_t uidHash, uint32_t deviceId, uint16_t node)
+{
+    size_t mask = m_slots.size() - 1;
+    for (size_t pos = home(uidHash); m_slots[pos].node != kInvalidNode; pos = (pos + 1) & mask) {
+        const Slot& slot = m_slots[pos];
+        if (slot.uidHash == uidHash && slot.deviceId == deviceId && slot.node == node) {
+            erase(pos);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t PresenceTable::find(uint64_t uidHash, uint32_t deviceId) const
+{
+    size_t mask = m_slots.size() - 1;
+    for (size_t pos = home(uidHash); m_slots[pos].node != kInvalidNode; pos = (pos + 1) & mask) {
+        const Slot& slot = m_slots[pos];
+        if (slot.uidHash == uidHash && slot.deviceId == deviceId) {
+            return slot.node;
+        }
+    }
+    return kInvalidNode;
+}
+
+bool PresenceTable::contains(uint64_t uidHash) const
+{
+    size_t mask = m_slots.size() - 1;
+    for (size_t pos = home(uidHash); m_slots[pos].node != kInvalidNode; pos = (pos + 1) & mask) {
+        if (m_slots[pos].uidHash == uidHash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PresenceTable::erase(size_t pos)
+{
+    // backward shift, no tombstones: move up every following slot of the run whose
+    // home is not between the hole and itself
+    size_t mask = m_slots.size() - 1;
+    size_t hole = pos;
+    for (size_t next = (hole + 1) & mask; m_slots[next].node != kInvalidNode; next = (next + 1) & mask) {
+        size_t h = home(m_slots[next].uidHash);
+        bool stays = (hole <= next) ? (hole < h && h <= next) : (hole < h || h <= next);
+        if (!stays) {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+        }
+    }
+    m_slots[hole].node = kInvalidNode;
+    --m_size;
+}
+
+size_t PresenceTable::removeIf(const std::function<bool(const Slot&)>& pred)
+{
+    size_t removed = 0;
+    for (size_t pos = 0; pos < m_slots.size(); ) {
+        const Slot& slot = m_slots[pos];
+        if (slot.node != kInvalidNode && pred(slot)) {
+            // a following slot may have been shifted into pos, look at it again
+            erase(pos);
+            ++removed;
+            continue;
+        }
+        ++pos;
+    }
+    return removed;
+}
+
+size_t PresenceTable::purge(uint16_t node, uint16_t gen)
+{
+    return removeIf([node, gen](const Slot& slot) {
+        return slot.node == node && slot.gen != gen;
+    });
+}
+
+size_t PresenceTable::removeNode(uint16_t node)
+{
+    return removeIf([node](const Slot& slot) {
+        return slot.node == node;
+    });
+}
+
+void PresenceTable::forEach(uint16_t node, const std::function<void(uint64_t, uint32_t)>& fn) const
+{
+    for (const auto& slot : m_slots) {
+        if (slot.node == node) {
+            fn(slot.uidHash, slot.deviceId);
+        }
+    }
+}
+
+void PresenceTable::rehash(size_t slotCount)
+{
+    std::vector<Slot> slots(slotCount, Slot{0, 0, kInvalidNode, 0});
+    slots.swap(m_slots);
+    size_t mask = slotCount - 1;
+    for (const auto& slot : slots) {
+        if (slot.node == kInvalidNode) {
+            continue;
+        }
+        size_t pos = home(slot.uidHash);
+        while (m_slots[pos].node != kInvalidNode) {
+            pos = (pos + 1) & mask;
+        }
+        m_slots[pos] = slot;
+    }
+}
+
+size_t PresenceTable::memoryUsage() const
+{
+    return m_slots.capacity() * sizeof(Slot);
+}
+
+} // namespace bcm
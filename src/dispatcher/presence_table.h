@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bcm {
+
+// Online devices keyed by the 64-bit hash of their uid, one 16 byte slot per device
+// and im node in an open addressing table with linear probing. The devices of a uid
+// share one probe run, a lookup touches a cache line or two.
+// Not thread safe, the owner serializes writers against readers.
+class PresenceTable {
+public:
+    static const uint16_t kInvalidNode = UINT16_MAX;
+
+    PresenceTable();
+
+    // sets the generation if the device is already on node, false in that case
+    bool add(uint64_t uidHash, uint32_t deviceId, uint16_t node, uint16_t gen);
+    bool remove(uint64_t uidHash, uint32_t deviceId, uint16_t node);
+
+    // node serving the device, kInvalidNode if it is offline. a device being kicked
+    // can be on two nodes for a moment, any of them is returned
+    uint16_t find(uint64_t uidHash, uint32_t deviceId) const;
+    // whether any device of the uid is online
+    bool contains(uint64_t uidHash) const;
+
+    // drops the devices of node with another generation than gen
+    size_t purge(uint16_t node, uint16_t gen);
+    // drops all devices of node
+    size_t removeNode(uint16_t node);
+
+    void forEach(uint16_t node, const std::function<void(uint64_t uidHash, uint32_t deviceId)>& fn) const;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    size_t memoryUsage() const;
+
+private:
+    struct Slot {
+        uint64_t uidHash;
+        uint32_t deviceId;
+        uint16_t node;
+        uint16_t gen;
+    };
+
+    size_t home(uint64_t uidHash) const;
+    void erase(size_t pos);
+    size_t removeIf(const std::function<bool(const Slot&)>& pred);
+    void rehash(size_t slotCount);
+
+private:
+    std::vector<Slot> m_slots;
+    size_t m_size{0};
+};
+
+} // namespace bcm
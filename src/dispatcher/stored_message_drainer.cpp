@@ -0,0 +1,125 @@
+#include "stored_message_drainer.h"
+#include <utils/log.h>
+
+namespace bcm {
+
+StoredMessageDrainer::StoredMessageDrainer(MessagesManager& messagesManager, std::string uid, uint32_t deviceId,
+                                           const Options& options)
+    : m_messagesManager(messagesManager)
+    , m_uid(std::move(uid))
+    , m_deviceId(deviceId)
+    , m_options(options)
+{
+}
+
+bool StoredMessageDrainer::drain(const Sender& sender, const Filter& filter)
+{
+    bool ok = true;
+    bool hasMore = true;
+    while (ok && hasMore) {
+        // the oldest messages come first, read past those still waiting for their delete so
+        // the next page is fetched while earlier batches are in flight
+        uint32_t count = m_options.pageSize + static_cast<uint32_t>(m_pending.size());
+        std::vector<StoredMessage> messages;
+        ++m_stats.reads;
+        if (!m_messagesManager.get(m_uid, m_deviceId, count, messages, hasMore)) {
+            ok = false;
+            break;
+        }
+
+        std::vector<StoredMessage> batch;
+        for (auto& message : messages) {
+            if (m_pending.find(message.id()) != m_pending.end()) {
+                continue;
+            }
+            Verdict verdict = filter(message);
+            if (verdict != SEND) {
+                m_pending.insert(message.id());
+                if (verdict == DROP) {
+                    m_toDelete.push_back(message.id());
+                    ++m_stats.dropped;
+                }
+                continue;
+            }
+            batch.emplace_back(std::move(message));
+            if (batch.size() >= m_options.batchSize) {
+                if (!send(batch, sender)) {
+                    ok = false;
+                    break;
+                }
+                batch.clear();
+            }
+        }
+        if (ok && !batch.empty()) {
+            ok = send(batch, sender);
+        }
+
+        flushDeletes(false);
+    }
+
+    while (!m_inflight.empty()) {
+        ok = awaitOldest() && ok;
+    }
+    flushDeletes(true);
+    return ok;
+}
+
+bool StoredMessageDrainer::send(std::vector<StoredMessage>& batch, const Sender& sender)
+{
+    while (m_unacked + batch.size() > m_options.maxUnacked && !m_inflight.empty()) {
+        if (!awaitOldest()) {
+            return false;
+        }
+    }
+
+    Ack ack = sender(batch);
+    if (!ack) {
+        return false;
+    }
+    Inflight inflight;
+    for (const auto& message : batch) {
+        inflight.ids.push_back(message.id());
+        m_pending.insert(message.id());
+    }
+    inflight.ack = std::move(ack);
+    m_unacked += static_cast<uint32_t>(inflight.ids.size());
+    m_stats.sent += inflight.ids.size();
+    ++m_stats.batches;
+    m_inflight.emplace_back(std::move(inflight));
+    return true;
+}
+
+bool StoredMessageDrainer::awaitOldest()
+{
+    Inflight inflight = std::move(m_inflight.front());
+    m_inflight.pop_front();
+    m_unacked -= static_cast<uint32_t>(inflight.ids.size());
+    if (!inflight.ack()) {
+        // not acknowledged, they are read and sent again on the next drain
+        for (const auto& id : inflight.ids) {
+            m_pending.erase(id);
+        }
+        return false;
+    }
+    m_toDelete.insert(m_toDelete.end(), inflight.ids.begin(), inflight.ids.end());
+    return true;
+}
+
+void StoredMessageDrainer::flushDeletes(bool force)
+{
+    if (m_toDelete.empty() || (!force && m_toDelete.size() < m_options.deleteBatch)) {
+        return;
+    }
+    ++m_stats.deletes;
+    if (!m_messagesManager.del(m_uid, m_toDelete)) {
+        // keep them pending so they are not sent twice, the next flush retries
+        LOGW << "failed to delete " << m_toDelete.size() << " stored messages of " << m_uid << "." << m_deviceId;
+        return;
+    }
+    for (const auto& id : m_toDelete) {
+        m_pending.erase(id);
+    }
+    m_toDelete.clear();
+}
+
+}
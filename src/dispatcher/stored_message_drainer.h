@@ -0,0 +1,86 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+#include <store/messages_manager.h>
+
+namespace bcm {
+
+/*
+ * drains the stored messages of one device into its session. batches are sent without
+ * waiting for the previous ones, the next page is read while they are in flight, and
+ * acknowledged messages are deleted in bulk.
+ */
+class StoredMessageDrainer {
+public:
+    struct Options {
+        // messages in one mailbox
+        uint32_t batchSize{50};
+        // messages sent to the client and not answered yet
+        uint32_t maxUnacked{200};
+        // fresh messages read from the dao at once
+        uint32_t pageSize{200};
+        // acknowledged messages deleted at once
+        uint32_t deleteBatch{200};
+    };
+
+    struct Stats {
+        uint64_t sent{0};
+        uint64_t dropped{0};
+        uint64_t batches{0};
+        uint64_t reads{0};
+        uint64_t deletes{0};
+    };
+
+    // blocks until the client answers a batch, true if it accepted the batch
+    typedef std::function<bool()> Ack;
+    // hands a batch to the client, an empty Ack if it could not be sent
+    typedef std::function<Ack(const std::vector<StoredMessage>& batch)> Sender;
+    enum Verdict {
+        SEND,
+        // dealt with without sending, deleted along with the acked ones
+        DROP,
+        // neither sent nor deleted
+        KEEP
+    };
+    typedef std::function<Verdict(const StoredMessage& message)> Filter;
+
+    StoredMessageDrainer(MessagesManager& messagesManager, std::string uid, uint32_t deviceId,
+                         const Options& options);
+
+    // true if the queue was drained, false if a read or a batch failed
+    bool drain(const Sender& sender, const Filter& filter);
+
+    const Stats& stats() const
+    {
+        return m_stats;
+    }
+
+private:
+    struct Inflight {
+        std::vector<uint64_t> ids;
+        Ack ack;
+    };
+
+    bool send(std::vector<StoredMessage>& batch, const Sender& sender);
+    bool awaitOldest();
+    void flushDeletes(bool force);
+
+private:
+    MessagesManager& m_messagesManager;
+    std::string m_uid;
+    uint32_t m_deviceId;
+    Options m_options;
+    Stats m_stats;
+
+    std::deque<Inflight> m_inflight;
+    uint32_t m_unacked{0};
+    // read in this drain and not deleted yet, a later read still returns them
+    std::set<uint64_t> m_pending;
+    std::vector<uint64_t> m_toDelete;
+};
+
+}
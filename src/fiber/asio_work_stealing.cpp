@@ -0,0 +1,266 @@
+#include "asio_work_stealing.h"
+#include "asio_round_robin.h"
+#include "stack_pool.h"
+
+namespace boost {
+namespace fibers {
+namespace asio {
+
+// a lane holding more than this wakes an idle peer
+static constexpr std::size_t kShareThreshold = 1;
+// tasks turned into fibers at once, a thief takes at most this many from a peer
+static constexpr std::size_t kSpawnBatch = 32;
+
+boost::asio::io_context::id work_stealing::lane_service::id;
+
+work_stealing::group::group(const std::vector<std::shared_ptr<boost::asio::io_context>>& iocs)
+{
+    for (const auto& ioc : iocs) {
+        m_lanes.emplace_back(new lane());
+        m_lanes.back()->ioc = ioc;
+    }
+}
+
+void work_stealing::group::wakeIdle(std::size_t index)
+{
+    std::size_t size = m_lanes.size();
+    for (std::size_t i = 1; i < size; ++i) {
+        auto& peer = *m_lanes[(index + i) % size];
+        bool idle = true;
+        if (peer.idle.compare_exchange_strong(idle, false)) {
+            // returning from run_one is enough, the peer looks at the lanes afterwards
+            boost::asio::post(*peer.ioc, []() {});
+            return;
+        }
+    }
+}
+
+work_stealing::work_stealing(std::shared_ptr<boost::asio::io_context> ioc,
+                             std::shared_ptr<group> peers,
+                             std::size_t index)
+    : m_ioc(std::move(ioc))
+    , m_suspendTimer(*m_ioc)
+    , m_group(std::move(peers))
+    , m_index(index)
+    , m_lane(*m_group->m_lanes[index])
+{
+    boost::asio::add_service(*m_ioc, new round_robin::service(*m_ioc));
+    auto& service = boost::asio::use_service<lane_service>(*m_ioc);
+    service.index = m_index;
+    service.peers = m_group;
+    fibers::context::active()->get_scheduler()->set_algo(this);
+}
+
+bool work_stealing::submit(boost::asio::io_context& ioc, std::function<void()> task)
+{
+    if (!boost::asio::has_service<lane_service>(ioc)) {
+        return false;
+    }
+    auto& service = boost::asio::use_service<lane_service>(ioc);
+    auto peers = service.peers.lock();
+    if (!peers) {
+        return false;
+    }
+
+    auto& lane = *peers->m_lanes[service.index];
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> l(lane.mtx);
+        lane.tasks.push_back(std::move(task));
+        count = ++lane.count;
+    }
+    bool idle = true;
+    if (lane.idle.compare_exchange_strong(idle, false)) {
+        boost::asio::post(ioc, []() {});
+    } else if (count > kShareThreshold) {
+        peers->wakeIdle(service.index);
+    }
+    return true;
+}
+
+void work_stealing::awakened(context* ctx, migration_props& props) noexcept
+{
+    BOOST_ASSERT(nullptr != ctx);
+    BOOST_ASSERT(!ctx->ready_is_linked());
+    if (ctx->is_context(type::pinned_context) || !props.migratable()) {
+        ctx->ready_link(m_readyQueue);
+        if (!ctx->is_context(boost::fibers::type::dispatcher_context)) {
+            ++m_counter;
+        }
+        return;
+    }
+
+    // whoever picks it up attaches it to its own scheduler
+    ctx->detach();
+    std::size_t count;
+    {
+        std::lock_guard<std::mutex> l(m_lane.mtx);
+        m_lane.fibers.push_back(ctx);
+        count = ++m_lane.count;
+    }
+    if (count > kShareThreshold) {
+        m_group->wakeIdle(m_index);
+    }
+}
+
+context* work_stealing::popFiber(group::lane& lane) noexcept
+{
+    if (lane.count.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> l(lane.mtx);
+    if (lane.fibers.empty()) {
+        return nullptr;
+    }
+    context* ctx = lane.fibers.front();
+    lane.fibers.pop_front();
+    --lane.count;
+    return ctx;
+}
+
+context* work_stealing::steal() noexcept
+{
+    std::size_t size = m_group->size();
+    for (std::size_t i = 1; i < size; ++i) {
+        context* ctx = popFiber(*m_group->m_lanes[(m_index + i) % size]);
+        if (nullptr != ctx) {
+            return ctx;
+        }
+    }
+    return nullptr;
+}
+
+context* work_stealing::pick_next() noexcept
+{
+    // alternate between pinned fibers and the lane so neither starves the other
+    m_preferLane = !m_preferLane;
+    context* ctx = nullptr;
+    if (m_preferLane || m_readyQueue.empty()) {
+        ctx = popFiber(m_lane);
+    }
+    if (nullptr == ctx && !m_readyQueue.empty()) {
+        ctx = &m_readyQueue.front();
+        m_readyQueue.pop_front();
+        BOOST_ASSERT(context::active() != ctx);
+        if (!ctx->is_context(boost::fibers::type::dispatcher_context)) {
+            --m_counter;
+        }
+        return ctx;
+    }
+    if (nullptr == ctx) {
+        ctx = steal();
+    }
+    if (nullptr != ctx) {
+        context::active()->attach(ctx);
+    }
+    return ctx;
+}
+
+std::size_t work_stealing::takeTasks(group::lane& lane, std::vector<std::function<void()>>& tasks)
+{
+    if (lane.count.load(std::memory_order_relaxed) == 0) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> l(lane.mtx);
+    std::size_t n = std::min(lane.tasks.size(), kSpawnBatch);
+    for (std::size_t i = 0; i < n; ++i) {
+        tasks.emplace_back(std::move(lane.tasks.front()));
+        lane.tasks.pop_front();
+    }
+    lane.count -= n;
+    return n;
+}
+
+void work_stealing::spawnTasks()
+{
+    std::vector<std::function<void()>> tasks;
+    if (takeTasks(m_lane, tasks) == 0) {
+        std::size_t size = m_group->size();
+        for (std::size_t i = 1; i < size && tasks.empty(); ++i) {
+            takeTasks(*m_group->m_lanes[(m_index + i) % size], tasks);
+        }
+    }
+    for (auto& task : tasks) {
+        fibers::fiber fiber(std::allocator_arg, bcm::stackAllocatorOf(*m_ioc), std::move(task));
+        fiber.properties<migration_props>().set_migratable(true);
+        fiber.detach();
+    }
+}
+
+bool work_stealing::hasStealable() const noexcept
+{
+    for (const auto& lane : m_group->m_lanes) {
+        if (lane->count.load() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool work_stealing::has_ready_fibers() const noexcept
+{
+    return 0 < m_counter || hasStealable();
+}
+
+void work_stealing::property_change(context* ctx, migration_props& props) noexcept
+{
+    // re-queue a fiber made migratable while it sits on the pinned queue
+    if (!ctx->ready_is_linked()) {
+        return;
+    }
+    ctx->ready_unlink();
+    if (!ctx->is_context(boost::fibers::type::dispatcher_context)) {
+        --m_counter;
+    }
+    awakened(ctx, props);
+}
+
+void work_stealing::suspend_until(std::chrono::steady_clock::time_point const& abs_time) noexcept
+{
+    // same as round_robin::suspend_until
+    if ((std::chrono::steady_clock::time_point::max) () != abs_time) {
+        m_suspendTimer.expires_at(abs_time);
+        m_suspendTimer.async_wait([](boost::system::error_code const&) {
+            this_fiber::yield();
+        });
+    }
+    m_cnd.notify_one();
+}
+
+void work_stealing::notify() noexcept
+{
+    // same as round_robin::notify
+    m_suspendTimer.async_wait([](boost::system::error_code const&) {
+        this_fiber::yield();
+    });
+    m_suspendTimer.expires_at(std::chrono::steady_clock::now());
+}
+
+void work_stealing::run() noexcept
+{
+    while (!m_ioc->stopped()) {
+        spawnTasks();
+        if (has_ready_fibers()) {
+            while (m_ioc->poll());
+            std::unique_lock<boost::fibers::mutex> lk(m_mutex);
+            m_cnd.wait(lk);
+        } else {
+            // announce idleness before the last look at the lanes, a peer queuing work
+            // after that look sees the flag and wakes us up
+            m_lane.idle.store(true);
+            if (has_ready_fibers()) {
+                m_lane.idle.store(false);
+                continue;
+            }
+            bool ran = m_ioc->run_one() > 0;
+            m_lane.idle.store(false);
+            if (!ran) {
+                break;
+            }
+        }
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/config.hpp>
+
+#include <boost/fiber/algo/algorithm.hpp>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/context.hpp>
+#include <boost/fiber/mutex.hpp>
+#include <boost/fiber/operations.hpp>
+#include <boost/fiber/properties.hpp>
+#include <boost/fiber/scheduler.hpp>
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_PREFIX
+#endif
+
+namespace boost {
+namespace fibers {
+namespace asio {
+
+// Fibers are pinned to the thread that created them unless marked migratable.
+// Anything that owns or waits on an asio I/O object of its io_context must stay pinned.
+class migration_props : public fiber_properties {
+public:
+    explicit migration_props(context* ctx)
+        : fiber_properties(ctx)
+    {
+    }
+
+    bool migratable() const
+    {
+        return m_migratable;
+    }
+
+    void set_migratable(bool migratable)
+    {
+        if (migratable != m_migratable) {
+            m_migratable = migratable;
+            notify();
+        }
+    }
+
+private:
+    bool m_migratable{false};
+};
+
+// round_robin over one io_context, plus a shared lane per thread holding migratable
+// fibers and submitted tasks that have not become fibers yet. A thread runs its pinned
+// fibers and its own lane alternately, and takes the oldest work of a peer lane when it
+// has nothing else to run. A lane building a backlog wakes an idle peer out of
+// io_context::run_one so it can come and steal, even while the owner thread is stuck
+// in a blocking call.
+class work_stealing : public algo::algorithm_with_properties<migration_props> {
+public:
+    class group;
+
+    work_stealing(std::shared_ptr<boost::asio::io_context> ioc, std::shared_ptr<group> peers, std::size_t index);
+
+    // queues task to run as a migratable fiber on the pool owning ioc, returns false
+    // if ioc does not belong to a work stealing pool
+    static bool submit(boost::asio::io_context& ioc, std::function<void()> task);
+
+    void awakened(context* ctx, migration_props& props) noexcept override;
+    context* pick_next() noexcept override;
+    bool has_ready_fibers() const noexcept override;
+    void suspend_until(std::chrono::steady_clock::time_point const& abs_time) noexcept override;
+    void notify() noexcept override;
+    void property_change(context* ctx, migration_props& props) noexcept override;
+
+    void run() noexcept;
+
+    // lanes of the threads of one pool, they outlive the threads so a late thief
+    // never touches a destroyed scheduler
+    class group {
+    public:
+        // one lane per io_context, in the index order of the threads
+        explicit group(const std::vector<std::shared_ptr<boost::asio::io_context>>& iocs);
+
+        std::size_t size() const
+        {
+            return m_lanes.size();
+        }
+
+    private:
+        friend class work_stealing;
+
+        struct lane {
+            std::mutex mtx;
+            std::deque<context*> fibers;
+            std::deque<std::function<void()>> tasks;
+            // fibers and tasks, read without the lock
+            std::atomic<std::size_t> count{0};
+            std::atomic<bool> idle{false};
+            std::shared_ptr<boost::asio::io_context> ioc;
+        };
+
+        // wakes one idle thread other than index out of run_one
+        void wakeIdle(std::size_t index);
+
+        std::vector<std::unique_ptr<lane>> m_lanes;
+    };
+
+    // finds the lane of an io_context
+    class lane_service : public boost::asio::io_context::service {
+    public:
+        static boost::asio::io_context::id id;
+
+        explicit lane_service(boost::asio::io_context& ioc)
+            : boost::asio::io_context::service(ioc)
+        {
+        }
+
+        void shutdown_service() final
+        {
+        }
+
+        std::weak_ptr<group> peers;
+        std::size_t index{0};
+    };
+
+private:
+    context* popFiber(group::lane& lane) noexcept;
+    context* steal() noexcept;
+    std::size_t takeTasks(group::lane& lane, std::vector<std::function<void()>>& tasks);
+    void spawnTasks();
+    bool hasStealable() const noexcept;
+
+private:
+    std::shared_ptr<boost::asio::io_context> m_ioc;
+    boost::asio::steady_timer m_suspendTimer;
+    std::shared_ptr<group> m_group;
+    std::size_t m_index;
+    group::lane& m_lane;
+    bool m_preferLane{false};
+
+    boost::fibers::scheduler::ready_queue_type m_readyQueue{};
+    boost::fibers::mutex m_mutex{};
+    boost::fibers::condition_variable m_cnd{};
+    std::size_t m_counter{0};
+};
+
+}
+}
+}
+
+#ifdef BOOST_HAS_ABI_HEADERS
+#  include BOOST_ABI_SUFFIX
+#endif
@@ -1,5 +1,6 @@
 #include "fiber_pool.h"
 #include "asio_round_robin.h"
+#include "asio_work_stealing.h"
 #include <utils/log.h>
 #include <utils/sync_latch.h>
 #include <utils/thread_utils.h>
@@ -9,24 +10,48 @@ namespace bcm {
 using namespace boost;
 
 static thread_local asio::io_context* s_tlsIoc = nullptr;
+// released stacks kept for reuse, per thread of a pool
+static constexpr size_t kCachedStacksPerThread = 256;
 
-FiberPool::FiberPool(size_t concurrency)
+FiberPool::FiberPool(size_t concurrency, bool workStealing, size_t stackSize)
+    : m_workStealing(workStealing)
+    , m_stackPool(std::make_shared<StackPool>(stackSize, kCachedStacksPerThread * concurrency))
 {
     for (size_t i = 0; i < concurrency; ++i) {
         m_iocs.push_back(std::make_shared<asio::io_context>());
+        asio::use_service<StackPoolService>(*m_iocs.back()).setPool(m_stackPool);
     }
 }
 
 void FiberPool::run(const std::string& name)
 {
     auto sl = std::make_shared<SyncLatch>(m_iocs.size() + 1);
+    if (m_workStealing) {
+        auto group = std::make_shared<fibers::asio::work_stealing::group>(m_iocs);
+        for (size_t i = 0; i < m_iocs.size(); ++i) {
+            auto& ioc = m_iocs[i];
+            m_threads.emplace_back([sl, &ioc, group, i, name]() {
+                setCurrentThreadName(name);
+                // the scheduler keeps a reference, the algorithm dies with the thread
+                intrusive_ptr<fibers::asio::work_stealing> ws(new fibers::asio::work_stealing(ioc, group, i));
+                s_tlsIoc = ioc.get();
+                sl->sync();
+                ws->run();
+                s_tlsIoc = nullptr;
+            });
+        }
+        sl->sync();
+        LOGD << "work stealing fiber pool is running for " << name;
+        return;
+    }
+
     for (auto& ioc : m_iocs) {
         m_threads.emplace_back([sl, &ioc, name]() {
             setCurrentThreadName(name);
-            fibers::asio::round_robin rr(ioc);
+            intrusive_ptr<fibers::asio::round_robin> rr(new fibers::asio::round_robin(ioc));
             s_tlsIoc = ioc.get();
             sl->sync();
-            rr.run();
+            rr->run();
             s_tlsIoc = nullptr;
         });
     }
@@ -2,6 +2,8 @@
 
 #include <boost/asio.hpp>
 #include <boost/fiber/all.hpp>
+#include "asio_work_stealing.h"
+#include "stack_pool.h"
 
 namespace bcm {
 
@@ -10,7 +12,9 @@ namespace fibers = boost::fibers;
 
 class FiberPool {
 public:
-    explicit FiberPool(size_t concurrency);
+    // with workStealing, fibers posted by postMigratable may run on any thread of the pool.
+    // fibers of the pool run on pooled stacks of stackSize bytes, 0 for the boost default
+    explicit FiberPool(size_t concurrency, bool workStealing = false, size_t stackSize = 0);
     ~FiberPool() = default;
 
     void run(const std::string& name = "fiber.worker");
@@ -20,13 +24,39 @@ public:
     template <typename Func, typename ... Args>
     static void post(asio::io_context& ioc, Func&& func, Args&&... args)
     {
+        auto allocator = stackAllocatorOf(ioc);
+        if (getThreadIOContext() == &ioc) {
+            // already on the thread of ioc, start the fiber without a round trip through its queue
+            fibers::fiber(std::allocator_arg, std::move(allocator),
+                          std::forward<Func>(func), std::forward<Args>(args)...).detach();
+            return;
+        }
         asio::post(ioc, [=]() {
-            fibers::fiber(func, (args)...).detach();
+            fibers::fiber(std::allocator_arg, allocator, func, (args)...).detach();
         });
     }
+
+    // for fibers that hold no I/O object of ioc, they can be taken over by an idle
+    // thread when the pool steals work, otherwise the same as post
+    template <typename Func, typename ... Args>
+    static void postMigratable(asio::io_context& ioc, Func&& func, Args&&... args)
+    {
+        auto task = std::bind(func, args...);
+        if (!fibers::asio::work_stealing::submit(ioc, task)) {
+            post(ioc, std::move(task));
+        }
+    }
+
     static asio::io_context* getThreadIOContext();
 
+    const StackPool& stackPool() const
+    {
+        return *m_stackPool;
+    }
+
 private:
+    bool m_workStealing;
+    std::shared_ptr<StackPool> m_stackPool;
     std::atomic_size_t m_nextIocIndex{0};
     std::vector<std::thread> m_threads;
     std::vector<std::shared_ptr<asio::io_context>> m_iocs;
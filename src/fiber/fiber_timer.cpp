@@ -1,88 +1,172 @@
 #include "fiber_timer.h"
+#include <utils/time.h>
+#include <limits>
 
 namespace bcm {
 
 FiberTimer::FiberTimer()
     : m_execPool(1)
+    , m_wheel(steadyNowInMilli())
+    , m_wakeAt(std::numeric_limits<int64_t>::min())
 {
     m_execPool.run("fiber.timer");
+    FiberPool::post(m_execPool.getIOContext(), [this]() {
+        driveWheel();
+    });
 }
 
 FiberTimer::~FiberTimer()
 {
     clear();
+    {
+        std::unique_lock<fibers::mutex> l(m_mtx);
+        m_stopped = true;
+        m_cond.notify_all();
+        // the driver fiber references this object, let it leave before the pool stops
+        m_cond.wait(l, [this]() { return m_driverExited; });
+    }
     m_execPool.stop();
 }
 
-void FiberTimer::schedule(const std::shared_ptr<Task>& task, int64_t intervalInMilli, bool bImmediatelyRun)
+void FiberTimer::driveWheel()
 {
-    FiberPool::post(m_execPool.getIOContext(), [=]() {
-        m_tasks.emplace_back(task);
+    std::vector<TimingWheel::Callback> expired;
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    while (!m_stopped) {
+        m_wheel.advance(steadyNowInMilli(), expired);
+        if (!expired.empty()) {
+            m_wakeAt = std::numeric_limits<int64_t>::min();
+            l.unlock();
+            for (auto& fn : expired) {
+                fn();
+            }
+            expired.clear();
+            l.lock();
+            continue;
+        }
 
-        if (bImmediatelyRun) {
-            task->run();
+        m_wakeAt = m_wheel.nextExpiry();
+        if (m_wakeAt == std::numeric_limits<int64_t>::max()) {
+            m_cond.wait(l);
+        } else {
+            std::chrono::steady_clock::time_point wakeAt{std::chrono::milliseconds(m_wakeAt)};
+            m_cond.wait_until(l, wakeAt);
         }
+    }
+    m_driverExited = true;
+    m_cond.notify_all();
+}
 
-        while (!task->m_canceled) {
-            auto waitTime = intervalInMilli - task->lastExecTimeInMilli();
-            if (waitTime <= 0) {
-                // exec too long, go to next round
-                waitTime = intervalInMilli;
-            }
+FiberTimer::TimerId FiberTimer::arm(int64_t delayInMilli, std::function<void()> fn)
+{
+    int64_t expireAt = steadyNowInMilli() + std::max<int64_t>(delayInMilli, 0);
+    TimerId id = m_wheel.schedule(expireAt, std::move(fn));
+    if (expireAt < m_wakeAt) {
+        m_cond.notify_all();
+    }
+    return id;
+}
 
-            std::unique_lock<fibers::mutex> l(task->m_mtx);
-            std::chrono::milliseconds duration(waitTime);
-            task->m_cond.wait_for(l, duration);
+FiberTimer::TimerId FiberTimer::addTimer(int64_t delayInMilli, std::function<void()> fn)
+{
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    return arm(delayInMilli, std::move(fn));
+}
 
-            if (task->m_canceled) {
-                break;
-            }
-            task->run();
-        }
+bool FiberTimer::cancelTimer(TimerId id)
+{
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    return m_wheel.cancel(id);
+}
 
-        m_tasks.remove(task);
+void FiberTimer::armTask(const std::shared_ptr<Task>& task, int64_t delayInMilli, int64_t intervalInMilli)
+{
+    auto& ioc = m_execPool.getIOContext();
+    task->m_timerId = arm(delayInMilli, [this, task, intervalInMilli, &ioc]() {
+        // run() may block, give every firing its own fiber
+        FiberPool::post(ioc, [this, task, intervalInMilli]() {
+            runTask(task, intervalInMilli);
+        });
     });
 }
 
-void FiberTimer::scheduleOnce(const std::shared_ptr<Task>& task, int64_t delayInMilli)
+void FiberTimer::runTask(const std::shared_ptr<Task>& task, int64_t intervalInMilli)
 {
-    FiberPool::post(m_execPool.getIOContext(), [=]() {
-        if (delayInMilli <= 0) {
-            task->run();
+    {
+        std::unique_lock<fibers::mutex> l(m_mtx);
+        if (task->m_canceled) {
             return;
         }
+    }
+
+    task->run();
+
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    if (task->m_canceled) {
+        return;
+    }
+    if (intervalInMilli <= 0) {
+        task->m_timerId = TimingWheel::kInvalidTimer;
+        m_tasks.erase(task);
+        return;
+    }
+
+    auto waitTime = intervalInMilli - task->lastExecTimeInMilli();
+    if (waitTime <= 0) {
+        // exec too long, go to next round
+        waitTime = intervalInMilli;
+    }
+    armTask(task, waitTime, intervalInMilli);
+}
 
-        m_tasks.emplace_back(task);
-
-        std::unique_lock<fibers::mutex> l(task->m_mtx);
-        std::chrono::milliseconds duration(delayInMilli);
-        task->m_cond.wait_for(l, duration);
+void FiberTimer::schedule(const std::shared_ptr<Task>& task, int64_t intervalInMilli, bool bImmediatelyRun)
+{
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    task->m_canceled = false;
+    m_tasks.insert(task);
+    if (bImmediatelyRun) {
+        // runTask arms the next round once the task has run
+        FiberPool::post(m_execPool.getIOContext(), [this, task, intervalInMilli]() {
+            runTask(task, intervalInMilli);
+        });
+        return;
+    }
+    armTask(task, intervalInMilli, intervalInMilli);
+}
 
-        if (!task->m_canceled) {
+void FiberTimer::scheduleOnce(const std::shared_ptr<Task>& task, int64_t delayInMilli)
+{
+    if (delayInMilli <= 0) {
+        FiberPool::post(m_execPool.getIOContext(), [task]() {
             task->run();
-        }
-        m_tasks.remove(task);
-    });
+        });
+        return;
+    }
+
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    task->m_canceled = false;
+    m_tasks.insert(task);
+    armTask(task, delayInMilli, 0);
 }
 
 void FiberTimer::cancel(const std::shared_ptr<Task>& task)
 {
-    FiberPool::post(m_execPool.getIOContext(), [=] {
-        {
-            std::unique_lock<fibers::mutex> l(task->m_mtx);
-            task->m_canceled = true;
-        }
-        task->m_cond.notify_all();
-    });
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    task->m_canceled = true;
+    m_wheel.cancel(task->m_timerId);
+    task->m_timerId = TimingWheel::kInvalidTimer;
+    m_tasks.erase(task);
 }
 
 void FiberTimer::clear()
 {
-    FiberPool::post(m_execPool.getIOContext(), [=] {
-        for (auto& task : m_tasks) {
-            this->cancel(task);
-        }
-    });
+    std::unique_lock<fibers::mutex> l(m_mtx);
+    for (auto& task : m_tasks) {
+        task->m_canceled = true;
+        m_wheel.cancel(task->m_timerId);
+        task->m_timerId = TimingWheel::kInvalidTimer;
+    }
+    m_tasks.clear();
 }
 
-}
\ No newline at end of file
+}
@@ -1,13 +1,18 @@
 #pragma once
 
 #include "fiber_pool.h"
-#include <list>
+#include "timing_wheel.h"
+#include <unordered_set>
 
 
 namespace bcm {
 
+// All timers share one hierarchical timing wheel driven by a single fiber, so arming
+// and canceling are O(1) and an idle timer costs no fiber.
 class FiberTimer {
 public:
+    typedef TimingWheel::TimerId TimerId;
+
     class Task {
     public:
         virtual void run() = 0;
@@ -15,8 +20,8 @@ public:
         virtual int64_t lastExecTimeInMilli() { return 0; };
 
     private:
-        fibers::condition_variable m_cond;
-        fibers::mutex m_mtx;
+        // guarded by the mutex of the timer
+        TimerId m_timerId{TimingWheel::kInvalidTimer};
         bool m_canceled{false};
 
         friend class FiberTimer;
@@ -31,9 +36,29 @@ public:
 
     void clear();
 
+    // lightweight one-shot timer, fn runs on the timer fiber and must not block.
+    // safe to call from any thread
+    TimerId addTimer(int64_t delayInMilli, std::function<void()> fn);
+    // false if the timer already fired or was canceled
+    bool cancelTimer(TimerId id);
+
+private:
+    // lock held
+    TimerId arm(int64_t delayInMilli, std::function<void()> fn);
+    void armTask(const std::shared_ptr<Task>& task, int64_t delayInMilli, int64_t intervalInMilli);
+    void runTask(const std::shared_ptr<Task>& task, int64_t intervalInMilli);
+    void driveWheel();
+
 private:
     FiberPool m_execPool;
-    std::list<std::shared_ptr<Task>> m_tasks;
+    fibers::mutex m_mtx;
+    fibers::condition_variable m_cond;
+    TimingWheel m_wheel;
+    // when the driver fiber wakes up next, INT64_MIN while it is firing timers
+    int64_t m_wakeAt;
+    bool m_stopped{false};
+    bool m_driverExited{false};
+    std::unordered_set<std::shared_ptr<Task>> m_tasks;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,91 @@
+#include "stack_pool.h"
+
+#include <sys/mman.h>
+#include <new>
+
+#include <boost/context/stack_traits.hpp>
+
+namespace bcm {
+
+// bound of the default pool, the pool of a FiberPool is sized by its owner
+static constexpr size_t kDefaultMaxCached = 1024;
+
+boost::asio::io_context::id StackPoolService::id;
+
+StackPool::StackPool(size_t stackSize, size_t maxCached)
+    : m_maxCached(maxCached)
+{
+    using traits = boost::context::stack_traits;
+    size_t pageSize = traits::page_size();
+    if (stackSize == 0) {
+        stackSize = traits::default_size();
+    }
+    m_stackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+    m_mappedSize = m_stackSize + pageSize;
+    m_free.reserve(m_maxCached);
+}
+
+StackPool::~StackPool()
+{
+    for (void* vp : m_free) {
+        ::munmap(vp, m_mappedSize);
+    }
+}
+
+boost::context::stack_context StackPool::allocate()
+{
+    void* vp = nullptr;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        if (!m_free.empty()) {
+            vp = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    if (vp == nullptr) {
+        vp = ::mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (vp == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        // the lowest page catches overflows
+        if (::mprotect(vp, boost::context::stack_traits::page_size(), PROT_NONE) != 0) {
+            ::munmap(vp, m_mappedSize);
+            throw std::bad_alloc();
+        }
+    }
+    m_allocated.fetch_add(1, std::memory_order_relaxed);
+
+    boost::context::stack_context sctx;
+    sctx.size = m_mappedSize;
+    sctx.sp = static_cast<char*>(vp) + sctx.size;
+    return sctx;
+}
+
+void StackPool::deallocate(boost::context::stack_context& sctx)
+{
+    void* vp = static_cast<char*>(sctx.sp) - sctx.size;
+    m_allocated.fetch_sub(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        if (m_free.size() < m_maxCached) {
+            m_free.push_back(vp);
+            return;
+        }
+    }
+    ::munmap(vp, m_mappedSize);
+}
+
+size_t StackPool::cached() const
+{
+    std::lock_guard<std::mutex> l(m_mutex);
+    return m_free.size();
+}
+
+std::shared_ptr<StackPool> StackPool::defaultPool()
+{
+    static std::shared_ptr<StackPool> g_pool = std::make_shared<StackPool>(0, kDefaultMaxCached);
+    return g_pool;
+}
+
+} // namespace bcm
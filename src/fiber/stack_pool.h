@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/context/stack_context.hpp>
+
+namespace bcm {
+
+// Guard paged fiber stacks. Released stacks are kept on a free list for the next
+// fiber instead of going back to the kernel, up to maxCached of them.
+class StackPool {
+public:
+    // stackSize 0 picks the boost default, sizes are rounded up to whole pages
+    StackPool(size_t stackSize, size_t maxCached);
+    ~StackPool();
+
+    StackPool(const StackPool&) = delete;
+    StackPool& operator=(const StackPool&) = delete;
+
+    boost::context::stack_context allocate();
+    void deallocate(boost::context::stack_context& sctx);
+
+    // usable bytes of a stack, the guard page excluded
+    size_t stackSize() const
+    {
+        return m_stackSize;
+    }
+    size_t cached() const;
+    size_t allocated() const
+    {
+        return m_allocated.load(std::memory_order_relaxed);
+    }
+
+    static std::shared_ptr<StackPool> defaultPool();
+
+private:
+    size_t m_stackSize;
+    size_t m_mappedSize;
+    size_t m_maxCached;
+    std::atomic<size_t> m_allocated{0};
+    mutable std::mutex m_mutex;
+    std::vector<void*> m_free;
+};
+
+// StackAllocator for fibers::fiber, copies share the pool
+class PooledStackAllocator {
+public:
+    explicit PooledStackAllocator(std::shared_ptr<StackPool> pool = StackPool::defaultPool())
+        : m_pool(std::move(pool))
+    {
+    }
+
+    boost::context::stack_context allocate() const
+    {
+        return m_pool->allocate();
+    }
+
+    void deallocate(boost::context::stack_context& sctx) const
+    {
+        m_pool->deallocate(sctx);
+    }
+
+private:
+    std::shared_ptr<StackPool> m_pool;
+};
+
+// the stack pool fibers of an io_context are allocated from, FiberPool installs its
+// own, any other io_context gets the default pool
+class StackPoolService : public boost::asio::io_context::service {
+public:
+    static boost::asio::io_context::id id;
+
+    explicit StackPoolService(boost::asio::io_context& ioc)
+        : boost::asio::io_context::service(ioc)
+        , m_pool(StackPool::defaultPool())
+    {
+    }
+
+    void shutdown_service() final
+    {
+    }
+
+    void setPool(std::shared_ptr<StackPool> pool)
+    {
+        m_pool = std::move(pool);
+    }
+
+    PooledStackAllocator allocator() const
+    {
+        return PooledStackAllocator(m_pool);
+    }
+
+private:
+    std::shared_ptr<StackPool> m_pool;
+};
+
+inline PooledStackAllocator stackAllocatorOf(boost::asio::io_context& ioc)
+{
+    return boost::asio::use_service<StackPoolService>(ioc).allocator();
+}
+
+} // namespace bcm
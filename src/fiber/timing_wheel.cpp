@@ -0,0 +1,204 @@
+#include "timing_wheel.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace bcm {
+
+constexpr TimingWheel::TimerId TimingWheel::kInvalidTimer;
+constexpr uint32_t TimingWheel::kLevels;
+constexpr uint32_t TimingWheel::kSlots;
+constexpr uint32_t TimingWheel::kNil;
+
+TimingWheel::TimingWheel(int64_t nowInMilli)
+    : m_current(nowInMilli)
+{
+    m_slots.fill(kNil);
+    m_tails.fill(kNil);
+    m_levelSizes.fill(0);
+}
+
+TimingWheel::TimerId TimingWheel::schedule(int64_t expireAtInMilli, Callback cb)
+{
+    uint32_t index;
+    if (!m_freeNodes.empty()) {
+        index = m_freeNodes.back();
+        m_freeNodes.pop_back();
+    } else {
+        index = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    Node& node = m_nodes[index];
+    node.expireAt = expireAtInMilli;
+    node.cb = std::move(cb);
+    // generation 0 never names a live timer, so no id equals kInvalidTimer
+    if (++node.generation == 0) {
+        node.generation = 1;
+    }
+    link(index);
+    ++m_size;
+    return (static_cast<uint64_t>(node.generation) << 32) | index;
+}
+
+bool TimingWheel::cancel(TimerId id)
+{
+    uint32_t index = static_cast<uint32_t>(id & 0xFFFFFFFF);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index >= m_nodes.size()) {
+        return false;
+    }
+    Node& node = m_nodes[index];
+    if (node.generation != generation || node.slot == kNil) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+void TimingWheel::link(uint32_t index)
+{
+    Node& node = m_nodes[index];
+    int64_t expireAt = std::max(node.expireAt, m_current);
+    uint64_t delta = static_cast<uint64_t>(expireAt - m_current);
+
+    uint32_t level = 0;
+    while (level + 1 < kLevels && delta >= (1ull << ((level + 1) * kSlotBits))) {
+        ++level;
+    }
+    if (level == kLevels - 1 && delta >= (1ull << (kLevels * kSlotBits))) {
+        // beyond the wheel, wait on the farthest slot and get placed again from there
+        expireAt = m_current + static_cast<int64_t>((1ull << (kLevels * kSlotBits)) - 1);
+    }
+
+    uint32_t slot = level * kSlots + ((static_cast<uint64_t>(expireAt) >> (level * kSlotBits)) & kSlotMask);
+    node.slot = slot;
+    // append, so timers due on the same tick fire in scheduling order
+    node.prev = m_tails[slot];
+    node.next = kNil;
+    if (node.prev != kNil) {
+        m_nodes[node.prev].next = index;
+    } else {
+        m_slots[slot] = index;
+    }
+    m_tails[slot] = index;
+    ++m_levelSizes[level];
+}
+
+void TimingWheel::unlink(uint32_t index)
+{
+    Node& node = m_nodes[index];
+    if (node.prev != kNil) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_slots[node.slot] = node.next;
+    }
+    if (node.next != kNil) {
+        m_nodes[node.next].prev = node.prev;
+    } else {
+        m_tails[node.slot] = node.prev;
+    }
+    --m_levelSizes[node.slot / kSlots];
+    node.slot = kNil;
+    node.prev = kNil;
+    node.next = kNil;
+}
+
+void TimingWheel::release(uint32_t index)
+{
+    m_nodes[index].cb = nullptr;
+    m_freeNodes.push_back(index);
+    --m_size;
+}
+
+void TimingWheel::cascade(uint32_t level)
+{
+    uint32_t slot = level * kSlots + ((static_cast<uint64_t>(m_current) >> (level * kSlotBits)) & kSlotMask);
+    uint32_t index = m_slots[slot];
+    m_slots[slot] = kNil;
+    m_tails[slot] = kNil;
+    while (index != kNil) {
+        uint32_t next = m_nodes[index].next;
+        --m_levelSizes[level];
+        link(index);
+        index = next;
+    }
+}
+
+void TimingWheel::advance(int64_t nowInMilli, std::vector<Callback>& expired)
+{
+    while (m_current <= nowInMilli) {
+        if (m_size == 0) {
+            m_current = nowInMilli + 1;
+            return;
+        }
+
+        uint32_t slot = static_cast<uint32_t>(m_current) & kSlotMask;
+        if (slot == 0) {
+            // the lower levels wrapped, bring the next round of each level down
+            for (uint32_t level = 1; level < kLevels; ++level) {
+                cascade(level);
+                if (((static_cast<uint64_t>(m_current) >> (level * kSlotBits)) & kSlotMask) != 0) {
+                    break;
+                }
+            }
+        }
+
+        if (m_levelSizes[0] == 0) {
+            // nothing due on level 0, skip to the next cascade
+            m_current = std::min(std::max(nextExpiry(), m_current + 1), nowInMilli + 1);
+            continue;
+        }
+
+        uint32_t index = m_slots[slot];
+        m_slots[slot] = kNil;
+        m_tails[slot] = kNil;
+        while (index != kNil) {
+            Node& node = m_nodes[index];
+            uint32_t next = node.next;
+            --m_levelSizes[0];
+            node.slot = kNil;
+            expired.emplace_back(std::move(node.cb));
+            release(index);
+            index = next;
+        }
+        ++m_current;
+    }
+}
+
+int64_t TimingWheel::nextExpiry() const
+{
+    if (m_size == 0) {
+        return std::numeric_limits<int64_t>::max();
+    }
+
+    int64_t next = std::numeric_limits<int64_t>::max();
+    if (m_levelSizes[0] > 0) {
+        for (uint32_t i = 0; i < kSlots; ++i) {
+            int64_t tick = m_current + i;
+            if (m_slots[static_cast<uint32_t>(tick) & kSlotMask] != kNil) {
+                next = tick;
+                break;
+            }
+        }
+    }
+    for (uint32_t level = 1; level < kLevels; ++level) {
+        if (m_levelSizes[level] == 0) {
+            continue;
+        }
+        // a slot comes down when the wheel reaches its index with all lower levels at 0
+        uint32_t shift = level * kSlotBits;
+        int64_t base = m_current >> shift;
+        bool aligned = (m_current & ((1LL << shift) - 1)) == 0;
+        for (int64_t k = aligned ? 0 : 1; k <= kSlots; ++k) {
+            if (m_slots[level * kSlots + ((base + k) & kSlotMask)] != kNil) {
+                next = std::min(next, (base + k) << shift);
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+} // namespace bcm
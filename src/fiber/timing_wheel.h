@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bcm {
+
+// Hierarchical timing wheel with 1ms ticks: 4 levels of 256 slots reach ~49 days,
+// later deadlines are parked on the last level until they come into range. Timers
+// live in a slab and are chained into slots by index, so schedule and cancel are
+// O(1). Not thread safe.
+class TimingWheel {
+public:
+    typedef std::function<void()> Callback;
+    typedef uint64_t TimerId;
+
+    static constexpr TimerId kInvalidTimer = 0;
+
+    explicit TimingWheel(int64_t nowInMilli);
+
+    TimerId schedule(int64_t expireAtInMilli, Callback cb);
+    // false if the timer already fired or was canceled
+    bool cancel(TimerId id);
+
+    // moves the wheel to nowInMilli, callbacks of the expired timers are appended to
+    // expired in expiry order
+    void advance(int64_t nowInMilli, std::vector<Callback>& expired);
+
+    // the earliest tick advance has something to do at, INT64_MAX when empty
+    int64_t nextExpiry() const;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    static constexpr uint32_t kLevels = 4;
+    static constexpr uint32_t kSlotBits = 8;
+    static constexpr uint32_t kSlots = 1u << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlots - 1;
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node {
+        int64_t expireAt{0};
+        uint32_t prev{kNil};
+        uint32_t next{kNil};
+        // level * kSlots + slot, kNil when free
+        uint32_t slot{kNil};
+        uint32_t generation{0};
+        Callback cb;
+    };
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(uint32_t level);
+
+private:
+    // next tick to process
+    int64_t m_current;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_freeNodes;
+    // heads and tails of the slot lists
+    std::array<uint32_t, kLevels * kSlots> m_slots;
+    std::array<uint32_t, kLevels * kSlots> m_tails;
+    std::array<size_t, kLevels> m_levelSizes;
+    size_t m_size{0};
+};
+
+} // namespace bcm
@@ -0,0 +1,120 @@
+#include "group_ack_buffer.h"
+
+#include <algorithm>
+
+#include "utils/log.h"
+#include "utils/time.h"
+
+namespace bcm {
+
+GroupAckBuffer::GroupAckBuffer(std::shared_ptr<dao::GroupUsers> groupUsers, size_t batchSize)
+    : m_groupUsers(std::move(groupUsers))
+    , m_batchSize(batchSize > 0 ? batchSize : 1)
+{
+}
+
+void GroupAckBuffer::ack(uint64_t gid, const std::string& uid, uint64_t mid)
+{
+    std::lock_guard<std::mutex> l(m_mtx);
+    ++m_stats.acks;
+    uint64_t& pending = m_pending[uid][gid];
+    if (mid > pending) {
+        pending = mid;
+    }
+}
+
+std::map<uint64_t, uint64_t> GroupAckBuffer::pending(const std::string& uid) const
+{
+    std::lock_guard<std::mutex> l(m_mtx);
+    auto it = m_pending.find(uid);
+    if (it == m_pending.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+bool GroupAckBuffer::flush()
+{
+    std::vector<dao::GroupUserAck> acks;
+    {
+        std::lock_guard<std::mutex> l(m_mtx);
+        for (const auto& user : m_pending) {
+            for (const auto& item : user.second) {
+                acks.push_back(dao::GroupUserAck{item.first, user.first, item.second});
+            }
+        }
+    }
+    return write(acks);
+}
+
+bool GroupAckBuffer::flushUser(const std::string& uid)
+{
+    std::vector<dao::GroupUserAck> acks;
+    {
+        std::lock_guard<std::mutex> l(m_mtx);
+        auto it = m_pending.find(uid);
+        if (it == m_pending.end()) {
+            return true;
+        }
+        for (const auto& item : it->second) {
+            acks.push_back(dao::GroupUserAck{item.first, uid, item.second});
+        }
+    }
+    return write(acks);
+}
+
+bool GroupAckBuffer::write(const std::vector<dao::GroupUserAck>& acks)
+{
+    bool ok = true;
+    for (size_t begin = 0; begin < acks.size(); begin += m_batchSize) {
+        size_t end = std::min(begin + m_batchSize, acks.size());
+        std::vector<dao::GroupUserAck> batch(acks.begin() + begin, acks.begin() + end);
+        dao::ErrorCode ec = m_groupUsers->updateLastAckMidBatch(batch);
+
+        std::lock_guard<std::mutex> l(m_mtx);
+        ++m_stats.batches;
+        if (ec != dao::ERRORCODE_SUCCESS) {
+            // still pending, the next flush retries them
+            LOGE << "failed to write " << batch.size() << " last_ack_mid, error: " << ec;
+            ++m_stats.failedBatches;
+            ok = false;
+            continue;
+        }
+        m_stats.written += batch.size();
+        for (const auto& ack : batch) {
+            auto user = m_pending.find(ack.uid);
+            if (user == m_pending.end()) {
+                continue;
+            }
+            auto item = user->second.find(ack.gid);
+            // a later ack arrived while writing, it goes out with the next flush
+            if (item != user->second.end() && item->second <= ack.lastAckMid) {
+                user->second.erase(item);
+            }
+            if (user->second.empty()) {
+                m_pending.erase(user);
+            }
+        }
+    }
+    return ok;
+}
+
+GroupAckBuffer::Stats GroupAckBuffer::stats() const
+{
+    std::lock_guard<std::mutex> l(m_mtx);
+    return m_stats;
+}
+
+void GroupAckBuffer::run()
+{
+    int64_t start = nowInMilli();
+    flush();
+    m_execTime = nowInMilli() - start;
+}
+
+int64_t GroupAckBuffer::lastExecTimeInMilli()
+{
+    return m_execTime;
+}
+
+}
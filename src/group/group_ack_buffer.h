@@ -0,0 +1,60 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dao/group_users.h"
+#include "fiber/fiber_timer.h"
+
+namespace bcm {
+
+/*
+ * write-behind buffer of the last_ack_mid of group members. clients ack every group
+ * message they read, only the highest mid per member is kept and written in bulk on
+ * every timer run, when the member goes offline and on shutdown.
+ * acks not written yet are only visible through pending() on this node.
+ */
+class GroupAckBuffer : public FiberTimer::Task {
+public:
+    struct Stats {
+        uint64_t acks{0};
+        // members written, acks replaced by a later one before the flush are not counted
+        uint64_t written{0};
+        uint64_t batches{0};
+        uint64_t failedBatches{0};
+    };
+
+    GroupAckBuffer(std::shared_ptr<dao::GroupUsers> groupUsers, size_t batchSize);
+
+    void ack(uint64_t gid, const std::string& uid, uint64_t mid);
+
+    // gid -> last_ack_mid of uid not written yet
+    std::map<uint64_t, uint64_t> pending(const std::string& uid) const;
+
+    // false if some acks are left for the next flush
+    bool flush();
+    bool flushUser(const std::string& uid);
+
+    Stats stats() const;
+
+    void run() override;
+    int64_t lastExecTimeInMilli() override;
+
+private:
+    bool write(const std::vector<dao::GroupUserAck>& acks);
+
+private:
+    std::shared_ptr<dao::GroupUsers> m_groupUsers;
+    size_t m_batchSize;
+    mutable std::mutex m_mtx;
+    // uid -> gid -> highest mid acked
+    std::unordered_map<std::string, std::map<uint64_t, uint64_t>> m_pending;
+    Stats m_stats;
+    int64_t m_execTime{0};
+};
+
+}
@@ -2,6 +2,7 @@
 #include "message_type.h"
 #include "online_msg_member_mgr.h"
 #include "group_event.h"
+#include "group_meta_cache.h"
 #include "config/redis_config.h"
 #include "utils/log.h"
 
@@ -63,6 +64,8 @@ void GroupEventSub::onError(int code)
 void GroupEventSub::handleEvent(int type, const std::string& uid, 
                                     uint64_t gid)
 {
+    GroupMetaCache::Instance()->onUserEvent(type, gid, uid);
+
     switch (type) {
     case INTERNAL_USER_ENTER_GROUP:
         m_onlineMsgMemberMgr.handleUserEnterGroup(uid, gid);
@@ -0,0 +1,143 @@
+#include "group_meta_cache.h"
+#include "message_type.h"
+
+#include <nlohmann/json.hpp>
+
+#include "config/bcm_options.h"
+#include "dao/client.h"
+#include "proto/dao/group_msg.pb.h"
+#include "utils/log.h"
+#include "utils/time.h"
+
+namespace bcm {
+
+constexpr size_t GroupMetaCache::kInvalidationShards;
+
+GroupMetaCache::GroupMetaCache(size_t limit, int64_t ttlInMilli,
+                               std::shared_ptr<dao::Groups> groups,
+                               std::shared_ptr<dao::GroupUsers> groupUsers)
+    : m_ttlInMilli(ttlInMilli)
+    , m_groups(std::move(groups))
+    , m_groupUsers(std::move(groupUsers))
+    // member roles outnumber groups by far
+    , m_metas(limit / 8)
+    , m_roles(limit - limit / 8)
+{
+    for (auto& invalidations : m_invalidations) {
+        invalidations.store(0);
+    }
+}
+
+GroupMetaCache* GroupMetaCache::Instance()
+{
+    static GroupMetaCache instance(
+        BcmOptions::getInstance()->getConfig().cacheConfig.groupMetaLimit,
+        BcmOptions::getInstance()->getConfig().cacheConfig.groupMetaTtl * 1000,
+        dao::ClientFactory::groups(),
+        dao::ClientFactory::groupUsers());
+    return &instance;
+}
+
+dao::ErrorCode GroupMetaCache::getGroup(uint64_t gid, GroupMeta& meta)
+{
+    int64_t now = nowInMilli();
+    auto cached = m_metas.get(gid);
+    if (cached && cached->expireAt > now) {
+        meta = cached->value;
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    std::atomic<uint64_t>& shard = invalidationsOf(gid);
+    uint64_t invalidations = shard.load();
+    bcm::Group group;
+    dao::ErrorCode ec = m_groups->get(gid, group);
+    if (ec != dao::ERRORCODE_SUCCESS) {
+        return ec;
+    }
+    meta.broadcast = group.broadcast();
+    meta.status = group.status();
+    if (invalidations == shard.load()) {
+        m_metas.set(gid, GroupEntry{meta, now + m_ttlInMilli});
+    }
+    return ec;
+}
+
+dao::ErrorCode GroupMetaCache::getMemberRole(uint64_t gid, const std::string& uid, GroupUser::Role& role)
+{
+    int64_t now = nowInMilli();
+    std::string key = memberKey(gid, uid);
+    auto cached = m_roles.get(key);
+    if (cached && cached->expireAt > now) {
+        role = cached->value;
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    std::atomic<uint64_t>& shard = invalidationsOf(gid);
+    uint64_t invalidations = shard.load();
+    dao::ErrorCode ec = m_groupUsers->getMemberRole(gid, uid, role);
+    // a non member may join at any moment, only an existing membership is worth keeping
+    if (ec == dao::ERRORCODE_SUCCESS && role != GroupUser::ROLE_UNDEFINE
+        && invalidations == shard.load()) {
+        m_roles.set(key, RoleEntry{role, now + m_ttlInMilli});
+    }
+    return ec;
+}
+
+void GroupMetaCache::invalidateGroup(uint64_t gid)
+{
+    ++invalidationsOf(gid);
+    m_metas.erase(gid);
+}
+
+void GroupMetaCache::invalidateMember(uint64_t gid, const std::string& uid)
+{
+    ++invalidationsOf(gid);
+    m_roles.erase(memberKey(gid, uid));
+}
+
+void GroupMetaCache::onUserEvent(int type, uint64_t gid, const std::string& uid)
+{
+    switch (type) {
+    case INTERNAL_USER_ENTER_GROUP:
+    case INTERNAL_USER_QUIT_GROUP:
+    case INTERNAL_USER_CHANGE_ROLE:
+        invalidateMember(gid, uid);
+        break;
+    default:
+        // muting only changes the notifications of the member
+        break;
+    }
+}
+
+void GroupMetaCache::onSystemMessage(uint64_t gid, int type, const std::string& text)
+{
+    if (type == GroupMsg::TYPE_INFO_UPDATE) {
+        invalidateGroup(gid);
+        return;
+    }
+    if (type != GroupMsg::TYPE_MEMBER_UPDATE) {
+        return;
+    }
+    try {
+        nlohmann::json textObj = nlohmann::json::parse(text);
+        const nlohmann::json& arr = textObj.at("members");
+        for (nlohmann::json::const_iterator it = arr.begin(); it != arr.end(); ++it) {
+            invalidateMember(gid, it->at("uid").get<std::string>());
+        }
+    } catch (std::exception& e) {
+        // members unknown, the ttl has to do
+        LOGE << "failed to parse member update of group " << gid << ": " << e.what();
+    }
+}
+
+std::atomic<uint64_t>& GroupMetaCache::invalidationsOf(uint64_t gid)
+{
+    return m_invalidations[gid % kInvalidationShards];
+}
+
+std::string GroupMetaCache::memberKey(uint64_t gid, const std::string& uid)
+{
+    return std::to_string(gid) + "_" + uid;
+}
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "dao/groups.h"
+#include "dao/group_users.h"
+#include "dao/dao_cache/tiny_lfu_cache.h"
+
+namespace bcm {
+
+/*
+ * node local cache of what the group message paths check before every send, get and ack:
+ * the broadcast flag and status of a group, and the role of a member in it.
+ * entries are dropped on the group events published on user_<uid> and group_event_msg,
+ * and on local writes before they are published. a short ttl bounds how long a missed
+ * event can leave an entry stale.
+ */
+class GroupMetaCache {
+public:
+    struct GroupMeta {
+        int32_t broadcast{0};
+        int32_t status{0};
+    };
+
+    GroupMetaCache(size_t limit, int64_t ttlInMilli,
+                   std::shared_ptr<dao::Groups> groups,
+                   std::shared_ptr<dao::GroupUsers> groupUsers);
+
+    static GroupMetaCache* Instance();
+
+    // same results as Groups::get, only successful reads are cached
+    dao::ErrorCode getGroup(uint64_t gid, GroupMeta& meta);
+    // same results as GroupUsers::getMemberRole, only members are cached
+    dao::ErrorCode getMemberRole(uint64_t gid, const std::string& uid, GroupUser::Role& role);
+
+    void invalidateGroup(uint64_t gid);
+    void invalidateMember(uint64_t gid, const std::string& uid);
+
+    // an INTERNAL_USER_* event of uid in gid
+    void onUserEvent(int type, uint64_t gid, const std::string& uid);
+    // a group system message, info updates drop the group, member updates drop the listed members
+    void onSystemMessage(uint64_t gid, int type, const std::string& text);
+
+private:
+    template <class T>
+    struct Entry {
+        T value;
+        int64_t expireAt;
+    };
+
+    template <class T>
+    struct EntrySize {
+        size_t operator()(const Entry<T>&) const
+        {
+            // the key and the bookkeeping of the cache cost about as much as the value
+            return 2 * sizeof(Entry<T>) + 64;
+        }
+    };
+
+    typedef Entry<GroupMeta> GroupEntry;
+    typedef Entry<GroupUser::Role> RoleEntry;
+
+    static std::string memberKey(uint64_t gid, const std::string& uid);
+
+    static constexpr size_t kInvalidationShards = 256;
+
+    std::atomic<uint64_t>& invalidationsOf(uint64_t gid);
+
+private:
+    int64_t m_ttlInMilli;
+    std::shared_ptr<dao::Groups> m_groups;
+    std::shared_ptr<dao::GroupUsers> m_groupUsers;
+    dao::TinyLFUCache<uint64_t, GroupEntry, EntrySize<GroupMeta>> m_metas;
+    dao::TinyLFUCache<std::string, RoleEntry, EntrySize<GroupUser::Role>> m_roles;
+    // bumped by the invalidations of the gids of a shard, a read that raced with one
+    // of its shard is not cached
+    std::array<std::atomic<uint64_t>, kInvalidationShards> m_invalidations;
+};
+
+}
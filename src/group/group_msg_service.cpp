@@ -4,6 +4,8 @@
 #include "group_msg_sub.h"
 #include "group_event_sub.h"
 #include "online_msg_member_mgr.h"
+#include "group_meta_cache.h"
+#include "group_ack_buffer.h"
 
 #include "online_msg_handler.h"
 
@@ -31,6 +33,8 @@
 namespace bcm {
 
 static const std::string groupMessageService = "bcm_gmessager";
+// system messages of every group, published by GroupManagerController
+static const std::string groupEventChannel = "group_event_msg";
 static const std::string receivedInternalMessageFromRedis = 
     "received_internal_message_from_redis";
 static const std::string receivedGroupMessageFromRedis = 
@@ -55,6 +59,7 @@ class GroupMsgServiceImpl
     OnlineMsgMemberMgr m_onlineMsgMemberMgr;
     OnlineMsgHandler m_onlineMsgHandler;
     GroupEventSub m_groupEventSub;
+    std::shared_ptr<GroupAckBuffer> m_ackBuffer;
 
 public:
     GroupMsgServiceImpl(const RedisConfig redisCfg, 
@@ -107,6 +112,14 @@ public:
     void onUserOffline(const DispatchAddress& user) override
     {
         m_onlineMsgMemberMgr.handleUserOffline(user);
+        if (m_ackBuffer) {
+            m_ackBuffer->flushUser(user.getUid());
+        }
+    }
+
+    void setAckBuffer(std::shared_ptr<GroupAckBuffer> ackBuffer)
+    {
+        m_ackBuffer = std::move(ackBuffer);
     }
 
     void getLocalOnlineGroupMembers(uint64_t gid, uint32_t count, OnlineMsgMemberMgr::UserList& users)
@@ -141,6 +154,11 @@ private:
              << ", message: " << msg;
         try {
             nlohmann::json msgObj = nlohmann::json::parse(msg);
+            if (chan == groupEventChannel) {
+                GroupMetaCache::Instance()->onSystemMessage(msgObj.at("gid").get<uint64_t>(),
+                                                            msgObj.at("type").get<int>(),
+                                                            msgObj.value("text", ""));
+            }
             m_onlineMsgHandler.handleMessage(chan, msgObj);
         } catch (std::exception& e) {
             LOGE << "exception caught: " << e.what() 
@@ -188,24 +206,58 @@ void GroupMsgService::updateRedisdbOfflineInfo(uint64_t gid, uint64_t mid, Group
     bcm::PushPeopleType pushType = bcm::PushPeopleType::PUSHPEOPLETYPE_TO_ALL;
     if (!groupMultibroadInfo.members.empty()) {
         pushType = bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON;
-        char multiField[50];
-        snprintf(multiField, sizeof(multiField), "%020lu_%020lu_%02d", gid, mid, pushType);
-        if (!RedisDbManager::Instance()->hset(gid, REDISDB_KEY_GROUP_MULTI_LIST_INFO, std::string(multiField), groupMultibroadInfo.to_string())) {
-            LOGE << "failed to hset group info to redis 'group_multi_msg_list', gid: " << gid
-                 << ", mid: " << mid << ", broadInfo: " << groupMultibroadInfo.to_string();
+    }
+    std::string groupField = formatGroupMsgField(gid, mid, pushType);
+    uint32_t shard = groupMsgShard(gid, m_offlineMsgShards);
+
+    if (m_offlineMsgStream) {
+        std::vector<HField> values;
+        values.emplace_back(REDISDB_GROUP_MSG_STREAM_FIELD_MSG, groupField);
+        if (pushType == bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
+            values.emplace_back(REDISDB_GROUP_MSG_STREAM_FIELD_MULTI, groupMultibroadInfo.to_string());
+        }
+        if (RedisDbManager::Instance()->xadd(gid, groupMsgShardKey(REDISDB_KEY_GROUP_MSG_STREAM, shard),
+                                             values, m_offlineMsgStreamMaxLen)) {
             return;
         }
+        // the offline server still polls the sorted set as recovery path
+        LOGW << "failed to xadd group info to redis 'group_msg_stream', fall back to 'group_msg_list', gid: "
+             << gid << ", mid: " << mid;
     }
 
-    char groupField[50];
-    snprintf(groupField, sizeof(groupField), "%020lu_%020lu_%02d", gid, mid, pushType);
-    if (!RedisDbManager::Instance()->zadd(gid, REDISDB_KEY_GROUP_MSG_INFO, std::string(groupField), nowInSec())) {
+    std::string msgListKey = groupMsgShardKey(REDISDB_KEY_GROUP_MSG_INFO, shard);
+    if (pushType == bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
+        if (!RedisDbManager::Instance()->hsetZadd(gid, groupMsgShardKey(REDISDB_KEY_GROUP_MULTI_LIST_INFO, shard),
+                                                  groupMultibroadInfo.to_string(),
+                                                  msgListKey, groupField, nowInSec())) {
+            LOGE << "failed to hset and zadd group info to redis 'group_multi_msg_list', gid: " << gid
+                 << ", mid: " << mid << ", broadInfo: " << groupMultibroadInfo.to_string();
+        }
+        return;
+    }
+
+    if (!RedisDbManager::Instance()->zadd(gid, msgListKey, groupField, nowInSec())) {
         LOGE << "failed to zadd group info to redis 'group_msg_list', gid: " << gid
              << ", mid: " << mid << ", from_uid: " << groupMultibroadInfo.from_uid;
         return;
     }
 }
 
+void GroupMsgService::setOfflineMsgStream(bool enabled, uint32_t maxLen)
+{
+    m_offlineMsgStream = enabled;
+    m_offlineMsgStreamMaxLen = maxLen;
+}
+
+void GroupMsgService::setOfflineMsgShards(uint32_t shards)
+{
+    m_offlineMsgShards = shards > 0 ? shards : 1;
+}
+
+void GroupMsgService::setAckBuffer(std::shared_ptr<GroupAckBuffer> ackBuffer)
+{
+    m_impl.setAckBuffer(std::move(ackBuffer));
+}
 
 void GroupMsgService::getLocalOnlineGroupMembers(uint64_t gid, uint32_t count, OnlineMsgMemberMgr::UserList& users)
 {
@@ -22,6 +22,7 @@ class DispatchManager;
 class AccountsManager;
 class OnlineUserRegistry;
 class GroupMsgServiceImpl;
+class GroupAckBuffer;
 
 class GroupMsgService : public std::enable_shared_from_this<GroupMsgService> {
 public:
@@ -35,12 +36,20 @@ public:
     void notifyUserOffline(const DispatchAddress& user);
 
     void updateRedisdbOfflineInfo(uint64_t gid, uint64_t mid, GroupMultibroadMessageInfo& groupMultibroadInfo);
+    // notify the offline server through the group message stream instead of the sorted set
+    void setOfflineMsgStream(bool enabled, uint32_t maxLen);
+    void setOfflineMsgShards(uint32_t shards);
+    // pending acks of a user are written when the user goes offline
+    void setAckBuffer(std::shared_ptr<GroupAckBuffer> ackBuffer);
 
     virtual void getLocalOnlineGroupMembers(uint64_t gid, uint32_t count, OnlineMsgMemberMgr::UserList& users);
 
 private:
     GroupMsgServiceImpl* m_pImpl;
     GroupMsgServiceImpl& m_impl;
+    bool m_offlineMsgStream{false};
+    uint32_t m_offlineMsgStreamMaxLen{0};
+    uint32_t m_offlineMsgShards{1};
 };
 
 } // namespace bcm
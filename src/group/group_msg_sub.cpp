@@ -1,3 +1,4 @@
+#include <atomic>
 #include <shared_mutex>
 
 #include "group_msg_sub.h"
@@ -15,6 +16,10 @@
 
 namespace bcm {
 
+static const std::string groupChannelPrefix = "group_";
+static const std::string groupBucketChannelPrefix = "group_bucket_";
+static std::atomic<uint32_t> gs_channelBuckets(0);
+
 // -----------------------------------------------------------------------------
 // Section: GroupMsgSubImpl
 // -----------------------------------------------------------------------------
@@ -27,6 +32,16 @@ public:
     GroupMsgSubImpl()
     {
         OnlineRedisManager::Instance()->subscribe("group_event_msg", this);
+
+        uint32_t buckets = GroupMsgSub::channelBuckets();
+        if (buckets > 0) {
+            std::vector<std::string> chans;
+            chans.reserve(buckets);
+            for (uint32_t b = 0; b < buckets; ++b) {
+                chans.push_back(groupBucketChannelPrefix + std::to_string(b));
+            }
+            OnlineRedisManager::Instance()->subscribeBatch(chans, this);
+        }
     }
 
     virtual ~GroupMsgSubImpl()
@@ -52,24 +67,31 @@ public:
 
     void subscribeGids(const std::vector<uint64_t>& gids)
     {
-        if (gids.empty()) {
+        // buckets are subscribed for good
+        if (gids.empty() || GroupMsgSub::channelBuckets() > 0) {
             return;
         }
 
+        std::vector<std::string> chans;
+        chans.reserve(gids.size());
         for (auto& g : gids) {
-            OnlineRedisManager::Instance()->subscribe("group_" + std::to_string(g), this);
+            chans.push_back(groupChannelPrefix + std::to_string(g));
         }
+        OnlineRedisManager::Instance()->subscribeBatch(chans, this);
     }
 
     void unsubcribeGids(const std::vector<uint64_t>& gids)
     {
-        if (gids.empty()) {
+        if (gids.empty() || GroupMsgSub::channelBuckets() > 0) {
             return;
         }
 
+        std::vector<std::string> chans;
+        chans.reserve(gids.size());
         for (auto& g : gids) {
-            OnlineRedisManager::Instance()->unsubscribe("group_" + std::to_string(g));
+            chans.push_back(groupChannelPrefix + std::to_string(g));
         }
+        OnlineRedisManager::Instance()->unsubscribeBatch(chans);
     }
 
 private:
@@ -136,7 +158,35 @@ void GroupMsgSub::unsubcribeGids(const std::vector<uint64_t>& gids)
 // static
 bool GroupMsgSub::isGroupMessageChannel(const std::string& chan)
 {
-    return (chan.find("group_") == 0) || (chan.find("instant_") == 0);
+    return (chan.find(groupChannelPrefix) == 0) || (chan.find("instant_") == 0);
+}
+
+// static
+void GroupMsgSub::setChannelBuckets(uint32_t buckets)
+{
+    gs_channelBuckets = buckets;
+}
+
+// static
+uint32_t GroupMsgSub::channelBuckets()
+{
+    return gs_channelBuckets;
+}
+
+// static
+std::string GroupMsgSub::groupChannel(uint64_t gid)
+{
+    uint32_t buckets = gs_channelBuckets;
+    if (buckets == 0) {
+        return groupChannelPrefix + std::to_string(gid);
+    }
+    return groupBucketChannelPrefix + std::to_string(gid % buckets);
+}
+
+// static
+bool GroupMsgSub::isBucketChannel(const std::string& chan)
+{
+    return chan.find(groupBucketChannelPrefix) == 0;
 }
 
 } // namespace bcm
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <thread>
 #include <functional>
+#include <string>
 #include <vector>
 
 struct event_base;
@@ -26,6 +27,14 @@ public:
 
     static bool isGroupMessageChannel(const std::string& chan);
 
+    // with buckets > 0 group messages go to group_bucket_<gid % buckets> and every
+    // node subscribes to all buckets, every node must be configured the same.
+    // set once at startup before any GroupMsgSub is created
+    static void setChannelBuckets(uint32_t buckets);
+    static uint32_t channelBuckets();
+    static std::string groupChannel(uint64_t gid);
+    static bool isBucketChannel(const std::string& chan);
+
     void subscribeGids(const std::vector<uint64_t>& gids);
     void unsubcribeGids(const std::vector<uint64_t>& gids);
 
@@ -7,6 +7,7 @@
 #include <event2/event.h>
 #include <hiredis/hiredis.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace bcm {
@@ -62,13 +63,12 @@ void ImServerMgr::shutdown(DisconnectHandler&& handler)
 
 bool ImServerMgr::shouldHandleGroup(uint64_t gid)
 {
-    std::shared_lock<std::shared_timed_mutex> l(m_constHashMtx);
-    std::string addr = m_consistentHash.GetServer(gid);
-    if (addr.empty()) {
+    int32_t node = m_consistentHash.GetNode(gid);
+    if (node < 0) {
         LOGW << "could not find im server by group id; " << gid;
         return false;
     }
-    if (!isSelf(addr)) {
+    if (node != m_selfNode.load()) {
         LOGW << "group, gid: " << gid << " does not belong to me";
         return false;
     }
@@ -77,7 +77,6 @@ bool ImServerMgr::shouldHandleGroup(uint64_t gid)
 
 std::string ImServerMgr::getServerByGroup(uint64_t gid)
 {
-    std::shared_lock<std::shared_timed_mutex> l(m_constHashMtx);
     return m_consistentHash.GetServer(gid);
 }
 
@@ -151,26 +150,40 @@ void ImServerMgr::updateImServerList()
         LOGD << "found " << serverDescList.size() << " im server(s)";
 
         bool shouldLog = ((rand() % 10) == 0);
-        std::unique_lock<std::shared_timed_mutex> l(m_imsvrsMtx);
-        std::unique_lock<std::shared_timed_mutex> ll(m_constHashMtx);
-        m_imsvrs.clear();
-        m_consistentHash.Clear();
-        
-        m_imsvrs.reserve(serverDescList.size());
+        std::vector<std::string> imsvrs;
+        imsvrs.reserve(serverDescList.size());
         for (auto& ipPortEnt : serverDescList) {
             std::vector<std::string> tokens;
             boost::split(tokens, ipPortEnt, boost::is_any_of("_"));
             if (tokens.size() >= 2) {
                 std::string& ipport = tokens[1];
-                if (std::find(m_imsvrs.begin(), m_imsvrs.end(), ipport) 
-                        == m_imsvrs.end()) {
-                    m_imsvrs.emplace_back(ipport);
-                    m_consistentHash.AddServer(ipport);
+                if (std::find(imsvrs.begin(), imsvrs.end(), ipport) == imsvrs.end()) {
+                    imsvrs.emplace_back(ipport);
                 }
             } else {
                 LOGE << "invalid server descriptor format: " << ipPortEnt;
             }
         }
+
+        std::unique_lock<std::shared_timed_mutex> l(m_imsvrsMtx);
+        std::vector<std::string> sortedOld = m_imsvrs;
+        std::vector<std::string> sortedNew = imsvrs;
+        std::sort(sortedOld.begin(), sortedOld.end());
+        std::sort(sortedNew.begin(), sortedNew.end());
+        m_imsvrs.swap(imsvrs);
+        // the ring is rebuilt on membership changes only
+        if (sortedOld != sortedNew) {
+            m_consistentHash.SetServers(m_imsvrs);
+            int32_t selfNode = -1;
+            for (const auto& ipport : m_imsvrs) {
+                if (isSelf(ipport)) {
+                    selfNode = m_consistentHash.FindNode(ipport);
+                    break;
+                }
+            }
+            m_selfNode = selfNode;
+        }
+
         if (shouldLog) {
             std::stringstream ss;
             for (auto& ent : m_imsvrs) {
@@ -182,7 +195,6 @@ void ImServerMgr::updateImServerList()
             LOGI << "found " << m_imsvrs.size() << " im servers: " << ss.str();
         }
 
-        ll.unlock();
         l.unlock();
         
         if (m_listener != nullptr) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <shared_mutex>
@@ -48,7 +49,8 @@ private:
     std::vector<std::string> m_imsvrs;
     mutable std::shared_timed_mutex m_imsvrsMtx;
     UserConsistentFnvHash m_consistentHash;
-    mutable std::shared_timed_mutex m_constHashMtx;
+    // node of this server on m_consistentHash, -1 until it is listed
+    std::atomic<int32_t> m_selfNode{-1};
     IServerListUpdateListener* m_listener;
     std::vector<std::string> m_regKeys;
 };
@@ -254,6 +254,10 @@ void OnlineMsgHandler::handleMessage(const std::string& chan,
 {
     if (GroupMsgSub::isGroupMessageChannel(chan)) {
         uint64_t gid = msgObj.at("gid").get<uint64_t>();
+        // a bucket carries the groups of every node, keep those with local members
+        if (GroupMsgSub::isBucketChannel(chan) && !m_memberMgr.isGroupExist(gid)) {
+            return;
+        }
         IoCtxPool& pool = m_memberMgr.ioCtxPool();
         IoCtxPool::io_context_ptr ioc = pool.getIoCtxByGid(gid);
         if (ioc != nullptr) {
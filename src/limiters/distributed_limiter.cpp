@@ -142,46 +142,35 @@ void DistributedLimiter::incr(const std::string& uid,
                               int64_t& count,
                               int64_t timeSlot)
 {
-    uint64_t new_value = 0;
     uint32_t period = rule.period / 1000; // period in seconds
     std::ostringstream oss;
     oss << m_identity << "_" << uid << "_" << timeSlot;
     std::string keyId = oss.str();
-    int32_t ret = RedisDbManager::Instance()->incr(uid, keyId, new_value);
-    
+
+    // INCR and EXPIRE in one round trip and one transaction, so the key of a slot can
+    // not be left without expire time
+    std::vector<RedisDbCmd> cmds;
+    cmds.push_back(RedisDbCmd::keyCmd(uid, {"INCR", keyId}));
+    cmds.push_back(RedisDbCmd::keyCmd(uid, {"EXPIRE", keyId, std::to_string(period)}));
+    std::vector<RedisCmdResult> results;
+
     // Communication error
-    auto communicationErrorHandler = [&]() {
+    if (!RedisDbManager::Instance()->pipeline(cmds, results, true)) {
         LOGE << "failed to incr: (" << m_identity << "," << keyId << ")." ;
-    };
+        count = 0;
+        return;
+    }
 
     // Key already exist but in invalid type, update it explicitly
-    auto invalidKeyTypeHandler = [&]() {
+    if (!results[0].ok || results[0].type != REDIS_REPLY_INTEGER) {
         LOGE << "unexpeted type for (" << m_identity << "," << keyId << ")." ;
-        RedisDbManager::Instance()->set(uid, keyId, "1");
-        RedisDbManager::Instance()->expire(uid, keyId, period);
-    };
-
-    // Normal valid reply
-    //     case 1: a new interval, set expire time
-    //     case 2: exceed threshold, do nothing and wait redis to expire
-    //     case 3: within the threshold, do nothing
-    auto normalReplyHandler = [&]() {
-        if (1 == new_value) {
-            RedisDbManager::Instance()->expire(uid, keyId, period);
-        }
-    };     
-
-    switch (ret) {
-        case -1:
-            communicationErrorHandler();
-            count = 0;
-        case 0:
-            invalidKeyTypeHandler();
-            count = 1;
-        default:
-            normalReplyHandler();
-            count = new_value;
+        RedisDbManager::Instance()->set(uid, keyId, "1", period);
+        count = 1;
+        return;
     }
+
+    // Normal valid reply, redis expires the key at the end of the slot
+    count = results[0].integer;
 }
 
 }
@@ -42,12 +42,15 @@
 #include "registers/imservice_register.h"
 #include "registers/offline_register.h"
 #include "group/group_msg_service.h"
+#include "group/group_ack_buffer.h"
+#include "group/group_msg_sub.h"
 #include <metrics_client.h>
 #include <metrics_log.h>
 #include "metrics/onlineuser_metrics.h"
 #include "redis/redis_manager.h"
 #include "redis/redis_manage_timer.h"
 #include "redis/online_redis_manager.h"
+#include "dispatcher/presence_index.h"
 #include "limiters/configuration_manager.h"
 #include "limiters/limiter_config_update.h"
 #include "limiters/limiter_executor.h"
@@ -85,27 +88,31 @@ static void globalClean()
 
 void metricsLogCallback(MetricsLogLevel level, const std::string& str)
 {
+    LogSeverity severity;
     switch (level) {
         case METRICS_LOGLEVEL_TRACE:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_TRACE) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_TRACE;
             break;
         case METRICS_LOGLEVEL_DEBUG:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_DEBUG) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_DEBUG;
             break;
         case METRICS_LOGLEVEL_INFO:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_INFO) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_INFO;
             break;
         case METRICS_LOGLEVEL_WARN:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_WARN) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_WARN;
             break;
         case METRICS_LOGLEVEL_ERROR:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_ERROR) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_ERROR;
             break;
         case METRICS_LOGLEVEL_FATAL:
-            BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_FATAL) << boost::this_fiber::get_id() << "|" << str;
+            severity = LOGSEVERITY_FATAL;
             break;
         default:
-            break;
+            return;
+    }
+    if (Log::enabled(severity)) {
+        LogRecord(severity, nullptr, nullptr, 0).stream() << str;
     }
 }
 
@@ -134,6 +141,8 @@ int main(int argc, char** argv)
     BCMMetricsConfig::copyToMetricsConfig(config.bcmMetricsConfig, metricsConfig);
     MetricsClient::Init(metricsConfig);
 
+    RedisServer::setDefaultPoolConfig(config.redisPool);
+    RedisServer::enablePoolMetrics();
     RedisClientSync::Instance()->setRedisConfig(config.redis);
 
     // redis for group/offline
@@ -142,6 +151,7 @@ int main(int argc, char** argv)
         exit(-1);
     }
     // redis for sub/pub
+    OnlineRedisManager::enableMetrics();
     if (!OnlineRedisManager::Instance()->init(config.onlineRedis)) {
         LOGE << "online redis manager init fail";
         exit(-1);
@@ -174,7 +184,21 @@ int main(int argc, char** argv)
                                                              contacts,
                                                              config.encryptSender);
 
+    std::shared_ptr<PresenceIndex> presenceIndex;
+    if (config.presence.enabled) {
+        // named like the register keys of this server
+        std::string selfNode = (config.http.ips.empty() ? config.http.host : config.http.ips[0])
+                               + ":" + std::to_string(config.http.port);
+        presenceIndex = std::make_shared<PresenceIndex>(config.presence, selfNode);
+        dispatchManager->registerUserStatusListener(presenceIndex.get());
+        presenceIndex->start();
+    }
+
+    GroupMsgSub::setChannelBuckets(config.groupConfig.channelBuckets);
     auto groupMsgService = std::make_shared<GroupMsgService>(config.redis[0], dispatchManager, config.noise);
+    groupMsgService->setOfflineMsgStream(config.groupConfig.offlineMsgStream,
+                                         config.groupConfig.offlineMsgStreamMaxLen);
+    groupMsgService->setOfflineMsgShards(config.groupConfig.offlineMsgShards);
 
     for (const std::string& key : imServiceRegister->getRegisterKeys()) {
         groupMsgService->addRegKey(key);
@@ -194,8 +218,11 @@ int main(int argc, char** argv)
     auto accountController = std::make_shared<AccountsController>(accountsManager, challenges, turnTokenGenerator,
                                                                   dispatchManager, keysManager, config.challenge);
     auto deviceController = std::make_shared<DeviceController>(accountsManager, dispatchManager, keysManager, config.multiDeviceConfig);
+    auto groupAckBuffer = std::make_shared<GroupAckBuffer>(dao::ClientFactory::groupUsers(),
+                                                           config.groupConfig.ackFlushBatchSize);
+    groupMsgService->setAckBuffer(groupAckBuffer);
     auto groupMsgController = std::make_shared<GroupMsgController>(groupMsgService, config.encryptSender, 
-                                                                  config.sizeCheck);
+                                                                  config.sizeCheck, groupAckBuffer);
     
     auto messageController = std::make_shared<MessageController>(accountsManager,
                                                                  offlineDispatcher,
@@ -272,6 +299,10 @@ int main(int argc, char** argv)
     fiberTimer->schedule(offlineRegister, OfflineServiceRegister::kKeepAliveInterval, true);
     fiberTimer->schedule(limiterConfigUpdater, config.limiterConfig.configUpdateInterval, false);
     redisFiberTimer->schedule(redisManageTimer, RedisManageTimer::redisManageTimerInterval, true);
+    fiberTimer->schedule(groupAckBuffer, config.groupConfig.ackFlushInterval, false);
+    if (presenceIndex != nullptr) {
+        fiberTimer->schedule(presenceIndex, config.presence.flushIntervalInMilli, true);
+    }
 
     service->wait();
     fiberTimer->cancel(lbsRegister);
@@ -279,6 +310,12 @@ int main(int argc, char** argv)
     fiberTimer->cancel(offlineRegister);
     fiberTimer->cancel(limiterConfigUpdater);
     redisFiberTimer->cancel(redisManageTimer);
+    fiberTimer->cancel(groupAckBuffer);
+    groupAckBuffer->flush();
+    if (presenceIndex != nullptr) {
+        fiberTimer->cancel(presenceIndex);
+        presenceIndex->stop();
+    }
     LimiterConfigurationManager::getInstance()->uninitialize();
     globalClean();
     return 0;
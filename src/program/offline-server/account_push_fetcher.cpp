@@ -0,0 +1,112 @@
+#include "account_push_fetcher.h"
+
+#include <algorithm>
+
+#include <utils/log.h>
+#include "utils/sync_latch.h"
+#include "store/accounts_manager.h"
+#include "dispatcher/dispatch_address.h"
+
+namespace bcm {
+
+AccountPushFetcher::AccountPushFetcher(std::shared_ptr<AccountsManager> accountMgr, int concurrency, int batchSize)
+    : m_accountMgr(std::move(accountMgr))
+    , m_pool(std::max(1, concurrency))
+    , m_batchSize(static_cast<size_t>(std::max(1, batchSize)))
+{
+}
+
+bool AccountPushFetcher::fetch(const std::vector<std::string>& uids,
+                               std::map<std::string, GroupUserMessageIdInfo>& pushInfos,
+                               std::vector<std::string>& missedUids)
+{
+    std::vector<Account> accountList;
+    std::vector<std::string> notFound;
+
+    if (!m_accountMgr->get(uids, accountList, notFound)) {
+        LOGE << "fetch push info, get account database error"
+             << ", uids: " << toString(uids);
+        return false;
+    }
+
+    if (!notFound.empty()) {
+        LOGW << notFound.size() << " uids could not be found in database, "
+             << "missed uids: " << toString(notFound);
+
+        for (const auto& itAcc : notFound) {
+            missedUids.emplace_back(itAcc);
+        }
+    }
+
+    for (const auto& a : accountList) {
+        const auto& dev = AccountsManager::getDevice(a, Device::MASTER_ID);
+        if (dev == boost::none) {
+            LOGW << "account, uid: " << a.uid() << " does not have a master device";
+            continue;
+        }
+
+        auto& info = pushInfos[a.uid()];
+        if (!AccountsManager::isDevicePushable(*dev)) {
+            info.cfgFlag = GroupUserConfigPushType::NO_CONFIG;
+            continue;
+        }
+
+        info.cfgFlag = GroupUserConfigPushType::NORMAL;
+        info.gcmId = dev->gcmid();
+        info.umengId = dev->umengid();
+        info.osType = dev->clientversion().ostype();
+        info.osVersion = dev->clientversion().osversion();
+        info.bcmBuildCode = dev->clientversion().bcmbuildcode();
+        info.phoneModel = dev->clientversion().phonemodel();
+        info.targetAddress = DispatchAddress(a.uid(), dev->id()).getSerialized();
+        info.apnId = dev->apnid();
+        info.apnType = dev->apntype();
+        info.voipApnId = dev->voipapnid();
+    }
+    return true;
+}
+
+bool AccountPushFetcher::batchFetch(const std::vector<std::string>& uids,
+                                    std::map<std::string, GroupUserMessageIdInfo>& pushInfos,
+                                    std::vector<std::string>& missedUids)
+{
+    if (uids.empty()) {
+        return true;
+    }
+
+    auto batches = std::make_shared<std::vector<Batch>>((uids.size() + m_batchSize - 1) / m_batchSize);
+    for (size_t i = 0; i < uids.size(); ++i) {
+        (*batches)[i / m_batchSize].uids.emplace_back(uids[i]);
+    }
+
+    if (batches->size() == 1) {
+        auto& batch = batches->front();
+        batch.result = fetch(batch.uids, batch.pushInfos, batch.missedUids);
+    } else {
+        auto latch = std::make_shared<SyncLatch>(batches->size());
+        for (size_t i = 0; i < batches->size(); ++i) {
+            m_pool.execInPool([this, batches, latch, i]() {
+                auto& batch = (*batches)[i];
+                batch.result = fetch(batch.uids, batch.pushInfos, batch.missedUids);
+                latch->countDown();
+            });
+        }
+        latch->wait();
+    }
+
+    bool result = true;
+    for (auto& batch : *batches) {
+        if (!batch.result) {
+            result = false;
+            continue;
+        }
+        pushInfos.insert(batch.pushInfos.begin(), batch.pushInfos.end());
+        missedUids.insert(missedUids.end(), batch.missedUids.begin(), batch.missedUids.end());
+    }
+
+    LOGI << "batch fetch push info, uids: " << uids.size() << ", batches: " << batches->size()
+         << ", result: " << result;
+    return result;
+}
+
+} // namespace bcm
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../config/group_store_format.h"
+#include "../../group/io_ctx_executor.h"
+
+namespace bcm {
+
+class AccountsManager;
+
+// Reads the push info of accounts from the accounts dao. Uid lists are split into batches
+// that run on a dedicated pool, so the pool size bounds the dao calls in flight.
+class AccountPushFetcher {
+public:
+    AccountPushFetcher(std::shared_ptr<AccountsManager> accountMgr, int concurrency, int batchSize);
+
+    // fills pushInfos for the accounts found, accounts not in database go to missedUids
+    bool fetch(const std::vector<std::string>& uids,
+               std::map<std::string, GroupUserMessageIdInfo>& pushInfos,
+               std::vector<std::string>& missedUids);
+
+    // fetch with the uids split into batches running concurrently. the results of the
+    // batches that succeeded are kept when another batch fails, which returns false
+    bool batchFetch(const std::vector<std::string>& uids,
+                    std::map<std::string, GroupUserMessageIdInfo>& pushInfos,
+                    std::vector<std::string>& missedUids);
+
+private:
+    struct Batch {
+        std::vector<std::string> uids;
+        std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+        std::vector<std::string> missedUids;
+        bool result{false};
+    };
+
+private:
+    std::shared_ptr<AccountsManager> m_accountMgr;
+    IoCtxExecutor m_pool;
+    size_t m_batchSize;
+};
+
+} // namespace bcm
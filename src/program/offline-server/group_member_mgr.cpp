@@ -15,6 +15,8 @@
 
 #include "proto/dao/group_user.pb.h"
 
+#include <algorithm>
+
 namespace bcm {
 
 GroupMemberMgr::GroupMemberMgr(GroupUsersDaoPtr groupUsersDao,
@@ -84,17 +86,14 @@ void GroupMemberMgr::doHandleUserEnterGroup(const std::string& uid,
     
     {
         std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
+        uint8_t flag = 0;
         if (user.role() == GroupUser::ROLE_SUBSCRIBER) {
-            m_groupSubscribers[gid].insert(uid);
-            removeGroupMemberNoLock(uid, gid);
-        } else {
-            m_groupMembers[gid].insert(uid);
-            removeGroupSubscriberNoLock(uid, gid);
+            flag |= GroupMemberIndex::SUBSCRIBER;
         }
-    
         if ((user.status() & static_cast<int>(GroupStatus::MUTED)) != 0) {
-            m_mutedMembers[gid].insert(uid);
+            flag |= GroupMemberIndex::MUTED;
         }
+        m_groups[gid].set(m_uids.intern(uid), flag);
     }
 }
 
@@ -117,7 +116,6 @@ void GroupMemberMgr::doHandleUserLeaveGroup(const std::string& uid,
         std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
         removeGroupMemberNoLock(uid, gid);
         removeGroupSubscriberNoLock(uid, gid);
-        removeMutedMemberNoLock(uid, gid);
     }
 }
 
@@ -138,7 +136,7 @@ void GroupMemberMgr::doHandleUserMuteGroup(const std::string& uid,
     
     {
         std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
-        m_mutedMembers[gid].insert(uid);
+        setMutedNoLock(uid, gid, true);
     }
 }
 
@@ -163,46 +161,22 @@ void GroupMemberMgr::doHandleUserUnmuteGroup(const std::string& uid,
 void GroupMemberMgr::getUnmuteGroupMembers(uint64_t gid, UidSet& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupMembers.find(gid);
-    const auto itM = m_mutedMembers.find(gid);
-    if (it != m_groupMembers.end()) {
-        for (const auto& uid : it->second) {
-            if ( (itM == m_mutedMembers.end()) ||
-                 (itM->second.find(uid) == itM->second.end()) ) {
-                uids.emplace(uid);
-            }
-        }
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER | GroupMemberIndex::MUTED, 0, uids);
 }
 
 void GroupMemberMgr::getUnmuteGroupSubscribers(uint64_t gid,
                                                UidSet& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupSubscribers.find(gid);
-    const auto itM = m_mutedMembers.find(gid);
-    if (it != m_groupSubscribers.end()) {
-        for (const auto& uid : it->second) {
-            if ( (itM == m_mutedMembers.end()) ||
-                 (itM->second.find(uid) == itM->second.end()) ) {
-                uids.emplace(uid);
-            }
-        }
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER | GroupMemberIndex::MUTED,
+                  GroupMemberIndex::SUBSCRIBER, uids);
 }
 
 
 bool GroupMemberMgr::loadGroupMembersFromDb(uint64_t gid)
 {
-    {
-        std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-        if (m_groupMembers.find(gid) != m_groupMembers.end()) {
-            return true;
-        }
-
-        if (m_groupSubscribers.find(gid) != m_groupSubscribers.end()) {
-            return true;
-        }
+    if (isGroupExist(gid)) {
+        return true;
     }
     
     return syncReloadGroupMembersFromDb(gid);
@@ -211,9 +185,10 @@ bool GroupMemberMgr::loadGroupMembersFromDb(uint64_t gid)
 bool GroupMemberMgr::syncReloadGroupMembersFromDb(uint64_t gid)
 {
     {
-        std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-        if (m_reloadTimes.find(gid) != m_reloadTimes.end()) {
-            if ((nowInSec() - m_reloadTimes[gid]) < DB_RELOAD_GROUPUSER_INTERVAL) {
+        std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
+        auto itReload = m_reloadTimes.find(gid);
+        if (itReload != m_reloadTimes.end()) {
+            if ((nowInSec() - itReload->second) < DB_RELOAD_GROUPUSER_INTERVAL) {
                 return true;
             }
         }
@@ -241,23 +216,41 @@ bool GroupMemberMgr::syncReloadGroupMembersFromDb(uint64_t gid)
     std::size_t numSubscribers = 0;
     {
         std::unique_lock<std::shared_timed_mutex> l1(m_memberMutex);
-        m_groupMembers.erase(gid);
-        m_groupSubscribers.erase(gid);
-        m_mutedMembers.erase(gid);
-
+        std::vector<std::pair<uint32_t, uint8_t>> entries;
+        entries.reserve(members.size());
         for (auto it = members.begin(); it != members.end(); ++it) {
+            uint8_t flag = 0;
             if (it->status() & GroupUser::STATUS_MUTED) {
-                m_mutedMembers[gid].insert(it->uid());
+                flag |= GroupMemberIndex::MUTED;
                 ++numMuted;
             }
             
             if (GroupUser::ROLE_SUBSCRIBER == it->role()) {
-                m_groupSubscribers[gid].insert(it->uid());
+                flag |= GroupMemberIndex::SUBSCRIBER;
                 ++numSubscribers;
             } else {
-                m_groupMembers[gid].insert(it->uid());
                 ++numMembers;
             }
+            entries.emplace_back(m_uids.intern(it->uid()), flag);
+        }
+
+        if (entries.empty()) {
+            m_groups.erase(gid);
+        } else {
+            // built at exact size, the arrays only grow again on enter group events
+            std::sort(entries.begin(), entries.end());
+            GroupMemberIndex group;
+            group.ids.reserve(entries.size());
+            group.flags.reserve(entries.size());
+            for (const auto& entry : entries) {
+                if (!group.ids.empty() && group.ids.back() == entry.first) {
+                    group.flags.back() = entry.second;
+                    continue;
+                }
+                group.ids.push_back(entry.first);
+                group.flags.push_back(entry.second);
+            }
+            m_groups[gid] = std::move(group);
         }
     }
     
@@ -271,46 +264,39 @@ bool GroupMemberMgr::syncReloadGroupMembersFromDb(uint64_t gid)
 bool GroupMemberMgr::isMemberExists(const std::string& uid,
                                          uint64_t gid) const
 {
-    std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
-    {
-        auto it = m_groupMembers.find(gid);
-        if (it != m_groupMembers.end()) {
-            if (it->second.find(uid) != it->second.end()) {
-                return true;
-            }
-        }
-    }
-
-    {
-        auto it = m_groupSubscribers.find(gid);
-        if (it != m_groupSubscribers.end()) {
-            if (it->second.find(uid) != it->second.end()) {
-                return true;
-            }
-        }
+    std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
+    auto it = m_groups.find(gid);
+    if (it == m_groups.end()) {
+        return false;
     }
-
-    return false;
+    uint32_t id = m_uids.find(uid);
+    return id != UidInterner::kInvalidId && it->second.find(id) >= 0;
 }
 
 void GroupMemberMgr::removeMutedMember(const std::string& uid,
                                        uint64_t gid)
 {
     std::unique_lock<std::shared_timed_mutex> l(m_memberMutex);
-    removeMutedMemberNoLock(uid, gid);
+    setMutedNoLock(uid, gid, false);
 }
 
-void GroupMemberMgr::removeMutedMemberNoLock(const std::string& uid,
-                                            uint64_t gid)
+void GroupMemberMgr::setMutedNoLock(const std::string& uid,
+                                    uint64_t gid, bool muted)
 {
-    auto it = m_mutedMembers.find(gid);
-    if (it != m_mutedMembers.end()) {
-        it->second.erase(uid);
-        if (it->second.empty()) {
-            m_mutedMembers.erase(gid);
-        }
+    auto it = m_groups.find(gid);
+    if (it == m_groups.end()) {
+        return;
+    }
+    uint32_t id = m_uids.find(uid);
+    int64_t pos = (id == UidInterner::kInvalidId) ? -1 : it->second.find(id);
+    if (pos < 0) {
+        return;
+    }
+    if (muted) {
+        it->second.flags[pos] |= GroupMemberIndex::MUTED;
+    } else {
+        it->second.flags[pos] &= static_cast<uint8_t>(~GroupMemberIndex::MUTED);
     }
 }
 
 } // namespace bcm
-
@@ -40,11 +40,10 @@ private:
     void doHandleUserUnmuteGroup(const std::string& uid, uint64_t gid);
 
     void removeMutedMember(const std::string& uid, uint64_t gid);
-    void removeMutedMemberNoLock(const std::string& uid, uint64_t gid);
+    void setMutedNoLock(const std::string& uid, uint64_t gid, bool muted);
 
 private:
-    std::map<uint64_t /* gid */, UidSet>    m_mutedMembers;
-    std::map<uint64_t /* gid */, int64_t>   m_reloadTimes;
+    std::unordered_map<uint64_t /* gid */, int64_t>   m_reloadTimes;
 };
 
 } // namespace bcm
@@ -4,6 +4,11 @@
 #include <map>
 #include <set>
 #include <string>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
 #include <shared_mutex>
 
 namespace bcm {
@@ -15,6 +20,9 @@ struct GroupMessageSeqInfo
 };
 
 
+// Read-mostly: groups are hashed over shards guarded by shared locks, the lock is
+// taken exclusively only to insert a new group. The sequence of a known group is
+// updated in place under a per group seqlock, so readers never see a torn pair.
 class GroupPartitionMgr {
 public:
     GroupPartitionMgr() {}
@@ -28,43 +36,98 @@ public:
 
     bool updateMid(uint64_t gid, uint32_t tm, uint64_t lastMid)
     {
-        std::unique_lock<std::shared_timed_mutex> l(m_groupMutex);
-        if (m_groupMsgSeq.find(gid) != m_groupMsgSeq.end()) {
-            m_groupMsgSeq[gid].timestamp = tm;
-            m_groupMsgSeq[gid].lastMid = lastMid;
-        } else {
-            GroupMessageSeqInfo gm;
-            gm.timestamp = tm;
-            gm.lastMid = lastMid;
-            m_groupMsgSeq[gid] = gm;
+        Shard& shard = shardOf(gid);
+        {
+            std::shared_lock<std::shared_timed_mutex> l(shard.mtx);
+            auto it = shard.groups.find(gid);
+            if (it != shard.groups.end()) {
+                it->second->store(tm, lastMid);
+                return true;
+            }
         }
+
+        std::unique_lock<std::shared_timed_mutex> l(shard.mtx);
+        auto& entry = shard.groups[gid];
+        if (!entry) {
+            entry.reset(new SeqEntry());
+        }
+        entry->store(tm, lastMid);
         return true;
     }
 
     bool getGroupPushInfo(uint64_t gid, GroupMessageSeqInfo&  gm)
     {
-        std::unique_lock<std::shared_timed_mutex> l(m_groupMutex);
-        if (m_groupMsgSeq.find(gid) != m_groupMsgSeq.end()) {
-            gm = m_groupMsgSeq[gid];
-        } else {
+        Shard& shard = shardOf(gid);
+        std::shared_lock<std::shared_timed_mutex> l(shard.mtx);
+        auto it = shard.groups.find(gid);
+        if (it == shard.groups.end()) {
             return false;
         }
+        it->second->load(gm);
         return true;
     }
 
     bool isExistGroup(uint64_t gid)
     {
-        std::unique_lock<std::shared_timed_mutex> l(m_groupMutex);
-        if (m_groupMsgSeq.find(gid) == m_groupMsgSeq.end()) {
-            return false;
-        }
-        return true;
+        Shard& shard = shardOf(gid);
+        std::shared_lock<std::shared_timed_mutex> l(shard.mtx);
+        return shard.groups.find(gid) != shard.groups.end();
     }
-    
+
 private:
-    mutable std::shared_timed_mutex m_groupMutex;
+    struct SeqEntry {
+        std::atomic<uint32_t> seq{0};
+        std::atomic<uint32_t> timestamp{0};
+        std::atomic<uint64_t> lastMid{0};
+
+        void store(uint32_t tm, uint64_t mid)
+        {
+            // an odd sequence marks a write in progress, concurrent writers wait for it
+            uint32_t s = seq.load(std::memory_order_relaxed);
+            do {
+                while (s & 1) {
+                    s = seq.load(std::memory_order_relaxed);
+                }
+            } while (!seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+            timestamp.store(tm, std::memory_order_relaxed);
+            lastMid.store(mid, std::memory_order_relaxed);
+            seq.store(s + 2, std::memory_order_release);
+        }
 
-    std::map<uint64_t /* gid */, GroupMessageSeqInfo>  m_groupMsgSeq;
+        void load(GroupMessageSeqInfo& gm) const
+        {
+            while (true) {
+                uint32_t s = seq.load(std::memory_order_acquire);
+                if (s & 1) {
+                    continue;
+                }
+                gm.timestamp = timestamp.load(std::memory_order_relaxed);
+                gm.lastMid = lastMid.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (seq.load(std::memory_order_relaxed) == s) {
+                    return;
+                }
+            }
+        }
+    };
+
+    static constexpr size_t kShardCount = 64;
+
+    struct alignas(64) Shard {
+        mutable std::shared_timed_mutex mtx;
+        // entries are never removed, so the pointers stay valid under the shared lock
+        std::unordered_map<uint64_t /* gid */, std::unique_ptr<SeqEntry>> groups;
+    };
+
+    Shard& shardOf(uint64_t gid)
+    {
+        // gids are sequential, mix them before picking a shard
+        return m_shards[(gid * 0x9E3779B97F4A7C15ULL) >> 58];
+    }
+
+private:
+    std::array<Shard, kShardCount> m_shards;
 };
 
-} // namespace bcm
\ No newline at end of file
+} // namespace bcm
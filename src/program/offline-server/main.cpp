@@ -14,12 +14,14 @@
 #include "redis/redis_manage_timer.h"
 
 #include "redis/hiredis_client.h"
+#include "redis/online_redis_manager.h"
 #include "fiber/fiber_timer.h"
 
 #include "offline_server_controller.h"
 #include "registers/offline_register.h"
 #include "push/push_service.h"
 #include "dispatcher/offline_dispatcher.h"
+#include "dispatcher/presence_index.h"
 #include "offline_server.h"
 
 using namespace bcm;
@@ -70,6 +72,7 @@ int main(int argc, char** argv)
         exit(-1);
     }
     
+    RedisServer::setDefaultPoolConfig(config.redisPool);
     std::map<int32_t, RedisConfig> redisDbHosts;
     for (const auto& itDb : config.groupRedis[config.offlineSvr.redisPartition]) {
         int32_t  redisId = -1;
@@ -115,12 +118,28 @@ int main(int argc, char** argv)
     auto pushService = std::make_shared<PushService>(accountsManager,
                        config.redis[0], config.apns, config.fcm, config.umeng);
 
+    // follows the devices online on the im servers, resends are not checked against redis
+    std::shared_ptr<PresenceIndex> presenceIndex;
+    if (config.presence.enabled) {
+        if (!OnlineRedisManager::Instance()->init(config.onlineRedis)) {
+            LOGE << "online redis manager init fail";
+            exit(-1);
+        }
+        OnlineRedisManager::Instance()->start();
+        presenceIndex = std::make_shared<PresenceIndex>(config.presence, "");
+        presenceIndex->start();
+        pushService->setPresenceIndex(presenceIndex);
+    }
+
     //
     auto offlineService = std::make_shared<OfflineService>(config, accountsManager,
                                                            offlineServiceRegister, redisDbHosts, pushService);
     fiberTimer->schedule(offlineService, config.offlineSvr.pushRoundInterval, false);
     fiberTimer->schedule(offlineServiceRegister, OfflineServiceRegister::kKeepAliveInterval, false);
     redisFiberTimer->schedule(redisManageTimer, RedisManageTimer::redisManageTimerInterval, true);
+    if (presenceIndex != nullptr) {
+        fiberTimer->schedule(presenceIndex, config.presence.flushIntervalInMilli, false);
+    }
     
     auto httpRouter = std::make_shared<HttpRouter>();
 
@@ -140,6 +159,10 @@ int main(int argc, char** argv)
     fiberTimer->cancel(offlineService);
     fiberTimer->cancel(offlineServiceRegister);
     redisFiberTimer->cancel(redisManageTimer);
+    if (presenceIndex != nullptr) {
+        fiberTimer->cancel(presenceIndex);
+        presenceIndex->stop();
+    }
     
     sleep(1);   // waiting for fiberTimer->cancel
     
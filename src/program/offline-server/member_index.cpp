@@ -0,0 +1,127 @@
+#include "member_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bcm {
+
+const uint32_t UidInterner::kInvalidId;
+
+UidInterner::UidInterner()
+    : m_offsets(1, 0)
+    , m_slots(1024, kInvalidId)
+{
+}
+
+uint64_t UidInterner::hashOf(const char* data, size_t len)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool UidInterner::equals(uint32_t id, const char* data, size_t len) const
+{
+    uint32_t begin = m_offsets[id];
+    uint32_t end = m_offsets[id + 1];
+    return (end - begin) == len && std::memcmp(m_arena.data() + begin, data, len) == 0;
+}
+
+uint32_t UidInterner::find(const std::string& uid) const
+{
+    size_t mask = m_slots.size() - 1;
+    for (size_t pos = hashOf(uid.data(), uid.size()) & mask; ; pos = (pos + 1) & mask) {
+        uint32_t id = m_slots[pos];
+        if (id == kInvalidId) {
+            return kInvalidId;
+        }
+        if (equals(id, uid.data(), uid.size())) {
+            return id;
+        }
+    }
+}
+
+uint32_t UidInterner::intern(const std::string& uid)
+{
+    size_t mask = m_slots.size() - 1;
+    size_t pos = hashOf(uid.data(), uid.size()) & mask;
+    for (; m_slots[pos] != kInvalidId; pos = (pos + 1) & mask) {
+        if (equals(m_slots[pos], uid.data(), uid.size())) {
+            return m_slots[pos];
+        }
+    }
+
+    uint32_t id = static_cast<uint32_t>(size());
+    m_arena.insert(m_arena.end(), uid.begin(), uid.end());
+    m_offsets.push_back(static_cast<uint32_t>(m_arena.size()));
+    m_slots[pos] = id;
+
+    // keep the load factor under 0.7
+    if (size() * 10 > m_slots.size() * 7) {
+        rehash(m_slots.size() * 2);
+    }
+    return id;
+}
+
+void UidInterner::rehash(size_t slotCount)
+{
+    std::vector<uint32_t> slots(slotCount, kInvalidId);
+    size_t mask = slotCount - 1;
+    for (uint32_t id = 0; id < size(); ++id) {
+        const char* data = m_arena.data() + m_offsets[id];
+        size_t pos = hashOf(data, m_offsets[id + 1] - m_offsets[id]) & mask;
+        while (slots[pos] != kInvalidId) {
+            pos = (pos + 1) & mask;
+        }
+        slots[pos] = id;
+    }
+    m_slots.swap(slots);
+}
+
+std::string UidInterner::uid(uint32_t id) const
+{
+    return std::string(m_arena.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id]);
+}
+
+size_t UidInterner::memoryUsage() const
+{
+    return m_arena.capacity() + (m_offsets.capacity() + m_slots.capacity()) * sizeof(uint32_t);
+}
+
+int64_t GroupMemberIndex::find(uint32_t id) const
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) {
+        return -1;
+    }
+    return it - ids.begin();
+}
+
+void GroupMemberIndex::set(uint32_t id, uint8_t flag)
+{
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    size_t pos = static_cast<size_t>(it - ids.begin());
+    if (it != ids.end() && *it == id) {
+        flags[pos] = flag;
+        return;
+    }
+    ids.insert(it, id);
+    flags.insert(flags.begin() + pos, flag);
+}
+
+bool GroupMemberIndex::erase(uint32_t id)
+{
+    int64_t pos = find(id);
+    if (pos < 0) {
+        return false;
+    }
+    ids.erase(ids.begin() + pos);
+    flags.erase(flags.begin() + pos);
+    return true;
+}
+
+} // namespace bcm
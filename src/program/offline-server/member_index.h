@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bcm {
+
+// Maps uids to dense 32-bit ids. The uid bytes are stored once in an arena and
+// looked up through an open addressing table of ids, ids are never released.
+// Not thread safe, the owner serializes writers against readers.
+class UidInterner {
+public:
+    static const uint32_t kInvalidId = UINT32_MAX;
+
+    UidInterner();
+
+    // returns the id of uid, assigning a new one if it is unknown
+    uint32_t intern(const std::string& uid);
+    // returns kInvalidId if uid was never interned
+    uint32_t find(const std::string& uid) const;
+
+    std::string uid(uint32_t id) const;
+    size_t size() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    size_t memoryUsage() const;
+
+private:
+    static uint64_t hashOf(const char* data, size_t len);
+    bool equals(uint32_t id, const char* data, size_t len) const;
+    void rehash(size_t slotCount);
+
+private:
+    std::vector<char> m_arena;
+    // uid i occupies [m_offsets[i], m_offsets[i + 1]) of the arena
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_slots;
+};
+
+// Members of one group as sorted interned ids with a parallel array of flags.
+struct GroupMemberIndex {
+    enum Flag : uint8_t {
+        SUBSCRIBER = 0x01,
+        MUTED = 0x02,
+    };
+
+    std::vector<uint32_t> ids;
+    std::vector<uint8_t> flags;
+
+    // returns the position of id or -1
+    int64_t find(uint32_t id) const;
+    void set(uint32_t id, uint8_t flag);
+    bool erase(uint32_t id);
+
+    bool empty() const
+    {
+        return ids.empty();
+    }
+
+    size_t memoryUsage() const
+    {
+        return ids.capacity() * sizeof(uint32_t) + flags.capacity();
+    }
+};
+
+} // namespace bcm
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <string>
 
 #include "../../config/log_config.h"
@@ -11,6 +12,7 @@
 #include "../../config/umeng_config.h"
 #include "../../config/offline_server_config.h"
 #include "../../config/sysmsg_config.h"
+#include "../../config/presence_config.h"
 
 namespace bcm {
 
@@ -20,11 +22,15 @@ struct OfflineConfig {
     DaoConfig dao;
     std::vector<RedisConfig> redis;     // redis pub/sub
     std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig>> groupRedis; // redis for store
+    RedisPoolConfig redisPool;  // pool of each redis in groupRedis
     ApnsConfig apns;
     FcmConfig fcm;
     UmengConfig umeng;
     OfflineServerConfig offlineSvr;
     SysMsgConfig sysmsg;
+    // online redis of the im servers, only needed to follow their presence
+    std::map<std::string, std::vector<RedisConfig>> onlineRedis;
+    PresenceConfig presence;
 };
 
 inline void to_json(nlohmann::json& j, const OfflineConfig& config)
@@ -34,11 +40,14 @@ inline void to_json(nlohmann::json& j, const OfflineConfig& config)
                        {"dao", config.dao},
                        {"redis", config.redis},
                        {"groupRedis", config.groupRedis},
+                       {"redisPool", config.redisPool},
                        {"apns", config.apns},
                        {"fcm", config.fcm},
                        {"umeng", config.umeng},
                        {"offlineSvr", config.offlineSvr},
-                       {"sysmsg", config.sysmsg}
+                       {"sysmsg", config.sysmsg},
+                       {"onlineRedis", config.onlineRedis},
+                       {"presence", config.presence}
         };
 }
 
@@ -49,11 +58,14 @@ inline void from_json(const nlohmann::json& j, OfflineConfig& config)
     jsonable::toGeneric(j, "dao", config.dao);
     jsonable::toGeneric(j, "redis", config.redis);
     jsonable::toGeneric(j, "groupRedis", config.groupRedis);
+    jsonable::toGeneric(j, "redisPool", config.redisPool, jsonable::OPTIONAL);
     jsonable::toGeneric(j, "apns", config.apns);
     jsonable::toGeneric(j, "fcm", config.fcm);
     jsonable::toGeneric(j, "umeng", config.umeng);
     jsonable::toGeneric(j, "offlineSvr", config.offlineSvr);
     jsonable::toGeneric(j, "sysmsg", config.sysmsg, jsonable::OPTIONAL);
+    jsonable::toGeneric(j, "onlineRedis", config.onlineRedis, jsonable::OPTIONAL);
+    jsonable::toGeneric(j, "presence", config.presence, jsonable::OPTIONAL);
 }
 
 
@@ -11,25 +11,13 @@ OfflineMemberMgrBase::OfflineMemberMgrBase(GroupUsersDaoPtr groupUsersDao,
 void OfflineMemberMgrBase::getGroupMembers(uint64_t gid, UidList& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupMembers.find(gid);
-    if (it != m_groupMembers.end()) {
-        uids.reserve(it->second.size());
-        for (const std::string& uid : it->second) {
-            uids.emplace_back(uid);
-        }
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER, 0, uids);
 }
 
 void OfflineMemberMgrBase::getGroupSubscribers(uint64_t gid, UidList& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupSubscribers.find(gid);
-    if (it != m_groupSubscribers.end()) {
-        uids.reserve(it->second.size());
-        for (const std::string& uid : it->second) {
-            uids.emplace_back(uid);
-        }
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER, GroupMemberIndex::SUBSCRIBER, uids);
 }
 
 
@@ -37,53 +25,19 @@ bool OfflineMemberMgrBase::isGroupExist(uint64_t gid) const
 {
 
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    if (m_groupMembers.find(gid) != m_groupMembers.end()) {
-        return true;
-    }
-
-    if (m_groupSubscribers.find(gid) != m_groupSubscribers.end()) {
-        return true;
-    }
-
-    return false;
+    return m_groups.find(gid) != m_groups.end();
 }
 
 void OfflineMemberMgrBase::getGroupMembers(uint64_t gid, UidSet& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupMembers.find(gid);
-    if (it != m_groupMembers.end()) {
-        uids.insert(it->second.begin(), it->second.end());
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER, 0, uids);
 }
 
-/* void OfflineMemberMgrBase::getGroupMembers(uint64_t gid, UidSet::size_type size, UidSet& uids) const
-{
-    std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupMembers.find(gid);
-    if (it == m_groupMembers.end()) {
-        return;
-    }
-    if (size == 0) {
-        uids.insert(it->second.begin(), it->second.end());
-        return;
-    }
-    for (const auto& item : it->second) {
-        uids.emplace(item);
-        if (--size == 0) {
-            break;
-        }
-    }
-
-} */
-
 void OfflineMemberMgrBase::getGroupSubscribers(uint64_t gid, UidSet& uids) const
 {
     std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
-    const auto it = m_groupSubscribers.find(gid);
-    if (it != m_groupSubscribers.end()) {
-        uids.insert(it->second.begin(), it->second.end());
-    }
+    collectNoLock(gid, GroupMemberIndex::SUBSCRIBER, GroupMemberIndex::SUBSCRIBER, uids);
 }
 
 void OfflineMemberMgrBase::removeGroupMember(const std::string& uid, uint64_t gid)
@@ -119,25 +73,44 @@ void OfflineMemberMgrBase::removeSubscriberForGroups(
 void OfflineMemberMgrBase::removeGroupMemberNoLock(const std::string& uid, 
                                             uint64_t gid)
 {
-    auto it = m_groupMembers.find(gid);
-    if (it != m_groupMembers.end()) {
-        it->second.erase(uid);
-        if (it->second.empty()) {
-            m_groupMembers.erase(gid);
-        }
-    }
+    removeNoLock(uid, gid, 0);
 }
 
 void OfflineMemberMgrBase::removeGroupSubscriberNoLock(const std::string& uid, 
                                                 uint64_t gid)
 {
-    auto it = m_groupSubscribers.find(gid);
-    if (it != m_groupSubscribers.end()) {
-        it->second.erase(uid);
-        if (it->second.empty()) {
-            m_groupSubscribers.erase(gid);
-        }
+    removeNoLock(uid, gid, GroupMemberIndex::SUBSCRIBER);
+}
+
+void OfflineMemberMgrBase::removeNoLock(const std::string& uid, uint64_t gid,
+                                        uint8_t subscriberFlag)
+{
+    auto it = m_groups.find(gid);
+    if (it == m_groups.end()) {
+        return;
+    }
+    uint32_t id = m_uids.find(uid);
+    int64_t pos = (id == UidInterner::kInvalidId) ? -1 : it->second.find(id);
+    if (pos < 0 || (it->second.flags[pos] & GroupMemberIndex::SUBSCRIBER) != subscriberFlag) {
+        return;
+    }
+    it->second.erase(id);
+    if (it->second.empty()) {
+        m_groups.erase(it);
+    }
+}
+
+size_t OfflineMemberMgrBase::memoryUsage() const
+{
+    std::shared_lock<std::shared_timed_mutex> l(m_memberMutex);
+    // hash node: next pointer, key and the index itself, plus the bucket pointer
+    size_t total = m_uids.memoryUsage()
+                   + m_groups.size() * (sizeof(void*) * 2 + sizeof(uint64_t) + sizeof(GroupMemberIndex))
+                   + m_groups.bucket_count() * sizeof(void*);
+    for (const auto& itGroup : m_groups) {
+        total += itGroup.second.memoryUsage();
     }
+    return total;
 }
 
 IoCtxPool& OfflineMemberMgrBase::ioCtxPool() {
@@ -4,8 +4,13 @@
 #include <map>
 #include <set>
 #include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <shared_mutex>
 
+#include "member_index.h"
+
 struct event_base;
 
 namespace bcm {
@@ -41,16 +46,38 @@ public:
 
     bool isGroupExist(uint64_t gid) const;
 
+    // approximate bytes held by the membership index
+    size_t memoryUsage() const;
+
     IoCtxPool& ioCtxPool();
 
 protected:
     void removeGroupMemberNoLock(const std::string& uid, uint64_t gid);
     void removeGroupSubscriberNoLock(const std::string& uid, uint64_t gid);
+    // removes the uid if its subscriber flag equals the given one
+    void removeNoLock(const std::string& uid, uint64_t gid, uint8_t subscriberFlag);
+
+    // appends the uids whose flags match (flags & mask) == value
+    template <class Container>
+    void collectNoLock(uint64_t gid, uint8_t mask, uint8_t value, Container& uids) const
+    {
+        const auto it = m_groups.find(gid);
+        if (it == m_groups.end()) {
+            return;
+        }
+        const GroupMemberIndex& group = it->second;
+        for (size_t i = 0; i < group.ids.size(); ++i) {
+            if ((group.flags[i] & mask) == value) {
+                uids.insert(uids.end(), m_uids.uid(group.ids[i]));
+            }
+        }
+    }
 
 protected:
     GroupUsersDaoPtr m_groupUsersDao;
-    std::map<uint64_t, UidSet> m_groupMembers;
-    std::map<uint64_t, UidSet> m_groupSubscribers;
+    // members and subscribers of a group share one index, told apart by the SUBSCRIBER flag
+    UidInterner m_uids;
+    std::unordered_map<uint64_t /* gid */, GroupMemberIndex> m_groups;
     mutable std::shared_timed_mutex m_memberMutex;
     IoCtxPool& m_ioCtxPool;
 };
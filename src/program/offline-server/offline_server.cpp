@@ -10,6 +10,7 @@
 #include <event2/thread.h>
 
 #include <nlohmann/json.hpp>
+#include <algorithm>
 #include <thread>
 #include <shared_mutex>
 
@@ -18,6 +19,7 @@
 #include <utils/log.h>
 #include "utils/libevent_utils.h"
 #include "utils/thread_utils.h"
+#include "utils/sync_latch.h"
 
 #include "../../group/io_ctx_pool.h"
 #include "../../group/group_event.h"
@@ -37,6 +39,8 @@
 #include "group_partition_mgr.h"
 #include "group_member_mgr.h"
 #include "http_post_request.h"
+#include "push_info_cache.h"
+#include "account_push_fetcher.h"
 
 namespace bcm {
 
@@ -56,8 +60,12 @@ class OfflineServiceImpl
     
     GroupUserEventSub m_groupEventSub;
     
+    AccountPushFetcher m_accountPushFetcher;
+    
     IoCtxExecutor m_workThdPool;
     
+    PushInfoCache m_pushInfoCache;
+    
     std::unique_ptr<std::thread> m_thread;
     
     std::shared_ptr<OfflineServiceRegister> m_offlineReg;
@@ -70,6 +78,10 @@ class OfflineServiceImpl
     std::atomic<std::uint64_t> m_runRoundStartTime;
     
     boost::asio::ssl::context m_sslCtx;
+
+    std::function<bool()> m_isMaster;
+    std::atomic<bool> m_streamStop{false};
+    std::vector<std::thread> m_streamThreads;
     
 public:
     OfflineServiceImpl(const RedisConfig& redisCfg,
@@ -85,7 +97,11 @@ public:
           , m_config(offlineCfg)
           , m_groupMemberMgr(m_groupUsersDao, m_ioCtxPool)
           , m_groupEventSub(m_eb, redisCfg.ip, redisCfg.port, redisCfg.password)
+          , m_accountPushFetcher(m_accountMgr, offlineCfg.offlineSvr.accountFetchConcurrency,
+                                 offlineCfg.offlineSvr.accountBatchSize)
           , m_workThdPool(offlineCfg.offlineSvr.pushThreadNumb)
+          , m_pushInfoCache(static_cast<size_t>(std::max(0, offlineCfg.offlineSvr.pushInfoCacheSize)),
+                            static_cast<int64_t>(offlineCfg.offlineSvr.pushInfoCacheTtlSec) * 1000)
           , m_offlineReg(offlineReg)
           , m_redisDbHosts(redisDbHosts)
           , m_pushService(pushService)
@@ -101,6 +117,8 @@ public:
 
     virtual ~OfflineServiceImpl()
     {
+        stopGroupMsgStream();
+
         m_groupEventSub.shutdown([](int status) {
             LOGI << "group event subscription is shutdown with status: "
                  << status;
@@ -111,33 +129,31 @@ public:
         event_base_free(m_eb);
     }
     
-    void  dbGetAndDeleteOneRedisMultiMsg(int32_t redisId, const std::vector<std::string>& vecMulitMsgs,
+    void  dbGetAndDeleteOneRedisMultiMsg(int32_t redisId, uint32_t shard, const std::vector<std::string>& vecMulitMsgs,
                                  std::map<uint64_t, GroupMessageInfoTask>& newGroupMsg)
     {
+        const std::string multiListKey = groupMsgShardKey(REDISDB_KEY_GROUP_MULTI_LIST_INFO, shard);
         std::map<std::string /* dbKey */, std::string> mapFieldValue;
         bool res = RedisClientSync::OfflineInstance()->hmget(redisId,
-                                                  REDISDB_KEY_GROUP_MULTI_LIST_INFO,
+                                                  multiListKey,
                                                   vecMulitMsgs, mapFieldValue);
         if (!res) {
             LOGE << "redis hmget error, redisId: " << redisId
-                    << ", key: " << REDISDB_KEY_GROUP_MULTI_LIST_INFO
+                    << ", key: " << multiListKey
                     << ", multi message size: " << vecMulitMsgs.size()
                     << ", multi message: " << toString(vecMulitMsgs);
             return;
         }
         
         for (const auto& itMsg : mapFieldValue) {
-            std::vector<std::string> groupInfos;
-            boost::split(groupInfos, itMsg.first, boost::is_any_of("_"));
-    
-            if (groupInfos.size() != 3) {
+            uint64_t  curGid        = 0;
+            uint64_t  curLastMid    = 0;
+            int32_t   curType       = 0;
+            if (!parseGroupMsgField(itMsg.first, curGid, curLastMid, curType)) {
                 LOGE << "redis group list format error redisId: " << redisId
                      << ", dbKey: " << itMsg.first << ", member: " << itMsg.second;
                 continue;
             }
-            
-            uint64_t  curGid        = std::stoull(groupInfos[0]);
-            uint64_t  curLastMid    = std::stoull(groupInfos[1]);
     
             auto itTask = newGroupMsg.find(curGid);
             if (itTask == newGroupMsg.end()) {
@@ -163,12 +179,62 @@ public:
         
         if (!vecMulitMsgs.empty()) {
             res = RedisClientSync::OfflineInstance()->hdel(redisId,
-                                                           REDISDB_KEY_GROUP_MULTI_LIST_INFO, vecMulitMsgs);
+                                                           multiListKey, vecMulitMsgs);
         }
     }
     
-    bool  dbGetAndDeleteOneRedisGroupMsg(int32_t redisId, std::map<uint64_t, GroupMessageInfoTask>& newGroupMsg)
+    // returns false if the message is dropped: unknown type, expired or already pushed
+    bool appendGroupMessageTask(uint64_t gid, const GroupMessageIdInfo& gmDb,
+                                std::map<uint64_t, GroupMessageInfoTask>& newGroupMsg)
+    {
+        // check group message type
+        if (gmDb.type != bcm::PushPeopleType::PUSHPEOPLETYPE_TO_ALL
+            && gmDb.type != bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
+            LOGE << "redis group type error, redisId: " << gmDb.redisId
+                 << ", member: " << gmDb.dbKey << ", tm: " << gmDb.tm;
+            return false;
+        }
+
+        //  More than 30 minutes to discard
+        if ((nowInSec() - gmDb.tm) > OFFLINE_GROUP_MESSAGE_EXPIRE_TIME) {
+            return false;
+        }
+
+        GroupMessageInfoTask  tmpNew;
+        // append Previous round messageId, timestamp
+        GroupMessageSeqInfo  gmS;
+        if (GroupPartitionMgr::Instance().getGroupPushInfo(gid, gmS)) {
+            tmpNew.preRoundMid     = gmS.lastMid;
+            tmpNew.preRoundMsgTs   = gmS.timestamp;
+
+            if (gmS.lastMid > gmDb.last_mid) {
+                LOGE << "redis group expire message, redisId: " << gmDb.redisId
+                     << ", member: " << gmDb.dbKey << ", tm: " << gmDb.tm
+                     << ", current message tm: " << gmS.lastMid;
+                return false;
+            }
+        }
+
+        auto itTask = newGroupMsg.find(gid);
+        if (itTask == newGroupMsg.end()) {
+            itTask = newGroupMsg.emplace(gid, tmpNew).first;
+        }
+
+        if (gmDb.type == bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
+            itTask->second.multicastCount++;
+            itTask->second.multicastMembers.insert(gmDb.gmm.members.begin(), gmDb.gmm.members.end());
+        } else {
+            itTask->second.broadcastCount++;
+        }
+
+        itTask->second.gms.emplace_back(gmDb);
+        return true;
+    }
+
+    bool  dbGetAndDeleteOneRedisGroupMsg(int32_t redisId, uint32_t shard,
+                                         std::map<uint64_t, GroupMessageInfoTask>& newGroupMsg)
     {
+        const std::string msgListKey = groupMsgShardKey(REDISDB_KEY_GROUP_MSG_INFO, shard);
         int32_t  redisGroupIndex    = 0;
         int64_t  minTimeStamp       = 0;
         int64_t  maxTimeStamp       = nowInSec() - OFFLINE_GROUP_MESSAGE_DELAY_TIME;
@@ -183,12 +249,12 @@ public:
             std::vector<std::string>        cleanGroupMsg;
             
             bool res = RedisClientSync::OfflineInstance()->getMemsByScoreWithLimit(redisId,
-                                                                 REDISDB_KEY_GROUP_MSG_INFO,
+                                                                 msgListKey,
                                                                  minTimeStamp, maxTimeStamp,
                                                                  recordOffset, recordSize, resultGroups);
             if (!res) {
                 LOGE << "hscan redis group list, redis id: " << redisId
-                     << ", key: " << REDISDB_KEY_GROUP_MSG_INFO
+                     << ", key: " << msgListKey
                      << ", recordOffset: " << recordOffset << ", count: " << recordSize
                      << ", result: " << res
                      << ", return size: " << resultGroups.size();
@@ -196,10 +262,9 @@ public:
             }
             
             for (const auto& itGroup : resultGroups) {
-                std::vector<std::string> groupInfos;
-                boost::split(groupInfos, itGroup.member, boost::is_any_of("_"));
-                
-                if (groupInfos.size() != 3) {
+                uint64_t  curGid = 0;
+                GroupMessageIdInfo gmDb;
+                if (!parseGroupMsgField(itGroup.member, curGid, gmDb.last_mid, gmDb.type)) {
                     cleanGroupMsg.emplace_back(itGroup.member);
                     LOGE << "redis group list format error redisId: " << redisId
                          << ", member: " << itGroup.member << ", tm: " << itGroup.score;
@@ -207,67 +272,24 @@ public:
                 }
 
                 resultRedisData = true;
-                
-                uint64_t  curGid = std::stoull(groupInfos[0]);
 
-                GroupMessageIdInfo gmDb;
-                gmDb.last_mid   = std::stoull(groupInfos[1]);
-                gmDb.type       = std::stol(groupInfos[2]);
                 gmDb.tm         = itGroup.score;
                 gmDb.dbKey      = itGroup.member;
                 gmDb.redisId    = redisId;
 
-                // check group message type
-                if (gmDb.type != bcm::PushPeopleType::PUSHPEOPLETYPE_TO_ALL
-                    && gmDb.type != bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
-    
-                    LOGE << "redis group type error, redisId: " << redisId
-                         << ", member: " << itGroup.member << ", tm: " << itGroup.score;
-                    cleanGroupMsg.emplace_back(itGroup.member);
-                    continue;
-                }
-
-                //  More than 30 minutes to discard
-                if ( (nowInSec() - gmDb.tm) > OFFLINE_GROUP_MESSAGE_EXPIRE_TIME) {
-                    cleanGroupMsg.emplace_back(itGroup.member);
+                cleanGroupMsg.emplace_back(itGroup.member);
+                if (!appendGroupMessageTask(curGid, gmDb, newGroupMsg)) {
                     continue;
                 }
 
-                GroupMessageInfoTask  tmpNew;
-                // append Previous round messageId, timestamp
-                GroupMessageSeqInfo  gmS;
-                if (GroupPartitionMgr::Instance().getGroupPushInfo(curGid, gmS)) {
-                    tmpNew.preRoundMid     = gmS.lastMid;
-                    tmpNew.preRoundMsgTs   = gmS.timestamp;
-                    
-                    if (gmS.lastMid > gmDb.last_mid) {
-                        cleanGroupMsg.emplace_back(itGroup.member);
-                        LOGE << "redis group expire message, redisId: " << redisId
-                                << ", member: " << itGroup.member << ", tm: " << itGroup.score
-                             << ", current message tm: " << gmS.lastMid;
-                        continue;
-                    }
-                }
-
                 redisGroupIndex++;
-                
-                if (newGroupMsg.find(curGid) == newGroupMsg.end()) {
-                    newGroupMsg[curGid] = tmpNew;
-                }
-                
                 if (gmDb.type == bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
-                    newGroupMsg[curGid].multicastCount++;
                     mGetMultiMsgs.emplace_back(itGroup.member);
-                } else {
-                    newGroupMsg[curGid].broadcastCount++;
                 }
-                
-                newGroupMsg[curGid].gms.emplace_back(gmDb);
-                cleanGroupMsg.emplace_back(itGroup.member);
             }
 
             LOGI << "redis group list, redis id: " << redisId
-                 << ", key: " << REDISDB_KEY_GROUP_MSG_INFO
+                 << ", key: " << msgListKey
                  << ", recordOffset: " << recordOffset << ", count: " << recordSize
                  << ", result: " << res
                  << ", return size: " << resultGroups.size();
@@ -275,14 +297,14 @@ public:
             // clean redis key
             if (!cleanGroupMsg.empty()) {
                 if(!RedisClientSync::OfflineInstance()->zrem(redisId,
-                                                         REDISDB_KEY_GROUP_MSG_INFO, cleanGroupMsg)) {
+                                                         msgListKey, cleanGroupMsg)) {
                     break;
                 }
             }
     
             // get multi message from redis
             if (!mGetMultiMsgs.empty()) {
-                dbGetAndDeleteOneRedisMultiMsg(redisId, mGetMultiMsgs, newGroupMsg);
+                dbGetAndDeleteOneRedisMultiMsg(redisId, shard, mGetMultiMsgs, newGroupMsg);
             }
             
             if ((int32_t)resultGroups.size() < recordSize) {
@@ -290,7 +312,7 @@ public:
             }
         } // end while(true)
     
-        LOGI << "updateOneRedis group list, redis id: " << redisId
+        LOGI << "updateOneRedis group list, redis id: " << redisId << ", key: " << msgListKey
                 << ", one redis new group message count: " << redisGroupIndex
                 << ", new message group count: " << newGroupMsg.size();
     
@@ -421,86 +443,42 @@ public:
         return true;
     }
 
-    bool dbGetAccountsPushType(const std::vector<std::string>& uids,
-                               std::map<std::string, GroupUserMessageIdInfo>& groupUserMsgId,
-                               std::vector<std::string>& missedUids)
-    {
-        std::vector<Account> accountList;
-        std::vector<std::string> m_missedUids;
-        
-        if (!m_accountMgr->get(uids, accountList, m_missedUids)) {
-            LOGE <<"dbGetAccountsPushType get account database error"
-                 << ", uids: " << toString(uids);
-            return false;
-        }
-    
-        if (!m_missedUids.empty()) {
-            LOGW << m_missedUids.size() << "uids could not be found in database, "
-                                         << "missed uids: " << toString(m_missedUids);
-            
-            for (const auto& itAcc : m_missedUids) {
-                groupUserMsgId[itAcc].cfgFlag = GroupUserConfigPushType::NO_CONFIG;
-                missedUids.emplace_back(itAcc);
-            }
-        }
-    
-        for (const auto& a : accountList) {
-            const auto& dev = AccountsManager::getDevice(a, Device::MASTER_ID);
-            if (dev == boost::none) {
-                LOGW << "account, uid: " << a.uid() << " does not have a master device";
-                continue;
-            }
-        
-            if (!AccountsManager::isDevicePushable(*dev)) {
-                groupUserMsgId[a.uid()].cfgFlag = GroupUserConfigPushType::NO_CONFIG;
-                continue;
-            }
-            
-            auto itgum = groupUserMsgId.find(a.uid());
-            if (itgum != groupUserMsgId.end()) {
-                itgum->second.cfgFlag = GroupUserConfigPushType::NORMAL;
-                itgum->second.gcmId = dev->gcmid();
-                itgum->second.umengId = dev->umengid();
-                itgum->second.osType = dev->clientversion().ostype();
-                itgum->second.osVersion = dev->clientversion().osversion();
-                itgum->second.bcmBuildCode = dev->clientversion().bcmbuildcode();
-                itgum->second.phoneModel = dev->clientversion().phonemodel();
-                itgum->second.targetAddress = DispatchAddress(a.uid(), dev->id()).getSerialized();
-                itgum->second.apnId = dev->apnid();
-                itgum->second.apnType = dev->apntype();
-                itgum->second.voipApnId = dev->voipapnid();
-            }
-        }
-        return true;
-    }
-    
+    // serves cached uids, fetches the rest through m_accountPushFetcher
     bool dbBatchGetAccountsPushType(const std::vector<std::string>& uids,
                                     std::map<std::string, GroupUserMessageIdInfo>& groupUserMsgId,
                                     std::vector<std::string>& missedUids)
     {
-        std::vector<std::string>   partUids;
-        
-        int32_t numb = 0;
+        std::vector<std::string> fetchUids;
         for (const auto& itUid : uids) {
-            partUids.emplace_back(itUid);
-
-            numb++;
-            if (numb >= 20) {
-                numb    = 0;
-    
-                if (!dbGetAccountsPushType(partUids, groupUserMsgId, missedUids)) {
-                    return false;
-                }
-                partUids.clear();
+            auto itgum = groupUserMsgId.find(itUid);
+            if (itgum == groupUserMsgId.end() || !m_pushInfoCache.get(itUid, itgum->second)) {
+                fetchUids.emplace_back(itUid);
             }
         }
-        
-        if (numb > 0) {
-            if (!dbGetAccountsPushType(partUids, groupUserMsgId, missedUids)) {
-                return false;
+        if (fetchUids.empty()) {
+            return true;
+        }
+
+        std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+        std::vector<std::string> fetchMissed;
+        bool result = m_accountPushFetcher.batchFetch(fetchUids, pushInfos, fetchMissed);
+
+        for (const auto& itInfo : pushInfos) {
+            m_pushInfoCache.put(itInfo.first, itInfo.second);
+            auto itgum = groupUserMsgId.find(itInfo.first);
+            if (itgum != groupUserMsgId.end()) {
+                assignPushInfo(itInfo.second, itgum->second);
             }
         }
-        return true;
+
+        for (const auto& itMissed : fetchMissed) {
+            groupUserMsgId[itMissed].cfgFlag = GroupUserConfigPushType::NO_CONFIG;
+            missedUids.emplace_back(itMissed);
+        }
+
+        LOGI << "dbBatchGetAccountsPushType uids: " << uids.size() << ", fetched: " << fetchUids.size()
+             << ", result: " << result;
+        return result;
     }
     
     void doPostGroupMessage(const std::string& offlineSvrAddr,
@@ -796,6 +774,166 @@ public:
         return true;
     }
     
+    // -----------------------------------------------------------------------------
+    // Section: group message stream
+    // -----------------------------------------------------------------------------
+
+    void startGroupMsgStream(std::function<bool()> isMaster)
+    {
+        if (!m_config.offlineSvr.groupMsgStream) {
+            return;
+        }
+
+        m_isMaster = std::move(isMaster);
+        for (const auto& itDb : m_redisDbHosts) {
+            int32_t redisId = itDb.first;
+            for (uint32_t shard = 0; shard < groupMsgShards(); ++shard) {
+                m_streamThreads.emplace_back([this, redisId, shard]() {
+                    setCurrentThreadName("offline.stream." + std::to_string(redisId) + "." + std::to_string(shard));
+                    groupMsgStreamLoop(redisId, groupMsgShardKey(REDISDB_KEY_GROUP_MSG_STREAM, shard));
+                });
+            }
+        }
+    }
+
+    void stopGroupMsgStream()
+    {
+        m_streamStop.store(true);
+        for (auto& thd : m_streamThreads) {
+            thd.join();
+        }
+        m_streamThreads.clear();
+    }
+
+    // the lease holder is the only consumer of a partition, so a fixed consumer name
+    // lets a new master pick up entries the previous one read but did not ack
+    void groupMsgStreamLoop(int32_t redisId, const std::string& streamKey)
+    {
+        const std::string consumer = "offline_" + m_config.offlineSvr.redisPartition;
+        std::string startId = "0";
+        bool groupCreated = false;
+
+        while (!m_streamStop.load()) {
+            if (!m_isMaster()) {
+                startId = "0";
+                std::this_thread::sleep_for(std::chrono::milliseconds(OFFLINE_GROUP_STREAM_IDLE_MILLIS));
+                continue;
+            }
+
+            if (!groupCreated) {
+                groupCreated = RedisClientSync::OfflineInstance()->xgroupCreate(redisId,
+                                                                                streamKey,
+                                                                                REDISDB_GROUP_MSG_STREAM_GROUP);
+                if (!groupCreated) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(OFFLINE_GROUP_STREAM_IDLE_MILLIS));
+                    continue;
+                }
+            }
+
+            std::vector<RedisStreamEntry> entries;
+            if (!RedisClientSync::OfflineInstance()->xreadgroup(redisId, streamKey,
+                                                                REDISDB_GROUP_MSG_STREAM_GROUP, consumer, startId,
+                                                                m_config.offlineSvr.groupMsgStreamBatchSize,
+                                                                OFFLINE_GROUP_STREAM_BLOCK_MILLIS, entries)) {
+                // the stream may have been dropped together with its group
+                groupCreated = false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(OFFLINE_GROUP_STREAM_IDLE_MILLIS));
+                continue;
+            }
+
+            if (entries.empty()) {
+                // pending entries of the previous owner are drained, switch to new entries
+                startId = ">";
+                continue;
+            }
+
+            handleGroupMsgStreamEntries(redisId, streamKey, entries);
+        }
+    }
+
+    static int64_t streamIdMillis(const std::string& id)
+    {
+        return std::strtoll(id.c_str(), nullptr, 10);
+    }
+
+    void handleGroupMsgStreamEntries(int32_t redisId, const std::string& streamKey,
+                                     const std::vector<RedisStreamEntry>& entries)
+    {
+        // give online members the same grace period as the zset path before pushing offline
+        int64_t waitMillis = streamIdMillis(entries.back().id)
+                             + m_config.offlineSvr.groupMsgStreamDelayMillis - nowInMilli();
+        if (waitMillis > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(
+                std::min<int64_t>(waitMillis, m_config.offlineSvr.groupMsgStreamDelayMillis)));
+        }
+
+        std::map<uint64_t, GroupMessageInfoTask> newGroupMsg;
+        std::vector<std::string> ackIds;
+        ackIds.reserve(entries.size());
+        for (const auto& entry : entries) {
+            ackIds.emplace_back(entry.id);
+
+            uint64_t  curGid = 0;
+            GroupMessageIdInfo gmDb;
+            auto itMsg = entry.fields.find(REDISDB_GROUP_MSG_STREAM_FIELD_MSG);
+            if (itMsg == entry.fields.end()
+                || !parseGroupMsgField(itMsg->second, curGid, gmDb.last_mid, gmDb.type)) {
+                LOGE << "redis group stream format error, redisId: " << redisId << ", id: " << entry.id;
+                continue;
+            }
+
+            gmDb.tm         = static_cast<uint32_t>(streamIdMillis(entry.id) / 1000);
+            gmDb.dbKey      = itMsg->second;
+            gmDb.redisId    = redisId;
+
+            if (gmDb.type == bcm::PushPeopleType::PUSHPEOPLETYPE_TO_DESIGNATED_PERSON) {
+                auto itMulti = entry.fields.find(REDISDB_GROUP_MSG_STREAM_FIELD_MULTI);
+                if (itMulti == entry.fields.end() || !gmDb.gmm.from_string(itMulti->second)) {
+                    LOGE << "redis group stream multi message format error, redisId: " << redisId
+                         << ", id: " << entry.id << ", member: " << itMsg->second;
+                    continue;
+                }
+            }
+
+            appendGroupMessageTask(curGid, gmDb, newGroupMsg);
+        }
+
+        std::vector<uint32_t> vecDbLists = getActiveRedisDbs();
+
+        // ack only after the batch is pushed, so a crash leaves the entries pending for the next master
+        auto latch = std::make_shared<SyncLatch>(newGroupMsg.size());
+        for (const auto& itGroup : newGroupMsg) {
+            m_workThdPool.execInPool([this, itGroup, vecDbLists, latch]() {
+                handleOfflineGroupMessage(vecDbLists, itGroup.first, itGroup.second);
+                latch->countDown();
+            });
+        }
+        latch->wait();
+
+        if (!RedisClientSync::OfflineInstance()->xack(redisId, streamKey,
+                                                      REDISDB_GROUP_MSG_STREAM_GROUP, ackIds)) {
+            LOGW << "redis group stream ack failed, redisId: " << redisId << ", key: " << streamKey
+                 << ", size: " << ackIds.size();
+        }
+
+        LOGI << "redis group stream batch, redisId: " << redisId << ", key: " << streamKey
+             << ", entries: " << entries.size() << ", gid size: " << newGroupMsg.size()
+             << ", first lag(ms): " << (nowInMilli() - streamIdMillis(entries.front().id));
+    }
+
+    std::vector<uint32_t> getActiveRedisDbs()
+    {
+        std::vector<uint32_t> vecDbLists;
+        for (const auto& itDb : m_redisDbHosts) {
+            std::string value = "";
+            if (RedisClientSync::OfflineInstance()->get(itDb.first, REDISDB_KEY_GROUP_REDIS_ACTIVE, value)
+                && "" != value) {
+                vecDbLists.emplace_back(itDb.first);
+            }
+        }
+        return vecDbLists;
+    }
+
     // start round offline server
     void runRoundOfflinePush()
     {
@@ -803,19 +941,44 @@ public:
         std::map<uint64_t, GroupMessageInfoTask> newGroupMsgSeq;
         std::vector<uint32_t>    vecDbLists;
         
-        // check redisDb at new group message
+        // check redisDb at new group message, the shards of all of them are read in parallel
+        struct ShardScan {
+            int32_t redisId;
+            uint32_t shard;
+            bool hasData{false};
+            std::map<uint64_t, GroupMessageInfoTask> groupMsgs;
+        };
+        std::vector<ShardScan> scans;
         for (const auto& itDb : m_redisDbHosts) {
             std::string value = "";
             if (!RedisClientSync::OfflineInstance()->get(itDb.first, REDISDB_KEY_GROUP_REDIS_ACTIVE, value)) {
                 continue;
             }
-    
+
             if ("" != value) {
-                if (dbGetAndDeleteOneRedisGroupMsg(itDb.first, newGroupMsgSeq)) {
-                    vecDbLists.emplace_back(itDb.first);
+                for (uint32_t shard = 0; shard < groupMsgShards(); ++shard) {
+                    scans.push_back(ShardScan{itDb.first, shard});
                 }
             }
         }
+
+        auto latch = std::make_shared<SyncLatch>(scans.size());
+        for (auto& scan : scans) {
+            ShardScan* pScan = &scan;
+            m_workThdPool.execInPool([this, pScan, latch]() {
+                pScan->hasData = dbGetAndDeleteOneRedisGroupMsg(pScan->redisId, pScan->shard, pScan->groupMsgs);
+                latch->countDown();
+            });
+        }
+        latch->wait();
+
+        for (auto& scan : scans) {
+            if (scan.hasData
+                && std::find(vecDbLists.begin(), vecDbLists.end(), scan.redisId) == vecDbLists.end()) {
+                vecDbLists.emplace_back(scan.redisId);
+            }
+            mergeGroupMessageTasks(scan.groupMsgs, newGroupMsgSeq);
+        }
     
         m_runRoundTaskCount.store(newGroupMsgSeq.size(), std::memory_order_seq_cst);
         m_runRoundStartTime.store(nowInMilli(), std::memory_order_relaxed);
@@ -832,6 +995,29 @@ public:
         }
     }
 
+    uint32_t groupMsgShards() const
+    {
+        return static_cast<uint32_t>(std::max(1, m_config.offlineSvr.groupMsgShards));
+    }
+
+    // a gid is in one shard only, unless the shard count of the im servers changed
+    static void mergeGroupMessageTasks(std::map<uint64_t, GroupMessageInfoTask>& from,
+                                       std::map<uint64_t, GroupMessageInfoTask>& to)
+    {
+        for (auto& itFrom : from) {
+            auto itTo = to.find(itFrom.first);
+            if (itTo == to.end()) {
+                to.emplace(itFrom.first, std::move(itFrom.second));
+                continue;
+            }
+            itTo->second.broadcastCount += itFrom.second.broadcastCount;
+            itTo->second.multicastCount += itFrom.second.multicastCount;
+            itTo->second.gms.insert(itTo->second.gms.end(), itFrom.second.gms.begin(), itFrom.second.gms.end());
+            itTo->second.multicastMembers.insert(itFrom.second.multicastMembers.begin(),
+                                                 itFrom.second.multicastMembers.end());
+        }
+    }
+
     bool isLastRoundFinished()
     {
         return (0 == m_runRoundTaskCount.load());
@@ -859,6 +1045,9 @@ private:
             GroupEvent evt;
             msgObj.get_to(evt);
 
+            // group user events are also the hint that a member's push info may have changed
+            m_pushInfoCache.invalidate(evt.uid);
+
             if (m_groupMemberMgr.isGroupExist(evt.gid)) {
                 handleEvent(evt.type, evt.uid, evt.gid);
             }
@@ -906,6 +1095,7 @@ OfflineService::OfflineService(OfflineConfig& config,
       , m_masterLease("offline_redis_" + config.offlineSvr.redisPartition, 10000, OfflineService::lostLease)
 {
     m_masterLease.start();
+    m_impl.startGroupMsgStream([this]() { return m_masterLease.isMaster(); });
 }
 
 OfflineService::~OfflineService()
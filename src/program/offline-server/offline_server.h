@@ -16,6 +16,9 @@ namespace bcm {
 #define     OFFLINE_GROUP_MESSAGE_DELAY_TIME    5
 #define     OFFLINE_GROUP_MESSAGE_SCAN_SIZE     300
 #define     OFFLINE_GROUP_USER_SCAN_SIZE        100
+// stays below the redis socket timeout
+#define     OFFLINE_GROUP_STREAM_BLOCK_MILLIS   1000
+#define     OFFLINE_GROUP_STREAM_IDLE_MILLIS    1000
     
     
     struct GroupMessageIdInfo {
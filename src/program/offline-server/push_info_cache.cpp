@@ -0,0 +1,91 @@
+#include "push_info_cache.h"
+
+#include <utils/time.h>
+
+namespace bcm {
+
+constexpr size_t PushInfoCache::kShardCount;
+
+PushInfoCache::PushInfoCache(size_t capacity, int64_t ttlMillis)
+    : m_shardCapacity((capacity + kShardCount - 1) / kShardCount)
+    , m_ttlMillis(ttlMillis)
+{
+}
+
+PushInfoCache::Shard& PushInfoCache::shardOf(const std::string& uid)
+{
+    return m_shards[std::hash<std::string>()(uid) % kShardCount];
+}
+
+bool PushInfoCache::get(const std::string& uid, GroupUserMessageIdInfo& info)
+{
+    if (m_shardCapacity == 0) {
+        return false;
+    }
+
+    Shard& shard = shardOf(uid);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.entries.find(uid);
+    if (it == shard.entries.end()) {
+        return false;
+    }
+    if (it->second.expireAt <= nowInMilli()) {
+        shard.entries.erase(it);
+        return false;
+    }
+    assignPushInfo(it->second.info, info);
+    return true;
+}
+
+void PushInfoCache::put(const std::string& uid, const GroupUserMessageIdInfo& info)
+{
+    if (m_shardCapacity == 0) {
+        return;
+    }
+
+    int64_t now = nowInMilli();
+    Shard& shard = shardOf(uid);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    auto it = shard.entries.find(uid);
+    if (it == shard.entries.end()) {
+        if (shard.entries.size() >= m_shardCapacity) {
+            // prefer an expired victim within a few probes, otherwise drop the first one
+            auto victim = shard.entries.begin();
+            int probes = 0;
+            for (auto itProbe = shard.entries.begin(); itProbe != shard.entries.end() && probes < 8;
+                 ++itProbe, ++probes) {
+                if (itProbe->second.expireAt <= now) {
+                    victim = itProbe;
+                    break;
+                }
+            }
+            shard.entries.erase(victim);
+        }
+        it = shard.entries.emplace(uid, Entry()).first;
+    }
+    assignPushInfo(info, it->second.info);
+    it->second.expireAt = now + m_ttlMillis;
+}
+
+void PushInfoCache::invalidate(const std::string& uid)
+{
+    if (m_shardCapacity == 0) {
+        return;
+    }
+
+    Shard& shard = shardOf(uid);
+    std::lock_guard<std::mutex> l(shard.mtx);
+    shard.entries.erase(uid);
+}
+
+size_t PushInfoCache::size() const
+{
+    size_t total = 0;
+    for (const auto& shard : m_shards) {
+        std::lock_guard<std::mutex> l(shard.mtx);
+        total += shard.entries.size();
+    }
+    return total;
+}
+
+} // namespace bcm
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../../config/group_store_format.h"
+
+namespace bcm {
+
+// copies the device push fields (everything but last_mid)
+inline void assignPushInfo(const GroupUserMessageIdInfo& from, GroupUserMessageIdInfo& to)
+{
+    to.gcmId = from.gcmId;
+    to.umengId = from.umengId;
+    to.osType = from.osType;
+    to.osVersion = from.osVersion;
+    to.bcmBuildCode = from.bcmBuildCode;
+    to.phoneModel = from.phoneModel;
+    to.apnId = from.apnId;
+    to.apnType = from.apnType;
+    to.voipApnId = from.voipApnId;
+    to.targetAddress = from.targetAddress;
+    to.cfgFlag = from.cfgFlag;
+}
+
+// Push ids and push type of accounts, keyed by uid. Entries expire after ttl, and are
+// dropped on group user events, so a member re-entering a group is fetched again.
+class PushInfoCache {
+public:
+    // capacity 0 disables the cache
+    PushInfoCache(size_t capacity, int64_t ttlMillis);
+
+    // fills the push fields of info on hit, last_mid is left untouched
+    bool get(const std::string& uid, GroupUserMessageIdInfo& info);
+    void put(const std::string& uid, const GroupUserMessageIdInfo& info);
+    void invalidate(const std::string& uid);
+
+    size_t size() const;
+
+private:
+    struct Entry {
+        GroupUserMessageIdInfo info;
+        int64_t expireAt;
+    };
+
+    struct Shard {
+        mutable std::mutex mtx;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    static constexpr size_t kShardCount = 16;
+
+    Shard& shardOf(const std::string& uid);
+
+private:
+    std::array<Shard, kShardCount> m_shards;
+    size_t m_shardCapacity;
+    int64_t m_ttlMillis;
+};
+
+} // namespace bcm
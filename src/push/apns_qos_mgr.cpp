@@ -3,6 +3,7 @@
 #include "apns_notification.h"
 #include "config/bcm_config.h"
 #include "dispatcher/dispatch_address.h"
+#include "dispatcher/presence_index.h"
 #include "redis/async_conn.h"
 #include "redis/reply.h"
 #include "utils/log.h"
@@ -78,6 +79,8 @@ class QosMgrImpl
     std::unique_ptr<std::thread> m_thread;
     redis::AsyncConn m_conn;
     redis::AsyncConn m_connPub;
+    // accessed in the event loop only
+    std::shared_ptr<PresenceIndex> m_presence;
 
     std::unordered_map<std::string, std::unique_ptr<ResendTask>> m_addrTaskMap;
 
@@ -129,6 +132,13 @@ public:
                         notification.release() ) );
     }
 
+    void setPresenceIndex(std::shared_ptr<PresenceIndex> presence)
+    {
+        bcm::libevent::AsyncFunc::invoke(m_eb, [this, presence]() {
+            m_presence = presence;
+        });
+    }
+
 private:
     void eventLoop()
     {
@@ -314,6 +324,11 @@ void ResendTask::handleTimeout(evutil_socket_t fd, short events, void* arg)
 void ResendTask::onTimeout()
 {
     LOGD << "resend task for '" << m_addr << "' is timeout";
+    if (m_qosMgr.m_presence != nullptr && m_qosMgr.m_presence->isReady()) {
+        onCheckUserOnline(m_qosMgr.m_presence->isOnline(m_addr));
+        return;
+    }
+
     const std::string& chan = m_addr.getSerialized();
     
     bcm::PubSubMessage msg;
@@ -381,6 +396,11 @@ void QosMgr::scheduleResend(const DispatchAddress& addr,
     m_impl.scheduleResend(addr, apnsType, std::move(notification));
 }
 
+void QosMgr::setPresenceIndex(std::shared_ptr<PresenceIndex> presence)
+{
+    m_impl.setPresenceIndex(std::move(presence));
+}
+
 } // namespace apns
 } // namespace push
 } // namespace bcm
\ No newline at end of file
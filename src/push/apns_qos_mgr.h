@@ -4,12 +4,14 @@
 
 #include <boost/system/error_code.hpp>
 
+#include <memory>
 #include <string>
 
 namespace bcm {
 class ApnsConfig;
 class RedisConfig;
 class DispatchAddress;
+class PresenceIndex;
 };
 
 namespace bcm {
@@ -34,6 +36,8 @@ public:
     void scheduleResend(const DispatchAddress& addr, 
                         const std::string& apnsType, 
                         std::unique_ptr<Notification> notification);
+    // answers the online checks from memory once it is ready instead of redis
+    void setPresenceIndex(std::shared_ptr<PresenceIndex> presence);
 private:
     QosMgrImpl* m_pImpl;
     QosMgrImpl& m_impl;
@@ -312,6 +312,11 @@ public:
         m_maxRetries = times;
     }
 
+    void setPresenceIndex(std::shared_ptr<PresenceIndex> presence)
+    {
+        m_apnsQosMgr.setPresenceIndex(std::move(presence));
+    }
+
     push::fcm::Client& fcm()
     {
         return m_fcmClient;
@@ -758,5 +763,10 @@ Service::shared_ptr Service::maxRetries(int32_t times)
     return shared_from_this();
 }
 
+void Service::setPresenceIndex(std::shared_ptr<PresenceIndex> presence)
+{
+    m_impl.setPresenceIndex(std::move(presence));
+}
+
 } // namespace push
 } // namespace bcm
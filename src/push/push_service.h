@@ -14,6 +14,7 @@ class Account;
 class Device;
 class AccountsManager;
 class RedisConfig;
+class PresenceIndex;
 } // namespace bcm
 
 namespace bcm {
@@ -44,6 +45,9 @@ public:
     shared_ptr maxDelay(int32_t maxDelayMillis);
     shared_ptr maxRetries(int32_t times);
 
+    // online checks before resending are answered by presence once it is ready
+    void setPresenceIndex(std::shared_ptr<PresenceIndex> presence);
+
 private:
     ServiceImpl* m_pImpl;
     ServiceImpl& m_impl;
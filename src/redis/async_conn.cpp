@@ -8,6 +8,7 @@
 #include <hiredis/async.h>
 #include <hiredis/adapters/libevent.h>
 
+#include <cstring>
 #include <vector>
 
 namespace bcm {
@@ -230,6 +231,41 @@ public:
         });
     }
 
+    // one SUBSCRIBE for all channels, redis replies once per channel
+    void subscribeBatch(const std::vector<std::string>& chanVec,
+                        AsyncConn::ISubscriptionHandler* handler)
+    {
+        if (chanVec.empty()) {
+            return;
+        }
+
+        libevent::AsyncFunc::invoke(m_eb, [=]() {
+            int res = execArgv(handleSubscription, "SUBSCRIBE", chanVec);
+            if (REDIS_OK != res) {
+                LOGE << "exec 'SUBSCRIBE' of " << chanVec.size() << " channels error: " << res;
+                handler->onError(res);
+            } else {
+                for (const auto& it : chanVec) {
+                    m_subHandlerMap[it] = handler;
+                }
+            }
+        });
+    }
+
+    void unsubscribeBatch(const std::vector<std::string>& chanVec)
+    {
+        if (chanVec.empty()) {
+            return;
+        }
+
+        libevent::AsyncFunc::invoke(m_eb, [=]() {
+            int res = execArgv(handleSubscription, "UNSUBSCRIBE", chanVec);
+            if (REDIS_OK != res) {
+                LOGE << "exec 'UNSUBSCRIBE' of " << chanVec.size() << " channels error: " << res;
+            }
+        });
+    }
+
     void psubscribeBatch(const std::vector<std::string>& chanVec,
                          AsyncConn::ISubscriptionHandler* handler)
     {
@@ -446,6 +482,22 @@ private:
         m_shutdownHandlers.clear();
     }
 
+    int execArgv(redisCallbackFn* fn, const char* cmd, const std::vector<std::string>& args)
+    {
+        std::vector<const char*> argv;
+        std::vector<size_t> argvLen;
+        argv.reserve(args.size() + 1);
+        argvLen.reserve(args.size() + 1);
+        argv.push_back(cmd);
+        argvLen.push_back(strlen(cmd));
+        for (const auto& a : args) {
+            argv.push_back(a.data());
+            argvLen.push_back(a.size());
+        }
+        return redisAsyncCommandArgv(m_ac, fn, reinterpret_cast<void*>(this),
+                                     static_cast<int>(argv.size()), argv.data(), argvLen.data());
+    }
+
     static void handleSubscription(struct redisAsyncContext* ac, 
                                    void* r, void* priv)
     {
@@ -635,6 +687,17 @@ void AsyncConn::punsubscribe(const std::string& chan)
     m_pImpl->punsubscribe(chan);
 }
 
+void AsyncConn::subscribeBatch(const std::vector<std::string>& chanVec,
+                               ISubscriptionHandler* handler)
+{
+    m_pImpl->subscribeBatch(chanVec, handler);
+}
+
+void AsyncConn::unsubscribeBatch(const std::vector<std::string>& chanVec)
+{
+    m_pImpl->unsubscribeBatch(chanVec);
+}
+
 void AsyncConn::psubscribeBatch(const std::vector<std::string>& chanVec,
                            ISubscriptionHandler* handler)
 {
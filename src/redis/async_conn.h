@@ -58,6 +58,10 @@ public:
     void unsubscribe(const std::string& chan);
     void punsubscribe(const std::string& chan);
 
+    // callers bound the size of chanVec, it is sent as a single command
+    void subscribeBatch(const std::vector<std::string>& chanVec,
+                        ISubscriptionHandler* handler);
+    void unsubscribeBatch(const std::vector<std::string>& chanVec);
     void psubscribeBatch(const std::vector<std::string>& chanVec,
                                     ISubscriptionHandler* handler);
     void punsubscribeBatch(const std::vector<std::string>& chanVec);
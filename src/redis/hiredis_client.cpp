@@ -9,6 +9,9 @@
 #include <boost/algorithm/string/split.hpp>
 #include "hiredis_client.h"
 #include "libevent_task.h"
+#include "metrics_client.h"
+#include <algorithm>
+#include <atomic>
 
 using namespace bcm;
 
@@ -82,6 +85,18 @@ bool RedisClientSync::setRedisConfig(const std::map<int32_t, RedisConfig>& redis
     return true;
 }
 
+void RedisClientSync::maintainPools()
+{
+    std::map<int32_t, std::shared_ptr<RedisServer>> servers;
+    {
+        std::unique_lock<std::recursive_mutex> mutexRecu(m_mutexRedisList);
+        servers = m_vecRedisClusterList;
+    }
+    for (auto& server : servers) {
+        server.second->maintainPool();
+    }
+}
+
 std::shared_ptr<RedisServer> RedisClientSync::getRedisServer(const std::string& key)
 {
     std::unique_lock<std::recursive_mutex> mutexRecu(m_mutexRedisList);
@@ -211,6 +226,7 @@ bool RedisClientSync::mget(const std::string& strPrekey, const std::set<std::str
         std::shared_ptr<RedisConn> pRedisConn = itMapNodeKeys->first->getRedisConn();
         if (pRedisConn != nullptr) {
             pRedisConn->mget(itMapNodeKeys->second, mapKeyValues);
+            itMapNodeKeys->first->freeRedisConn(pRedisConn);
         }
     }
 
@@ -238,6 +254,7 @@ bool RedisClientSync::mget(const std::string& strPrekey, const std::vector<std::
         std::shared_ptr<RedisConn> pRedisConn = itMapNodeKeys->first->getRedisConn();
         if (pRedisConn != nullptr) {
             pRedisConn->mget(itMapNodeKeys->second, mapKeyValues);
+            itMapNodeKeys->first->freeRedisConn(pRedisConn);
         }
     }
 
@@ -436,6 +453,41 @@ bool RedisClientSync::publishRes(const std::string& channel, const std::string&
     return isSuccess;
 }
 
+bool RedisClientSync::ppublish(const std::vector<std::string>& channels, const std::vector<std::string>& messages)
+{
+    if (channels.size() != messages.size()) {
+        LOGE << "[PPUBLISH] " << channels.size() << " channels for " << messages.size() << " messages";
+        return false;
+    }
+
+    std::map<std::shared_ptr<RedisServer>, std::vector<std::vector<std::string>>> mapNodeCmds;
+    bool isSuccess = true;
+    for (size_t i = 0; i < channels.size(); ++i) {
+        std::shared_ptr<RedisServer> ptrRedisServer = getRedisServer(channels[i]);
+        if (ptrRedisServer == nullptr) {
+            isSuccess = false;
+            continue;
+        }
+        mapNodeCmds[ptrRedisServer].push_back({"PUBLISH", channels[i], messages[i]});
+    }
+
+    std::vector<RedisCmdResult> results;
+    for (const auto& item : mapNodeCmds) {
+        std::shared_ptr<RedisConn> pRedisConn = item.first->getRedisConn();
+        if (pRedisConn == nullptr) {
+            LOGE << "[PPUBLISH] failed to get available redis connection.";
+            isSuccess = false;
+            continue;
+        }
+        if (!pRedisConn->pipeline(item.second, false, results)) {
+            LOGE << "[PPUBLISH] failed to publish " << item.second.size() << " messages";
+            isSuccess = false;
+        }
+        item.first->freeRedisConn(pRedisConn);
+    }
+    return isSuccess;
+}
+
 bool RedisClientSync::pubsub(const std::string& strTopic, std::set<std::string>& setTopics)
 {
     std::shared_ptr<RedisServer> ptrRedisServer = getRedisServer(strTopic);
@@ -775,6 +827,72 @@ bool RedisClientSync::getMemsByScoreWithLimit(int32_t dbIndex,
     return isSuccess;
 }
 
+bool RedisClientSync::xgroupCreate(int32_t dbIndex, const std::string& key, const std::string& group)
+{
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisServerById(dbIndex);
+    if (ptrRedisServer == nullptr) {
+        LOGE << "[XGROUP] no redisServer db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    std::shared_ptr<RedisConn> pRedisConn = ptrRedisServer->getRedisConn();
+    if (pRedisConn == nullptr) {
+        LOGE << "[XGROUP] failed to get available redis connection. db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    bool isSuccess = pRedisConn->xgroupCreate(key, group);
+    ptrRedisServer->freeRedisConn(pRedisConn);
+    return isSuccess;
+}
+
+bool RedisClientSync::xreadgroup(int32_t dbIndex, const std::string& key,
+                                 const std::string& group, const std::string& consumer,
+                                 const std::string& startId, uint32_t count, int32_t blockMillis,
+                                 std::vector<RedisStreamEntry>& entries)
+{
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisServerById(dbIndex);
+    if (ptrRedisServer == nullptr) {
+        LOGE << "[XREADGROUP] no redisServer db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    std::shared_ptr<RedisConn> pRedisConn = ptrRedisServer->getRedisConn();
+    if (pRedisConn == nullptr) {
+        LOGE << "[XREADGROUP] failed to get available redis connection. db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    bool isSuccess = pRedisConn->xreadgroup(key, group, consumer, startId, count, blockMillis, entries);
+    ptrRedisServer->freeRedisConn(pRedisConn);
+    return isSuccess;
+}
+
+bool RedisClientSync::xack(int32_t dbIndex, const std::string& key,
+                           const std::string& group, const std::vector<std::string>& ids)
+{
+    if (ids.empty()) {
+        LOGE << "[XACK] no id specified. db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisServerById(dbIndex);
+    if (ptrRedisServer == nullptr) {
+        LOGE << "[XACK] no redisServer db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    std::shared_ptr<RedisConn> pRedisConn = ptrRedisServer->getRedisConn();
+    if (pRedisConn == nullptr) {
+        LOGE << "[XACK] failed to get available redis connection. db: " << dbIndex << ", key: " << key;
+        return false;
+    }
+
+    bool isSuccess = pRedisConn->xack(key, group, ids);
+    ptrRedisServer->freeRedisConn(pRedisConn);
+    return isSuccess;
+}
+
 // Return
 //     -1: communication error
 //      0: key is not a valid integer
@@ -1198,46 +1316,228 @@ void RedisClientAsync::onAuthRes(redisAsyncContext* pRedisContext, void* pvRedis
     }    
 }
 
+static const std::string kRedisPoolServiceName = "RedisPoolService";
+static const std::string kRedisPoolWaitTimeout = "timeout";
+
+static RedisPoolConfig gs_defaultPoolConfig;
+static std::atomic<bool> gs_poolMetrics(false);
+
+void RedisServer::setDefaultPoolConfig(const RedisPoolConfig& config)
+{
+    gs_defaultPoolConfig = config;
+}
+
+void RedisServer::enablePoolMetrics()
+{
+    gs_poolMetrics = true;
+}
+
 RedisServer::RedisServer(const std::string& host, const int port, const std::string& password, const std::string& keepaliveKey)
     : m_redisHost(host)
     , m_redisPort(port)
     , m_redisPassword(password)
     , m_keepaliveKey(keepaliveKey)
+    , m_poolConfig(gs_defaultPoolConfig)
+{
+}
+
+void RedisServer::setPoolConfig(const RedisPoolConfig& config)
 {
+    std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+    m_poolConfig = config;
 }
 
-std::shared_ptr<RedisConn> RedisServer::getRedisConn()
+std::shared_ptr<RedisConn> RedisServer::getRedisConn(bool* isExhausted)
 {
-    //find a redis connect from pool.
-    std::unique_lock<std::recursive_mutex> mutexRecu(m_mutexConnectList);
     std::shared_ptr<RedisConn> pRedisConn = nullptr;
-    if (m_redisConnList.size() == 0) {
+    int64_t idleSince = 0;
+    bool isNewConn = false;
+    bool isWaited = false;
+    bool isTimeout = false;
+    int64_t waitMicros = 0;
+    {
+        std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+        if (!m_idleConns.empty()) {
+            pRedisConn = m_idleConns.front().conn;
+            idleSince = m_idleConns.front().idleSince;
+            m_idleConns.pop_front();
+            ++m_poolStats.inUse;
+        } else if (m_poolConfig.maxConns <= 0 || m_poolStats.total < static_cast<uint32_t>(m_poolConfig.maxConns)) {
+            ++m_poolStats.total;
+            ++m_poolStats.inUse;
+            ++m_poolStats.created;
+            isNewConn = true;
+        } else if (m_poolConfig.maxWaitInMilli <= 0) {
+            ++m_poolStats.waits;
+            ++m_poolStats.waitTimeouts;
+            isTimeout = true;
+        } else {
+            // FIFO, freeRedisConn() and dropRedisConn() hand over to the first waiter
+            Waiter waiter;
+            m_waiters.push_back(&waiter);
+            ++m_poolStats.waits;
+            isWaited = true;
+            int64_t start = nowInMicro();
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_poolConfig.maxWaitInMilli);
+            bool isReady = waiter.cv.wait_until(l, deadline, [&waiter]() {
+                return waiter.conn != nullptr || waiter.slot;
+            });
+            waitMicros = nowInMicro() - start;
+            m_poolStats.waitMicros += waitMicros;
+            if (!isReady) {
+                m_waiters.erase(std::find(m_waiters.begin(), m_waiters.end(), &waiter));
+                ++m_poolStats.waitTimeouts;
+                isTimeout = true;
+            } else if (waiter.conn != nullptr) {
+                // comes straight from use, no need to validate it
+                pRedisConn = std::move(waiter.conn);
+                idleSince = nowInMilli();
+            } else {
+                // the slot of a closed connection, already counted in total and inUse
+                isNewConn = true;
+            }
+        }
+        m_poolStats.peakInUse = std::max(m_poolStats.peakInUse, m_poolStats.inUse);
+    }
+
+    if (isWaited) {
+        markWait(waitMicros, isTimeout);
+    }
+    if (isTimeout) {
+        LOGE << "no redis connection available (" << m_redisHost << ":" << m_redisPort << ")";
+        if (isExhausted != nullptr) {
+            *isExhausted = true;
+        }
+        return nullptr;
+    }
+
+    if (isNewConn) {
         pRedisConn = std::make_shared<RedisConn>(m_redisHost, m_redisPort, m_redisPassword);
         if (pRedisConn->connectRedis() == false) {
-            pRedisConn = nullptr;
+            dropRedisConn();
+            return nullptr;
         }
-    }
-    else {
-        pRedisConn = m_redisConnList.front();
-        m_redisConnList.pop_front();
+        return std::move(pRedisConn);
     }
 
+    if (nowInMilli() - idleSince >= m_poolConfig.validateAfterInMilli && !pRedisConn->ping()) {
+        LOGW << "idle redis connection is broken, reconnecting (" << m_redisHost << ":" << m_redisPort << ")";
+        if (pRedisConn->connectRedis() == false) {
+            dropRedisConn();
+            return nullptr;
+        }
+    }
     return std::move(pRedisConn);
 } 
 
 void RedisServer::freeRedisConn(std::shared_ptr<RedisConn> pRedisConn)
 {
-    std::unique_lock<std::recursive_mutex> mutexRecu(m_mutexConnectList);
-    m_redisConnList.push_back(pRedisConn);
+    if (pRedisConn == nullptr) {
+        return;
+    }
+    std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+    if (handOver(pRedisConn)) {
+        return;
+    }
+    --m_poolStats.inUse;
+    m_idleConns.push_front(IdleConn{std::move(pRedisConn), nowInMilli()});
+}
+
+bool RedisServer::handOver(std::shared_ptr<RedisConn> conn)
+{
+    if (m_waiters.empty()) {
+        return false;
+    }
+    Waiter* waiter = m_waiters.front();
+    m_waiters.pop_front();
+    if (conn != nullptr) {
+        waiter->conn = std::move(conn);
+    } else {
+        waiter->slot = true;
+    }
+    waiter->cv.notify_one();
+    return true;
+}
+
+void RedisServer::dropRedisConn()
+{
+    std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+    ++m_poolStats.closed;
+    if (handOver(nullptr)) {
+        // the slot, counted in total and inUse, moves to the waiter
+        ++m_poolStats.created;
+        return;
+    }
+    --m_poolStats.total;
+    --m_poolStats.inUse;
+}
+
+void RedisServer::markWait(int64_t waitMicros, bool timeout)
+{
+    if (!gs_poolMetrics) {
+        return;
+    }
+    metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kRedisPoolServiceName,
+        m_redisHost + ":" + std::to_string(m_redisPort), waitMicros, timeout ? kRedisPoolWaitTimeout : "0");
 }
 
 void RedisServer::syncRedisKeepAlive()
 {
-    std::unique_lock<std::recursive_mutex> mutexRecu(m_mutexConnectList);
-    for (std::list<std::shared_ptr<RedisConn>>::iterator itRedisConn = m_redisConnList.begin();
-        itRedisConn != m_redisConnList.end(); ++itRedisConn) {
-        (*itRedisConn)->redisCmdArgs0(std::string("PING"));
-    }   
+    std::list<IdleConn> idleConns;
+    {
+        std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+        idleConns.swap(m_idleConns);
+        m_poolStats.inUse += idleConns.size();
+    }
+    // borrowed while pinging, so nothing is sent on them concurrently
+    for (auto& idle : idleConns) {
+        idle.conn->redisCmdArgs0(std::string("PING"));
+        freeRedisConn(idle.conn);
+    }
+}
+
+void RedisServer::maintainPool()
+{
+    std::vector<std::shared_ptr<RedisConn>> expired;
+    PoolStats stats;
+    {
+        std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+        int64_t idleBefore = nowInMilli() - m_poolConfig.maxIdleInMilli;
+        while (!m_idleConns.empty() && m_idleConns.back().idleSince <= idleBefore) {
+            expired.push_back(std::move(m_idleConns.back().conn));
+            m_idleConns.pop_back();
+            --m_poolStats.total;
+            ++m_poolStats.closed;
+        }
+        stats = m_poolStats;
+        stats.idle = m_idleConns.size();
+        stats.waiters = m_waiters.size();
+        m_poolStats.peakInUse = m_poolStats.inUse;
+    }
+    if (!expired.empty()) {
+        LOGI << "closed " << expired.size() << " idle redis connections (" << m_redisHost << ":" << m_redisPort << ")";
+    }
+    // the connections are closed here, outside the lock
+    expired.clear();
+
+    if (!gs_poolMetrics) {
+        return;
+    }
+    std::string prefix = "redis_pool_" + m_redisHost + ":" + std::to_string(m_redisPort);
+    metrics::MetricsClient::Instance()->counterSet(prefix + "_total", stats.total);
+    metrics::MetricsClient::Instance()->counterSet(prefix + "_idle", stats.idle);
+    metrics::MetricsClient::Instance()->counterSet(prefix + "_in_use", stats.inUse);
+    metrics::MetricsClient::Instance()->counterSet(prefix + "_peak_in_use", stats.peakInUse);
+    metrics::MetricsClient::Instance()->counterSet(prefix + "_waiters", stats.waiters);
+}
+
+RedisServer::PoolStats RedisServer::poolStats()
+{
+    std::unique_lock<boost::fibers::mutex> l(m_poolMutex);
+    PoolStats stats = m_poolStats;
+    stats.idle = m_idleConns.size();
+    stats.waiters = m_waiters.size();
+    return stats;
 }
 
 RedisConn::RedisConn(const std::string& host, const int port, const std::string& password) :
@@ -1312,6 +1612,154 @@ void RedisConn::freeConnect()
     }
 }
 
+bool RedisConn::ping()
+{
+    if (m_pRedisContext == nullptr) {
+        return false;
+    }
+
+    redisReply* pReply = static_cast<redisReply*>(redisCommand(m_pRedisContext, "PING"));
+    if (isReplySuccess(pReply) == false) {
+        LOGE << "[ping] failed to ping redis (" << m_redisHost << ":" << m_redisPort << " error: " << getReplyError(pReply) << ").";
+        freeReplyObject(pReply);
+        freeConnect();
+        return false;
+    }
+
+    freeReplyObject(pReply);
+    m_dwLastActiveTime = nowInMilli();
+    return true;
+}
+
+static void toCmdResult(const redisReply* pReply, RedisCmdResult& result)
+{
+    result.type = pReply->type;
+    result.ok = (pReply->type != REDIS_REPLY_ERROR);
+    switch (pReply->type) {
+        case REDIS_REPLY_INTEGER:
+            result.integer = pReply->integer;
+            break;
+        case REDIS_REPLY_STRING:
+        case REDIS_REPLY_STATUS:
+        case REDIS_REPLY_ERROR:
+            result.str.assign(pReply->str, pReply->len);
+            break;
+        case REDIS_REPLY_ARRAY:
+            for (size_t i = 0; i < pReply->elements; ++i) {
+                const redisReply* e = pReply->element[i];
+                if (e->str == nullptr) {
+                    result.elements.emplace_back("");
+                } else {
+                    result.elements.emplace_back(e->str, e->len);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+bool RedisConn::pipeline(const std::vector<std::vector<std::string>>& cmds, bool multi,
+                         std::vector<RedisCmdResult>& results)
+{
+    results.clear();
+    if (cmds.empty()) {
+        return true;
+    }
+    return pipelineSend(cmds, multi) && pipelineReceive(cmds.size(), multi, results);
+}
+
+bool RedisConn::pipelineSend(const std::vector<std::vector<std::string>>& cmds, bool multi)
+{
+    // a malformed command is the caller's fault, the connection stays as it is
+    for (const auto& cmd : cmds) {
+        if (cmd.empty()) {
+            LOGE << "[pipeline] empty command in a batch of " << cmds.size() << ".";
+            return false;
+        }
+    }
+
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    auto append = [this](const std::vector<std::string>& args) {
+        std::vector<const char*> argv;
+        std::vector<size_t> argvlen;
+        for (const auto& a : args) {
+            argv.push_back(a.data());
+            argvlen.push_back(a.size());
+        }
+        return redisAppendCommandArgv(m_pRedisContext, static_cast<int>(argv.size()), argv.data(), argvlen.data());
+    };
+
+    bool appended = !multi || (append({"MULTI"}) == REDIS_OK);
+    for (const auto& cmd : cmds) {
+        appended = appended && (append(cmd) == REDIS_OK);
+    }
+    appended = appended && (!multi || (append({"EXEC"}) == REDIS_OK));
+    if (!appended) {
+        // commands already in the output buffer must not leak into the next call
+        LOGE << "[pipeline] failed to append " << cmds.size() << " commands.";
+        freeConnect();
+        return false;
+    }
+
+    int done = 0;
+    while (!done) {
+        if (redisBufferWrite(m_pRedisContext, &done) != REDIS_OK) {
+            LOGE << "[pipeline] failed to send " << cmds.size() << " commands.";
+            freeConnect();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RedisConn::pipelineReceive(size_t numOfCmds, bool multi, std::vector<RedisCmdResult>& results)
+{
+    results.clear();
+    if (m_pRedisContext == nullptr) {
+        return false;
+    }
+
+    results.resize(numOfCmds);
+    size_t numOfReplies = numOfCmds + (multi ? 2 : 0);
+    for (size_t i = 0; i < numOfReplies; ++i) {
+        redisReply* pReply = nullptr;
+        if (redisGetReply(m_pRedisContext, (void **)&pReply) != REDIS_OK || pReply == nullptr) {
+            LOGE << "[pipeline] redisGetReply failed after " << i << " of " << numOfReplies << " replies.";
+            freeReplyObject(pReply);
+            freeConnect();
+            results.clear();
+            return false;
+        }
+
+        if (!multi) {
+            toCmdResult(pReply, results[i]);
+        } else if (i == numOfReplies - 1) {
+            // EXEC: the replies of the queued commands, or an error/nil if the transaction was aborted
+            if (pReply->type == REDIS_REPLY_ARRAY && pReply->elements == numOfCmds) {
+                for (size_t j = 0; j < numOfCmds; ++j) {
+                    toCmdResult(pReply->element[j], results[j]);
+                }
+            } else {
+                LOGE << "[pipeline] transaction of " << numOfCmds << " commands aborted: "
+                     << getReplyError(pReply);
+            }
+        } else if (i > 0 && pReply->type == REDIS_REPLY_ERROR) {
+            // rejected while queuing, EXEC aborts the transaction
+            toCmdResult(pReply, results[i - 1]);
+        }
+        freeReplyObject(pReply);
+    }
+
+    m_dwLastActiveTime = nowInMilli();
+    return true;
+}
+
 bool RedisConn::redisCmdArgs0(const std::string& strCmd)
 {
     if (m_pRedisContext == nullptr) {
@@ -2227,6 +2675,58 @@ bool RedisConn::zadd(
     return true;
 }
 
+bool RedisConn::hsetZadd(
+        const std::string& hkey,
+        const std::string& value,
+        const std::string& zkey,
+        const std::string& mem,
+        const int64_t& score)
+{
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    std::string strScore = std::to_string(score);
+
+    int i = 0;
+    while (i++ < 2) {
+        redisAppendCommand(m_pRedisContext, "HSET %b %b %b", hkey.c_str(), hkey.size(),
+                           mem.c_str(), mem.size(), value.c_str(), value.size());
+        redisAppendCommand(m_pRedisContext, "ZADD %b %b %b", zkey.c_str(), zkey.size(),
+                           strScore.c_str(), strScore.size(), mem.c_str(), mem.size());
+
+        // both replies are read to keep the connection in sync
+        bool isSuccess = true;
+        for (int r = 0; r < 2; ++r) {
+            redisReply* pReply = nullptr;
+            int nReply = redisGetReply(m_pRedisContext, (void **)&pReply);
+            if ((nReply == REDIS_ERR) || (isReplySuccess(pReply) == false)) {
+                LOGE << "failed to excute hsetZadd hkey: " << hkey << ", zkey: " << zkey
+                     << ", mem: " << mem << ", reply: " << nReply << ", (error: " << getReplyError(pReply) << ")";
+                isSuccess = false;
+            }
+            freeReplyObject(pReply);
+            if (nReply == REDIS_ERR) {
+                break;
+            }
+        }
+
+        if (isSuccess) {
+            m_dwLastActiveTime = nowInMilli();
+            return true;
+        }
+
+        // both commands are idempotent, resend them on a fresh connection
+        if ((i >= 2) || (reConnectRedis() == false)) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
 bool RedisConn::zrem(const std::string& key, const std::vector<std::string>& memberList)
 {
     if (memberList.empty()) {
@@ -2524,4 +3024,235 @@ bool RedisConn::del(const std::string& key)
 
     freeReplyObject(pReply);
     return true;
-}
\ No newline at end of file
+}
+
+bool RedisConn::xadd(const std::string& key, const std::vector<HField>& values,
+                     uint32_t maxLen, std::string& id)
+{
+    if (values.empty()) {
+        return false;
+    }
+
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    std::string maxLenStr = std::to_string(maxLen);
+
+    std::vector<const char *> argv;
+    std::vector<size_t> argvlen;
+    argv.reserve(values.size() * 2 + 6);
+    argvlen.reserve(values.size() * 2 + 6);
+
+    static char xaddCmd[] = "XADD";
+    static char maxLenArg[] = "MAXLEN";
+    static char approxArg[] = "~";
+    static char autoId[] = "*";
+
+    argv.push_back(xaddCmd);
+    argvlen.push_back(sizeof(xaddCmd) - 1);
+    argv.push_back(key.c_str());
+    argvlen.push_back(key.size());
+    if (maxLen > 0) {
+        argv.push_back(maxLenArg);
+        argvlen.push_back(sizeof(maxLenArg) - 1);
+        argv.push_back(approxArg);
+        argvlen.push_back(sizeof(approxArg) - 1);
+        argv.push_back(maxLenStr.c_str());
+        argvlen.push_back(maxLenStr.size());
+    }
+    argv.push_back(autoId);
+    argvlen.push_back(sizeof(autoId) - 1);
+    for (const auto& it : values) {
+        argv.push_back(it.field.data());
+        argvlen.push_back(it.field.size());
+        argv.push_back(it.value.data());
+        argvlen.push_back(it.value.size());
+    }
+
+    int i = 0;
+    redisReply* pReply = nullptr;
+    while (i++ < 2) {
+        pReply = (redisReply*)redisCommandArgv(m_pRedisContext, argv.size(), &(argv[0]), &(argvlen[0]));
+        if (isReplySuccess(pReply) == true && REDIS_REPLY_STRING == pReply->type) {
+            break;
+        }
+
+        LOGE << "failed to excute xadd key: " << key
+             << ", (error: " << getReplyError(pReply) << ")";
+
+        freeReplyObject(pReply);
+        if ((i >= 2) || (reConnectRedis() == false)) {
+            return false;
+        }
+    }
+
+    id.assign(pReply->str, pReply->len);
+    freeReplyObject(pReply);
+    return true;
+}
+
+bool RedisConn::xgroupCreate(const std::string& key, const std::string& group)
+{
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    int i = 0;
+    redisReply* pReply = nullptr;
+    while (i++ < 2) {
+        pReply = static_cast<redisReply*>(redisCommand(m_pRedisContext, "XGROUP CREATE %b %b 0 MKSTREAM",
+                                                       key.c_str(), key.size(), group.c_str(), group.size()));
+        if (isReplySuccess(pReply) == true) {
+            break;
+        }
+
+        // the group was created before, by us or by a previous master
+        if (nullptr != pReply && REDIS_REPLY_ERROR == pReply->type
+                && getReplyError(pReply).compare(0, 9, "BUSYGROUP") == 0) {
+            break;
+        }
+
+        LOGE << "failed to excute xgroup create key: " << key
+             << ", (error: " << getReplyError(pReply) << ")"
+             << ", group: " << group;
+
+        freeReplyObject(pReply);
+        if ((i >= 2) || (reConnectRedis() == false)) {
+            return false;
+        }
+    }
+
+    freeReplyObject(pReply);
+    return true;
+}
+
+bool RedisConn::xreadgroup(const std::string& key, const std::string& group, const std::string& consumer,
+                           const std::string& startId, uint32_t count, int32_t blockMillis,
+                           std::vector<RedisStreamEntry>& entries)
+{
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    std::ostringstream ssCmdStr;
+    ssCmdStr << "XREADGROUP GROUP %b %b COUNT " << count;
+    if (blockMillis > 0) {
+        ssCmdStr << " BLOCK " << blockMillis;
+    }
+    ssCmdStr << " STREAMS %b %b";
+
+    // a blocking read that times out replies nil, which is not an error, so no retry here
+    redisReply* pReply = static_cast<redisReply*>(redisCommand(m_pRedisContext, ssCmdStr.str().c_str(),
+                                                               group.c_str(), group.size(),
+                                                               consumer.c_str(), consumer.size(),
+                                                               key.c_str(), key.size(),
+                                                               startId.c_str(), startId.size()));
+    if (isReplySuccess(pReply) == false) {
+        LOGE << "failed to excute xreadgroup key: " << key
+             << ", (error: " << getReplyError(pReply) << ")"
+             << ", group: " << group << ", consumer: " << consumer << ", id: " << startId;
+        // keep the connection if redis itself answered with an error, e.g. NOGROUP
+        bool isConnLost = (nullptr == pReply || REDIS_REPLY_ERROR != pReply->type);
+        freeReplyObject(pReply);
+        if (isConnLost) {
+            freeConnect();
+        }
+        return false;
+    }
+
+    // result format: [[key, [[id, [field1, value1, ...]], ...]]]
+    if (REDIS_REPLY_ARRAY == pReply->type) {
+        for (size_t s = 0; s < pReply->elements; ++s) {
+            redisReply* stream = pReply->element[s];
+            if (REDIS_REPLY_ARRAY != stream->type || stream->elements != 2
+                    || REDIS_REPLY_ARRAY != stream->element[1]->type) {
+                continue;
+            }
+            redisReply* items = stream->element[1];
+            for (size_t e = 0; e < items->elements; ++e) {
+                redisReply* item = items->element[e];
+                if (REDIS_REPLY_ARRAY != item->type || item->elements != 2) {
+                    continue;
+                }
+                RedisStreamEntry entry;
+                entry.id.assign(item->element[0]->str, item->element[0]->len);
+                // fields are nil for entries trimmed out of the stream while still pending
+                redisReply* fields = item->element[1];
+                if (REDIS_REPLY_ARRAY == fields->type) {
+                    for (size_t f = 0; f + 1 < fields->elements; f += 2) {
+                        entry.fields.emplace(std::string(fields->element[f]->str, fields->element[f]->len),
+                                             std::string(fields->element[f + 1]->str, fields->element[f + 1]->len));
+                    }
+                }
+                entries.emplace_back(std::move(entry));
+            }
+        }
+    }
+
+    freeReplyObject(pReply);
+    m_dwLastActiveTime = nowInMilli();
+    return true;
+}
+
+bool RedisConn::xack(const std::string& key, const std::string& group, const std::vector<std::string>& ids)
+{
+    if (ids.empty()) {
+        return false;
+    }
+
+    if (m_pRedisContext == nullptr) {
+        if (reConnectRedis() == false) {
+            return false;
+        }
+    }
+
+    std::vector<const char *> argv( ids.size() + 3 );
+    std::vector<size_t> argvlen( ids.size() + 3 );
+
+    uint32_t j = 0;
+    static char xackCmd[] = "XACK";
+    argv[j] = xackCmd;
+    argvlen[j] = sizeof(xackCmd)-1;
+
+    j++;
+    argv[j] = key.c_str();
+    argvlen[j] = key.size();
+
+    j++;
+    argv[j] = group.c_str();
+    argvlen[j] = group.size();
+
+    for (const auto& it : ids) {
+        j++;
+        argv[j] = it.data();
+        argvlen[j] = it.size();
+    }
+
+    int i = 0;
+    redisReply* pReply = nullptr;
+    while (i++ < 2) {
+        pReply = (redisReply*)redisCommandArgv(m_pRedisContext, argv.size(), &(argv[0]), &(argvlen[0]));
+        if (isReplySuccess(pReply) == true) {
+            break;
+        }
+
+        LOGE << "failed to excute xack key: " << key
+             << ", (error: " << getReplyError(pReply) << ")"
+             << ", group: " << group << ", ids: " << toString(ids);
+
+        freeReplyObject(pReply);
+        if ((i >= 2) || (reConnectRedis() == false)) {
+            return false;
+        }
+    }
+
+    freeReplyObject(pReply);
+    return true;
+}
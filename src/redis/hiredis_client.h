@@ -12,6 +12,9 @@
 #include <hiredis/async.h>
 #include <config/redis_config.h>
 #include <mutex>
+#include <deque>
+#include <boost/fiber/mutex.hpp>
+#include <boost/fiber/condition_variable.hpp>
 #include "iasync_redis_event.h"
 
 namespace bcm{
@@ -28,6 +31,23 @@ struct ZSetMemberScore {
     int64_t     score;
 };
 
+// Reply of one pipelined command
+struct RedisCmdResult {
+    // false for error replies and for commands that did not run
+    bool ok{false};
+    int type{0};    // REDIS_REPLY_*
+    long long integer{0};
+    // string, status and error replies
+    std::string str;
+    // array replies of bulk strings, nil elements are empty
+    std::vector<std::string> elements;
+};
+
+struct RedisStreamEntry {
+    std::string id;
+    std::map<std::string, std::string> fields;
+};
+
 class RedisConn {
 public:
     RedisConn(const std::string& host, const int port, const std::string& password);
@@ -67,6 +87,10 @@ public:
     // zset/sortset
     bool zadd(const std::string& key, const std::string& mem, const int64_t& score);
     bool zrem(const std::string& key, const std::vector<std::string>& memberList);
+    // HSET hkey mem value and ZADD zkey score mem in one pipelined round trip,
+    // the hash is written first so a reader of the zset always finds it
+    bool hsetZadd(const std::string& hkey, const std::string& value,
+                  const std::string& zkey, const std::string& mem, const int64_t& score);
 
     bool getMemsByScoreWithLimit(
             const std::string& key,
@@ -76,12 +100,33 @@ public:
             const uint32_t limit,
             std::vector<ZSetMemberScore>& mems);
 
+    // stream
+    // XADD key MAXLEN ~ maxLen * field value ..., maxLen 0 means no trimming
+    bool xadd(const std::string& key, const std::vector<HField>& values, uint32_t maxLen, std::string& id);
+    // creates the consumer group, and the stream if missing; an existing group is not an error
+    bool xgroupCreate(const std::string& key, const std::string& group);
+    // startId ">" reads new entries, "0" re-reads the consumer's pending (delivered, unacked) ones;
+    // blockMillis 0 does not block, it must stay below the connection's socket timeout
+    bool xreadgroup(const std::string& key, const std::string& group, const std::string& consumer,
+                    const std::string& startId, uint32_t count, int32_t blockMillis,
+                    std::vector<RedisStreamEntry>& entries);
+    bool xack(const std::string& key, const std::string& group, const std::vector<std::string>& ids);
+
     // pub/sub
     bool pubsub(const std::string& strTopic, std::set<std::string>& setTopics);
     bool publishRes(const std::string& channel, const std::string& message);
     bool publishBatch(std::set<std::string>& setCmds);
 
 
+    // sends all commands in one round trip, wrapped in MULTI/EXEC if 'multi' is set;
+    // false on a communication error, error replies only fail their own result
+    bool pipeline(const std::vector<std::vector<std::string>>& cmds, bool multi,
+                  std::vector<RedisCmdResult>& results);
+    // the two halves of pipeline, so requests to several servers can be in flight at once;
+    // a failed send leaves nothing to receive
+    bool pipelineSend(const std::vector<std::vector<std::string>>& cmds, bool multi);
+    bool pipelineReceive(size_t numOfCmds, bool multi, std::vector<RedisCmdResult>& results);
+
     bool redisCmdArgs0(const std::string& strCmd);
     bool redisCmdArgs1(const std::string& strCmd, const char* pchKey, int nKeySize);
     bool redisCmdArgs2(const std::string& strCmd, const char* pchKey, int nKeySize, const char* pchValue, int nValueSize);
@@ -114,6 +159,8 @@ public:
 
     bool connectRedis();
     uint32_t info_uptime();
+    // PING without retrying, a failure closes the connection
+    bool ping();
 
 private:
     bool reConnectRedis();
@@ -132,28 +179,82 @@ private:
     redisContext* m_pRedisContext;
 };
 
+// Connection pool of one redis server.
+// At most maxConns connections are open, borrowers wait in FIFO order for one to be returned
+// (fiber-aware, other fibers of the thread keep running) and get nullptr after maxWaitInMilli.
+// Idle connections are pinged before being lent out once idle for validateAfterInMilli,
+// and closed by maintainPool() once idle for maxIdleInMilli.
 class RedisServer{
 public:
+    struct PoolStats {
+        uint32_t total{0};
+        uint32_t idle{0};
+        uint32_t inUse{0};
+        uint32_t waiters{0};
+        uint32_t peakInUse{0};
+        uint64_t created{0};
+        uint64_t closed{0};
+        // borrows that had to wait, and those of them that timed out
+        uint64_t waits{0};
+        uint64_t waitTimeouts{0};
+        int64_t waitMicros{0};
+    };
+
     RedisServer(const std::string& host, const int port, const std::string& password, const std::string& keepaliveKey);
     ~RedisServer() {}
 
-    std::shared_ptr<RedisConn> getRedisConn();
+    // applies to servers created afterwards
+    static void setDefaultPoolConfig(const RedisPoolConfig& config);
+    // report pool gauges and wait times to MetricsClient, which must be initialized
+    static void enablePoolMetrics();
+
+    void setPoolConfig(const RedisPoolConfig& config);
+
+    // nullptr if no connection could be opened or the wait timed out. isExhausted tells the
+    // two apart: a server whose pool stays busy is slow, not gone, callers must not fail over
+    std::shared_ptr<RedisConn> getRedisConn(bool* isExhausted = nullptr);
+    // every connection from getRedisConn() must be returned here, also after a failed command
     void freeRedisConn(std::shared_ptr<RedisConn> pRedisConn);
     void syncRedisKeepAlive();
+    // closes connections idle longer than maxIdleInMilli and reports the pool metrics
+    void maintainPool();
+    PoolStats poolStats();
 
     std::string getRedisHost() { return m_redisHost; }
     int getRedisPort() { return m_redisPort; }
     std::string getRedisPassword() { return m_redisPassword;}
 	std::string getKeepaliveKey() { return m_keepaliveKey;}
 
+private:
+    struct IdleConn {
+        std::shared_ptr<RedisConn> conn;
+        int64_t idleSince;
+    };
+
+    struct Waiter {
+        boost::fibers::condition_variable cv;
+        std::shared_ptr<RedisConn> conn;
+        // a connection was closed, the waiter opens a new one in its place
+        bool slot{false};
+    };
+
+    // the caller holds m_poolMutex, 'conn' nullptr gives the slot of a closed connection
+    bool handOver(std::shared_ptr<RedisConn> conn);
+    void dropRedisConn();
+    void markWait(int64_t waitMicros, bool timeout);
+
 private:
     std::string m_redisHost;
     int m_redisPort;
     std::string m_redisPassword;
 	std::string m_keepaliveKey;
 
-    std::recursive_mutex m_mutexConnectList;
-    std::list<std::shared_ptr<RedisConn>> m_redisConnList;
+    boost::fibers::mutex m_poolMutex;
+    RedisPoolConfig m_poolConfig;
+    // most recently returned first
+    std::list<IdleConn> m_idleConns;
+    std::deque<Waiter*> m_waiters;
+    PoolStats m_poolStats;
 };
 
 class RedisClientSync {
@@ -182,6 +283,9 @@ public:
 	void setRedisConfig(const std::vector<RedisConfig>& redisHosts);
     bool setRedisConfig(const std::map<int32_t, RedisConfig>& redisHosts);
 
+    // RedisServer::maintainPool() of every server
+    void maintainPools();
+
     //redis sync api.
     // string
     bool set(const std::string& key, const std::string& value, const int extime = 0);
@@ -274,6 +378,15 @@ public:
             const uint32_t limit,
             std::vector<ZSetMemberScore>& mems);
 
+    // stream
+    bool xgroupCreate(int32_t dbIndex, const std::string& key, const std::string& group);
+    bool xreadgroup(int32_t dbIndex, const std::string& key,
+                    const std::string& group, const std::string& consumer,
+                    const std::string& startId, uint32_t count, int32_t blockMillis,
+                    std::vector<RedisStreamEntry>& entries);
+    bool xack(int32_t dbIndex, const std::string& key,
+              const std::string& group, const std::vector<std::string>& ids);
+
     // Return
     //     -1: communication error
     //      0: key is not a valid integer
@@ -2,29 +2,61 @@
 #include <event2/event.h>
 #include "redis/reply.h"
 #include <hiredis/hiredis.h>
+#include <atomic>
 #include <list>
 #include "utils/thread_utils.h"
 #include "utils/libevent_utils.h"
+#include "utils/time.h"
 #include "metrics_client.h"
 
 namespace bcm {
 
+// off in the processes which only follow the online redis and never init MetricsClient
+static std::atomic<bool> gs_metrics(false);
+
+static void markMetrics(const std::string& topic, int64_t duration, int retCode)
+{
+    if (!gs_metrics) {
+        return;
+    }
+    metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
+                                                                  topic, duration, retCode);
+}
+
 class RedisPartition {
     struct RedisAsyncConn {
         public:
         AsyncConn asyncConn;
         uint32_t priority;
+        // bumped on every (dis)connect, a resubscribe of an older round stops
+        uint64_t resubscribeRound{0};
         RedisAsyncConn(struct event_base* eb, const std::string& host, 
               int32_t port, const std::string& password, uint32_t pri)
               : asyncConn(eb, host, port, password)
               , priority(pri) {}
     };
 
-    typedef std::unordered_map<std::string, AsyncConn::ISubscriptionHandler*> ChanHandlerMap;
+    // ordered, a resubscribe walks it in steps and resumes after the last channel sent
+    typedef std::map<std::string, AsyncConn::ISubscriptionHandler*> ChanHandlerMap;
     typedef std::map<uint32_t, std::shared_ptr<RedisAsyncConn>> RedisAsyncConnMap;
 
     //static constexpr int32_t kPublishMaxtTryTimes = 2;
 
+    // bounds of a single multi-channel SUBSCRIBE
+    static constexpr size_t kSubscribeBatchChannels = 1000;
+    static constexpr size_t kSubscribeBatchBytes = 64 * 1024;
+
+    struct ResubscribeCursor {
+        uint64_t round;
+        int64_t startTime;
+        bool pattern{false};
+        bool started{false};
+        std::string lastChan;
+        size_t channels{0};
+    };
+
+    struct event_base* m_eb;
+
     RedisAsyncConnMap m_allSubConnections;
     RedisAsyncConnMap m_availableSubConns;
     std::shared_timed_mutex m_subConnMutex;
@@ -42,7 +74,8 @@ class RedisPartition {
 public:
     RedisPartition(struct event_base* eb, const std::vector<RedisConfig>& partitionRedis,
                    std::string partitionName)
-                   : m_partitionName(partitionName)
+                   : m_eb(eb)
+                   , m_partitionName(partitionName)
     {
         if (partitionRedis.empty()) {
             return;
@@ -92,10 +125,7 @@ public:
             if (m_availableSubConns.empty()) {
                 LOGE << "online redis manager partition '" << m_partitionName 
                      << "' no available redis for unsubscribe: " << chan;
-                metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
-                                                                              kOnlineRedisTopicName,
-                                                                              0,
-                                                                              10001);
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
                 return false;
             }
 
@@ -123,10 +153,7 @@ public:
             if (m_availableSubConns.empty()) {
                 LOGE << "online redis manager partition '" << m_partitionName 
                      << "' no available redis for punsubscribe: " << chan;
-                metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
-                                                                              kOnlineRedisTopicName,
-                                                                              0,
-                                                                              10001);
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
                 return false;
             }
 
@@ -151,10 +178,7 @@ public:
             if (m_availableSubConns.empty()) {
                 LOGE << "online redis manager partition '" << m_partitionName 
                      << "' no available redis for subscribe: " << chan;
-                metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
-                                                                              kOnlineRedisTopicName,
-                                                                              0,
-                                                                              10001);
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
                 return false;
             }
 
@@ -166,6 +190,64 @@ public:
         return true;
     }
 
+    bool subscribeBatch(const std::vector<std::string>& chans, AsyncConn::ISubscriptionHandler* handler)
+    {
+        {
+            std::unique_lock<std::shared_timed_mutex> l(m_chanMutex);
+            for (const auto& chan : chans) {
+                m_subChansMap[chan] = handler;
+            }
+        }
+
+        {
+            std::shared_lock<std::shared_timed_mutex> l(m_subConnMutex);
+
+            if (m_availableSubConns.empty()) {
+                LOGE << "online redis manager partition '" << m_partitionName
+                     << "' no available redis for subscribe " << chans.size() << " channels";
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
+                return false;
+            }
+
+            for (const auto& batch : splitBatch(chans)) {
+                for (auto& c : m_availableSubConns) {
+                    c.second->asyncConn.subscribeBatch(batch, handler);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool unsubscribeBatch(const std::vector<std::string>& chans)
+    {
+        {
+            std::unique_lock<std::shared_timed_mutex> l(m_chanMutex);
+            for (const auto& chan : chans) {
+                m_subChansMap.erase(chan);
+            }
+        }
+
+        {
+            std::shared_lock<std::shared_timed_mutex> l(m_subConnMutex);
+
+            if (m_availableSubConns.empty()) {
+                LOGE << "online redis manager partition '" << m_partitionName
+                     << "' no available redis for unsubscribe " << chans.size() << " channels";
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
+                return false;
+            }
+
+            for (const auto& batch : splitBatch(chans)) {
+                for (auto& c : m_availableSubConns) {
+                    c.second->asyncConn.unsubscribeBatch(batch);
+                }
+            }
+        }
+
+        return true;
+    }
+
     bool psubscribe(const std::string& chan, AsyncConn::ISubscriptionHandler* handler)
     {
         {
@@ -179,10 +261,7 @@ public:
             if (m_availableSubConns.empty()) {
                 LOGE << "online redis manager partition '" << m_partitionName 
                      << "' no available redis for psubscribe: " << chan;
-                metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
-                                                                              kOnlineRedisTopicName,
-                                                                              0,
-                                                                              10001);
+                markMetrics(kOnlineRedisTopicName, 0, 10001);
                 return false;
             }
 
@@ -218,6 +297,7 @@ private:
                 std::unique_lock<std::shared_timed_mutex> l(m_subConnMutex);
                 m_availableSubConns.erase(conn->priority);
             }
+            ++conn->resubscribeRound;
             LOGW << "online redis manager for sub disconnect, partition: " << m_partitionName 
                  << ", ip: " << conn->asyncConn.getRedisHost()
                  << ", port: " << conn->asyncConn.getRedisPort();
@@ -299,6 +379,26 @@ private:
         m_allPubConnections[conn->priority] = conn;
     }
 
+    static bool isBatchFull(size_t channels, size_t bytes, const std::string& next)
+    {
+        return channels >= kSubscribeBatchChannels || (channels > 0 && bytes + next.size() > kSubscribeBatchBytes);
+    }
+
+    static std::vector<std::vector<std::string>> splitBatch(const std::vector<std::string>& chans)
+    {
+        std::vector<std::vector<std::string>> batches;
+        size_t bytes = 0;
+        for (const auto& chan : chans) {
+            if (batches.empty() || isBatchFull(batches.back().size(), bytes, chan)) {
+                batches.emplace_back();
+                bytes = 0;
+            }
+            batches.back().push_back(chan);
+            bytes += chan.size();
+        }
+        return batches;
+    }
+
     void onSubConnect(std::shared_ptr<RedisAsyncConn> conn)
     {
         {
@@ -306,20 +406,75 @@ private:
             m_availableSubConns[conn->priority] = conn;
         }
 
-        ChanHandlerMap subChanTmp, psubChanTmp;                
+        // channels subscribed from now on reach conn directly, the rest is sent
+        // back in bounded batches, one per event loop turn
+        auto cursor = std::make_shared<ResubscribeCursor>();
+        cursor->round = ++conn->resubscribeRound;
+        cursor->startTime = nowInMicro();
+        resubscribeStep(conn, cursor);
+    }
+
+    // runs on the event loop, as the (re)connect and disconnect handlers do
+    void resubscribeStep(std::shared_ptr<RedisAsyncConn> conn, std::shared_ptr<ResubscribeCursor> cursor)
+    {
+        if (cursor->round != conn->resubscribeRound) {
+            LOGW << "online redis manager partition '" << m_partitionName << "' resubscribe to "
+                 << conn->asyncConn.getRedisHost() << ":" << conn->asyncConn.getRedisPort()
+                 << " interrupted after " << cursor->channels << " channels";
+            return;
+        }
+
+        std::vector<std::string> batch;
+        AsyncConn::ISubscriptionHandler* handler = nullptr;
+        size_t bytes = 0;
+        bool end = false;
         {
             std::shared_lock<std::shared_timed_mutex> l(m_chanMutex);
-            subChanTmp = m_subChansMap;
-            psubChanTmp = m_psubChansMap;
+            const ChanHandlerMap& chans = cursor->pattern ? m_psubChansMap : m_subChansMap;
+            auto itr = cursor->started ? chans.upper_bound(cursor->lastChan) : chans.begin();
+            for (; itr != chans.end(); ++itr) {
+                // one command carries a single handler
+                if (handler != nullptr
+                    && (itr->second != handler || isBatchFull(batch.size(), bytes, itr->first))) {
+                    break;
+                }
+                handler = itr->second;
+                batch.push_back(itr->first);
+                bytes += itr->first.size();
+            }
+            end = (itr == chans.end());
         }
 
-        for (auto& chan : subChanTmp) {
-            conn->asyncConn.subscribe(chan.first, chan.second);
+        if (!batch.empty()) {
+            cursor->started = true;
+            cursor->lastChan = batch.back();
+            cursor->channels += batch.size();
+            if (cursor->pattern) {
+                for (const auto& chan : batch) {
+                    conn->asyncConn.psubscribe(chan, handler);
+                }
+            } else {
+                conn->asyncConn.subscribeBatch(batch, handler);
+            }
         }
 
-        for (auto &chan : psubChanTmp) {
-            conn->asyncConn.psubscribe(chan.first, chan.second);
+        if (end) {
+            if (cursor->pattern) {
+                int64_t duration = nowInMicro() - cursor->startTime;
+                markMetrics(kOnlineRedisResubscribeTopicName, duration, 0);
+                LOGI << "online redis manager partition '" << m_partitionName << "' resubscribed "
+                     << cursor->channels << " channels to " << conn->asyncConn.getRedisHost() << ":"
+                     << conn->asyncConn.getRedisPort() << " in " << duration << "us";
+                return;
+            }
+            cursor->pattern = true;
+            cursor->started = false;
+            cursor->lastChan.clear();
         }
+
+        libevent::AsyncFunc::invoke(m_eb, [this, conn, cursor]() {
+            resubscribeStep(conn, cursor);
+        });
     }
 
     bool tryPublish(RedisAsyncConnMap& connMap, const std::string& chan,
@@ -338,10 +493,7 @@ private:
             LOGE << "partition '" << m_partitionName << "' no available redis for publish: " << chan
                 << ", message: " << msg;
             handler(REDIS_ERR, Reply());
-            metrics::MetricsClient::Instance()->markMicrosecondAndRetCode(kOnlineRedisServiceName,
-                                                                          kOnlineRedisTopicName,
-                                                                          0,
-                                                                          10001);
+            markMetrics(kOnlineRedisTopicName, 0, 10001);
             return false;
         }
 
@@ -386,6 +538,11 @@ OnlineRedisManager::~OnlineRedisManager()
     m_eb = nullptr;
 }
 
+void OnlineRedisManager::enableMetrics()
+{
+    gs_metrics = true;
+}
+
 bool OnlineRedisManager::init(const Partition2RedisCfgMap& redisConfig)
 {
     if (redisConfig.empty()) {
@@ -402,6 +559,11 @@ bool OnlineRedisManager::init(const Partition2RedisCfgMap& redisConfig)
         auto partition = std::make_shared<RedisPartition>(m_eb, pcfg.second, pcfg.first);
         m_partitions[pcfg.first] = partition;
         m_consistentHash.AddServer(pcfg.first);
+        size_t node = m_consistentHash.FindNode(pcfg.first);
+        if (m_nodePartitions.size() <= node) {
+            m_nodePartitions.resize(node + 1);
+        }
+        m_nodePartitions[node] = partition;
     }
 
     return true;
@@ -435,17 +597,12 @@ void OnlineRedisManager::runKeepAlive()
 
 std::shared_ptr<RedisPartition> OnlineRedisManager::getPartitionByHashKey(const std::string hashKey)
 {
-    std::string partitionName = m_consistentHash.GetServer(hashKey);
-    if ("" == partitionName) {
+    int32_t node = m_consistentHash.GetNode(hashKey);
+    if (node < 0) {
         return nullptr;
     }
 
-    auto itr = m_partitions.find(partitionName);
-    if (itr == m_partitions.end()) {
-        return nullptr;
-    }
-
-    return itr->second;
+    return m_nodePartitions[node];
 }
 
 bool OnlineRedisManager::subscribe(const std::string& hashKey, const std::string& chan,
@@ -466,6 +623,47 @@ bool OnlineRedisManager::subscribe(const std::string& chan, AsyncConn::ISubscrip
     return subscribe(chan, chan, handler);
 }
 
+bool OnlineRedisManager::subscribeBatch(const std::vector<std::string>& chans,
+                                        AsyncConn::ISubscriptionHandler* handler)
+{
+    std::map<std::shared_ptr<RedisPartition>, std::vector<std::string>> partitionChans;
+    bool ok = true;
+    for (const auto& chan : chans) {
+        auto partition = getPartitionByHashKey(chan);
+        if (nullptr == partition) {
+            LOGE << "online redis manager no partition for subscribe: " << chan;
+            ok = false;
+            continue;
+        }
+        partitionChans[partition].push_back(chan);
+    }
+
+    for (const auto& p : partitionChans) {
+        ok = p.first->subscribeBatch(p.second, handler) && ok;
+    }
+    return ok;
+}
+
+bool OnlineRedisManager::unsubscribeBatch(const std::vector<std::string>& chans)
+{
+    std::map<std::shared_ptr<RedisPartition>, std::vector<std::string>> partitionChans;
+    bool ok = true;
+    for (const auto& chan : chans) {
+        auto partition = getPartitionByHashKey(chan);
+        if (nullptr == partition) {
+            LOGE << "online redis manager no partition for unsubscribe: " << chan;
+            ok = false;
+            continue;
+        }
+        partitionChans[partition].push_back(chan);
+    }
+
+    for (const auto& p : partitionChans) {
+        ok = p.first->unsubscribeBatch(p.second) && ok;
+    }
+    return ok;
+}
+
 bool OnlineRedisManager::psubscribe(const std::string& hashKey, const std::string& chan, 
                                     AsyncConn::ISubscriptionHandler* handler)
 {
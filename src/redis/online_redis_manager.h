@@ -7,6 +7,7 @@
 #include <map>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace bcm {
 
@@ -17,6 +18,7 @@ class RedisPartition;
 static const std::string kKeepAliveChannel = "onlineRedis:keepAlive";
 static const std::string kOnlineRedisServiceName = "OnlineRedisService";
 static const std::string kOnlineRedisTopicName = "availability";
+static const std::string kOnlineRedisResubscribeTopicName = "resubscribe";
 
 class OnlineRedisManager {
 typedef std::map<std::string, std::vector<RedisConfig>> Partition2RedisCfgMap;
@@ -31,11 +33,17 @@ public:
         return &gs_instance;
     }
 
+    // report failures and resubscriptions to MetricsClient, which must be initialized
+    static void enableMetrics();
+
     bool init(const Partition2RedisCfgMap& redisConfig);
     void start();
 
     bool subscribe(const std::string& chan, AsyncConn::ISubscriptionHandler* handler);
     bool subscribe(const std::string& hashKey, const std::string& chan, AsyncConn::ISubscriptionHandler* handler);
+    // channels are hashed by themselves and sent in bounded multi-channel commands
+    bool subscribeBatch(const std::vector<std::string>& chans, AsyncConn::ISubscriptionHandler* handler);
+    bool unsubscribeBatch(const std::vector<std::string>& chans);
     bool psubscribe(const std::string& chan, AsyncConn::ISubscriptionHandler* handler);
     bool psubscribe(const std::string& hashKey, const std::string& chan, AsyncConn::ISubscriptionHandler* handler);
 
@@ -68,6 +76,8 @@ private:
     std::thread m_thread;
     std::unordered_map<std::string, std::shared_ptr<RedisPartition>> m_partitions;
     UserConsistentFnvHash m_consistentHash;
+    // node index on m_consistentHash -> partition
+    std::vector<std::shared_ptr<RedisPartition>> m_nodePartitions;
 };
 
 }
\ No newline at end of file
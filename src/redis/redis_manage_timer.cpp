@@ -11,6 +11,9 @@ void RedisManageTimer::run()
     int64_t start = nowInMilli();
     
     m_redisDbManager->updateRedisConnPeriod();
+    RedisClientSync::Instance()->maintainPools();
+    RedisClientSync::OnlineInstance()->maintainPools();
+    RedisClientSync::OfflineInstance()->maintainPools();
 
     m_execTime = nowInMilli() - start;
 }
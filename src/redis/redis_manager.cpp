@@ -32,6 +32,11 @@ bool RedisDbManager::setRedisDbConfig(const RedisPartitionMap& redisDbConfig)
         m_redisPartitions[partition.first] = redisConns;
         m_currPartitionConn[partition.first] = 0;
         m_consistentHash.AddServer(partition.first);
+        size_t node = m_consistentHash.FindNode(partition.first);
+        if (m_partitionNames.size() <= node) {
+            m_partitionNames.resize(node + 1);
+        }
+        m_partitionNames[node] = partition.first;
     }
     return true;
 }
@@ -48,7 +53,8 @@ bool RedisDbManager::hset(uint64_t gid, const std::string& key, const std::strin
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->redisCmdArgs3(
                     std::string("HSET"),
@@ -62,6 +68,9 @@ bool RedisDbManager::hset(uint64_t gid, const std::string& key, const std::strin
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -80,7 +89,8 @@ bool RedisDbManager::hmset(uint64_t gid, const std::string& key, const std::vect
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->hmset(key, values);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -90,6 +100,9 @@ bool RedisDbManager::hmset(uint64_t gid, const std::string& key, const std::vect
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -108,7 +121,8 @@ bool RedisDbManager::hget(uint64_t gid, const std::string& key, const std::strin
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->hget(key, field, value);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -118,6 +132,9 @@ bool RedisDbManager::hget(uint64_t gid, const std::string& key, const std::strin
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -139,7 +156,8 @@ bool RedisDbManager::hmget(uint64_t gid,
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->hmget(key, fields, mapFieldValue);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -149,6 +167,9 @@ bool RedisDbManager::hmget(uint64_t gid,
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -167,7 +188,8 @@ bool RedisDbManager::hdel(uint64_t gid, const std::string& key, const std::vecto
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->hdel(key, fields);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -177,6 +199,9 @@ bool RedisDbManager::hdel(uint64_t gid, const std::string& key, const std::vecto
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -195,7 +220,8 @@ bool RedisDbManager::zadd(uint64_t gid, const std::string& key, const std::strin
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->zadd(key, mem, score);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -205,6 +231,75 @@ bool RedisDbManager::zadd(uint64_t gid, const std::string& key, const std::strin
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
+        ptrRedisServer = getNextRedis(partitionName);
+    } while (++loopCounter < numOfRedis);
+
+    return false;
+}
+
+bool RedisDbManager::hsetZadd(uint64_t gid, const std::string& hkey, const std::string& value,
+                              const std::string& zkey, const std::string& mem, const int64_t score)
+{
+    std::string  partitionName;
+    size_t numOfRedis;
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisByGid(gid, partitionName, numOfRedis);
+
+    size_t loopCounter = 0;
+    do {
+        if (nullptr == ptrRedisServer) {
+            return false;
+        }
+
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
+        if (nullptr != ptrRedisConn) {
+            bool isSuccess = ptrRedisConn->hsetZadd(hkey, value, zkey, mem, score);
+            ptrRedisServer->freeRedisConn(ptrRedisConn);
+
+            if (isSuccess) {
+                return isSuccess;
+            }
+        }
+
+        if (isExhausted) {
+            break;
+        }
+        ptrRedisServer = getNextRedis(partitionName);
+    } while (++loopCounter < numOfRedis);
+
+    return false;
+}
+
+bool RedisDbManager::xadd(uint64_t gid, const std::string& key, const std::vector<HField>& values, uint32_t maxLen)
+{
+    std::string  partitionName;
+    size_t numOfRedis;
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisByGid(gid, partitionName, numOfRedis);
+
+    size_t loopCounter = 0;
+    do {
+        if (nullptr == ptrRedisServer) {
+            return false;
+        }
+
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
+        if (nullptr != ptrRedisConn) {
+            std::string id;
+            bool isSuccess = ptrRedisConn->xadd(key, values, maxLen, id);
+            ptrRedisServer->freeRedisConn(ptrRedisConn);
+
+            if (isSuccess) {
+                return isSuccess;
+            }
+        }
+
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -214,11 +309,12 @@ bool RedisDbManager::zadd(uint64_t gid, const std::string& key, const std::strin
 std::shared_ptr<RedisServer> RedisDbManager::getRedisByGid(uint64_t gid,
                                                            std::string& outPartitionName, size_t& redisSize)
 {
-    outPartitionName  = m_consistentHash.GetServer(gid);
-    if ("" == outPartitionName) {
+    int32_t node = m_consistentHash.GetNode(gid);
+    if (node < 0) {
         LOGE << "partition name is empty in consistent hash !";
         return nullptr;
     }
+    outPartitionName = m_partitionNames[node];
 
     std::shared_lock<std::shared_timed_mutex> l(m_currPartitionConnMutex);
 
@@ -242,11 +338,12 @@ std::shared_ptr<RedisServer> RedisDbManager::getRedisByGid(uint64_t gid,
 std::shared_ptr<RedisServer> RedisDbManager::getRedisByKey(const std::string& hashKey,
                                                                std::string& outPartitionName, size_t& redisSize)
 {
-    outPartitionName  = m_consistentHash.GetServer(hashKey);
-    if ("" == outPartitionName) {
+    int32_t node = m_consistentHash.GetNode(hashKey);
+    if (node < 0) {
         LOGE << "partition name is empty in consistent hash !";
         return nullptr;
     }
+    outPartitionName = m_partitionNames[node];
 
     std::shared_lock<std::shared_timed_mutex> l(m_currPartitionConnMutex);
 
@@ -267,6 +364,143 @@ std::shared_ptr<RedisServer> RedisDbManager::getRedisByKey(const std::string& ha
     return partitionRedisVector[redisIndex];
 }
 
+std::shared_ptr<RedisServer> RedisDbManager::getRedisByPartition(const std::string& partitionName, size_t& redisSize)
+{
+    std::shared_lock<std::shared_timed_mutex> l(m_currPartitionConnMutex);
+
+    auto itRedisServer = m_redisPartitions.find(partitionName);
+    if (itRedisServer == m_redisPartitions.end()) {
+        return nullptr;
+    }
+
+    std::vector<std::shared_ptr<RedisServer>>& partitionRedisVector = itRedisServer->second;
+    redisSize = partitionRedisVector.size();
+
+    int32_t redisIndex = 0;
+    auto itr = m_currPartitionConn.find(partitionName);
+    if (itr != m_currPartitionConn.end()) {
+        redisIndex = itr->second;
+    }
+
+    return partitionRedisVector[redisIndex];
+}
+
+bool RedisDbManager::pipeline(const std::vector<RedisDbCmd>& cmds, std::vector<RedisCmdResult>& results, bool multi)
+{
+    struct PartitionCmds {
+        std::vector<size_t> indexes;
+        std::vector<std::vector<std::string>> cmds;
+        std::vector<RedisCmdResult> results;
+        std::shared_ptr<RedisServer> server;
+        std::shared_ptr<RedisConn> conn;
+        size_t numOfRedis{0};
+        // the pool of the server timed out, no failover for that
+        bool isExhausted{false};
+        bool ok{false};
+    };
+
+    results.clear();
+    results.resize(cmds.size());
+
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        if (cmds[i].args.empty()) {
+            LOGE << "empty command " << i << " of " << cmds.size() << " in pipeline";
+            return false;
+        }
+    }
+
+    bool isSuccess = true;
+    // by node index of the partition
+    std::map<int32_t, PartitionCmds> partitions;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+        int32_t node = cmds[i].byGid ? m_consistentHash.GetNode(cmds[i].gid)
+                                     : m_consistentHash.GetNode(cmds[i].hashKey);
+        if (node < 0) {
+            LOGE << "partition name is empty in consistent hash !";
+            isSuccess = false;
+            continue;
+        }
+        PartitionCmds& p = partitions[node];
+        p.indexes.push_back(i);
+        p.cmds.push_back(cmds[i].args);
+    }
+
+    // every partition gets its request before any reply is read, so the round trips
+    // overlap on the calling thread. connections are borrowed in partition order and
+    // all of them are returned before any failover borrows again, so two callers never
+    // wait for each other's connections in a cycle
+    for (auto& p : partitions) {
+        p.second.server = getRedisByPartition(m_partitionNames[p.first], p.second.numOfRedis);
+        if (p.second.server == nullptr) {
+            continue;
+        }
+        p.second.conn = p.second.server->getRedisConn(&p.second.isExhausted);
+        if (p.second.conn != nullptr && !p.second.conn->pipelineSend(p.second.cmds, multi)) {
+            p.second.server->freeRedisConn(p.second.conn);
+            p.second.conn = nullptr;
+        }
+    }
+    for (auto& p : partitions) {
+        if (p.second.conn != nullptr) {
+            p.second.ok = p.second.conn->pipelineReceive(p.second.cmds.size(), multi, p.second.results);
+            p.second.server->freeRedisConn(p.second.conn);
+            p.second.conn = nullptr;
+        }
+    }
+    for (auto& p : partitions) {
+        if (!p.second.ok && !p.second.isExhausted && p.second.numOfRedis > 1) {
+            // the failover of the partition goes on with the next redis
+            const std::string& partitionName = m_partitionNames[p.first];
+            getNextRedis(partitionName);
+            p.second.ok = pipelinePartition(partitionName, p.second.cmds, multi, p.second.results, 1);
+        }
+    }
+
+    for (auto& p : partitions) {
+        if (!p.second.ok) {
+            isSuccess = false;
+            continue;
+        }
+        for (size_t i = 0; i < p.second.indexes.size(); ++i) {
+            results[p.second.indexes[i]] = std::move(p.second.results[i]);
+        }
+    }
+    return isSuccess;
+}
+
+bool RedisDbManager::pipelinePartition(const std::string& partitionName,
+                                       const std::vector<std::vector<std::string>>& cmds,
+                                       bool multi, std::vector<RedisCmdResult>& results, size_t tried)
+{
+    size_t numOfRedis = 0;
+    std::shared_ptr<RedisServer> ptrRedisServer = getRedisByPartition(partitionName, numOfRedis);
+
+    size_t loopCounter = tried;
+    do {
+        if (nullptr == ptrRedisServer) {
+            return false;
+        }
+
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
+        if (nullptr != ptrRedisConn) {
+            bool isSuccess = ptrRedisConn->pipeline(cmds, multi, results);
+            ptrRedisServer->freeRedisConn(ptrRedisConn);
+
+            if (isSuccess) {
+                return isSuccess;
+            }
+        }
+
+        if (isExhausted) {
+            break;
+        }
+        ptrRedisServer = getNextRedis(partitionName);
+    } while (++loopCounter < numOfRedis);
+
+    return false;
+}
+
 std::shared_ptr<RedisServer> RedisDbManager::getNextRedis(const std::string& partitionName)
 {
     std::unique_lock<std::shared_timed_mutex> l(m_currPartitionConnMutex);
@@ -305,7 +539,8 @@ int32_t RedisDbManager::incr(const std::string& hashKey, const std::string& key,
             return -1;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
 
             int32_t res = ptrRedisConn->incr(key, newValue);
@@ -316,6 +551,9 @@ int32_t RedisDbManager::incr(const std::string& hashKey, const std::string& key,
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -338,7 +576,8 @@ bool RedisDbManager::del(const std::string& hashKey, const std::string& key)
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
 
             bool res = ptrRedisConn->del(key);
@@ -349,6 +588,9 @@ bool RedisDbManager::del(const std::string& hashKey, const std::string& key)
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -371,7 +613,8 @@ int32_t RedisDbManager::expire(const std::string& hashKey, const std::string& ke
             return -1;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             int32_t res = ptrRedisConn->expire(key, timeout);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -381,6 +624,9 @@ int32_t RedisDbManager::expire(const std::string& hashKey, const std::string& ke
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -404,7 +650,8 @@ int32_t RedisDbManager::ttl(const std::string& hashKey, const std::string& key)
             return -1;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             int32_t res = ptrRedisConn->ttl(key);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -414,6 +661,9 @@ int32_t RedisDbManager::ttl(const std::string& hashKey, const std::string& key)
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -433,7 +683,8 @@ bool RedisDbManager::set(const std::string& hashKey, const std::string& key,
             return false;
         }
 
-        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn>  ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->set(key, value, exptime);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -443,6 +694,9 @@ bool RedisDbManager::set(const std::string& hashKey, const std::string& key,
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -466,7 +720,8 @@ bool RedisDbManager::get(const std::string& hashKey, const std::string& key, std
             return false;
         }
 
-        std::shared_ptr<RedisConn> ptrRedisConn = ptrRedisServer->getRedisConn();
+        bool isExhausted = false;
+        std::shared_ptr<RedisConn> ptrRedisConn = ptrRedisServer->getRedisConn(&isExhausted);
         if (nullptr != ptrRedisConn) {
             bool isSuccess = ptrRedisConn->get(key, value);
             ptrRedisServer->freeRedisConn(ptrRedisConn);
@@ -476,6 +731,9 @@ bool RedisDbManager::get(const std::string& hashKey, const std::string& key, std
             }
         }
 
+        if (isExhausted) {
+            break;
+        }
         ptrRedisServer = getNextRedis(partitionName);
     } while (++loopCounter < numOfRedis);
 
@@ -516,6 +774,12 @@ void RedisDbManager::updateRedisConnPeriod()
             }
         }
     }
+
+    for (auto& p : m_redisPartitions) {
+        for (auto& server : p.second) {
+            server->maintainPool();
+        }
+    }
 }
 
 } // namespace bcm
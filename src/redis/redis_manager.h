@@ -10,6 +10,25 @@
 namespace bcm
 {
 
+// A command of RedisDbManager::pipeline, routed to a partition by gid or by hashKey
+// like the single command calls
+struct RedisDbCmd {
+    bool byGid;
+    uint64_t gid;
+    std::string hashKey;
+    std::vector<std::string> args;
+
+    static RedisDbCmd gidCmd(uint64_t gid, std::vector<std::string> args)
+    {
+        return RedisDbCmd{true, gid, "", std::move(args)};
+    }
+
+    static RedisDbCmd keyCmd(const std::string& hashKey, std::vector<std::string> args)
+    {
+        return RedisDbCmd{false, 0, hashKey, std::move(args)};
+    }
+};
+
 class RedisDbManager {
     typedef std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig>> RedisPartitionMap;
 public:
@@ -32,6 +51,17 @@ public:
                std::map<std::string, std::string>& mapFieldValue);
     bool hdel(uint64_t gid, const std::string& key, const std::vector<std::string>& fields);
     bool zadd(uint64_t gid, const std::string& key, const std::string& mem, const int64_t score);  // score 作为引用
+    // pipelined HSET hkey mem value + ZADD zkey score mem
+    bool hsetZadd(uint64_t gid, const std::string& hkey, const std::string& value,
+                  const std::string& zkey, const std::string& mem, const int64_t score);
+    bool xadd(uint64_t gid, const std::string& key, const std::vector<HField>& values, uint32_t maxLen);
+
+    // The commands of each partition are sent as one pipelined request, to all partitions
+    // before any reply is read, and in a MULTI/EXEC transaction per partition if 'multi'
+    // is set. results[i] is the reply of cmds[i]; returns false if some partition could not
+    // be reached, its commands are left with ok == false. A batch with an empty command is
+    // rejected before anything is sent
+    bool pipeline(const std::vector<RedisDbCmd>& cmds, std::vector<RedisCmdResult>& results, bool multi = false);
 
     int32_t incr(const std::string& hashKey, const std::string& key, uint64_t& newValue);
     int32_t expire(const std::string& hashKey, const std::string& key, uint32_t timeout);
@@ -48,6 +78,7 @@ public:
     int32_t expire(const std::string& key, uint32_t timeout);
     int32_t ttl(const std::string& key);
 
+    // also maintains the connection pools
     void updateRedisConnPeriod();
 
 private:
@@ -55,12 +86,18 @@ private:
                                                std::string& outPartitionName, size_t& redisSize);
     std::shared_ptr<RedisServer> getRedisByKey(const std::string& hashKey,
                                                std::string& outPartitionName, size_t& redisSize);
+    std::shared_ptr<RedisServer> getRedisByPartition(const std::string& partitionName, size_t& redisSize);
     std::shared_ptr<RedisServer> getNextRedis(const std::string& partitionName);
+    // 'tried' redis of the partition already failed the commands
+    bool pipelinePartition(const std::string& partitionName, const std::vector<std::vector<std::string>>& cmds,
+                           bool multi, std::vector<RedisCmdResult>& results, size_t tried = 0);
 private:
     std::unordered_map<std::string, std::vector<std::shared_ptr<RedisServer>>> m_redisPartitions;
     std::unordered_map<std::string, int32_t> m_currPartitionConn;
     std::shared_timed_mutex m_currPartitionConnMutex;
     UserConsistentFnvHash m_consistentHash;
+    // node index on m_consistentHash -> partition
+    std::vector<std::string> m_partitionNames;
 };
 
 } // namespace bcm
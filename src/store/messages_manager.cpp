@@ -4,6 +4,12 @@
 namespace bcm {
 
 MessagesManager::MessagesManager() = default;
+
+MessagesManager::MessagesManager(std::shared_ptr<dao::StoredMessages> storedMessages)
+    : m_storedMessages(std::move(storedMessages))
+{
+}
+
 MessagesManager::~MessagesManager() = default;
 
 bool MessagesManager::store(const std::string& destination, uint32_t destinationDeviceId,
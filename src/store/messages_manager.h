@@ -11,6 +11,7 @@ namespace bcm {
 class MessagesManager {
 public:
     MessagesManager();
+    explicit MessagesManager(std::shared_ptr<dao::StoredMessages> storedMessages);
     ~MessagesManager();
 
     bool store(const std::string& destination, uint32_t destinationDeviceId, uint32_t destinationRegistrationId,
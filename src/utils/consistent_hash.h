@@ -3,15 +3,23 @@
 #include <sys/time.h>
 #include <time.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 #include <mutex>
 #include <shared_mutex>
 
 #include "utils/log.h"
+#include "utils/time.h"
 
 #define DEFAULTNUMBEROFREPLICAS 200
 
@@ -47,106 +55,213 @@ public:
     }
 };
 
+// Consistent hash ring of named servers with DEFAULTNUMBEROFREPLICAS virtual nodes each.
+// Every server gets a node index on its first AddServer(), it is kept for the lifetime of the
+// ring, also across RemoveServer() and Clear(), so callers can index their own tables with it.
+// Lookups are lock free: the ring is an immutable sorted array, membership changes build a new
+// one and publish it with an atomic pointer swap. Replaced rings are freed kRetireDelayInMilli
+// later, lookups never keep a ring beyond the call.
 class UserConsistentFnvHash
 {
+    struct Ring {
+        // sorted positions of the virtual nodes, and the node index of each
+        std::vector<uint32_t> hashes;
+        std::vector<int32_t> nodes;
+        // node index -> server, of every server ever added
+        std::vector<std::string> servers;
+    };
+
+    static constexpr int64_t kRetireDelayInMilli = 10000;
+
 public:
     UserConsistentFnvHash(uint32_t numberOfReplicas = DEFAULTNUMBEROFREPLICAS)
+        : numberOfReplicas(numberOfReplicas)
+        , m_ring(new Ring())
+    {
+    }
+
+    ~UserConsistentFnvHash()
     {
-        this->numberOfReplicas = numberOfReplicas;
+        delete m_ring.load();
     }
 
+    UserConsistentFnvHash(const UserConsistentFnvHash&) = delete;
+    UserConsistentFnvHash& operator=(const UserConsistentFnvHash&) = delete;
+
     void AddServer(const std::string& strServerIpport)
     {
-        char hashbuf[50] = {0};
-        //memcpy(hashbuf, strServerIpport.data(), strServerIpport.length());
-        snprintf(hashbuf, sizeof(hashbuf), "%s", strServerIpport.c_str());
-        
-        std::unique_lock<std::shared_timed_mutex> l(m_mutexCircle);
-        for (uint32_t i = 0; i < numberOfReplicas; i++) 
-        {
-            uint32_t strLen = strServerIpport.length();
-            if (strLen > sizeof(hashbuf)-sizeof(i)) {
-                strLen = sizeof(hashbuf)-sizeof(i);
-            }
-            memcpy(hashbuf + strLen, &i, sizeof(i));
-            uint32_t uValue = FnvHashFunction::hash(hashbuf, sizeof(hashbuf));
+        std::lock_guard<std::mutex> l(m_mutexUpdate);
+        int32_t node = nodeOf(strServerIpport);
+        if (std::find(m_members.begin(), m_members.end(), node) == m_members.end()) {
+            m_members.push_back(node);
+        }
+        publish();
+    }
+
+    void RemoveServer(const std::string& strServerIpport)
+    {
+        std::lock_guard<std::mutex> l(m_mutexUpdate);
+        auto it = m_serverNodes.find(strServerIpport);
+        if (it == m_serverNodes.end()) {
+            return;
+        }
+        m_members.erase(std::remove(m_members.begin(), m_members.end(), it->second), m_members.end());
+        publish();
+    }
 
-            std::map<uint32_t, std::string>::iterator iter = server_circle.find(uValue);
-            if (iter != server_circle.end())
-            {
-                LOGW << "server circle duplicate! server:" << strServerIpport << " index:" << i;
+    // replaces all servers at once, lookups never see a partial ring
+    void SetServers(const std::vector<std::string>& servers)
+    {
+        std::lock_guard<std::mutex> l(m_mutexUpdate);
+        m_members.clear();
+        for (const auto& server : servers) {
+            int32_t node = nodeOf(server);
+            if (std::find(m_members.begin(), m_members.end(), node) == m_members.end()) {
+                m_members.push_back(node);
             }
-            server_circle[uValue] = strServerIpport;
         }
+        publish();
     }
 
-    void RemoveServer(std::string& strServerIpport)
+    void Clear()
     {
-        char hashbuf[50]={0};
-        memcpy(hashbuf, strServerIpport.data(), strServerIpport.length());
+        std::lock_guard<std::mutex> l(m_mutexUpdate);
+        m_members.clear();
+        publish();
+    }
 
-        std::unique_lock<std::shared_timed_mutex> l(m_mutexCircle);
-        for (uint32_t i = 0; i < numberOfReplicas; i++)
-        {
-            memcpy(hashbuf + strServerIpport.length(), &i, sizeof(i));
-            uint32_t uValue = FnvHashFunction::hash(hashbuf, sizeof(hashbuf));
-            server_circle.erase(uValue);
-        }
+    // node index of the server of the key, -1 if the ring is empty
+    int32_t GetNode(uint64_t dwGroupid) const
+    {
+        return lookup(FnvHashFunction::hash(dwGroupid));
+    }
+
+    int32_t GetNode(const std::string& sHashKey) const
+    {
+        return lookup(FnvHashFunction::hash(sHashKey.data(), sHashKey.size()));
+    }
+
+    // node index of a server added before, -1 if it never was
+    int32_t FindNode(const std::string& strServerIpport) const
+    {
+        const Ring* ring = m_ring.load(std::memory_order_acquire);
+        auto it = std::find(ring->servers.begin(), ring->servers.end(), strServerIpport);
+        return it == ring->servers.end() ? -1 : static_cast<int32_t>(it - ring->servers.begin());
     }
 
-    std::string GetServer(uint64_t dwGroupid)
+    // server of a node index, empty for -1
+    std::string GetServerName(int32_t node) const
     {
         static const std::string kEmptyStr;
-        
-        std::shared_lock<std::shared_timed_mutex> l(m_mutexCircle);
-        if (server_circle.empty())
-        {
+
+        const Ring* ring = m_ring.load(std::memory_order_acquire);
+        if (node < 0 || static_cast<size_t>(node) >= ring->servers.size()) {
             return kEmptyStr;
         }
+        return ring->servers[node];
+    }
 
-        uint32_t hash = FnvHashFunction::hash(dwGroupid);
+    std::string GetServer(uint64_t dwGroupid) const
+    {
+        return GetServerName(GetNode(dwGroupid));
+    }
 
-        std::map<uint32_t, std::string>::const_iterator it = server_circle.lower_bound(hash);
-        if (it == server_circle.end())
-        {
-            return server_circle.begin()->second;
-        }
+    std::string GetServer(const std::string& sHashKey) const
+    {
+        return GetServerName(GetNode(sHashKey));
+    }
+
+private:
+    // the position of virtual node 'replica' of a server
+    static uint32_t VirtualNodeHash(const std::string& strServerIpport, uint32_t replica)
+    {
+        char hashbuf[50] = {0};
+        snprintf(hashbuf, sizeof(hashbuf), "%s", strServerIpport.c_str());
 
-        return it->second;
+        uint32_t strLen = strServerIpport.length();
+        if (strLen > sizeof(hashbuf)-sizeof(replica)) {
+            strLen = sizeof(hashbuf)-sizeof(replica);
+        }
+        memcpy(hashbuf + strLen, &replica, sizeof(replica));
+        return FnvHashFunction::hash(hashbuf, sizeof(hashbuf));
     }
-    
-    std::string GetServer(const std::string& sHashKey)
+
+    int32_t lookup(uint32_t hash) const
     {
-        static const std::string kEmptyStr;
-        
-        std::shared_lock<std::shared_timed_mutex> l(m_mutexCircle);
-        if (server_circle.empty())
-        {
-            return kEmptyStr;
+        const Ring* ring = m_ring.load(std::memory_order_acquire);
+        if (ring->hashes.empty()) {
+            return -1;
         }
-        
-        uint32_t hash = FnvHashFunction::hash(sHashKey.data(), sHashKey.size());
-        
-        std::map<uint32_t, std::string>::const_iterator it = server_circle.lower_bound(hash);
-        if (it == server_circle.end())
-        {
-            return server_circle.begin()->second;
+
+        auto it = std::lower_bound(ring->hashes.begin(), ring->hashes.end(), hash);
+        if (it == ring->hashes.end()) {
+            return ring->nodes.front();
         }
-        
-        return it->second;
+        return ring->nodes[it - ring->hashes.begin()];
     }
 
-    void Clear()
+    // the caller holds m_mutexUpdate
+    int32_t nodeOf(const std::string& strServerIpport)
     {
-        std::unique_lock<std::shared_timed_mutex> l(m_mutexCircle);
-        server_circle.clear();
+        auto it = m_serverNodes.find(strServerIpport);
+        if (it != m_serverNodes.end()) {
+            return it->second;
+        }
+        int32_t node = static_cast<int32_t>(m_servers.size());
+        m_servers.push_back(strServerIpport);
+        m_serverNodes[strServerIpport] = node;
+        return node;
+    }
+
+    // the caller holds m_mutexUpdate
+    void publish()
+    {
+        std::vector<std::pair<uint32_t, int32_t>> points;
+        points.reserve(m_members.size() * numberOfReplicas);
+        for (int32_t node : m_members) {
+            for (uint32_t i = 0; i < numberOfReplicas; i++) {
+                points.emplace_back(VirtualNodeHash(m_servers[node], i), node);
+            }
+        }
+        // on a collision the server added last owns the position
+        std::stable_sort(points.begin(), points.end(),
+                         [](const std::pair<uint32_t, int32_t>& a, const std::pair<uint32_t, int32_t>& b) {
+                             return a.first < b.first;
+                         });
+
+        std::unique_ptr<Ring> ring(new Ring());
+        ring->hashes.reserve(points.size());
+        ring->nodes.reserve(points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            if (i + 1 < points.size() && points[i + 1].first == points[i].first) {
+                LOGW << "server circle duplicate! server:" << m_servers[points[i].second]
+                     << " hash:" << points[i].first;
+                continue;
+            }
+            ring->hashes.push_back(points[i].first);
+            ring->nodes.push_back(points[i].second);
+        }
+        ring->servers = m_servers;
+
+        int64_t now = nowInMilli();
+        m_retired.emplace_back(now, std::unique_ptr<const Ring>(m_ring.exchange(ring.release(),
+                                                                                std::memory_order_acq_rel)));
+        while (!m_retired.empty() && m_retired.front().first + kRetireDelayInMilli <= now) {
+            m_retired.pop_front();
+        }
     }
 
 private:
      uint32_t numberOfReplicas;
-     FnvHashFunction hashFunction;
-     std::shared_timed_mutex m_mutexCircle;
-     std::map<uint32_t, std::string> server_circle;
+     std::atomic<const Ring*> m_ring;
+
+     std::mutex m_mutexUpdate;
+     std::vector<std::string> m_servers;
+     std::unordered_map<std::string, int32_t> m_serverNodes;
+     // node indexes on the ring, in the order they were added
+     std::vector<int32_t> m_members;
+     // replaced rings and when, freed once no lookup can still read them
+     std::deque<std::pair<int64_t, std::unique_ptr<const Ring>>> m_retired;
 };
 
 }
@@ -1,7 +1,15 @@
 #include "utils/log.h"
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
 #include <boost/core/null_deleter.hpp>
+#include <boost/log/detail/thread_id.hpp>
 #include "boost/log/expressions.hpp"
 #include "boost/log/support/date_time.hpp"
+#include "utils/spsc_ring_buffer.h"
+#include "utils/thread_utils.h"
 
 namespace bcm {
 
@@ -11,6 +19,384 @@ namespace expr = boost::log::expressions;
 namespace sinks = boost::log::sinks;
 namespace keywords = boost::log::keywords;
 
+std::ostream& operator<< (std::ostream& strm, LogSeverity level);
+
+std::atomic<int> Log::s_level{LOGSEVERITY_TRACE};
+
+// -----------------------------------------------------------------------------
+// Section: LogStream
+// -----------------------------------------------------------------------------
+
+class LogStreamBuf : public std::streambuf {
+public:
+    std::string& str()
+    {
+        return m_buf;
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            m_buf.push_back(traits_type::to_char_type(ch));
+        }
+        return ch;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        m_buf.append(s, static_cast<size_t>(n));
+        return n;
+    }
+
+private:
+    std::string m_buf;
+};
+
+struct LogStream {
+    LogStream()
+        : os(&buf)
+    {
+    }
+
+    void reset()
+    {
+        buf.str().clear();
+        os.clear();
+        os.flags(std::ios_base::dec | std::ios_base::skipws);
+        os.width(0);
+        os.precision(6);
+        os.fill(' ');
+    }
+
+    LogStreamBuf buf;
+    std::ostream os;
+    bool busy{false};
+};
+
+// constructing a std::ostream is the expensive part, so each thread keeps one around;
+// a record built while another one is still streaming (nested log) gets its own
+static thread_local LogStream s_tlsStream;
+
+// -----------------------------------------------------------------------------
+// Section: AsyncLogBackend
+// -----------------------------------------------------------------------------
+
+struct LogEntry {
+    LogSeverity severity{LOGSEVERITY_TRACE};
+    std::chrono::system_clock::time_point time;
+    logging::aux::thread::id threadId;
+    boost::fibers::fiber::id fiberId;
+    const char* file{nullptr};
+    const char* function{nullptr};
+    int line{0};
+    std::string message;
+};
+
+class LogProducer {
+public:
+    explicit LogProducer(size_t capacity)
+        : ring(capacity)
+    {
+    }
+
+    SpscRingBuffer<LogEntry> ring;
+    std::atomic<bool> closed{false};
+    std::atomic<uint64_t> dropped{0};
+};
+
+class AsyncLogBackend {
+public:
+    AsyncLogBackend(size_t bufferSize, bool dropOnOverflow)
+        : m_bufferSize(bufferSize)
+        , m_dropOnOverflow(dropOnOverflow)
+    {
+        std::thread([this]() {
+            setCurrentThreadName("log.writer");
+            run();
+        }).detach();
+    }
+
+    void submit(LogSeverity severity, const char* file, const char* function, int line,
+                const std::string& message);
+
+    void flush();
+
+    uint64_t dropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    LogProducer& threadProducer();
+    void run();
+    size_t drain(LogProducer& producer);
+    void write(const LogEntry& entry);
+    void refreshProducers();
+
+private:
+    const size_t m_bufferSize;
+    const bool m_dropOnOverflow;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::condition_variable m_flushCond;
+    std::vector<std::shared_ptr<LogProducer>> m_producers;
+    std::atomic<uint64_t> m_producersVersion{0};
+    uint64_t m_flushRequested{0};
+    uint64_t m_flushDone{0};
+    std::atomic<uint64_t> m_dropped{0};
+
+    // producers blocked on a full buffer
+    boost::fibers::mutex m_spaceMutex;
+    boost::fibers::condition_variable m_spaceCond;
+    std::atomic<uint32_t> m_spaceWaiters{0};
+
+    // owned by the writer thread
+    std::vector<std::shared_ptr<LogProducer>> m_snapshot;
+    uint64_t m_snapshotVersion{0};
+    LogStream m_lineStream;
+    std::time_t m_cachedSecond{-1};
+    char m_cachedTime[16]{0};
+};
+
+static std::atomic<AsyncLogBackend*> s_backend{nullptr};
+
+namespace {
+
+// marks the producer closed when its thread exits, the writer reaps it once drained
+struct LogProducerHolder {
+    ~LogProducerHolder()
+    {
+        if (producer) {
+            producer->closed.store(true, std::memory_order_release);
+        }
+    }
+
+    std::shared_ptr<LogProducer> producer;
+};
+
+thread_local LogProducerHolder s_tlsProducer;
+
+}
+
+LogProducer& AsyncLogBackend::threadProducer()
+{
+    if (!s_tlsProducer.producer) {
+        s_tlsProducer.producer = std::make_shared<LogProducer>(m_bufferSize);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_producers.push_back(s_tlsProducer.producer);
+        ++m_producersVersion;
+    }
+    return *s_tlsProducer.producer;
+}
+
+void AsyncLogBackend::submit(LogSeverity severity, const char* file, const char* function, int line,
+                             const std::string& message)
+{
+    LogProducer* producer = &threadProducer();
+
+    LogEntry* entry = producer->ring.tryPrepare();
+    if (entry == nullptr) {
+        if (m_dropOnOverflow) {
+            producer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // a fiber waiting for space lets the other fibers of its thread run. a migratable
+        // fiber may wake up on another thread, the ring it pushes to is the one of the
+        // thread it runs on now, never one picked before it was suspended
+        std::unique_lock<boost::fibers::mutex> lk(m_spaceMutex);
+        m_spaceWaiters.fetch_add(1, std::memory_order_seq_cst);
+        for (;;) {
+            producer = &threadProducer();
+            if ((entry = producer->ring.tryPrepare()) != nullptr) {
+                break;
+            }
+            m_cond.notify_one();
+            m_spaceCond.wait_for(lk, std::chrono::milliseconds(5));
+        }
+        m_spaceWaiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    entry->severity = severity;
+    entry->time = std::chrono::system_clock::now();
+    entry->threadId = logging::aux::this_thread::get_id();
+    entry->fiberId = boost::this_fiber::get_id();
+    entry->file = file;
+    entry->function = function;
+    entry->line = line;
+    entry->message.assign(message);
+    producer->ring.commitPush();
+}
+
+void AsyncLogBackend::flush()
+{
+    std::unique_lock<std::mutex> lk(m_mutex);
+    uint64_t request = ++m_flushRequested;
+    m_cond.notify_one();
+    m_flushCond.wait(lk, [this, request]() { return m_flushDone >= request; });
+}
+
+void AsyncLogBackend::refreshProducers()
+{
+    if (m_snapshotVersion == m_producersVersion.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_snapshot = m_producers;
+    m_snapshotVersion = m_producersVersion.load(std::memory_order_relaxed);
+}
+
+size_t AsyncLogBackend::drain(LogProducer& producer)
+{
+    size_t count = 0;
+    LogEntry* entry = nullptr;
+    while ((entry = producer.ring.front()) != nullptr) {
+        write(*entry);
+        producer.ring.commitPop();
+        ++count;
+    }
+
+    uint64_t dropped = producer.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped != 0) {
+        m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+        LogEntry warn;
+        warn.severity = LOGSEVERITY_WARN;
+        warn.time = std::chrono::system_clock::now();
+        warn.threadId = logging::aux::this_thread::get_id();
+        warn.message = "log buffer overflow, dropped " + std::to_string(dropped) + " records";
+        write(warn);
+    }
+    return count;
+}
+
+void AsyncLogBackend::run()
+{
+    for (;;) {
+        uint64_t flushRequest = 0;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            flushRequest = m_flushRequested;
+        }
+
+        refreshProducers();
+
+        size_t count = 0;
+        bool reap = false;
+        for (auto& producer : m_snapshot) {
+            count += drain(*producer);
+            if (producer->closed.load(std::memory_order_acquire) && producer->ring.empty()) {
+                reap = true;
+            }
+        }
+
+        // pairs with the producer counting itself before its last try
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (count != 0 && m_spaceWaiters.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<boost::fibers::mutex> lk(m_spaceMutex);
+            m_spaceCond.notify_all();
+        }
+
+        if (reap) {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            auto removed = std::remove_if(m_producers.begin(), m_producers.end(),
+                                          [](const std::shared_ptr<LogProducer>& p) {
+                                              return p->closed.load(std::memory_order_acquire) && p->ring.empty();
+                                          });
+            m_producers.erase(removed, m_producers.end());
+            ++m_producersVersion;
+        }
+
+        std::unique_lock<std::mutex> lk(m_mutex);
+        if (flushRequest > m_flushDone) {
+            lk.unlock();
+            logging::core::get()->flush();
+            lk.lock();
+            m_flushDone = flushRequest;
+            m_flushCond.notify_all();
+        }
+        if (count == 0 && m_flushRequested == m_flushDone) {
+            m_cond.wait_for(lk, std::chrono::milliseconds(5));
+        }
+    }
+}
+
+void AsyncLogBackend::write(const LogEntry& entry)
+{
+    std::time_t second = std::chrono::system_clock::to_time_t(entry.time);
+    if (second != m_cachedSecond) {
+        struct tm tmNow;
+        localtime_r(&second, &tmNow);
+        std::strftime(m_cachedTime, sizeof(m_cachedTime), "%H:%M:%S", &tmNow);
+        m_cachedSecond = second;
+    }
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        entry.time.time_since_epoch()).count() % 1000000;
+    char fraction[16];
+    std::snprintf(fraction, sizeof(fraction), ".%06d", static_cast<int>(micros));
+
+    m_lineStream.reset();
+    std::ostream& os = m_lineStream.os;
+    os << m_cachedTime << fraction << "|" << entry.severity << "|" << entry.threadId
+       << "|" << entry.fiberId << "|";
+    if (entry.file != nullptr) {
+        os << entry.file << ":" << entry.function << ":" << entry.line << "|";
+    }
+    os << entry.message;
+
+    BOOST_LOG_SEV(BcmLogger::get(), entry.severity) << m_lineStream.buf.str();
+}
+
+// -----------------------------------------------------------------------------
+// Section: LogRecord
+// -----------------------------------------------------------------------------
+
+LogRecord::LogRecord(LogSeverity severity, const char* file, const char* function, int line)
+    : m_severity(severity)
+    , m_file(file)
+    , m_function(function)
+    , m_line(line)
+    , m_stream(&s_tlsStream)
+{
+    if (m_stream->busy) {
+        m_ownedStream.reset(new LogStream());
+        m_stream = m_ownedStream.get();
+    }
+    m_stream->reset();
+    m_stream->busy = true;
+}
+
+LogRecord::~LogRecord()
+{
+    // the stream is released before submit, which may suspend the fiber and resume it
+    // on another thread
+    std::string message = m_stream->buf.str();
+    m_stream->busy = false;
+
+    AsyncLogBackend* backend = s_backend.load(std::memory_order_acquire);
+    if (backend != nullptr) {
+        backend->submit(m_severity, m_file, m_function, m_line, message);
+    } else {
+        // not initialized yet (tools, tests): write through synchronously
+        auto& logger = BcmLogger::get();
+        if (m_file != nullptr) {
+            BOOST_LOG_SEV(logger, m_severity) << boost::this_fiber::get_id() << "|" << m_file << ":"
+                                              << m_function << ":" << m_line << "|" << message;
+        } else {
+            BOOST_LOG_SEV(logger, m_severity) << boost::this_fiber::get_id() << "|" << message;
+        }
+    }
+}
+
+std::ostream& LogRecord::stream()
+{
+    return m_stream->os;
+}
+
+// -----------------------------------------------------------------------------
+// Section: Log
+// -----------------------------------------------------------------------------
+
 bool Log::init(LogConfig& conf, const char* fileHead)
 {
     boost::shared_ptr<sinks::text_file_backend> logfile =
@@ -30,20 +416,14 @@ bool Log::init(LogConfig& conf, const char* fileHead)
     logfile->scan_for_files();
     logfile->auto_flush(conf.autoflush);
 
-    typedef sinks::asynchronous_sink<
-        sinks::text_file_backend,
-        sinks::bounded_fifo_queue<1024*1024, sinks::block_on_overflow>
-            > async_sink_t;
-
+    // records are already queued and formatted by the async backend's writer thread,
+    // which is the only one feeding the sinks
+    typedef sinks::synchronous_sink<sinks::text_file_backend> file_sink_t;
     typedef sinks::synchronous_sink<sinks::text_ostream_backend> sync_sink_t;
 
-    boost::shared_ptr<async_sink_t> sink(new async_sink_t(logfile));
+    boost::shared_ptr<file_sink_t> sink(new file_sink_t(logfile));
 
-    logging::formatter myFormat = expr::stream
-            << expr::format_date_time(timestamp, "%H:%M:%S.%f")
-            << "|" << severity
-            << "|" << threadId
-            << "|" << expr::smessage;
+    logging::formatter myFormat = expr::stream << expr::smessage;
 
     sink->set_formatter(myFormat);
 
@@ -52,12 +432,9 @@ bool Log::init(LogConfig& conf, const char* fileHead)
 
     logging::add_common_attributes();
 
+    setLevel(conf.level);
     if (conf.level > static_cast<int>(LOGSEVERITY_FATAL)) {
         core->set_logging_enabled(false);
-    } else if (conf.level < static_cast<int>(LOGSEVERITY_TRACE)) {
-        core->set_filter(severity >= LOGSEVERITY_TRACE);
-    } else {
-        core->set_filter(severity >= static_cast<LogSeverity>(conf.level));
     }
 
     if (conf.console) {
@@ -67,12 +444,37 @@ bool Log::init(LogConfig& conf, const char* fileHead)
         core->add_sink(consoleSink);
     }
 
+    if (s_backend.load() == nullptr) {
+        size_t bufferSize = conf.asyncBufferSize > 0 ? static_cast<size_t>(conf.asyncBufferSize) : 8192;
+        // intentionally never destroyed, so logging stays valid during static destruction
+        s_backend.store(new AsyncLogBackend(bufferSize, conf.overflowPolicy == "drop"));
+    }
+
     return true;
 }
 
 void Log::flush()
 {
-    logging::core::get()->flush();
+    AsyncLogBackend* backend = s_backend.load(std::memory_order_acquire);
+    if (backend != nullptr) {
+        backend->flush();
+    } else {
+        logging::core::get()->flush();
+    }
+}
+
+void Log::setLevel(int level)
+{
+    if (level < static_cast<int>(LOGSEVERITY_TRACE)) {
+        level = LOGSEVERITY_TRACE;
+    }
+    s_level.store(level, std::memory_order_relaxed);
+}
+
+uint64_t Log::droppedRecords()
+{
+    AsyncLogBackend* backend = s_backend.load(std::memory_order_acquire);
+    return backend == nullptr ? 0 : backend->dropped();
 }
 
 std::ostream& operator<< (std::ostream& strm, LogSeverity level)
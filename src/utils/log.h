@@ -2,6 +2,8 @@
 
 #include <string>
 #include <iostream>
+#include <atomic>
+#include <memory>
 #include <boost/log/common.hpp>
 #include <boost/log/sinks.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
@@ -59,7 +61,21 @@ enum LogSeverity {
 class Log {
 public:
     static bool init(LogConfig& conf, const char* fileHead);
+    // blocks until every record submitted before the call has reached the sinks
     static void flush();
+
+    // checked before any argument of a log statement is evaluated
+    static bool enabled(LogSeverity level)
+    {
+        return static_cast<int>(level) >= s_level.load(std::memory_order_relaxed);
+    }
+    static void setLevel(int level);
+
+    // records dropped because a thread's buffer was full (drop policy only)
+    static uint64_t droppedRecords();
+
+private:
+    static std::atomic<int> s_level;
 };
 
 //BOOST_LOG_ATTRIBUTE_KEYWORD(lineId, "LineID", unsigned int)
@@ -70,15 +86,43 @@ BOOST_LOG_ATTRIBUTE_KEYWORD(threadId, "ThreadID", boost::log::attributes::curren
 
 BOOST_LOG_INLINE_GLOBAL_LOGGER_DEFAULT(BcmLogger, boost::log::sources::severity_logger_mt<LogSeverity>);
 
-#define __FILENAME__ (__builtin_strrchr(__FILE__, '/') ? __builtin_strrchr(__FILE__, '/') + 1 : __FILE__)
+struct LogStream;
+
+// One log statement. The message is streamed into a per thread reusable buffer,
+// the destructor hands it with the call site to the async backend, which adds the
+// prefix (time, severity, thread, fiber, location) on its own thread.
+class LogRecord {
+public:
+    // file == nullptr omits the location part of the prefix
+    LogRecord(LogSeverity severity, const char* file, const char* function, int line);
+    ~LogRecord();
 
-#define BCMLOG(severity)\
-    BOOST_LOG_SEV(BcmLogger::get(), LOGSEVERITY_##severity)\
-    << boost::this_fiber::get_id() << "|" << __FILENAME__ << ":" <<  __PRETTY_FUNCTION__ << ":" << __LINE__ << "|"
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    std::ostream& stream();
+
+private:
+    LogSeverity m_severity;
+    const char* m_file;
+    const char* m_function;
+    int m_line;
+    LogStream* m_stream;
+    std::unique_ptr<LogStream> m_ownedStream;
+};
+
+// lets the log macros be a single expression, so they are safe in unbraced if/else
+struct LogVoidify {
+    void operator&(std::ostream&) {}
+};
+
+#define __FILENAME__ (__builtin_strrchr(__FILE__, '/') ? __builtin_strrchr(__FILE__, '/') + 1 : __FILE__)
 
 #define LOG2(severity)\
-    BOOST_LOG_SEV(BcmLogger::get(), severity)\
-    << boost::this_fiber::get_id() << "|" << __FILENAME__ << ":" <<  __PRETTY_FUNCTION__ << ":" << __LINE__ << "|"
+    !::bcm::Log::enabled(severity) ? (void) 0 : ::bcm::LogVoidify() &\
+    ::bcm::LogRecord((severity), __FILENAME__, __PRETTY_FUNCTION__, __LINE__).stream()
+
+#define BCMLOG(severity) LOG2(::bcm::LOGSEVERITY_##severity)
 
 #define LOGT BCMLOG(TRACE)
 #define LOGD BCMLOG(DEBUG)
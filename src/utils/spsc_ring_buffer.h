@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+namespace bcm {
+
+// Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Slots are preallocated and reused in place, so element types that own memory
+// (e.g. std::string) keep their capacity across rounds and steady state is allocation free.
+template <typename T>
+class SpscRingBuffer {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRingBuffer(size_t capacity)
+        : m_slots(roundUpPowerOfTwo(capacity))
+        , m_mask(m_slots.size() - 1)
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+    // producer side: returns the slot to fill or nullptr if the buffer is full,
+    // the slot becomes visible to the consumer only after commitPush()
+    T* tryPrepare()
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache >= m_slots.size()) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache >= m_slots.size()) {
+                return nullptr;
+            }
+        }
+        return &m_slots[tail & m_mask];
+    }
+
+    void commitPush()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // consumer side: returns the oldest slot or nullptr if the buffer is empty,
+    // the slot is handed back to the producer by commitPop()
+    T* front()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache) {
+                return nullptr;
+            }
+        }
+        return &m_slots[head & m_mask];
+    }
+
+    void commitPop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t n)
+    {
+        size_t size = 2;
+        while (size < n) {
+            size <<= 1;
+        }
+        return size;
+    }
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::vector<T> m_slots;
+    const size_t m_mask;
+
+    // consumer owned
+    alignas(kCacheLine) std::atomic<size_t> m_head{0};
+    size_t m_tailCache{0};
+
+    // producer owned
+    alignas(kCacheLine) std::atomic<size_t> m_tail{0};
+    size_t m_headCache{0};
+};
+
+}
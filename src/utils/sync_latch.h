@@ -31,6 +31,29 @@ public:
         }
     }
 
+    // non-blocking arrival, for workers whose completion is awaited by wait()
+    void countDown()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        if (m_count == 0) {
+            return;
+        }
+        if (--m_count == 0) {
+            ++m_generation;
+            lk.unlock();
+            m_cond.notify_all();
+        }
+    }
+
+    // blocks until the count reaches zero
+    void wait()
+    {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        while (m_count != 0) {
+            m_cond.wait(lk);
+        }
+    }
+
 private:
     std::mutex m_mutex;
     std::condition_variable m_cond;
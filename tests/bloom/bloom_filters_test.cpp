@@ -1,6 +1,10 @@
 #include "../test_common.h"
 
 #include "bloom/bloom_filters.h"
+#include "bloom/contacts_filter_cache.h"
+#include "crypto/base64.h"
+#include "crypto/murmurhash3.h"
+#include "utils/time.h"
 #include <vector>
 #include <string>
 
@@ -29,3 +33,107 @@ TEST_CASE("BloomFiltersTest")
     REQUIRE(filters3.contains("bbb") == false);
     REQUIRE(filters3.contains("ccc") == true);
 }
+
+TEST_CASE("BloomFiltersIndexMasking")
+{
+    // 1024 bits are masked, 1000 bits take the modulo path, both must match the plain modulo
+    for (uint32_t bits : {1024u, 1000u}) {
+        BloomFilters filters(0, bits);
+        filters.insert("aaa");
+        std::string content = filters.getFiltersContent();
+        for (uint32_t i = 0; i < 5; ++i) {
+            uint32_t index = MurmurHash3::murmurHash3(i * 0xFBA4C795 + 0x3, "aaa") % bits;
+            REQUIRE((static_cast<uint8_t>(content[index >> 3]) & (1 << (7 & index))) != 0);
+        }
+
+        BloomFilters decoded(0, content);
+        REQUIRE(decoded.contains("aaa"));
+        REQUIRE(decoded.contains("bbb") == false);
+    }
+}
+
+TEST_CASE("ContactsFilterCache")
+{
+    BloomFilters filters(0, 1024);
+    filters.insert("friend");
+    std::string encoded = Base64::encode(filters.getFiltersContent());
+
+    ContactsFilterCache cache(16 * 1024);
+    auto first = cache.get("uid1", 0, "v1", encoded);
+    REQUIRE(first->contains("friend"));
+    REQUIRE(first->contains("stranger") == false);
+    REQUIRE(cache.get("uid1", 0, "v1", encoded) == first);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.memoryUsage() == 128);
+
+    // a new version is decoded again
+    filters.insert("stranger");
+    std::string updated = Base64::encode(filters.getFiltersContent());
+    auto second = cache.get("uid1", 0, "v2", updated);
+    REQUIRE(second != first);
+    REQUIRE(second->contains("stranger"));
+    REQUIRE(cache.size() == 1);
+
+    // without a version the content itself is compared
+    auto legacy = cache.get("uid2", 0, "", encoded);
+    REQUIRE(cache.get("uid2", 0, "", encoded) == legacy);
+    REQUIRE(cache.get("uid2", 0, "", updated) != legacy);
+
+    cache.invalidate("uid1");
+    REQUIRE(cache.size() == 1);
+
+    // shards are bounded by the decoded size
+    for (int i = 0; i < 1000; ++i) {
+        cache.get("uid_" + std::to_string(i), 0, "v1", encoded);
+    }
+    REQUIRE(cache.memoryUsage() <= 16 * 1024);
+
+    ContactsFilterCache disabled(0);
+    REQUIRE(disabled.get("uid1", 0, "v1", encoded)->contains("friend"));
+    REQUIRE(disabled.size() == 0);
+}
+
+TEST_CASE("BloomFiltersThroughput", "[.][benchmark]")
+{
+    // a 64KB filter, the size of a large contact list
+    BloomFilters filters(0, 64 * 1024 * 8);
+    std::vector<std::string> uids;
+    for (int i = 0; i < 1000; ++i) {
+        uids.emplace_back("1PiMmSJHHdyUBtdJ4BWMeRb6sVJ" + std::to_string(i));
+        if (i % 2 == 0) {
+            filters.insert(uids.back());
+        }
+    }
+    std::string encoded = Base64::encode(filters.getFiltersContent());
+
+    const int kRounds = 200;
+    size_t hits = 0;
+    int64_t start = nowInMicro();
+    for (int r = 0; r < kRounds; ++r) {
+        for (const auto& uid : uids) {
+            hits += filters.contains(uid) ? 1 : 0;
+        }
+    }
+    int64_t containsSpent = nowInMicro() - start;
+    REQUIRE(hits >= static_cast<size_t>(kRounds * uids.size() / 2));
+
+    // one check per message, as sendMessage used to decode it
+    start = nowInMicro();
+    hits = 0;
+    for (int r = 0; r < kRounds; ++r) {
+        BloomFilters decoded(0, Base64::decode(encoded));
+        hits += decoded.contains(uids[r % uids.size()]) ? 1 : 0;
+    }
+    int64_t decodeSpent = nowInMicro() - start;
+
+    ContactsFilterCache cache(64 * 1024 * 1024);
+    start = nowInMicro();
+    for (int r = 0; r < kRounds; ++r) {
+        hits += cache.get("uid", 0, "v1", encoded)->contains(uids[r % uids.size()]) ? 1 : 0;
+    }
+    int64_t cachedSpent = nowInMicro() - start;
+
+    TLOG << "contains: " << containsSpent * 1000 / (kRounds * uids.size()) << " ns"
+         << ", decode and check: " << decodeSpent / kRounds << " us"
+         << ", cached check: " << cachedSpent * 1000 / kRounds << " ns";
+}
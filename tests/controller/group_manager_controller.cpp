@@ -10,6 +10,8 @@
 #include <metrics_client.h>
 #include "../../src/proto/dao/group_keys.pb.h"
 #include "../../src/limiters/distributed_limiter.h"
+#include "../../src/utils/time.h"
+#include <thread>
 
 using namespace bcm;
 using namespace bcm::metrics;
@@ -1995,3 +1997,96 @@ TEST_CASE("onQueryMembersV3")
     controller.onQueryMembersV3(context);
     REQUIRE(context.response.result() == http::status::bad_request);
 }
+
+// Accounts dao whose every call costs one round trip
+class LatencyAccountMock : public AccountMock {
+public:
+    explicit LatencyAccountMock(int64_t latencyMicros) : m_latencyMicros(latencyMicros) {}
+
+    bcm::dao::ErrorCode get(const std::string& uid, bcm::Account& account) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(m_latencyMicros));
+        return AccountMock::get(uid, account);
+    }
+
+    bcm::dao::ErrorCode get(const std::vector<std::string>& uids,
+                            std::vector<bcm::Account>& accounts,
+                            std::vector<std::string>& missedUids) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(m_latencyMicros));
+        for (const auto& uid : uids) {
+            bcm::Account account;
+            if (AccountMock::get(uid, account) == bcm::dao::ERRORCODE_NO_SUCH_DATA) {
+                missedUids.emplace_back(uid);
+                continue;
+            }
+            accounts.emplace_back(account);
+        }
+        return accounts.empty() ? bcm::dao::ERRORCODE_NO_SUCH_DATA : m_ec;
+    }
+
+    // clones the first account under new uids
+    std::vector<std::string> addMembers(int count)
+    {
+        std::vector<std::string> uids;
+        bcm::Account account = m_accounts.begin()->second;
+        for (int i = 0; i < count; i++) {
+            account.set_uid("member_" + std::to_string(i));
+            m_accounts.emplace(account.uid(), account);
+            uids.emplace_back(account.uid());
+        }
+        return uids;
+    }
+
+private:
+    int64_t m_latencyMicros;
+};
+
+TEST_CASE("checkBidirectionalRelationshipBatched")
+{
+    std::shared_ptr<bcm::AccountsManager> accountsManager = std::make_shared<bcm::AccountsManager>();
+    GroupConfig groupConfig;
+    MultiDeviceConfig multiDeviceConfig;
+    bcm::GroupManagerController controller(nullptr, accountsManager, nullptr, multiDeviceConfig, groupConfig);
+    LatencyAccountMock* accountMock = new LatencyAccountMock(0);
+    controller.m_accountsManager->m_accounts.reset(accountMock);
+
+    std::vector<std::string> members = accountMock->addMembers(175);
+    bcm::Account owner = accountMock->m_accounts.begin()->second;
+    http::response<http::string_body> resp;
+    REQUIRE(controller.checkBidirectionalRelationship(&owner, members, resp));
+
+    // a member missing from the dao fails the whole check
+    members.emplace_back("uid_not_exist");
+    REQUIRE_FALSE(controller.checkBidirectionalRelationship(&owner, members, resp));
+    REQUIRE(resp.result() == http::status::internal_server_error);
+}
+
+TEST_CASE("checkBidirectionalRelationshipLatency", "[.][benchmark]")
+{
+    std::shared_ptr<bcm::AccountsManager> accountsManager = std::make_shared<bcm::AccountsManager>();
+    GroupConfig groupConfig;
+    MultiDeviceConfig multiDeviceConfig;
+    bcm::GroupManagerController controller(nullptr, accountsManager, nullptr, multiDeviceConfig, groupConfig);
+    // 2ms per dao round trip
+    LatencyAccountMock* accountMock = new LatencyAccountMock(2000);
+    controller.m_accountsManager->m_accounts.reset(accountMock);
+
+    std::vector<std::string> members = accountMock->addMembers(200);
+    bcm::Account owner = accountMock->m_accounts.begin()->second;
+
+    int64_t start = nowInMicro();
+    for (const auto& uid : members) {
+        bcm::Account account;
+        REQUIRE(accountsManager->get(uid, account) == bcm::dao::ERRORCODE_SUCCESS);
+    }
+    int64_t serial = nowInMicro() - start;
+
+    http::response<http::string_body> resp;
+    start = nowInMicro();
+    REQUIRE(controller.checkBidirectionalRelationship(&owner, members, resp));
+    int64_t batched = nowInMicro() - start;
+
+    TLOG << members.size() << " members, serial lookups: " << serial / 1000 << " ms, batched check: "
+         << batched / 1000 << " ms";
+}
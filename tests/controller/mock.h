@@ -761,6 +761,21 @@ public:
         return m_ec;
     }
 
+    virtual bcm::dao::ErrorCode updateLastAckMidBatch(const std::vector<bcm::dao::GroupUserAck>& acks) override
+    {
+        for (const auto& ack : acks) {
+            auto g = m_groupUsers.find(ack.gid);
+            if (g == m_groupUsers.end()) {
+                continue;
+            }
+            auto u = g->second.find(ack.uid);
+            if (u != g->second.end()) {
+                u->second.set_lastackmid(ack.lastAckMid);
+            }
+        }
+        return m_ec;
+    }
+
     virtual bcm::dao::ErrorCode del(uint64_t gid)
     {
         boost::ignore_unused(gid);
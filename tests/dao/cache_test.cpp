@@ -1,6 +1,9 @@
 #include <cinttypes>
+#include <cmath>
+#include <random>
 #include "../test_common.h"
 #include "../../src/dao/dao_cache/fifo_cache.h"
+#include "../../src/dao/dao_cache/tiny_lfu_cache.h"
 #include "../../src/proto/dao/group_keys.pb.h"
 #include "../../src/controllers/group_manager_entities.h"
 
@@ -45,3 +48,194 @@ TEST_CASE("FIFOCache")
         compareKey(keys, res);
     }
 }
+
+TEST_CASE("TinyLFUCache")
+{
+    bcm::dao::TinyLFUCache<std::string, bcm::GroupKeys> cache(1024 * 1024, 4);
+
+    bcm::GroupKeys keys;
+    keys.set_gid(1);
+    keys.set_version(2);
+    keys.set_groupowner("member10");
+    keys.set_creator(keys.groupowner());
+    keys.set_groupkeys(std::string(1024, 'k'));
+    keys.set_mode(bcm::GroupKeys::ONE_FOR_EACH);
+
+    REQUIRE(cache.get("1_2") == nullptr);
+    REQUIRE(cache.set("1_2", keys) == true);
+    auto first = cache.get("1_2");
+    REQUIRE(first != nullptr);
+    compareKey(keys, *first);
+    // readers share the cached value
+    REQUIRE(cache.get("1_2").get() == first.get());
+
+    bcm::GroupKeys copy;
+    REQUIRE(cache.get("1_2", copy) == true);
+    compareKey(keys, copy);
+    REQUIRE(cache.size() == keys.ByteSizeLong());
+
+    // a replaced value does not change what earlier readers hold
+    keys.set_groupowner("member20");
+    REQUIRE(cache.set("1_2", keys) == true);
+    REQUIRE(cache.get("1_2")->groupowner() == "member20");
+    REQUIRE(first->groupowner() == "member10");
+
+    cache.erase("1_2");
+    REQUIRE(cache.get("1_2") == nullptr);
+    REQUIRE(cache.count() == 0);
+    REQUIRE(cache.size() == 0);
+
+    // larger than a shard
+    keys.set_groupkeys(std::string(1024 * 1024, 'k'));
+    REQUIRE(cache.set("1_3", keys) == false);
+}
+
+struct Blob {
+    std::string data;
+
+    size_t ByteSizeLong() const
+    {
+        return data.size();
+    }
+};
+
+TEST_CASE("TinyLFUCacheKeepsHotEntries")
+{
+    const size_t kEntry = 1024;
+    const size_t kHot = 32;
+    bcm::dao::TinyLFUCache<std::string, Blob> cache(128 * kEntry, 1);
+
+    for (size_t round = 0; round < 4; ++round) {
+        for (size_t i = 0; i < kHot; ++i) {
+            std::string k = "hot" + std::to_string(i);
+            if (cache.get(k) == nullptr) {
+                cache.set(k, Blob{std::string(kEntry, 'h')});
+            }
+        }
+    }
+
+    // a storm of one-off lookups, each missed key is filled in as GroupKeysRpcImpl does,
+    // while the hot entries keep being asked for
+    size_t hotMisses = 0;
+    for (size_t i = 0; i < 10000; ++i) {
+        std::string k = "cold" + std::to_string(i);
+        REQUIRE(cache.get(k) == nullptr);
+        cache.set(k, Blob{std::string(kEntry, 'c')});
+        REQUIRE(cache.size() <= cache.limit());
+        if (i % 4 == 0 && cache.get("hot" + std::to_string(i / 4 % kHot)) == nullptr) {
+            ++hotMisses;
+        }
+    }
+
+    size_t survived = 0;
+    for (size_t i = 0; i < kHot; ++i) {
+        if (cache.get("hot" + std::to_string(i)) != nullptr) {
+            ++survived;
+        }
+    }
+    TLOG << "hot misses during the storm: " << hotMisses << ", hot entries survived: " << survived << "/" << kHot;
+    REQUIRE(hotMisses == 0);
+    REQUIRE(survived == kHot);
+    REQUIRE(cache.stats().rejected > 0);
+}
+
+TEST_CASE("TinyLFUCacheGrowingEntries")
+{
+    const size_t kLimit = 100000;
+    bcm::dao::TinyLFUCache<std::string, Blob> cache(kLimit, 1);
+
+    // small entries fill the main space, then every one of them is overwritten larger
+    const size_t kEntries = 2000;
+    for (size_t round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < kEntries; ++i) {
+            std::string k = std::to_string(i);
+            cache.get(k);
+            cache.set(k, Blob{std::string(40, 's')});
+        }
+    }
+    REQUIRE(cache.size() <= kLimit);
+    REQUIRE(cache.count() > 1000);
+
+    for (size_t i = 0; i < kEntries; ++i) {
+        std::string k = std::to_string(i);
+        if (cache.get(k) != nullptr) {
+            cache.set(k, Blob{std::string(1000, 'l')});
+            REQUIRE(cache.size() <= kLimit);
+        }
+    }
+    TLOG << "after growing: " << cache.size() << " bytes in " << cache.count() << " entries";
+    REQUIRE(cache.size() <= kLimit);
+    REQUIRE(cache.count() > 0);
+    REQUIRE(cache.stats().evicted > 0);
+}
+
+// draws ranks in [0, n) with P(k) proportional to 1 / (k + 1)^s
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t n, double s, uint32_t seed) : m_cdf(n), m_rng(seed)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+            m_cdf[i] = sum;
+        }
+        for (auto& c : m_cdf) {
+            c /= sum;
+        }
+    }
+
+    size_t next()
+    {
+        double u = std::uniform_real_distribution<double>(0, 1)(m_rng);
+        auto it = std::lower_bound(m_cdf.begin(), m_cdf.end(), u);
+        return std::min(static_cast<size_t>(it - m_cdf.begin()), m_cdf.size() - 1);
+    }
+
+private:
+    std::vector<double> m_cdf;
+    std::mt19937 m_rng;
+};
+
+template <class TCache>
+double zipfHitRatio(TCache& cache, double s, size_t scanEvery)
+{
+    const size_t kKeys = 100000;
+    const size_t kOps = 1000000;
+    ZipfGenerator zipf(kKeys, s, 42);
+    size_t hits = 0;
+    size_t scanned = 0;
+    Blob value{std::string(64, 'v')};
+    Blob res;
+    for (size_t i = 0; i < kOps; ++i) {
+        std::string k;
+        if (scanEvery != 0 && i % scanEvery == 0) {
+            // a key that is never asked for again
+            k = "scan" + std::to_string(scanned++);
+        } else {
+            k = std::to_string(zipf.next());
+        }
+        if (cache.get(k, res)) {
+            ++hits;
+        } else {
+            cache.set(k, value);
+        }
+    }
+    return static_cast<double>(hits) / kOps;
+}
+
+TEST_CASE("CacheZipfHitRatio", "[.][benchmark]")
+{
+    // room for 1% of the keys
+    const size_t kLimit = 1000 * 64;
+    for (double s : {0.7, 0.9, 1.1}) {
+        for (size_t scanEvery : {0, 3}) {
+            bcm::dao::FIFOCache<std::string, Blob> fifo(kLimit);
+            bcm::dao::TinyLFUCache<std::string, Blob> tinyLfu(kLimit, 1);
+            double fifoRatio = zipfHitRatio(fifo, s, scanEvery);
+            double tinyLfuRatio = zipfHitRatio(tinyLfu, s, scanEvery);
+            TLOG << "zipf s=" << s << (scanEvery ? " with scans" : "") << ", hit ratio fifo: " << fifoRatio
+                 << ", w-tinylfu: " << tinyLfuRatio;
+            REQUIRE(tinyLfuRatio > fifoRatio);
+        }
+    }
+}
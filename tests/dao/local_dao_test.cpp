@@ -0,0 +1,288 @@
+#include "../test_common.h"
+
+#include <boost/filesystem.hpp>
+
+#include "dao/local_impl/local_store.h"
+#include "dao/local_impl/group_keys_local_impl.h"
+#include "dao/local_impl/group_msg_local_impl.h"
+#include "dao/local_impl/group_user_local_impl.h"
+#include "dao/local_impl/groups_local_impl.h"
+#include "dao/local_impl/onetime_keys_local_impl.h"
+#include "dao/local_impl/stored_messages_local_impl.h"
+#include "dao/local_impl/sys_messages_local_impl.h"
+#include "dao/local_impl/utilities_local_impl.h"
+
+using namespace bcm;
+using namespace bcm::dao;
+
+// a store in a fresh temp dir, which is removed with the fixture. declare it before
+// anything holding the store, so the database is closed first
+struct TempStore {
+    TempStore()
+        : path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("local_dao_%%%%%%%%"))
+    {
+        DaoConfig config;
+        config.local.path = path.string();
+        store = LocalStore::open(config);
+        REQUIRE(store != nullptr);
+    }
+
+    ~TempStore()
+    {
+        store.reset();
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(path, ec);
+    }
+
+    boost::filesystem::path path;
+    std::shared_ptr<LocalStore> store;
+};
+
+TEST_CASE("LocalKeyOrder")
+{
+    REQUIRE(LocalKey("t").u64(1).key() < LocalKey("t").u64(256).key());
+    REQUIRE(LocalKey("t").i64(-5).key() < LocalKey("t").i64(3).key());
+    REQUIRE(LocalKey("t").str("ab").u64(9).key() < LocalKey("t").str("abc").u64(0).key());
+
+    LocalKey prefix("t");
+    prefix.str("uid");
+    REQUIRE(LocalKey::tailString(LocalKey("t").str("uid").str("part").key(), prefix) == "part");
+    REQUIRE(LocalKey::tailU64(LocalKey("t").str("uid").u64(12345).key()) == 12345);
+}
+
+TEST_CASE("LocalStoreBasics")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    std::string value;
+    REQUIRE(store->get("missing", value) == ERRORCODE_NO_SUCH_DATA);
+
+    uint64_t id = 0;
+    REQUIRE(store->nextId("seq_test", id) == ERRORCODE_SUCCESS);
+    REQUIRE(id == 1);
+    REQUIRE(store->nextId("seq_test", id) == ERRORCODE_SUCCESS);
+    REQUIRE(id == 2);
+
+    for (uint64_t i = 1; i <= 5; ++i) {
+        REQUIRE(store->put(LocalKey("s").str("a").u64(i), std::to_string(i)) == ERRORCODE_SUCCESS);
+    }
+    REQUIRE(store->put(LocalKey("s").str("b").u64(1), "other") == ERRORCODE_SUCCESS);
+
+    std::vector<uint64_t> ids;
+    store->scanReverse(LocalKey("s").str("a"), [&ids](const leveldb::Slice& key, const leveldb::Slice&) {
+        ids.push_back(LocalKey::tailU64(key));
+        return ids.size() < 3;
+    });
+    REQUIRE(ids == std::vector<uint64_t>({5, 4, 3}));
+
+    REQUIRE(store->delPrefix(LocalKey("s").str("a")) == ERRORCODE_SUCCESS);
+    REQUIRE(store->get(LocalKey("s").str("a").u64(1), value) == ERRORCODE_NO_SUCH_DATA);
+    REQUIRE(store->get(LocalKey("s").str("b").u64(1), value) == ERRORCODE_SUCCESS);
+}
+
+TEST_CASE("LocalStoredMessages")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    StoredMessagesLocalImpl messages(store);
+
+    uint32_t unread = 0;
+    for (uint32_t i = 0; i < 3; ++i) {
+        bcm::StoredMessage msg;
+        msg.set_destination("uid1");
+        msg.set_destinationdeviceid(1);
+        REQUIRE(messages.set(msg, unread) == ERRORCODE_SUCCESS);
+        REQUIRE(unread == i + 1);
+    }
+    bcm::StoredMessage other;
+    other.set_destination("uid1");
+    other.set_destinationdeviceid(2);
+    REQUIRE(messages.set(other, unread) == ERRORCODE_SUCCESS);
+    REQUIRE(unread == 1);
+
+    std::vector<bcm::StoredMessage> msgs;
+    REQUIRE(messages.get("uid1", 1, 2, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.size() == 2);
+    REQUIRE(msgs[0].id() < msgs[1].id());
+
+    REQUIRE(messages.del("uid1", {msgs[0].id()}) == ERRORCODE_SUCCESS);
+    msgs.clear();
+    REQUIRE(messages.get("uid1", 1, 10, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.size() == 2);
+    REQUIRE(messages.set(other, unread) == ERRORCODE_SUCCESS);
+    REQUIRE(unread == 2);
+
+    REQUIRE(messages.clear("uid1") == ERRORCODE_SUCCESS);
+    msgs.clear();
+    REQUIRE(messages.get("uid1", 1, 10, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(messages.get("uid1", 2, 10, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.empty());
+}
+
+TEST_CASE("LocalGroups")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    GroupsLocalImpl groups(store);
+    GroupMsgsLocalImpl groupMsgs(store);
+    GroupUsersLocalImpl groupUsers(store);
+
+    uint64_t gid = 0;
+    REQUIRE(groups.create(bcm::Group(), gid) == ERRORCODE_SUCCESS);
+    REQUIRE(groups.update(gid, nlohmann::json({{"owner_confirm", 1}})) == ERRORCODE_SUCCESS);
+    REQUIRE(groups.update(gid, nlohmann::json({{"no_such_column", 1}})) == ERRORCODE_PARAM_INCORRECT);
+    bcm::Group group;
+    REQUIRE(groups.get(gid, group) == ERRORCODE_SUCCESS);
+    REQUIRE(group.ownerconfirm() == 1);
+
+    bcm::GroupMsg msg;
+    msg.set_gid(gid);
+    msg.set_fromuid("owner");
+    uint64_t mid = 0;
+    REQUIRE(groupMsgs.insert(msg, mid) == ERRORCODE_SUCCESS);
+    REQUIRE(mid == 1);
+    uint64_t recallMid = 0;
+    REQUIRE(groupMsgs.recall("", "owner", gid, mid, recallMid) == ERRORCODE_SUCCESS);
+    REQUIRE(recallMid == 2);
+
+    std::vector<bcm::GroupMsg> msgs;
+    REQUIRE(groupMsgs.batchGet(gid, 1, 10, 0, bcm::GroupUser::ROLE_MEMBER, false, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.size() == 1);
+    REQUIRE(msgs[0].status() == bcm::GroupMsg::STATUS_RECALLED);
+    msgs.clear();
+    REQUIRE(groupMsgs.batchGet(gid, 1, 10, 0, bcm::GroupUser::ROLE_MEMBER, true, msgs) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.size() == 2);
+
+    std::vector<bcm::GroupUser> users(3);
+    users[0].set_uid("c");
+    users[0].set_role(bcm::GroupUser::ROLE_OWNER);
+    users[0].set_createtime(1);
+    users[1].set_uid("b");
+    users[1].set_role(bcm::GroupUser::ROLE_MEMBER);
+    users[1].set_createtime(2);
+    users[2].set_uid("a");
+    users[2].set_role(bcm::GroupUser::ROLE_SUBSCRIBER);
+    users[2].set_createtime(2);
+    for (auto& user : users) {
+        user.set_gid(gid);
+    }
+    REQUIRE(groupUsers.insertBatch(users) == ERRORCODE_SUCCESS);
+
+    GroupCounter counter;
+    REQUIRE(groupUsers.queryGroupMemberInfoByGid(gid, counter) == ERRORCODE_SUCCESS);
+    REQUIRE(counter.owner == "c");
+    REQUIRE(counter.memberCnt == 2);
+    REQUIRE(counter.subscriberCnt == 1);
+
+    std::vector<bcm::GroupUser> ordered;
+    REQUIRE(groupUsers.getMembersOrderByCreateTime(gid,
+                                                   {bcm::GroupUser::ROLE_OWNER, bcm::GroupUser::ROLE_MEMBER,
+                                                    bcm::GroupUser::ROLE_SUBSCRIBER},
+                                                   "", 0, 10, ordered) == ERRORCODE_SUCCESS);
+    REQUIRE(ordered.size() == 3);
+    REQUIRE(ordered[0].uid() == "c");
+    REQUIRE(ordered[1].uid() == "a");
+    REQUIRE(ordered[2].uid() == "b");
+
+    REQUIRE(groupUsers.updateIfEmpty(gid, "b", nlohmann::json({{"last_ack_mid", 2}})) == ERRORCODE_SUCCESS);
+    REQUIRE(groupUsers.updateIfEmpty(gid, "b", nlohmann::json({{"last_ack_mid", 3}})) == ERRORCODE_ALREADY_EXSITED);
+    REQUIRE(groupUsers.updateLastAckMidBatch({{gid, "a", 5}, {gid, "b", 7}, {gid, "z", 9}}) == ERRORCODE_SUCCESS);
+    bcm::GroupUser member;
+    REQUIRE(groupUsers.getMember(gid, "b", member) == ERRORCODE_SUCCESS);
+    REQUIRE(member.lastackmid() == 7);
+
+    std::vector<uint64_t> gids;
+    REQUIRE(groupUsers.getJoinedGroups("a", gids) == ERRORCODE_SUCCESS);
+    REQUIRE(gids == std::vector<uint64_t>({gid}));
+    REQUIRE(groupUsers.delMember(gid, "a") == ERRORCODE_SUCCESS);
+    gids.clear();
+    REQUIRE(groupUsers.getJoinedGroups("a", gids) == ERRORCODE_SUCCESS);
+    REQUIRE(gids.empty());
+}
+
+TEST_CASE("LocalGroupKeys")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    GroupKeysLocalImpl groupKeys(store);
+
+    bcm::GroupKeys keys;
+    keys.set_gid(7);
+    keys.set_version(1);
+    REQUIRE(groupKeys.insert(keys) == ERRORCODE_SUCCESS);
+    keys.set_version(2);
+    keys.set_mode(bcm::GroupKeys::ONE_FOR_ALL);
+    REQUIRE(groupKeys.insert(keys) == ERRORCODE_SUCCESS);
+    REQUIRE(groupKeys.insert(keys) == ERRORCODE_CAS_FAIL);
+
+    bcm::dao::rpc::LatestModeAndVersion mv;
+    REQUIRE(groupKeys.getLatestModeAndVersion(7, mv) == ERRORCODE_SUCCESS);
+    REQUIRE(mv.version() == 2);
+    REQUIRE(mv.mode() == bcm::GroupKeys::ONE_FOR_ALL);
+    REQUIRE(groupKeys.getLatestModeAndVersion(8, mv) == ERRORCODE_NO_SUCH_DATA);
+}
+
+TEST_CASE("LocalSysMsgsAndKeys")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    SysMsgsLocalImpl sysMsgs(store);
+    for (uint64_t i = 1; i <= 5; ++i) {
+        bcm::SysMsg msg;
+        msg.set_destination("uid1");
+        msg.set_sysmsgid(i);
+        REQUIRE(sysMsgs.insert(msg) == ERRORCODE_SUCCESS);
+    }
+    REQUIRE(sysMsgs.delBatch("uid1", 2) == ERRORCODE_SUCCESS);
+    std::vector<bcm::SysMsg> msgs;
+    REQUIRE(sysMsgs.get("uid1", msgs, 2) == ERRORCODE_SUCCESS);
+    REQUIRE(msgs.size() == 2);
+    REQUIRE(msgs[0].sysmsgid() == 5);
+    REQUIRE(msgs[1].sysmsgid() == 4);
+
+    OnetimeKeysLocalImpl onetimeKeys(store);
+    std::vector<bcm::OnetimeKey> keys(2);
+    keys[0].set_keyid(20);
+    keys[1].set_keyid(10);
+    REQUIRE(onetimeKeys.set("uid1", 1, keys, "", bcm::SignedPreKey()) == ERRORCODE_SUCCESS);
+    REQUIRE(onetimeKeys.set("uid1", 2, keys, "", bcm::SignedPreKey()) == ERRORCODE_SUCCESS);
+
+    bcm::OnetimeKey key;
+    REQUIRE(onetimeKeys.get("uid1", 1, key) == ERRORCODE_SUCCESS);
+    REQUIRE(key.keyid() == 10);
+    std::vector<bcm::OnetimeKey> popped;
+    REQUIRE(onetimeKeys.get("uid1", popped) == ERRORCODE_SUCCESS);
+    REQUIRE(popped.size() == 2);
+    REQUIRE(popped[0].keyid() == 20);
+    REQUIRE(popped[1].keyid() == 10);
+    uint32_t count = 0;
+    REQUIRE(onetimeKeys.getCount("uid1", 2, count) == ERRORCODE_SUCCESS);
+    REQUIRE(count == 1);
+}
+
+TEST_CASE("LocalMasterLease")
+{
+    TempStore temp;
+    auto& store = temp.store;
+    MasterLeaseLocalImpl first(store);
+    MasterLeaseLocalImpl second(store);
+
+    REQUIRE(first.getLease("lease", 10000) == ERRORCODE_SUCCESS);
+    REQUIRE(second.getLease("lease", 10000) == ERRORCODE_CAS_FAIL);
+    REQUIRE(second.renewLease("lease", 10000) == ERRORCODE_CAS_FAIL);
+    REQUIRE(first.renewLease("lease", 10000) == ERRORCODE_SUCCESS);
+    REQUIRE(first.releaseLease("lease") == ERRORCODE_SUCCESS);
+    REQUIRE(second.getLease("lease", 10000) == ERRORCODE_SUCCESS);
+}
+
+TEST_CASE("LocalStoreTempDirRemoved")
+{
+    boost::filesystem::path path;
+    {
+        TempStore temp;
+        path = temp.path;
+        REQUIRE(temp.store->put(LocalKey("s").str("a").u64(1), "1") == ERRORCODE_SUCCESS);
+        REQUIRE(boost::filesystem::exists(path));
+    }
+    REQUIRE_FALSE(boost::filesystem::exists(path));
+}
@@ -998,7 +998,7 @@ TEST_CASE("group_message_key")
 
         for (const auto& v : noneCachedVersions) {
             auto* cache = bcm::dao::GroupKeysRpcImpl::CacheManager::getInstance();
-            cache->m_caches.m_caches.erase(cache->cacheKey(gid_keys.first, v));
+            cache->m_caches.erase(cache->cacheKey(gid_keys.first, v));
         }
         result.clear();
         REQUIRE(gk->get(gid_keys.first, versions, result) == bcm::dao::ErrorCode::ERRORCODE_SUCCESS);
@@ -0,0 +1,95 @@
+#include "../test_common.h"
+
+#include <brpc/channel.h>
+#include <brpc/server.h>
+#include <bthread/bthread.h>
+
+#include "dao/rpc_impl/signup_challenges_rpc_impl.h"
+#include "fiber/fiber_pool.h"
+#include "utils/time.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace bcm;
+
+// answers every request after a fixed delay
+class SlowSignUpChallengeService : public bcm::dao::rpc::SignUpChallengeService {
+public:
+    explicit SlowSignUpChallengeService(int64_t latencyInMilli)
+        : m_latencyInMilli(latencyInMilli)
+    {
+    }
+
+    void getSignUpChallenge(google::protobuf::RpcController*,
+                            const bcm::dao::rpc::GetSignUpChallengeReq* request,
+                            bcm::dao::rpc::GetSignUpChallengeResp* response,
+                            google::protobuf::Closure* done) override
+    {
+        brpc::ClosureGuard guard(done);
+        bthread_usleep(m_latencyInMilli * 1000);
+        response->set_rescode(dao::ErrorCode::ERRORCODE_SUCCESS);
+        response->mutable_challenge()->set_difficulty(request->uid().size());
+    }
+
+private:
+    int64_t m_latencyInMilli;
+};
+
+TEST_CASE("RpcCallSuspendsOnlyTheCallingFiber")
+{
+    const int64_t kLatency = 300;
+    SlowSignUpChallengeService service(kLatency);
+    brpc::Server server;
+    REQUIRE(server.AddService(&service, brpc::SERVER_DOESNT_OWN_SERVICE) == 0);
+    REQUIRE(server.Start("127.0.0.1:0", nullptr) == 0);
+
+    brpc::Channel channel;
+    brpc::ChannelOptions options;
+    options.timeout_ms = 5000;
+    std::string address = "127.0.0.1:" + std::to_string(server.listen_address().port);
+    REQUIRE(channel.Init(address.c_str(), &options) == 0);
+    dao::SignupChallengesRpcImpl challenges(&channel);
+
+    // a single worker thread, a blocking call would stall the ticking fiber
+    FiberPool pool(1);
+    pool.run("fiber.rpc.test");
+    auto& ioc = pool.getIOContext();
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> ticks{0};
+    FiberPool::post(ioc, [&stop, &ticks]() {
+        while (!stop) {
+            boost::this_fiber::sleep_for(std::chrono::milliseconds(1));
+            ++ticks;
+        }
+    });
+
+    std::atomic<int> ticksDuringCall{-1};
+    std::atomic<bool> finished{false};
+    dao::ErrorCode ec = dao::ErrorCode::ERRORCODE_INTERNAL_ERROR;
+    bcm::SignUpChallenge challenge;
+    FiberPool::post(ioc, [&]() {
+        int before = ticks;
+        ec = challenges.get("uid_1234", challenge);
+        ticksDuringCall = ticks - before;
+        finished = true;
+    });
+
+    int64_t deadline = nowInMilli() + 5000;
+    while (!finished && nowInMilli() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    stop = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pool.stop();
+    server.Stop(0);
+    server.Join();
+
+    REQUIRE(finished);
+    REQUIRE(ec == dao::ErrorCode::ERRORCODE_SUCCESS);
+    REQUIRE(challenge.difficulty() == 8);
+    TLOG << "ticks while waiting " << kLatency << "ms for the response: " << ticksDuringCall;
+    // the other fiber kept running all along, not just once the call returned
+    REQUIRE(ticksDuringCall > kLatency / 4);
+}
@@ -0,0 +1,148 @@
+#include "../test_common.h"
+
+#include <brpc/server.h>
+#include <bthread/bthread.h>
+
+#include "dao/rpc_impl/dao_channel.h"
+#include "dao/rpc_impl/signup_challenges_rpc_impl.h"
+#include "utils/time.h"
+
+#include <atomic>
+
+using namespace bcm;
+
+static const std::string kMethod = "SignUpChallengeService.getSignUpChallenge";
+
+// fast replies, except that every slowEvery-th request stalls for slowInMilli
+class TailSignUpChallengeService : public bcm::dao::rpc::SignUpChallengeService {
+public:
+    TailSignUpChallengeService(int slowEvery, int64_t slowInMilli)
+        : m_slowEvery(slowEvery)
+        , m_slowInMilli(slowInMilli)
+    {
+    }
+
+    void getSignUpChallenge(google::protobuf::RpcController*,
+                            const bcm::dao::rpc::GetSignUpChallengeReq* request,
+                            bcm::dao::rpc::GetSignUpChallengeResp* response,
+                            google::protobuf::Closure* done) override
+    {
+        brpc::ClosureGuard guard(done);
+        if (++m_requests % m_slowEvery == 0) {
+            bthread_usleep(m_slowInMilli * 1000);
+        }
+        response->set_rescode(dao::ErrorCode::ERRORCODE_SUCCESS);
+        response->mutable_challenge()->set_difficulty(request->uid().size());
+    }
+
+private:
+    int m_slowEvery;
+    int64_t m_slowInMilli;
+    std::atomic<int> m_requests{0};
+};
+
+class TailServer {
+public:
+    TailServer(int slowEvery, int64_t slowInMilli)
+        : m_service(slowEvery, slowInMilli)
+    {
+        REQUIRE(m_server.AddService(&m_service, brpc::SERVER_DOESNT_OWN_SERVICE) == 0);
+        REQUIRE(m_server.Start("127.0.0.1:0", nullptr) == 0);
+    }
+
+    ~TailServer()
+    {
+        m_server.Stop(0);
+        m_server.Join();
+    }
+
+    void connect(dao::DaoChannel& channel, const DaoMethodConfig& methodConfig)
+    {
+        DaoConfig config;
+        config.remote.methods[kMethod] = methodConfig;
+        channel.configure(config);
+
+        brpc::ChannelOptions options;
+        options.timeout_ms = 2000;
+        options.max_retry = 0;
+        std::string address = "127.0.0.1:" + std::to_string(m_server.listen_address().port);
+        REQUIRE(channel.Init(address.c_str(), &options) == 0);
+    }
+
+private:
+    TailSignUpChallengeService m_service;
+    brpc::Server m_server;
+};
+
+TEST_CASE("LatencyWindow")
+{
+    dao::LatencyWindow window(90);
+    for (size_t i = 1; i < dao::LatencyWindow::kMinSamples; ++i) {
+        window.add(static_cast<int64_t>(i));
+    }
+    REQUIRE(window.percentileUs() == -1);
+
+    window.add(0);
+    for (size_t i = 0; i < dao::LatencyWindow::kSize; ++i) {
+        window.add(static_cast<int64_t>(i % 100) + 1);
+    }
+    REQUIRE(window.percentileUs() == 90);
+}
+
+TEST_CASE("MethodTimeout")
+{
+    TailServer server(1, 300);
+    dao::DaoChannel channel;
+    DaoMethodConfig methodConfig;
+    methodConfig.timeout = 50;
+    server.connect(channel, methodConfig);
+    dao::SignupChallengesRpcImpl challenges(&channel);
+
+    bcm::SignUpChallenge challenge;
+    int64_t start = nowInMilli();
+    REQUIRE(challenges.get("uid_1234", challenge) == dao::ErrorCode::ERRORCODE_INTERNAL_ERROR);
+    REQUIRE(nowInMilli() - start < 250);
+
+    dao::DaoChannel::MethodStats stats;
+    REQUIRE(channel.stats(kMethod, stats));
+    REQUIRE(stats.calls == 1);
+    REQUIRE(stats.failures == 1);
+}
+
+TEST_CASE("HedgedReadCutsTheTail")
+{
+    const int kSlowEvery = 20;
+    const int64_t kSlowInMilli = 100;
+    TailServer server(kSlowEvery, kSlowInMilli);
+    dao::DaoChannel channel;
+    DaoMethodConfig methodConfig;
+    methodConfig.hedgePercentile = 90;
+    methodConfig.hedgeMinMs = 5;
+    server.connect(channel, methodConfig);
+    dao::SignupChallengesRpcImpl challenges(&channel);
+
+    // learn the latency of the method first
+    bcm::SignUpChallenge challenge;
+    for (size_t i = 0; i < dao::LatencyWindow::kMinSamples; ++i) {
+        REQUIRE(challenges.get("uid_1234", challenge) == dao::ErrorCode::ERRORCODE_SUCCESS);
+    }
+    dao::DaoChannel::MethodStats stats;
+    REQUIRE(channel.stats(kMethod, stats));
+    REQUIRE(stats.hedged == 0);
+    REQUIRE(stats.backupRequestMs >= methodConfig.hedgeMinMs);
+    REQUIRE(stats.backupRequestMs < kSlowInMilli);
+
+    int64_t slowest = 0;
+    for (int i = 0; i < 10 * kSlowEvery; ++i) {
+        int64_t start = nowInMilli();
+        REQUIRE(challenges.get("uid_1234", challenge) == dao::ErrorCode::ERRORCODE_SUCCESS);
+        slowest = std::max(slowest, nowInMilli() - start);
+    }
+
+    REQUIRE(channel.stats(kMethod, stats));
+    TLOG << "backup after " << stats.backupRequestMs << "ms, hedged " << stats.hedged
+         << ", won at most " << stats.hedgeWinsUpperBound << ", slowest " << slowest << "ms";
+    REQUIRE(stats.hedged >= 5);
+    REQUIRE(stats.hedgeWinsUpperBound >= 5);
+    REQUIRE(slowest < kSlowInMilli / 2);
+}
@@ -0,0 +1,215 @@
+#include "../redis/local_redis.h"
+#include <event2/thread.h>
+#include "dispatcher/connect_throttle.h"
+#include "dispatcher/dispatch_manager.h"
+#include "fiber/fiber_pool.h"
+#include "redis/hiredis_client.h"
+#include "redis/online_redis_manager.h"
+#include "redis/redis_manager.h"
+#include "websocket/websocket_session.h"
+#include <metrics_client.h>
+#include "config/group_store_format.h"
+
+using namespace bcm;
+using namespace bcm::metrics;
+
+static LocalRedis gs_redis(6382);
+static const int kDevices = 20000;
+static const int kSessionThreads = 4;
+
+// counts the device channels confirmed by redis, a device is fully online from then on
+class CountingDispatchManager : public DispatchManager {
+public:
+    CountingDispatchManager(const DispatcherConfig& config, EncryptSenderConfig& encryptSenderConfig)
+        : DispatchManager(config, nullptr, nullptr, nullptr, encryptSenderConfig)
+    {
+    }
+
+    void onSubscribe(const std::string& chan) override
+    {
+        ++subscribed;
+        DispatchManager::onSubscribe(chan);
+    }
+
+    std::atomic<int> subscribed{0};
+};
+
+static DispatchAddress deviceOf(int i)
+{
+    return DispatchAddress("uid_" + std::to_string(i), 1);
+}
+
+static int countBadges()
+{
+    std::vector<RedisDbCmd> cmds;
+    for (int i = 0; i < kDevices; ++i) {
+        std::string uid = deviceOf(i).getUid();
+        cmds.push_back(RedisDbCmd::keyCmd(uid, {"EXISTS", REDISDB_KEY_APNS_UID_BADGE_PREFIX + uid}));
+    }
+    std::vector<RedisCmdResult> results;
+    REQUIRE(RedisDbManager::Instance()->pipeline(cmds, results));
+    int count = 0;
+    for (const auto& result : results) {
+        count += static_cast<int>(result.integer);
+    }
+    return count;
+}
+
+static void setBadges()
+{
+    std::vector<RedisDbCmd> cmds;
+    for (int i = 0; i < kDevices; ++i) {
+        std::string uid = deviceOf(i).getUid();
+        cmds.push_back(RedisDbCmd::keyCmd(uid, {"SET", REDISDB_KEY_APNS_UID_BADGE_PREFIX + uid, "3"}));
+    }
+    std::vector<RedisCmdResult> results;
+    REQUIRE(RedisDbManager::Instance()->pipeline(cmds, results));
+    REQUIRE(countBadges() == kDevices);
+}
+
+TEST_CASE("ConnectThrottleBudget")
+{
+    DispatcherConfig config;
+    config.maxConcurrentSubscribes = 4;
+    ConnectThrottle throttle(config);
+
+    std::atomic<int> inside(0);
+    std::atomic<int> peak(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; ++i) {
+        threads.emplace_back([&throttle, &inside, &peak]() {
+            for (int j = 0; j < 50; ++j) {
+                throttle.acquire();
+                int now = ++inside;
+                int seen = peak;
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                --inside;
+                throttle.release();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ConnectThrottle::Stats stats = throttle.stats();
+    REQUIRE(peak <= 4);
+    REQUIRE(stats.peakConcurrent <= 4);
+    REQUIRE(stats.admitted == 16 * 50);
+    REQUIRE(stats.waited > 0);
+}
+
+TEST_CASE("ConnectThrottleSlot")
+{
+    DispatcherConfig config;
+    config.maxConcurrentSubscribes = 1;
+    ConnectThrottle throttle(config);
+
+    // a connect failing half way gives its slot back
+    try {
+        ConnectThrottle::Slot slot(throttle);
+        throw std::runtime_error("subscribe failed");
+    } catch (const std::runtime_error&) {
+    }
+    {
+        ConnectThrottle::Slot slot(throttle);
+    }
+
+    ConnectThrottle::Stats stats = throttle.stats();
+    REQUIRE(stats.admitted == 2);
+    REQUIRE(stats.waited == 0);
+    REQUIRE(stats.peakConcurrent == 1);
+}
+
+// a local redis-server and waits of seconds, too slow for the default run
+TEST_CASE("ConnectStorm", "[.][benchmark]")
+{
+    evthread_use_pthreads();
+    gs_redis.start();
+
+    // every session reports itself active
+    MetricsConfig metricsConfig;
+    metricsConfig.appVersion = "1.0";
+    metricsConfig.reportQueueSize = 5000;
+    metricsConfig.metricsDir = "/tmp";
+    metricsConfig.metricsFileSizeInBytes = 1024 * 10;
+    metricsConfig.metricsFileCount = 5;
+    metricsConfig.reportIntervalInMs = 3000;
+    metricsConfig.clientId = "00001";
+    metricsConfig.writeThresholdInBytes = 1024 * 1024;
+    MetricsClient::Init(metricsConfig);
+
+    RedisConfig redis = gs_redis.config();
+    RedisDbManager::Instance()->setRedisDbConfig({{"p0", {{"0", redis}}}});
+    RedisClientSync::Instance()->setRedisConfig(std::vector<RedisConfig>{redis});
+    std::map<std::string, std::vector<RedisConfig>> onlineRedis;
+    onlineRedis["p0"] = {redis};
+    OnlineRedisManager::Instance()->init(onlineRedis);
+    OnlineRedisManager::Instance()->start();
+
+    // the apns qos manager listening to the online notifications
+    CountingHandler notified;
+    OnlineRedisManager::Instance()->psubscribe("on:*", &notified);
+    REQUIRE(LocalRedis::waitFor([&notified]() { return notified.subscribed > 0; }, 2000));
+
+    setBadges();
+
+    DispatcherConfig config;
+    config.concurrency = 4;
+    config.maxConcurrentSubscribes = 8;
+    config.connectBatchSize = 500;
+    config.connectBatchDelayInMilli = 5;
+    EncryptSenderConfig encryptSenderConfig;
+    auto manager = std::make_shared<CountingDispatchManager>(config, encryptSenderConfig);
+    manager->start();
+
+    // the websocket session fibers of the http workers, sessions without a stream
+    // skip the stored messages once subscribed
+    FiberPool sessions(kSessionThreads);
+    sessions.run("test.session");
+
+    // every device of the failed over server connects at once
+    std::atomic<int> connected(0);
+    int64_t start = nowInMilli();
+    for (int i = 0; i < kDevices; ++i) {
+        FiberPool::post(sessions.getIOContext(), [manager, i, &connected]() {
+            DispatchAddress address = deviceOf(i);
+            auto session = std::make_shared<WebsocketSession>(nullptr, nullptr, address.getUid(),
+                                                              WebsocketService::REQUESTID_AUTH);
+            manager->subscribe(address, session);
+            ++connected;
+        });
+    }
+    REQUIRE(LocalRedis::waitFor([&connected]() { return connected == kDevices; }, 3000));
+    int64_t admitted = nowInMilli() - start;
+
+    bool online = LocalRedis::waitFor([&manager, &notified]() {
+        return manager->subscribed == kDevices && notified.messages == kDevices;
+    }, 3000);
+    int64_t fullyOnline = nowInMilli() - start;
+
+    ConnectThrottle::Stats stats = manager->getConnectStats();
+    TLOG << kDevices << " devices subscribed in " << admitted << "ms, fully online in " << fullyOnline << "ms, "
+         << stats.batches << " batches, peak pending " << stats.peakPending
+         << ", peak concurrent " << stats.peakConcurrent << ", waited " << stats.waited;
+
+    REQUIRE(online);
+    REQUIRE(manager->getDispatchCount() == kDevices);
+    REQUIRE(stats.admitted == static_cast<uint64_t>(kDevices));
+    REQUIRE(stats.peakConcurrent <= 8);
+    REQUIRE(stats.sent == static_cast<uint64_t>(kDevices));
+    REQUIRE(stats.failedBatches == 0);
+    REQUIRE(stats.batches < static_cast<uint64_t>(kDevices) / 10);
+    REQUIRE(countBadges() == 0);
+
+    std::vector<std::string> channels;
+    for (int i = 0; i < kDevices; ++i) {
+        channels.push_back(deviceOf(i).getSerialized());
+    }
+    OnlineRedisManager::Instance()->unsubscribeBatch(channels);
+    sessions.stop();
+    manager->stop();
+    gs_redis.stop();
+}
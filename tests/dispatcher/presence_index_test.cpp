@@ -0,0 +1,308 @@
+#include "../test_common.h"
+#include "../redis/local_redis.h"
+
+#include <event2/event.h>
+#include <event2/thread.h>
+#include <map>
+#include <random>
+#include <set>
+#include <tuple>
+#include <thread>
+
+#include "dispatcher/presence_index.h"
+#include "redis/async_conn.h"
+#include "redis/online_redis_manager.h"
+#include "redis/reply.h"
+#include "utils/time.h"
+#include "proto/message/message_protocol.pb.h"
+
+using namespace bcm;
+
+static const std::string kChannel = "presence";
+
+// delivers every published message to the other indexes, as the online redis does
+class PresenceBus {
+public:
+    PresenceIndex::Publisher publisher()
+    {
+        return [this](const std::string& chan, const std::string& msg) {
+            ++published;
+            if (drop) {
+                return;
+            }
+            for (auto index : indexes) {
+                index->onMessage(chan, msg);
+            }
+        };
+    }
+
+    std::vector<PresenceIndex*> indexes;
+    bool drop{false};
+    int published{0};
+};
+
+static PresenceConfig testConfig()
+{
+    PresenceConfig config;
+    config.enabled = true;
+    config.channel = kChannel;
+    config.flushIntervalInMilli = 0;
+    // every run sends a snapshot
+    config.snapshotIntervalInMilli = 0;
+    config.nodeTimeoutInMilli = 60000;
+    config.maxBatch = 100;
+    return config;
+}
+
+TEST_CASE("PresenceTable")
+{
+    PresenceTable table;
+    std::mt19937_64 rng(7);
+    // (uid hash, device, node), few uids to get long shared probe runs
+    std::set<std::tuple<uint64_t, uint32_t, uint16_t>> expected;
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t uidHash = PresenceIndex::hashUid("uid_" + std::to_string(rng() % 20000));
+        auto deviceId = static_cast<uint32_t>(rng() % 4 + 1);
+        auto node = static_cast<uint16_t>(rng() % 3);
+        auto key = std::make_tuple(uidHash, deviceId, node);
+        if (rng() % 3 == 0) {
+            REQUIRE(table.remove(uidHash, deviceId, node) == (expected.erase(key) == 1));
+        } else {
+            REQUIRE(table.add(uidHash, deviceId, node, 1) == expected.insert(key).second);
+        }
+    }
+    REQUIRE(table.size() == expected.size());
+    for (const auto& item : expected) {
+        REQUIRE(table.find(std::get<0>(item), std::get<1>(item)) != PresenceTable::kInvalidNode);
+        REQUIRE(table.contains(std::get<0>(item)));
+    }
+
+    size_t onNode1 = 0;
+    table.forEach(1, [&onNode1](uint64_t, uint32_t) { ++onNode1; });
+    REQUIRE(table.removeNode(1) == onNode1);
+    for (const auto& item : expected) {
+        if (std::get<2>(item) != 1) {
+            REQUIRE(table.find(std::get<0>(item), std::get<1>(item)) != PresenceTable::kInvalidNode);
+        }
+    }
+
+    // purge keeps the devices resent with the generation only
+    uint64_t uidHash = PresenceIndex::hashUid("uid_purge");
+    table.add(uidHash, 1, 0, 2);
+    table.add(uidHash, 2, 0, 3);
+    table.purge(0, 3);
+    REQUIRE(table.find(uidHash, 1) == PresenceTable::kInvalidNode);
+    REQUIRE(table.find(uidHash, 2) == 0);
+    REQUIRE(!table.contains(PresenceIndex::hashUid("uid_unknown")));
+}
+
+TEST_CASE("PresenceIndexDeltas")
+{
+    PresenceBus bus;
+    PresenceIndex a(testConfig(), "10.0.0.1:8080", bus.publisher());
+    PresenceIndex b(testConfig(), "10.0.0.2:8080", bus.publisher());
+    // the offline server only follows
+    PresenceIndex observer(testConfig(), "", bus.publisher());
+    bus.indexes = {&a, &b, &observer};
+    REQUIRE(!observer.isReady());
+    for (auto index : bus.indexes) {
+        index->onSubscribe(kChannel);
+    }
+    REQUIRE(observer.isReady());
+
+    DispatchAddress alice("alice", 1);
+    DispatchAddress aliceTablet("alice", 2);
+    DispatchAddress bob("bob", 1);
+    a.onUserOnline(alice);
+    b.onUserOnline(aliceTablet);
+    b.onUserOnline(bob);
+    // local devices are known at once, the others after a flush
+    REQUIRE(a.isOnline(alice));
+    REQUIRE(!observer.isOnline(alice));
+    a.run();
+    b.run();
+
+    for (auto index : bus.indexes) {
+        REQUIRE(index->isOnline("alice"));
+        REQUIRE(index->isOnline(bob));
+        REQUIRE(!index->isOnline("carol"));
+        REQUIRE(index->locate(alice) == "10.0.0.1:8080");
+        REQUIRE(index->locate(aliceTablet) == "10.0.0.2:8080");
+        REQUIRE(index->locate(DispatchAddress("alice", 3)).empty());
+    }
+    REQUIRE(observer.stats().devices == 3);
+    REQUIRE(observer.stats().nodes == 2);
+    REQUIRE(b.stats().localDevices == 2);
+
+    // bob moves to a, the kick on b comes late and only removes the device of b
+    a.onUserOnline(bob);
+    a.run();
+    b.onUserOffline(bob);
+    b.run();
+    REQUIRE(observer.locate(bob) == "10.0.0.1:8080");
+
+    b.onUserOffline(aliceTablet);
+    b.run();
+    REQUIRE(!observer.isOnline(aliceTablet));
+    REQUIRE(observer.isOnline("alice"));
+
+    // b stops, everybody drops its devices
+    b.onUserOnline(aliceTablet);
+    b.run();
+    REQUIRE(observer.isOnline(aliceTablet));
+    b.stop();
+    REQUIRE(!observer.isOnline(aliceTablet));
+    REQUIRE(!a.isOnline(aliceTablet));
+    REQUIRE(observer.stats().nodes == 1);
+
+    observer.onMessage(kChannel, "garbage");
+    REQUIRE(observer.stats().messagesDropped == 1);
+}
+
+TEST_CASE("PresenceIndexRepair")
+{
+    PresenceBus bus;
+    PresenceConfig config = testConfig();
+    config.nodeTimeoutInMilli = 50;
+    PresenceIndex a(config, "10.0.0.1:8080", bus.publisher());
+    PresenceIndex observer(config, "", bus.publisher());
+    bus.indexes = {&a, &observer};
+    observer.onSubscribe(kChannel);
+
+    DispatchAddress alice("alice", 1);
+    DispatchAddress bob("bob", 1);
+    a.onUserOnline(alice);
+    a.run();
+    REQUIRE(observer.isOnline(alice));
+
+    // the offline of alice and the online of bob are lost, the next snapshot repairs both
+    bus.drop = true;
+    a.onUserOffline(alice);
+    a.onUserOnline(bob);
+    a.run();
+    REQUIRE(observer.isOnline(alice));
+    REQUIRE(!observer.isOnline(bob));
+    bus.drop = false;
+    a.run();
+    REQUIRE(!observer.isOnline(alice));
+    REQUIRE(observer.isOnline(bob));
+
+    // a goes silent
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    observer.run();
+    REQUIRE(!observer.isOnline(bob));
+    REQUIRE(observer.stats().nodes == 0);
+    REQUIRE(bus.published > 0);
+}
+
+TEST_CASE("PresenceIndexMemory")
+{
+    PresenceBus bus;
+    PresenceConfig config = testConfig();
+    config.maxBatch = 4096;
+    PresenceIndex a(config, "10.0.0.1:8080", bus.publisher());
+    PresenceIndex observer(config, "", bus.publisher());
+    bus.indexes = {&observer};
+
+    const int kUsers = 200000;
+    for (int i = 0; i < kUsers; ++i) {
+        a.onUserOnline(DispatchAddress("uid_" + std::to_string(i), 1));
+    }
+    a.run();
+    PresenceIndex::Stats stats = observer.stats();
+    REQUIRE(stats.devices == static_cast<uint64_t>(kUsers));
+    TLOG << stats.devices << " devices in " << stats.memory << " bytes, "
+         << stats.memory / stats.devices << " bytes per device, "
+         << bus.published << " messages";
+    // 16 byte slots, at most 3/4 used after growing
+    REQUIRE(stats.memory / stats.devices <= 48);
+    for (int i = 0; i < kUsers; i += 97) {
+        REQUIRE(observer.isOnline(DispatchAddress("uid_" + std::to_string(i), 1)));
+    }
+}
+
+// the online redis of the PUBLISH baseline
+static LocalRedis gs_redis(6385);
+
+TEST_CASE("PresenceIndexQueryLatency", "[.][benchmark]")
+{
+    PresenceBus bus;
+    PresenceIndex a(testConfig(), "10.0.0.1:8080", bus.publisher());
+    const int kUsers = 1000000;
+    for (int i = 0; i < kUsers; ++i) {
+        a.onUserOnline(DispatchAddress("uid_" + std::to_string(i), 1));
+    }
+
+    std::vector<DispatchAddress> addresses;
+    for (int i = 0; i < 1000; ++i) {
+        addresses.emplace_back("uid_" + std::to_string(i * 997), 1);
+    }
+
+    const int kQueries = 1000000;
+    int online = 0;
+    int64_t start = nowInMicro();
+    for (int i = 0; i < kQueries; ++i) {
+        online += a.isOnline(addresses[i % addresses.size()]) ? 1 : 0;
+    }
+    int64_t spent = nowInMicro() - start;
+    REQUIRE(online == kQueries);
+    TLOG << "presence index: " << kUsers << " devices, "
+         << spent * 1000 / kQueries << " ns per query, " << a.stats().memory / kUsers << " bytes per device";
+
+    // the check ResendTask::onTimeout does without the index: a PUBLISH of a CHECK message
+    // on the device channel, online if its server is subscribed. one round trip per check
+    evthread_use_pthreads();
+    gs_redis.start();
+    std::map<std::string, std::vector<RedisConfig>> onlineRedis;
+    onlineRedis["p0"] = {gs_redis.config()};
+    OnlineRedisManager::Instance()->init(onlineRedis);
+    OnlineRedisManager::Instance()->start();
+    std::vector<std::string> chans;
+    for (const auto& address : addresses) {
+        chans.push_back(address.getSerialized());
+    }
+    CountingHandler subscribed;
+    REQUIRE(OnlineRedisManager::Instance()->subscribeBatch(chans, &subscribed));
+    REQUIRE(LocalRedis::waitFor([&subscribed, &chans]() {
+        return subscribed.subscribed == static_cast<int>(chans.size());
+    }, 2000));
+
+    PubSubMessage msg;
+    msg.set_type(PubSubMessage::CHECK);
+    std::string check;
+    msg.SerializeToString(&check);
+
+    const int kChecks = 10000;
+    struct event_base* eb = event_base_new();
+    redis::AsyncConn conn(eb, "127.0.0.1", gs_redis.port(), "");
+    int checked = 0;
+    int checkedOnline = 0;
+    std::function<void()> next = [&]() {
+        const std::string& chan = chans[checked % chans.size()];
+        conn.exec([&](int res, const redis::Reply& reply) {
+            if (REDIS_OK == res && reply.isInteger() && reply.getInteger() == 1) {
+                ++checkedOnline;
+            }
+            if (++checked < kChecks) {
+                next();
+                return;
+            }
+            spent = nowInMicro() - start;
+            conn.shutdown([](int status) { boost::ignore_unused(status); });
+        }, "PUBLISH %b %b", chan.c_str(), chan.size(), check.c_str(), check.size());
+    };
+    conn.start([&](int status) {
+        REQUIRE(REDIS_OK == status);
+        start = nowInMicro();
+        next();
+    });
+    event_base_dispatch(eb);
+    event_base_free(eb);
+
+    REQUIRE(checked == kChecks);
+    REQUIRE(checkedOnline == kChecks);
+    TLOG << "redis PUBLISH check: " << spent * 1000 / kChecks << " ns per query";
+
+    REQUIRE(OnlineRedisManager::Instance()->unsubscribeBatch(chans));
+    gs_redis.stop();
+}
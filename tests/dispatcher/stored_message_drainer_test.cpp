@@ -0,0 +1,238 @@
+#include "../test_common.h"
+
+#include <boost/fiber/all.hpp>
+#include <map>
+
+#include "dispatcher/stored_message_drainer.h"
+#include "utils/time.h"
+
+using namespace bcm;
+
+// in memory stored messages of one device, every call costs a round trip
+class MockStoredMessages : public dao::StoredMessages {
+public:
+    explicit MockStoredMessages(std::chrono::microseconds latency) : m_latency(latency) {}
+
+    dao::ErrorCode set(const bcm::StoredMessage& msg, uint32_t& unreadMsgCount) override
+    {
+        m_messages[++m_lastId] = msg;
+        m_messages[m_lastId].set_id(m_lastId);
+        unreadMsgCount = static_cast<uint32_t>(m_messages.size());
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    dao::ErrorCode get(const std::string&, uint32_t, uint32_t maxCount,
+                       std::vector<bcm::StoredMessage>& msgs) override
+    {
+        ++m_gets;
+        boost::this_fiber::sleep_for(m_latency);
+        for (const auto& item : m_messages) {
+            if (msgs.size() >= maxCount) {
+                break;
+            }
+            msgs.push_back(item.second);
+        }
+        return msgs.empty() ? dao::ERRORCODE_NO_SUCH_DATA : dao::ERRORCODE_SUCCESS;
+    }
+
+    dao::ErrorCode del(const std::string&, const std::vector<uint64_t>& msgId) override
+    {
+        ++m_dels;
+        boost::this_fiber::sleep_for(m_latency);
+        for (const auto& id : msgId) {
+            m_messages.erase(id);
+        }
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    dao::ErrorCode clear(const std::string&) override
+    {
+        m_messages.clear();
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    dao::ErrorCode clear(const std::string&, uint32_t) override
+    {
+        m_messages.clear();
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    std::chrono::microseconds m_latency;
+    std::map<uint64_t, bcm::StoredMessage> m_messages;
+    uint64_t m_lastId{0};
+    int m_gets{0};
+    int m_dels{0};
+};
+
+// a client answering every mailbox after rtt, or refusing the failAt-th one
+class MockClient {
+public:
+    explicit MockClient(std::chrono::microseconds rtt, int failAt = -1) : m_rtt(rtt), m_failAt(failAt) {}
+
+    StoredMessageDrainer::Sender sender()
+    {
+        return [this](const std::vector<StoredMessage>& batch) -> StoredMessageDrainer::Ack {
+            bool accept = (m_batches++ != m_failAt);
+            if (accept) {
+                for (const auto& message : batch) {
+                    m_received.push_back(message.id());
+                }
+            }
+            auto promise = std::make_shared<boost::fibers::promise<bool>>();
+            auto future = std::make_shared<boost::fibers::future<bool>>(promise->get_future());
+            auto rtt = m_rtt;
+            boost::fibers::fiber([promise, accept, rtt]() {
+                boost::this_fiber::sleep_for(rtt);
+                promise->set_value(accept);
+            }).detach();
+            return [future]() {
+                return future->get();
+            };
+        };
+    }
+
+    std::chrono::microseconds m_rtt;
+    int m_failAt;
+    int m_batches{0};
+    std::vector<uint64_t> m_received;
+};
+
+static void fill(MockStoredMessages& dao, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        bcm::StoredMessage message;
+        message.set_destination("uid");
+        message.set_content("message" + std::to_string(i));
+        uint32_t unread = 0;
+        dao.set(message, unread);
+    }
+}
+
+static StoredMessageDrainer::Verdict sendAll(const StoredMessage&)
+{
+    return StoredMessageDrainer::SEND;
+}
+
+// what the channel did before: read a batch, wait for the client, delete it, read again
+static void drainOneByOne(MessagesManager& messagesManager, MockClient& client)
+{
+    auto sender = client.sender();
+    bool hasMore = true;
+    while (hasMore) {
+        std::vector<StoredMessage> messages;
+        REQUIRE(messagesManager.get("uid", 1, 50, messages, hasMore));
+        if (messages.empty()) {
+            break;
+        }
+        REQUIRE(sender(messages)());
+        std::vector<uint64_t> ids;
+        for (const auto& message : messages) {
+            ids.push_back(message.id());
+        }
+        REQUIRE(messagesManager.del("uid", ids));
+    }
+}
+
+TEST_CASE("DrainInOrder")
+{
+    auto dao = std::make_shared<MockStoredMessages>(std::chrono::microseconds(100));
+    fill(*dao, 1234);
+    MessagesManager messagesManager(dao);
+    MockClient client(std::chrono::microseconds(300));
+
+    StoredMessageDrainer::Options options;
+    StoredMessageDrainer drainer(messagesManager, "uid", 1, options);
+    REQUIRE(drainer.drain(client.sender(), sendAll));
+
+    REQUIRE(dao->m_messages.empty());
+    REQUIRE(client.m_received.size() == 1234);
+    for (size_t i = 0; i < client.m_received.size(); ++i) {
+        REQUIRE(client.m_received[i] == i + 1);
+    }
+    REQUIRE(drainer.stats().sent == 1234);
+    REQUIRE(drainer.stats().batches == 25);
+    REQUIRE(dao->m_dels <= 8);
+}
+
+TEST_CASE("DrainFilter")
+{
+    auto dao = std::make_shared<MockStoredMessages>(std::chrono::microseconds(0));
+    fill(*dao, 300);
+    MessagesManager messagesManager(dao);
+    MockClient client(std::chrono::microseconds(0));
+
+    // every third is dropped, every fifth of the others stays stored
+    auto filter = [](const StoredMessage& message) {
+        if (message.id() % 3 == 0) {
+            return StoredMessageDrainer::DROP;
+        }
+        if (message.id() % 5 == 0) {
+            return StoredMessageDrainer::KEEP;
+        }
+        return StoredMessageDrainer::SEND;
+    };
+    StoredMessageDrainer drainer(messagesManager, "uid", 1, StoredMessageDrainer::Options());
+    REQUIRE(drainer.drain(client.sender(), filter));
+
+    REQUIRE(drainer.stats().dropped == 100);
+    REQUIRE(dao->m_messages.size() == 40);
+    for (const auto& item : dao->m_messages) {
+        REQUIRE(item.first % 5 == 0);
+    }
+    REQUIRE(client.m_received.size() == 160);
+}
+
+TEST_CASE("DrainStopsOnFailure")
+{
+    auto dao = std::make_shared<MockStoredMessages>(std::chrono::microseconds(0));
+    fill(*dao, 1000);
+    MessagesManager messagesManager(dao);
+    MockClient client(std::chrono::microseconds(100), 3);
+
+    StoredMessageDrainer drainer(messagesManager, "uid", 1, StoredMessageDrainer::Options());
+    REQUIRE(drainer.drain(client.sender(), sendAll) == false);
+
+    // the refused batch stays stored, batches already out when it was refused are deleted once acked
+    REQUIRE(dao->m_messages.begin()->first == 151);
+    REQUIRE(dao->m_messages.size() + client.m_received.size() == 1000);
+
+    // a later drain picks up where the failure left off
+    MockClient retry(std::chrono::microseconds(0));
+    StoredMessageDrainer again(messagesManager, "uid", 1, StoredMessageDrainer::Options());
+    REQUIRE(again.drain(retry.sender(), sendAll));
+    REQUIRE(dao->m_messages.empty());
+    REQUIRE(retry.m_received.front() == 151);
+}
+
+TEST_CASE("Drain10kQueuedMessages")
+{
+    const size_t kQueued = 10000;
+    const std::chrono::microseconds kDaoLatency(500);
+    const std::chrono::microseconds kClientRtt(1000);
+
+    auto legacyDao = std::make_shared<MockStoredMessages>(kDaoLatency);
+    fill(*legacyDao, kQueued);
+    MessagesManager legacyMessages(legacyDao);
+    MockClient legacyClient(kClientRtt);
+    int64_t start = nowInMilli();
+    drainOneByOne(legacyMessages, legacyClient);
+    int64_t legacyMs = nowInMilli() - start;
+    REQUIRE(legacyDao->m_messages.empty());
+
+    auto dao = std::make_shared<MockStoredMessages>(kDaoLatency);
+    fill(*dao, kQueued);
+    MessagesManager messagesManager(dao);
+    MockClient client(kClientRtt);
+    StoredMessageDrainer drainer(messagesManager, "uid", 1, StoredMessageDrainer::Options());
+    start = nowInMilli();
+    REQUIRE(drainer.drain(client.sender(), sendAll));
+    int64_t pipelinedMs = nowInMilli() - start;
+    REQUIRE(dao->m_messages.empty());
+    REQUIRE(client.m_received.size() == kQueued);
+
+    TLOG << "drained " << kQueued << " messages one batch at a time in " << legacyMs << "ms, "
+         << legacyDao->m_gets << " reads, " << legacyDao->m_dels << " deletes; pipelined in " << pipelinedMs
+         << "ms, " << dao->m_gets << " reads, " << dao->m_dels << " deletes";
+    REQUIRE(pipelinedMs * 2 < legacyMs);
+    REQUIRE(dao->m_dels * 3 < legacyDao->m_dels);
+}
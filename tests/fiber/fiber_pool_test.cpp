@@ -0,0 +1,227 @@
+#include "../test_common.h"
+
+#include "fiber/fiber_pool.h"
+#include "utils/time.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unistd.h>
+
+using namespace bcm;
+
+static bool waitFor(std::function<bool()> done, int64_t timeoutMillis)
+{
+    int64_t deadline = nowInMilli() + timeoutMillis;
+    while (!done()) {
+        if (nowInMilli() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST_CASE("FiberPoolWorkStealing")
+{
+    FiberPool pool(4, true);
+    pool.run("fiber.test");
+    auto& ioc = pool.getIOContext();
+
+    // a pinned fiber blocking its thread
+    std::atomic<bool> blocking{false};
+    FiberPool::post(ioc, [&blocking]() {
+        blocking = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        blocking = false;
+    });
+    REQUIRE(waitFor([&blocking]() { return blocking.load(); }, 1000));
+
+    // migratable work queued behind it is run by the other threads
+    std::atomic<int> done{0};
+    for (int i = 0; i < 100; ++i) {
+        FiberPool::postMigratable(ioc, [&done]() {
+            boost::this_fiber::yield();
+            ++done;
+        });
+    }
+    REQUIRE(waitFor([&done]() { return done == 100; }, 300));
+    REQUIRE(blocking);
+
+    // pinned fibers never leave their thread
+    std::atomic<int> pinned{0};
+    std::atomic<int> moved{0};
+    for (int i = 0; i < 8; ++i) {
+        FiberPool::post(pool.getIOContext(), [&pinned, &moved]() {
+            auto id = std::this_thread::get_id();
+            for (int j = 0; j < 100; ++j) {
+                boost::this_fiber::yield();
+                if (std::this_thread::get_id() != id) {
+                    ++moved;
+                }
+            }
+            ++pinned;
+        });
+    }
+    REQUIRE(waitFor([&pinned]() { return pinned == 8; }, 2000));
+    REQUIRE(moved == 0);
+
+    pool.stop();
+}
+
+static void skewedLoad(bool workStealing)
+{
+    const int kThreads = 4;
+    const int kBursts = 50;
+    const int kBurstSize = 200;
+
+    FiberPool pool(kThreads, workStealing);
+    pool.run("fiber.bench");
+    std::vector<asio::io_context*> iocs;
+    for (int i = 0; i < kThreads; ++i) {
+        iocs.push_back(&pool.getIOContext());
+    }
+
+    std::mutex mtx;
+    std::vector<int64_t> latencies;
+    std::atomic<int> done{0};
+    for (int burst = 0; burst < kBursts; ++burst) {
+        for (int i = 0; i < kBurstSize; ++i) {
+            // 70% of the requests land on one thread, one in 50 blocks it for 2ms
+            auto& ioc = (i % 10 < 7) ? *iocs[0] : *iocs[1 + i % (kThreads - 1)];
+            bool slow = (i % 50 == 0);
+            int64_t submitted = nowInMicro();
+            FiberPool::postMigratable(ioc, [&, slow, submitted]() {
+                if (slow) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                } else {
+                    int64_t until = nowInMicro() + 20;
+                    while (nowInMicro() < until);
+                }
+                std::lock_guard<std::mutex> l(mtx);
+                latencies.push_back(nowInMicro() - submitted);
+                ++done;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    REQUIRE(waitFor([&done]() { return done == kBursts * kBurstSize; }, 30000));
+    pool.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    TLOG << (workStealing ? "work stealing" : "round robin")
+         << ": p50 " << latencies[latencies.size() / 2] << " us"
+         << ", p99 " << latencies[latencies.size() * 99 / 100] << " us"
+         << ", max " << latencies.back() << " us";
+}
+
+TEST_CASE("FiberPoolSkewedLatency", "[.][benchmark]")
+{
+    skewedLoad(false);
+    skewedLoad(true);
+}
+
+TEST_CASE("StackPoolReuse")
+{
+    StackPool pool(10000, 2);
+    REQUIRE(pool.stackSize() % 4096 == 0);
+    REQUIRE(pool.stackSize() >= 10000);
+
+    auto first = pool.allocate();
+    auto second = pool.allocate();
+    auto third = pool.allocate();
+    REQUIRE(pool.allocated() == 3);
+    // the stack is writable from the top down to the guard page
+    static_cast<char*>(first.sp)[-1] = 1;
+    static_cast<char*>(first.sp)[-static_cast<int64_t>(pool.stackSize())] = 1;
+
+    void* firstSp = first.sp;
+    pool.deallocate(first);
+    pool.deallocate(second);
+    pool.deallocate(third);
+    REQUIRE(pool.allocated() == 0);
+    REQUIRE(pool.cached() == 2);
+    auto reused = pool.allocate();
+    REQUIRE(reused.sp != nullptr);
+    REQUIRE(pool.cached() == 1);
+    pool.deallocate(reused);
+
+    // fibers of a pool run on its stacks and hand them back when done
+    FiberPool fiberPool(2, false, 64 * 1024);
+    fiberPool.run("fiber.test");
+    std::atomic<int> done{0};
+    for (int i = 0; i < 1000; ++i) {
+        FiberPool::post(fiberPool.getIOContext(), [&done]() {
+            boost::this_fiber::yield();
+            ++done;
+        });
+    }
+    REQUIRE(waitFor([&done]() { return done == 1000; }, 3000));
+    REQUIRE(waitFor([&fiberPool]() { return fiberPool.stackPool().allocated() == 0; }, 1000));
+    REQUIRE(fiberPool.stackPool().cached() > 0);
+    REQUIRE(fiberPool.stackPool().stackSize() == 64 * 1024);
+    REQUIRE(firstSp != nullptr);
+    fiberPool.stop();
+}
+
+static int64_t residentKb()
+{
+    std::ifstream statm("/proc/self/statm");
+    int64_t size = 0;
+    int64_t resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void churn(const std::string& name, std::function<void(asio::io_context&, std::atomic<int>&)> spawn)
+{
+    const int kFibers = 200000;
+    FiberPool pool(1);
+    pool.run("fiber.bench");
+    auto& ioc = pool.getIOContext();
+
+    int64_t rss = residentKb();
+    std::atomic<int> done{0};
+    int64_t start = nowInMicro();
+    // spawn from a fiber on the pool thread, as session and dispatch fibers do
+    FiberPool::post(ioc, [&]() {
+        for (int i = 0; i < kFibers; ++i) {
+            spawn(ioc, done);
+            if (i % 64 == 0) {
+                boost::this_fiber::yield();
+            }
+        }
+    });
+    REQUIRE(waitFor([&done]() { return done == kFibers; }, 60000));
+    int64_t spent = nowInMicro() - start;
+    TLOG << name << ": " << static_cast<int64_t>(kFibers) * 1000000 / std::max<int64_t>(spent, 1)
+         << " fibers/s, rss +" << (residentKb() - rss) << " KB";
+    pool.stop();
+}
+
+TEST_CASE("FiberPoolChurn", "[.][benchmark]")
+{
+    churn("asio::post + default stack", [](asio::io_context& ioc, std::atomic<int>& done) {
+        // what FiberPool::post used to do
+        asio::post(ioc, [&done]() {
+            fibers::fiber([&done]() {
+                boost::this_fiber::yield();
+                ++done;
+            }).detach();
+        });
+    });
+    churn("fibers::fiber + default stack", [](asio::io_context&, std::atomic<int>& done) {
+        fibers::fiber([&done]() {
+            boost::this_fiber::yield();
+            ++done;
+        }).detach();
+    });
+    churn("FiberPool::post + pooled stack", [](asio::io_context& ioc, std::atomic<int>& done) {
+        FiberPool::post(ioc, [&done]() {
+            boost::this_fiber::yield();
+            ++done;
+        });
+    });
+}
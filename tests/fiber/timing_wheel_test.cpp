@@ -0,0 +1,176 @@
+#include "../test_common.h"
+
+#include "fiber/fiber_timer.h"
+#include "fiber/timing_wheel.h"
+#include "utils/time.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+
+using namespace bcm;
+
+static bool waitFor(std::function<bool()> done, int64_t timeoutMillis)
+{
+    int64_t deadline = nowInMilli() + timeoutMillis;
+    while (!done()) {
+        if (nowInMilli() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST_CASE("TimingWheel")
+{
+    // start right before several levels wrap
+    int64_t start = (1LL << 24) - 3;
+    TimingWheel wheel(start);
+    std::vector<int64_t> fired;
+    std::vector<TimingWheel::Callback> expired;
+    int64_t now = start;
+
+    std::vector<int64_t> delays = {0, 1, 2, 3, 255, 256, 257, 65535, 65536, 65537, 1 << 20, (1LL << 32) + 5};
+    for (auto delay : delays) {
+        wheel.schedule(start + delay, [&fired, &now]() { fired.push_back(now); });
+    }
+    auto canceled = wheel.schedule(start + 100, [&fired]() { fired.push_back(-1); });
+    REQUIRE(wheel.size() == delays.size() + 1);
+    REQUIRE(wheel.nextExpiry() == start);
+    REQUIRE(wheel.cancel(canceled));
+    REQUIRE_FALSE(wheel.cancel(canceled));
+    REQUIRE_FALSE(wheel.cancel(TimingWheel::kInvalidTimer));
+
+    // every timer fires exactly on its tick, stepping tick by tick and by large strides
+    for (auto delay : delays) {
+        while (now < start + delay) {
+            int64_t next = wheel.nextExpiry();
+            REQUIRE(next > now);
+            REQUIRE(next <= start + delay);
+            now = delay < 70000 ? now + 1 : next;
+            wheel.advance(now, expired);
+            for (auto& cb : expired) {
+                cb();
+            }
+            expired.clear();
+        }
+        if (delay == 0) {
+            wheel.advance(now, expired);
+            for (auto& cb : expired) {
+                cb();
+            }
+            expired.clear();
+        }
+        REQUIRE(!fired.empty());
+        REQUIRE(fired.back() == start + delay);
+    }
+    REQUIRE(fired.size() == delays.size());
+    REQUIRE(wheel.size() == 0);
+    REQUIRE(wheel.nextExpiry() == std::numeric_limits<int64_t>::max());
+
+    // timers due on the same tick fire in scheduling order, late advances catch up
+    std::vector<int> order;
+    for (int i = 0; i < 5; ++i) {
+        wheel.schedule(now + 1000, [&order, i]() { order.push_back(i); });
+    }
+    wheel.schedule(now - 10, [&order]() { order.push_back(-1); });
+    wheel.advance(now + 5000, expired);
+    for (auto& cb : expired) {
+        cb();
+    }
+    REQUIRE(order == std::vector<int>({-1, 0, 1, 2, 3, 4}));
+}
+
+TEST_CASE("FiberTimer")
+{
+    class CountTask : public FiberTimer::Task {
+    public:
+        void run() override
+        {
+            ++count;
+        }
+        std::atomic<int> count{0};
+    };
+
+    FiberTimer timer;
+    auto periodic = std::make_shared<CountTask>();
+    auto once = std::make_shared<CountTask>();
+    auto canceled = std::make_shared<CountTask>();
+
+    timer.schedule(periodic, 10, true);
+    timer.scheduleOnce(once, 20);
+    timer.scheduleOnce(canceled, 50);
+    timer.cancel(canceled);
+    REQUIRE(waitFor([&periodic]() { return periodic->count >= 5; }, 1000));
+    REQUIRE(once->count == 1);
+    timer.cancel(periodic);
+    int count = periodic->count;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(periodic->count <= count + 1);
+    REQUIRE(canceled->count == 0);
+
+    std::atomic<int> fired{0};
+    auto id = timer.addTimer(30, [&fired]() { fired += 10; });
+    timer.addTimer(5, [&fired]() { ++fired; });
+    REQUIRE(timer.cancelTimer(id));
+    REQUIRE(waitFor([&fired]() { return fired == 1; }, 1000));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(fired == 1);
+    REQUIRE_FALSE(timer.cancelTimer(id));
+}
+
+TEST_CASE("TimingWheelThroughput", "[.][benchmark]")
+{
+    const size_t kTimers = 1000000;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> delayDist(1, 600000);
+    std::vector<int64_t> delays(kTimers);
+    for (auto& delay : delays) {
+        delay = delayDist(rng);
+    }
+
+    TimingWheel wheel(0);
+    std::vector<TimingWheel::TimerId> ids(kTimers);
+    size_t fired = 0;
+
+    int64_t begin = nowInMicro();
+    for (size_t i = 0; i < kTimers; ++i) {
+        ids[i] = wheel.schedule(delays[i], [&fired]() { ++fired; });
+    }
+    int64_t scheduled = nowInMicro();
+    // cancel half of them, most timers never fire in practice
+    for (size_t i = 0; i < kTimers; i += 2) {
+        wheel.cancel(ids[i]);
+    }
+    int64_t canceled = nowInMicro();
+    std::vector<TimingWheel::Callback> expired;
+    for (int64_t now = 0; wheel.size() > 0; now += 1) {
+        wheel.advance(now, expired);
+        for (auto& cb : expired) {
+            cb();
+        }
+        expired.clear();
+    }
+    int64_t end = nowInMicro();
+    REQUIRE(fired == kTimers / 2);
+
+    TLOG << "schedule " << (scheduled - begin) * 1000 / kTimers << "ns/timer, cancel "
+         << (canceled - scheduled) * 2000 / kTimers << "ns/timer, expire over 600s of ticks "
+         << (end - canceled) / 1000 << "ms";
+
+    // the timer fiber keeps up with a million pending timers
+    FiberTimer timer;
+    std::atomic<size_t> timerFired{0};
+    begin = nowInMicro();
+    for (size_t i = 0; i < kTimers; ++i) {
+        auto id = timer.addTimer(static_cast<int64_t>(delays[i] % 500), [&timerFired]() { ++timerFired; });
+        if (i % 2 == 0) {
+            timer.cancelTimer(id);
+        }
+    }
+    scheduled = nowInMicro();
+    REQUIRE(waitFor([&timerFired]() { return timerFired == kTimers / 2; }, 10000));
+    TLOG << "FiberTimer add/cancel " << (scheduled - begin) * 1000 / kTimers << "ns/timer, all fired "
+         << (nowInMicro() - scheduled) / 1000 << "ms after";
+}
@@ -0,0 +1,229 @@
+#include "../test_common.h"
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "group/group_ack_buffer.h"
+#include "utils/time.h"
+
+using namespace bcm;
+
+// keeps the written last_ack_mid of every member and counts the dao calls
+class AckRecordingGroupUsers : public dao::GroupUsers {
+public:
+    typedef std::vector<bcm::GroupUser::Role> Roles;
+
+    dao::ErrorCode insert(const bcm::GroupUser&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode insertBatch(const std::vector<bcm::GroupUser>&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode getMemberRoles(uint64_t, std::map<std::string, bcm::GroupUser::Role>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode delMember(uint64_t, const std::string&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode delMemberBatch(uint64_t, const std::vector<std::string>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberBatch(uint64_t, const std::vector<std::string>&, std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberRangeByRolesBatch(uint64_t, const Roles&, std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberRangeByRolesBatchWithOffset(uint64_t, const Roles&, const std::string&, int,
+                                                        std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getJoinedGroupsList(const std::string&, std::vector<dao::UserGroupDetail>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getJoinedGroups(const std::string&, std::vector<uint64_t>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupDetailByGid(uint64_t, const std::string&, dao::UserGroupDetail&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupDetailByGidBatch(const std::vector<uint64_t>&, const std::string&,
+                                            std::vector<dao::UserGroupEntry>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupOwner(uint64_t, std::string&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode getMember(uint64_t, const std::string&, bcm::GroupUser&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode queryGroupMemberInfoByGid(uint64_t, dao::GroupCounter&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode queryGroupMemberInfoByGid(uint64_t, dao::GroupCounter&, const std::string&,
+                                             bcm::GroupUser::Role&, const std::string&,
+                                             bcm::GroupUser::Role&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode update(uint64_t, const std::string&, const nlohmann::json&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode updateIfEmpty(uint64_t, const std::string&, const nlohmann::json&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMembersOrderByCreateTime(uint64_t, const Roles&, const std::string&, int64_t, int,
+                                               std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    dao::ErrorCode getMemberRole(uint64_t, const std::string&, bcm::GroupUser::Role&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    dao::ErrorCode updateLastAckMidBatch(const std::vector<dao::GroupUserAck>& acks) override
+    {
+        std::lock_guard<std::mutex> l(m_mtx);
+        ++m_calls;
+        if (m_fail) {
+            return dao::ERRORCODE_INTERNAL_ERROR;
+        }
+        for (const auto& ack : acks) {
+            m_acks[std::make_pair(ack.gid, ack.uid)] = ack.lastAckMid;
+        }
+        m_rows += acks.size();
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    uint64_t stored(uint64_t gid, const std::string& uid)
+    {
+        std::lock_guard<std::mutex> l(m_mtx);
+        auto it = m_acks.find(std::make_pair(gid, uid));
+        return it == m_acks.end() ? 0 : it->second;
+    }
+
+    std::mutex m_mtx;
+    std::map<std::pair<uint64_t, std::string>, uint64_t> m_acks;
+    bool m_fail{false};
+    int m_calls{0};
+    size_t m_rows{0};
+};
+
+TEST_CASE("GroupAckKeepsHighestMid")
+{
+    auto dao = std::make_shared<AckRecordingGroupUsers>();
+    GroupAckBuffer buffer(dao, 100);
+    buffer.ack(1, "alice", 5);
+    buffer.ack(1, "alice", 9);
+    buffer.ack(1, "alice", 3);
+    buffer.ack(2, "alice", 4);
+    REQUIRE(buffer.pending("alice") == std::map<uint64_t, uint64_t>({{1, 9}, {2, 4}}));
+    REQUIRE(buffer.pending("bob").empty());
+    REQUIRE(dao->m_calls == 0);
+
+    REQUIRE(buffer.flush());
+    REQUIRE(dao->m_calls == 1);
+    REQUIRE(dao->stored(1, "alice") == 9);
+    REQUIRE(dao->stored(2, "alice") == 4);
+    REQUIRE(buffer.pending("alice").empty());
+
+    // nothing pending, nothing written
+    REQUIRE(buffer.flush());
+    REQUIRE(dao->m_calls == 1);
+}
+
+TEST_CASE("GroupAckRetriesFailedFlush")
+{
+    auto dao = std::make_shared<AckRecordingGroupUsers>();
+    GroupAckBuffer buffer(dao, 100);
+    buffer.ack(1, "alice", 5);
+    dao->m_fail = true;
+    REQUIRE(buffer.flush() == false);
+    REQUIRE(buffer.pending("alice").at(1) == 5);
+
+    dao->m_fail = false;
+    buffer.ack(1, "alice", 6);
+    REQUIRE(buffer.flush());
+    REQUIRE(dao->stored(1, "alice") == 6);
+    REQUIRE(buffer.pending("alice").empty());
+    REQUIRE(buffer.stats().failedBatches == 1);
+}
+
+TEST_CASE("GroupAckFlushUser")
+{
+    auto dao = std::make_shared<AckRecordingGroupUsers>();
+    GroupAckBuffer buffer(dao, 2);
+    for (uint64_t gid = 1; gid <= 5; ++gid) {
+        buffer.ack(gid, "alice", gid * 10);
+        buffer.ack(gid, "bob", gid * 10);
+    }
+    REQUIRE(buffer.flushUser("alice"));
+    REQUIRE(dao->m_calls == 3);
+    REQUIRE(buffer.pending("alice").empty());
+    REQUIRE(buffer.pending("bob").size() == 5);
+    REQUIRE(dao->stored(5, "alice") == 50);
+    REQUIRE(dao->stored(5, "bob") == 0);
+}
+
+TEST_CASE("GroupAckStorm")
+{
+    // 200 members of 20 groups ack 1000 messages a second for 10 seconds, the buffer
+    // is flushed once a second while 4 threads keep acking
+    const int kGroups = 20;
+    const int kMembers = 10;
+    const int kSeconds = 10;
+    const int kAcksPerSecond = 1000;
+    const int kThreads = 4;
+
+    auto dao = std::make_shared<AckRecordingGroupUsers>();
+    GroupAckBuffer buffer(dao, 200);
+    std::atomic<uint64_t> nextMid(0);
+    std::vector<std::map<std::pair<uint64_t, std::string>, uint64_t>> highest(kThreads);
+
+    for (int second = 0; second < kSeconds; ++second) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < kAcksPerSecond / kThreads; ++i) {
+                    uint64_t mid = ++nextMid;
+                    uint64_t gid = 1 + mid % kGroups;
+                    std::string uid = "user" + std::to_string((mid / kGroups) % kMembers);
+                    buffer.ack(gid, uid, mid);
+                    uint64_t& h = highest[t][std::make_pair(gid, uid)];
+                    h = std::max(h, mid);
+                }
+            });
+        }
+        threads.emplace_back([&]() {
+            buffer.flush();
+        });
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    REQUIRE(buffer.flush());
+
+    int legacyCalls = kSeconds * kAcksPerSecond;
+    auto stats = buffer.stats();
+    // the local backend writes a batch at once, the rpc backend sends an update per member
+    TLOG << stats.acks << " acks took " << legacyCalls << " dao updates one by one, buffered "
+         << dao->m_calls << " batch calls of " << dao->m_rows << " members in total";
+    REQUIRE(stats.acks == static_cast<uint64_t>(legacyCalls));
+    REQUIRE(dao->m_calls * 50 < legacyCalls);
+    // at most one row per member and flush
+    REQUIRE(dao->m_rows * 4 < static_cast<size_t>(legacyCalls));
+
+    for (const auto& perThread : highest) {
+        for (const auto& item : perThread) {
+            REQUIRE(dao->stored(item.first.first, item.first.second) >= item.second);
+        }
+    }
+}
@@ -0,0 +1,256 @@
+#include "../test_common.h"
+
+#include <functional>
+#include <map>
+#include <thread>
+#include <nlohmann/json.hpp>
+
+#include "group/group_meta_cache.h"
+#include "group/message_type.h"
+#include "proto/dao/group_msg.pb.h"
+
+using namespace bcm;
+
+class CountingGroups : public dao::Groups {
+public:
+    dao::ErrorCode create(const bcm::Group&, uint64_t&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode update(uint64_t, const nlohmann::json&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode del(uint64_t) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode setGroupExtensionInfo(const uint64_t, const std::map<std::string, std::string>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupExtensionInfo(const uint64_t, const std::set<std::string>&,
+                                         std::map<std::string, std::string>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    dao::ErrorCode get(uint64_t gid, bcm::Group& group) override
+    {
+        ++m_gets;
+        if (m_onGet) {
+            m_onGet();
+        }
+        auto it = m_groups.find(gid);
+        if (it == m_groups.end()) {
+            return dao::ERRORCODE_NO_SUCH_DATA;
+        }
+        group = it->second;
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    std::map<uint64_t, bcm::Group> m_groups;
+    int m_gets{0};
+    // runs while a read is in flight
+    std::function<void()> m_onGet;
+};
+
+class CountingGroupUsers : public dao::GroupUsers {
+public:
+    typedef std::vector<bcm::GroupUser::Role> Roles;
+
+    dao::ErrorCode insert(const bcm::GroupUser&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode insertBatch(const std::vector<bcm::GroupUser>&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode getMemberRoles(uint64_t, std::map<std::string, bcm::GroupUser::Role>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode delMember(uint64_t, const std::string&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode delMemberBatch(uint64_t, const std::vector<std::string>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberBatch(uint64_t, const std::vector<std::string>&, std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberRangeByRolesBatch(uint64_t, const Roles&, std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMemberRangeByRolesBatchWithOffset(uint64_t, const Roles&, const std::string&, int,
+                                                        std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getJoinedGroupsList(const std::string&, std::vector<dao::UserGroupDetail>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getJoinedGroups(const std::string&, std::vector<uint64_t>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupDetailByGid(uint64_t, const std::string&, dao::UserGroupDetail&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupDetailByGidBatch(const std::vector<uint64_t>&, const std::string&,
+                                            std::vector<dao::UserGroupEntry>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getGroupOwner(uint64_t, std::string&) override { return dao::ERRORCODE_INTERNAL_ERROR; }
+    dao::ErrorCode getMember(uint64_t, const std::string&, bcm::GroupUser&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode queryGroupMemberInfoByGid(uint64_t, dao::GroupCounter&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode queryGroupMemberInfoByGid(uint64_t, dao::GroupCounter&, const std::string&,
+                                             bcm::GroupUser::Role&, const std::string&,
+                                             bcm::GroupUser::Role&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode update(uint64_t, const std::string&, const nlohmann::json&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode updateIfEmpty(uint64_t, const std::string&, const nlohmann::json&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode updateLastAckMidBatch(const std::vector<dao::GroupUserAck>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+    dao::ErrorCode getMembersOrderByCreateTime(uint64_t, const Roles&, const std::string&, int64_t, int,
+                                               std::vector<bcm::GroupUser>&) override
+    {
+        return dao::ERRORCODE_INTERNAL_ERROR;
+    }
+
+    dao::ErrorCode getMemberRole(uint64_t gid, const std::string& uid, bcm::GroupUser::Role& role) override
+    {
+        ++m_gets;
+        auto it = m_roles.find(std::make_pair(gid, uid));
+        if (it == m_roles.end()) {
+            return dao::ERRORCODE_NO_SUCH_DATA;
+        }
+        role = it->second;
+        return dao::ERRORCODE_SUCCESS;
+    }
+
+    std::map<std::pair<uint64_t, std::string>, bcm::GroupUser::Role> m_roles;
+    int m_gets{0};
+};
+
+struct Fixture {
+    explicit Fixture(int64_t ttlInMilli)
+        : groups(std::make_shared<CountingGroups>())
+        , groupUsers(std::make_shared<CountingGroupUsers>())
+        , cache(1024 * 1024, ttlInMilli, groups, groupUsers)
+    {
+        bcm::Group group;
+        group.set_gid(1);
+        group.set_broadcast(0);
+        groups->m_groups[1] = group;
+        groupUsers->m_roles[std::make_pair(1, "alice")] = GroupUser::ROLE_OWNER;
+        groupUsers->m_roles[std::make_pair(1, "bob")] = GroupUser::ROLE_MEMBER;
+    }
+
+    std::shared_ptr<CountingGroups> groups;
+    std::shared_ptr<CountingGroupUsers> groupUsers;
+    GroupMetaCache cache;
+};
+
+TEST_CASE("GroupMetaCacheHit")
+{
+    Fixture f(60000);
+    for (int i = 0; i < 100; ++i) {
+        GroupMetaCache::GroupMeta meta;
+        REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+        REQUIRE(meta.broadcast == 0);
+        GroupUser::Role role;
+        REQUIRE(f.cache.getMemberRole(1, "alice", role) == dao::ERRORCODE_SUCCESS);
+        REQUIRE(role == GroupUser::ROLE_OWNER);
+    }
+    REQUIRE(f.groups->m_gets == 1);
+    REQUIRE(f.groupUsers->m_gets == 1);
+
+    // misses are answered by the dao every time
+    GroupMetaCache::GroupMeta meta;
+    GroupUser::Role role;
+    REQUIRE(f.cache.getGroup(2, meta) == dao::ERRORCODE_NO_SUCH_DATA);
+    REQUIRE(f.cache.getGroup(2, meta) == dao::ERRORCODE_NO_SUCH_DATA);
+    REQUIRE(f.cache.getMemberRole(1, "carol", role) == dao::ERRORCODE_NO_SUCH_DATA);
+    f.groupUsers->m_roles[std::make_pair(1, "carol")] = GroupUser::ROLE_MEMBER;
+    REQUIRE(f.cache.getMemberRole(1, "carol", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.groups->m_gets == 3);
+    REQUIRE(f.groupUsers->m_gets == 3);
+}
+
+TEST_CASE("GroupMetaCacheInvalidation")
+{
+    Fixture f(60000);
+    GroupMetaCache::GroupMeta meta;
+    GroupUser::Role role;
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.cache.getMemberRole(1, "alice", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_SUCCESS);
+
+    // role change of bob leaves alice cached
+    f.groupUsers->m_roles[std::make_pair(1, "bob")] = GroupUser::ROLE_ADMINISTROR;
+    f.cache.onUserEvent(INTERNAL_USER_CHANGE_ROLE, 1, "bob");
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(role == GroupUser::ROLE_ADMINISTROR);
+    REQUIRE(f.cache.getMemberRole(1, "alice", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.groupUsers->m_gets == 3);
+
+    // a member update lists who left
+    f.groupUsers->m_roles.erase(std::make_pair(1, "bob"));
+    nlohmann::json text = {{"action", QUIT_GROUP}, {"members", {{{"uid", "bob"}, {"nick", ""}, {"role", 3}}}}};
+    f.cache.onSystemMessage(1, GroupMsg::TYPE_MEMBER_UPDATE, text.dump());
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_NO_SUCH_DATA);
+
+    f.groups->m_groups[1].set_broadcast(1);
+    f.cache.onSystemMessage(1, GroupMsg::TYPE_CHAT, "hello");
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(meta.broadcast == 0);
+    f.cache.onSystemMessage(1, GroupMsg::TYPE_INFO_UPDATE, "{}");
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(meta.broadcast == 1);
+
+    // unparsable member updates are left to the ttl
+    f.cache.onSystemMessage(1, GroupMsg::TYPE_MEMBER_UPDATE, "not json");
+}
+
+TEST_CASE("GroupMetaCacheTtl")
+{
+    Fixture f(50);
+    GroupUser::Role role;
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_SUCCESS);
+    f.groupUsers->m_roles[std::make_pair(1, "bob")] = GroupUser::ROLE_SUBSCRIBER;
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(role == GroupUser::ROLE_MEMBER);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(f.cache.getMemberRole(1, "bob", role) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(role == GroupUser::ROLE_SUBSCRIBER);
+    REQUIRE(f.groupUsers->m_gets == 2);
+}
+
+TEST_CASE("GroupMetaCacheRacingInvalidation")
+{
+    Fixture f(60000);
+    GroupMetaCache::GroupMeta meta;
+
+    // an invalidation of another group does not keep the read from being cached
+    f.groups->m_onGet = [&f]() { f.cache.invalidateGroup(2); };
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    f.groups->m_onGet = nullptr;
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.groups->m_gets == 1);
+
+    // an invalidation of the group itself does, the read may predate it
+    f.cache.invalidateGroup(1);
+    f.groups->m_onGet = [&f]() { f.cache.invalidateMember(1, "bob"); };
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    f.groups->m_onGet = nullptr;
+    REQUIRE(f.cache.getGroup(1, meta) == dao::ERRORCODE_SUCCESS);
+    REQUIRE(f.groups->m_gets == 3);
+}
@@ -1,14 +1,18 @@
 #include "../test_common.h"
+#include "../redis/local_redis.h"
 
 #include "group/group_msg_sub.h"
 #include "utils/libevent_utils.h"
 #include "redis/async_conn.h"
 #include "redis/reply.h"
+#include "redis/online_redis_manager.h"
 
 #include <hiredis/hiredis.h>
 #include <event2/event.h>
 #include <event2/thread.h>
 #include <boost/core/ignore_unused.hpp>
+#include <unordered_set>
+#include <vector>
 
 static const std::string kChan = "group_11";
 static const std::vector<std::string> kMsgList = {"hello", "shutdown"};
@@ -126,4 +130,105 @@ TEST_CASE("GroupMsgSub")
     TLOG << "thread terminated";
 
     event_base_free(eb);
-}
\ No newline at end of file
+}
+
+TEST_CASE("GroupMsgSubChannelBuckets")
+{
+    REQUIRE(bcm::GroupMsgSub::groupChannel(11) == "group_11");
+    REQUIRE_FALSE(bcm::GroupMsgSub::isBucketChannel("group_11"));
+
+    bcm::GroupMsgSub::setChannelBuckets(64);
+    REQUIRE(bcm::GroupMsgSub::groupChannel(11) == "group_bucket_11");
+    REQUIRE(bcm::GroupMsgSub::groupChannel(75) == "group_bucket_11");
+    REQUIRE(bcm::GroupMsgSub::isBucketChannel("group_bucket_11"));
+    REQUIRE(bcm::GroupMsgSub::isGroupMessageChannel("group_bucket_11"));
+
+    // 1M groups spread evenly, a node holds 64 subscriptions whatever its members join
+    std::vector<uint32_t> counts(64, 0);
+    for (uint64_t gid = 1; gid <= 1000000; ++gid) {
+        std::string chan = bcm::GroupMsgSub::groupChannel(gid);
+        ++counts[std::stoul(chan.substr(std::string("group_bucket_").size()))];
+    }
+    for (uint32_t c : counts) {
+        REQUIRE(c >= 1000000 / 64);
+        REQUIRE(c <= 1000000 / 64 + 1);
+    }
+
+    bcm::GroupMsgSub::setChannelBuckets(0);
+}
+
+// a node hosting members of every group, against a redis-server of its own
+static LocalRedis gs_benchRedis(6383);
+static const uint64_t kBenchGroups = 1000000;
+static const int kBenchMessages = 10000;
+
+// the channels a node subscribes to for the groups it hosts, per gid or per bucket
+static void benchmarkChannels(const std::string& mode)
+{
+    std::unordered_set<std::string> unique;
+    for (uint64_t gid = 1; gid <= kBenchGroups; ++gid) {
+        unique.insert(bcm::GroupMsgSub::groupChannel(gid));
+    }
+    std::vector<std::string> chans(unique.begin(), unique.end());
+    int total = static_cast<int>(chans.size());
+
+    CountingHandler h;
+    int64_t start = bcm::nowInMilli();
+    REQUIRE(bcm::OnlineRedisManager::Instance()->subscribeBatch(chans, &h));
+    REQUIRE(LocalRedis::waitFor([&h, total]() { return h.subscribed == total; }, 60000));
+    int64_t subscribed = bcm::nowInMilli() - start;
+
+    // what a failover of the online redis costs
+    h.subscribed = 0;
+    gs_benchRedis.stop();
+    gs_benchRedis.start();
+    start = bcm::nowInMilli();
+    REQUIRE(LocalRedis::waitFor([&h, total]() { return h.subscribed == total; }, 60000));
+    int64_t resubscribed = bcm::nowInMilli() - start;
+
+    // one message to each of kBenchMessages groups spread over the gid space
+    h.messages = 0;
+    start = bcm::nowInMilli();
+    for (int i = 0; i < kBenchMessages; ++i) {
+        uint64_t gid = 1 + (static_cast<uint64_t>(i) * 7919) % kBenchGroups;
+        bcm::OnlineRedisManager::Instance()->publish(bcm::GroupMsgSub::groupChannel(gid), "hello");
+    }
+    REQUIRE(LocalRedis::waitFor([&h]() { return h.messages == kBenchMessages; }, 10000));
+    int64_t delivered = bcm::nowInMilli() - start;
+
+    // messages of groups hosted on other nodes, a bucket hands them to this node as well.
+    // the publishes share a connection, the last one to a hosted group arrives last
+    h.messages = 0;
+    int foreign = bcm::GroupMsgSub::channelBuckets() > 0 ? kBenchMessages : 0;
+    for (int i = 0; i < kBenchMessages; ++i) {
+        bcm::OnlineRedisManager::Instance()->publish(bcm::GroupMsgSub::groupChannel(kBenchGroups + 1 + i), "hello");
+    }
+    bcm::OnlineRedisManager::Instance()->publish(bcm::GroupMsgSub::groupChannel(1), "hello");
+    REQUIRE(LocalRedis::waitFor([&h, foreign]() { return h.messages == foreign + 1; }, 10000));
+
+    TLOG << mode << ": " << total << " channels for " << kBenchGroups << " groups, subscribed in "
+         << subscribed << "ms, resubscribed in " << resubscribed << "ms, "
+         << (delivered * 1000 / kBenchMessages) << "us per message, received " << foreign
+         << " of " << kBenchMessages << " messages for groups hosted elsewhere";
+
+    REQUIRE(bcm::OnlineRedisManager::Instance()->unsubscribeBatch(chans));
+}
+
+TEST_CASE("GroupMsgSubChannelsCost", "[.][benchmark]")
+{
+    evthread_use_pthreads();
+    gs_benchRedis.start();
+
+    std::map<std::string, std::vector<bcm::RedisConfig>> onlineRedis;
+    onlineRedis["p0"] = {gs_benchRedis.config()};
+    bcm::OnlineRedisManager::Instance()->init(onlineRedis);
+    bcm::OnlineRedisManager::Instance()->start();
+
+    benchmarkChannels("per gid");
+
+    bcm::GroupMsgSub::setChannelBuckets(64);
+    benchmarkChannels("64 buckets");
+    bcm::GroupMsgSub::setChannelBuckets(0);
+
+    gs_benchRedis.stop();
+}
@@ -183,6 +183,12 @@ public:
         return ERRORCODE_SUCCESS;
     }
 
+    virtual ErrorCode updateLastAckMidBatch(const std::vector<GroupUserAck>& acks) override
+    {
+        boost::ignore_unused(acks);
+        return ERRORCODE_SUCCESS;
+    }
+
     virtual ErrorCode getMembersOrderByCreateTime(uint64_t gid,
                                                   const std::vector<bcm::GroupUser::Role>& roles,
                                                   const std::string& startUid,
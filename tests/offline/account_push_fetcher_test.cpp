@@ -0,0 +1,182 @@
+#include "../test_common.h"
+
+#include "../controller/mock.h"
+#include "../../src/program/offline-server/account_push_fetcher.h"
+#include "../../src/store/accounts_manager.h"
+#include "../../src/dispatcher/dispatch_address.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace bcm;
+
+// accounts dao answering after a fixed delay, uids prefixed with "fail" fail their call
+// and uids prefixed with "missing" are not found
+class DelayedAccountMock : public AccountMock {
+public:
+    explicit DelayedAccountMock(int64_t delayInMilli) : m_delayInMilli(delayInMilli) {}
+
+    bcm::dao::ErrorCode get(const std::vector<std::string>& uids,
+                            std::vector<bcm::Account>& accounts,
+                            std::vector<std::string>& missedUids) override
+    {
+        int current = ++inFlight;
+        int peak = peakInFlight.load();
+        while (current > peak && !peakInFlight.compare_exchange_weak(peak, current)) {
+        }
+        ++calls;
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_delayInMilli));
+        --inFlight;
+
+        for (const auto& uid : uids) {
+            if (uid.compare(0, 4, "fail") == 0) {
+                return bcm::dao::ERRORCODE_INTERNAL_ERROR;
+            }
+            if (uid.compare(0, 7, "missing") == 0) {
+                missedUids.emplace_back(uid);
+                continue;
+            }
+            bcm::Account account;
+            account.set_uid(uid);
+            bcm::Device* dev = account.add_devices();
+            dev->set_id(bcm::Device::MASTER_ID);
+            dev->set_gcmid("gcm_" + uid);
+            dev->set_lastseentime(static_cast<uint64_t>(nowInMillis()));
+            accounts.emplace_back(std::move(account));
+        }
+        return bcm::dao::ERRORCODE_SUCCESS;
+    }
+
+    std::atomic<int> inFlight{0};
+    std::atomic<int> peakInFlight{0};
+    std::atomic<int> calls{0};
+
+private:
+    int64_t m_delayInMilli;
+};
+
+static std::shared_ptr<AccountsManager> makeAccountsManager(DelayedAccountMock* mock)
+{
+    auto accountsManager = std::make_shared<AccountsManager>();
+    accountsManager->m_accounts.reset(mock);
+    return accountsManager;
+}
+
+static std::vector<std::string> makeUids(const std::string& prefix, size_t count)
+{
+    std::vector<std::string> uids;
+    for (size_t i = 0; i < count; ++i) {
+        uids.emplace_back(prefix + std::to_string(i));
+    }
+    return uids;
+}
+
+TEST_CASE("AccountPushFetcherBoundedConcurrency")
+{
+    auto mock = new DelayedAccountMock(5);
+    AccountPushFetcher fetcher(makeAccountsManager(mock), 4, 10);
+
+    auto uids = makeUids("uid", 200);
+    std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+    std::vector<std::string> missedUids;
+    REQUIRE(fetcher.batchFetch(uids, pushInfos, missedUids));
+
+    REQUIRE(mock->calls == 20);
+    REQUIRE(mock->peakInFlight <= 4);
+    REQUIRE(mock->peakInFlight > 1);
+    REQUIRE(pushInfos.size() == 200);
+    REQUIRE(missedUids.empty());
+    REQUIRE(pushInfos["uid7"].cfgFlag == GroupUserConfigPushType::NORMAL);
+    REQUIRE(pushInfos["uid7"].gcmId == "gcm_uid7");
+    REQUIRE(pushInfos["uid7"].targetAddress == DispatchAddress("uid7", Device::MASTER_ID).getSerialized());
+}
+
+TEST_CASE("AccountPushFetcherBatchSize")
+{
+    auto mock = new DelayedAccountMock(0);
+    AccountPushFetcher fetcher(makeAccountsManager(mock), 2, 7);
+
+    std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+    std::vector<std::string> missedUids;
+    REQUIRE(fetcher.batchFetch(makeUids("uid", 50), pushInfos, missedUids));
+    REQUIRE(mock->calls == 8);
+    REQUIRE(pushInfos.size() == 50);
+
+    // a single batch is fetched inline
+    mock->calls = 0;
+    REQUIRE(fetcher.batchFetch(makeUids("uid", 7), pushInfos, missedUids));
+    REQUIRE(mock->calls == 1);
+
+    // empty input does not reach the dao
+    mock->calls = 0;
+    REQUIRE(fetcher.batchFetch({}, pushInfos, missedUids));
+    REQUIRE(mock->calls == 0);
+}
+
+TEST_CASE("AccountPushFetcherPartialFailure")
+{
+    auto mock = new DelayedAccountMock(1);
+    AccountPushFetcher fetcher(makeAccountsManager(mock), 4, 10);
+
+    // batches: uid0-9, uid10-19 with a failing uid, missing0-9, uid20-29
+    auto uids = makeUids("uid", 10);
+    auto failing = makeUids("uid", 20);
+    failing.erase(failing.begin(), failing.begin() + 10);
+    failing[5] = "fail0";
+    uids.insert(uids.end(), failing.begin(), failing.end());
+    auto missing = makeUids("missing", 10);
+    uids.insert(uids.end(), missing.begin(), missing.end());
+    auto tail = makeUids("uid", 30);
+    uids.insert(uids.end(), tail.begin() + 20, tail.end());
+
+    std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+    std::vector<std::string> missedUids;
+    REQUIRE_FALSE(fetcher.batchFetch(uids, pushInfos, missedUids));
+
+    REQUIRE(mock->calls == 4);
+    // the batches that succeeded are merged, the failed one leaves nothing behind
+    REQUIRE(pushInfos.size() == 20);
+    REQUIRE(pushInfos.count("uid0") == 1);
+    REQUIRE(pushInfos.count("uid29") == 1);
+    REQUIRE(pushInfos.count("uid10") == 0);
+    REQUIRE(pushInfos.count("fail0") == 0);
+    REQUIRE(missedUids.size() == 10);
+    REQUIRE(std::find(missedUids.begin(), missedUids.end(), "missing3") != missedUids.end());
+}
+
+TEST_CASE("AccountPushFetcherLatency")
+{
+    const size_t kUids = 5000;
+    const int64_t kDelayInMilli = 2;
+    auto uids = makeUids("uid", kUids);
+
+    // the serial path fetched 20 uids per dao call, one call after the other
+    auto serialMock = new DelayedAccountMock(kDelayInMilli);
+    AccountPushFetcher serialFetcher(makeAccountsManager(serialMock), 1, 20);
+    std::map<std::string, GroupUserMessageIdInfo> serialInfos;
+    std::vector<std::string> missedUids;
+    int64_t start = nowInMillis();
+    for (size_t i = 0; i < uids.size(); i += 20) {
+        std::vector<std::string> part(uids.begin() + i, uids.begin() + std::min(i + 20, uids.size()));
+        REQUIRE(serialFetcher.fetch(part, serialInfos, missedUids));
+    }
+    int64_t serialMillis = nowInMillis() - start;
+
+    auto mock = new DelayedAccountMock(kDelayInMilli);
+    AccountPushFetcher fetcher(makeAccountsManager(mock), 8, 20);
+    std::map<std::string, GroupUserMessageIdInfo> pushInfos;
+    start = nowInMillis();
+    REQUIRE(fetcher.batchFetch(uids, pushInfos, missedUids));
+    int64_t batchMillis = nowInMillis() - start;
+
+    TLOG << "fetch push info of " << kUids << " uids, serial: " << serialMillis
+         << " ms, " << serialMock->calls << " calls, batched: " << batchMillis
+         << " ms, " << mock->calls << " calls, peak in flight: " << mock->peakInFlight;
+
+    REQUIRE(serialInfos.size() == kUids);
+    REQUIRE(pushInfos.size() == kUids);
+    REQUIRE(serialMock->peakInFlight == 1);
+    REQUIRE(mock->peakInFlight <= 8);
+    REQUIRE(batchMillis < serialMillis);
+}
@@ -2,6 +2,8 @@
 
 #include <thread>
 #include <chrono>
+#include <cstdio>
+#include <unistd.h>
 
 #include <hiredis/hiredis.h>
 #include <event2/event.h>
@@ -215,6 +217,12 @@ public:
         boost::ignore_unused(gid, uid, upData);
         return bcm::dao::ERRORCODE_SUCCESS;
     }
+
+    virtual bcm::dao::ErrorCode updateLastAckMidBatch(const std::vector<bcm::dao::GroupUserAck>& acks) override
+    {
+        boost::ignore_unused(acks);
+        return bcm::dao::ERRORCODE_SUCCESS;
+    }
     
     virtual ErrorCode getMembersOrderByCreateTime(uint64_t gid,
                                                   const std::vector<bcm::GroupUser::Role>& roles,
@@ -666,3 +674,109 @@ TEST_CASE("offlineGroupMemberTest")
     TLOG << "offlineGroupMemberTest thread terminated";
     event_base_free(eb);
 }
+
+// groups of 20..199 members drawn from 2M users, one group in a thousand has 5000 members
+class SyntheticGroupUsersDao : public MockGroupUsersDao
+{
+public:
+    static constexpr uint64_t kUserCount = 2000000;
+
+    static std::string syntheticUid(uint64_t idx)
+    {
+        char buf[40];
+        snprintf(buf, sizeof(buf), "1%033llu", static_cast<unsigned long long>(idx));
+        return buf;
+    }
+
+    bcm::dao::ErrorCode getMemberRangeByRolesBatch(uint64_t gid, const std::vector<bcm::GroupUser::Role>& roles,
+                                                   std::vector<bcm::GroupUser>& users) override
+    {
+        boost::ignore_unused(roles);
+        uint64_t x = gid * 6364136223846793005ULL + 1442695040888963407ULL;
+        size_t size = (gid % 1000 == 0) ? 5000 : 20 + (x >> 33) % 180;
+        users.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+            bcm::GroupUser user;
+            user.set_gid(gid);
+            user.set_uid(syntheticUid((x >> 33) % kUserCount));
+            if (i == 0) {
+                user.set_role(bcm::GroupUser::ROLE_OWNER);
+            } else {
+                user.set_role(i % 10 == 0 ? bcm::GroupUser::ROLE_SUBSCRIBER : bcm::GroupUser::ROLE_MEMBER);
+            }
+            user.set_status(i % 7 == 0 ? bcm::GroupUser::STATUS_MUTED : 0);
+            users.emplace_back(user);
+        }
+        return bcm::dao::ERRORCODE_SUCCESS;
+    }
+};
+
+static int64_t residentBytes()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f != nullptr) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return static_cast<int64_t>(resident) * sysconf(_SC_PAGESIZE);
+}
+
+TEST_CASE("offlineGroupMemberMemory", "[.][benchmark]")
+{
+    // BCM_BENCH_GROUPS overrides the number of groups loaded
+    uint64_t groupCount = 1000000;
+    if (const char* env = getenv("BCM_BENCH_GROUPS")) {
+        groupCount = std::stoull(env);
+    }
+    const uint64_t kSampleGroups = std::min<uint64_t>(groupCount, 10000);
+
+    std::shared_ptr<SyntheticGroupUsersDao> dao = std::make_shared<SyntheticGroupUsersDao>();
+    Log::setLevel(LOGSEVERITY_WARN);
+
+    bcm::IoCtxPool pool(1);
+    GroupMemberMgr mgr(dao, pool);
+    int64_t rssBefore = residentBytes();
+    int64_t start = nowInMilli();
+    for (uint64_t gid = 1; gid <= groupCount; ++gid) {
+        REQUIRE(mgr.syncReloadGroupMembersFromDb(gid));
+    }
+    int64_t loadMillis = nowInMilli() - start;
+    TLOG << "compact index, " << groupCount << " groups: " << mgr.memoryUsage() / (1024 * 1024)
+         << " MB accounted, " << (residentBytes() - rssBefore) / (1024 * 1024) << " MB rss, loaded in "
+         << loadMillis << " ms";
+
+    // the former layout: node based sets of uid strings, measured on a sample
+    rssBefore = residentBytes();
+    {
+        std::map<uint64_t, std::set<std::string>> members;
+        std::map<uint64_t, std::set<std::string>> subscribers;
+        std::map<uint64_t, std::set<std::string>> muted;
+        for (uint64_t gid = 1; gid <= kSampleGroups; ++gid) {
+            std::vector<bcm::GroupUser> users;
+            dao->getMemberRangeByRolesBatch(gid, {}, users);
+            for (const auto& u : users) {
+                if (u.status() & bcm::GroupUser::STATUS_MUTED) {
+                    muted[gid].insert(u.uid());
+                }
+                if (u.role() == bcm::GroupUser::ROLE_SUBSCRIBER) {
+                    subscribers[gid].insert(u.uid());
+                } else {
+                    members[gid].insert(u.uid());
+                }
+            }
+        }
+        int64_t sampleBytes = residentBytes() - rssBefore;
+        TLOG << "std::set<std::string> index, " << kSampleGroups << " groups: " << sampleBytes / (1024 * 1024)
+             << " MB rss, extrapolated to " << groupCount << " groups: "
+             << sampleBytes * static_cast<int64_t>(groupCount / kSampleGroups) / (1024 * 1024) << " MB";
+    }
+
+    std::set<std::string> uids;
+    mgr.getUnmuteGroupMembers(1000, uids);
+    REQUIRE(!uids.empty());
+}
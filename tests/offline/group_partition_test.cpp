@@ -10,7 +10,9 @@
 
 #include "../../src/program/offline-server/group_partition_mgr.h"
 #include "../../src/config/group_store_format.h"
+#include "../../src/utils/time.h"
 #include <thread>
+#include <atomic>
 
 
 using namespace bcm;
@@ -89,4 +91,102 @@ TEST_CASE("group_partition_test")
     REQUIRE(gmS.timestamp == 1113);
     REQUIRE(gmS.lastMid == 2224);
 
-}
\ No newline at end of file
+}
+TEST_CASE("group_partition_concurrent")
+{
+    GroupPartitionMgr mgr;
+    const int kWriters = 4;
+    const int kReaders = 8;
+    const uint64_t kGroups = 1000;
+    const uint64_t kRounds = 200;
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> torn(0);
+    std::atomic<uint64_t> reads(0);
+
+    // writer w owns the gids with gid % kWriters == w, timestamp always mirrors the low bits of lastMid
+    std::vector<std::thread> threads;
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&mgr, w]() {
+            for (uint64_t r = 1; r <= kRounds; ++r) {
+                for (uint64_t gid = static_cast<uint64_t>(w); gid < kGroups; gid += kWriters) {
+                    uint64_t mid = (r << 32) | gid;
+                    mgr.updateMid(gid, static_cast<uint32_t>(mid), mid);
+                }
+            }
+        });
+    }
+    for (int i = 0; i < kReaders; ++i) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> lastSeen(kGroups, 0);
+            while (!stop.load()) {
+                for (uint64_t gid = 0; gid < kGroups; ++gid) {
+                    GroupMessageSeqInfo gm;
+                    if (!mgr.getGroupPushInfo(gid, gm)) {
+                        continue;
+                    }
+                    if (gm.timestamp != static_cast<uint32_t>(gm.lastMid) || gm.lastMid < lastSeen[gid]) {
+                        torn++;
+                    }
+                    lastSeen[gid] = gm.lastMid;
+                    reads++;
+                }
+            }
+        });
+    }
+
+    for (int w = 0; w < kWriters; ++w) {
+        threads[w].join();
+    }
+    stop.store(true);
+    for (size_t i = kWriters; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    REQUIRE(torn.load() == 0);
+    REQUIRE(reads.load() > 0);
+    for (uint64_t gid = 0; gid < kGroups; ++gid) {
+        GroupMessageSeqInfo gm;
+        REQUIRE(mgr.getGroupPushInfo(gid, gm));
+        REQUIRE(gm.lastMid == ((kRounds << 32) | gid));
+        REQUIRE(mgr.isExistGroup(gid));
+    }
+    REQUIRE_FALSE(mgr.isExistGroup(kGroups));
+}
+
+TEST_CASE("group_partition_scaling", "[.][benchmark]")
+{
+    // 95% lookups, 5% updates over 10k groups, as seen by polling workers
+    const uint64_t kGroups = 10000;
+    const int kOpsPerThread = 2000000;
+    GroupPartitionMgr mgr;
+    for (uint64_t gid = 0; gid < kGroups; ++gid) {
+        mgr.updateMid(gid, 1, 1);
+    }
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned n = 1; n <= maxThreads; n *= 2) {
+        std::vector<std::thread> threads;
+        int64_t start = nowInMilli();
+        for (unsigned t = 0; t < n; ++t) {
+            threads.emplace_back([&mgr, t]() {
+                uint64_t x = t * 7919 + 1;
+                GroupMessageSeqInfo gm;
+                for (int i = 0; i < kOpsPerThread; ++i) {
+                    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                    uint64_t gid = (x >> 33) % kGroups;
+                    if (i % 20 == 0) {
+                        mgr.updateMid(gid, static_cast<uint32_t>(i), static_cast<uint64_t>(i));
+                    } else {
+                        mgr.getGroupPushInfo(gid, gm);
+                    }
+                }
+            });
+        }
+        for (auto& thd : threads) {
+            thd.join();
+        }
+        int64_t spent = std::max<int64_t>(1, nowInMilli() - start);
+        TLOG << n << " threads: " << (static_cast<int64_t>(kOpsPerThread) * n / spent) << " ops/ms";
+    }
+}
@@ -0,0 +1,58 @@
+#include "../test_common.h"
+
+#include "../../src/program/offline-server/member_index.h"
+
+using namespace bcm;
+
+TEST_CASE("UidInterner")
+{
+    UidInterner interner;
+    REQUIRE(interner.find("1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxcu") == UidInterner::kInvalidId);
+
+    uint32_t id = interner.intern("1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxcu");
+    REQUIRE(interner.intern("1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxcu") == id);
+    REQUIRE(interner.find("1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxcu") == id);
+    REQUIRE(interner.uid(id) == "1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxcu");
+    REQUIRE(interner.find("1PiMmSJHHdyUBtdJ4BWMeRb6sVJyq7Cxc") == UidInterner::kInvalidId);
+
+    // grow through several rehashes
+    const uint32_t kCount = 100000;
+    for (uint32_t i = 0; i < kCount; ++i) {
+        interner.intern("uid_" + std::to_string(i));
+    }
+    REQUIRE(interner.size() == kCount + 1);
+    for (uint32_t i = 0; i < kCount; i += 997) {
+        uint32_t uidId = interner.find("uid_" + std::to_string(i));
+        REQUIRE(uidId != UidInterner::kInvalidId);
+        REQUIRE(interner.uid(uidId) == "uid_" + std::to_string(i));
+    }
+    REQUIRE(interner.find("") == UidInterner::kInvalidId);
+    uint32_t emptyId = interner.intern("");
+    REQUIRE(interner.find("") == emptyId);
+    REQUIRE(interner.uid(emptyId).empty());
+}
+
+TEST_CASE("GroupMemberIndex")
+{
+    GroupMemberIndex group;
+    group.set(30, 0);
+    group.set(10, GroupMemberIndex::SUBSCRIBER);
+    group.set(20, GroupMemberIndex::MUTED);
+    REQUIRE(group.ids == std::vector<uint32_t>({10, 20, 30}));
+    REQUIRE(group.flags[0] == GroupMemberIndex::SUBSCRIBER);
+    REQUIRE(group.flags[1] == GroupMemberIndex::MUTED);
+
+    group.set(20, 0);
+    REQUIRE(group.ids.size() == 3);
+    REQUIRE(group.flags[group.find(20)] == 0);
+
+    REQUIRE(group.find(15) == -1);
+    REQUIRE(group.erase(10));
+    REQUIRE_FALSE(group.erase(10));
+    REQUIRE(group.ids == std::vector<uint32_t>({20, 30}));
+    REQUIRE(group.flags.size() == 2);
+
+    REQUIRE(group.erase(20));
+    REQUIRE(group.erase(30));
+    REQUIRE(group.empty());
+}
@@ -0,0 +1,96 @@
+#include "../test_common.h"
+
+#include "../../src/program/offline-server/push_info_cache.h"
+#include "../../src/utils/time.h"
+
+#include <thread>
+
+using namespace bcm;
+
+static GroupUserMessageIdInfo makePushInfo(const std::string& uid)
+{
+    GroupUserMessageIdInfo info;
+    info.gcmId = "gcm_" + uid;
+    info.apnId = "apn_" + uid;
+    info.apnType = "voip";
+    info.osType = 1;
+    info.osVersion = "13.1";
+    info.targetAddress = uid + "/1";
+    return info;
+}
+
+TEST_CASE("PushInfoCacheHit")
+{
+    PushInfoCache cache(100, 60000);
+
+    GroupUserMessageIdInfo info;
+    REQUIRE_FALSE(cache.get("uid1", info));
+
+    cache.put("uid1", makePushInfo("uid1"));
+    REQUIRE(cache.size() == 1);
+
+    info.last_mid = 42;
+    REQUIRE(cache.get("uid1", info));
+    REQUIRE(info.gcmId == "gcm_uid1");
+    REQUIRE(info.apnId == "apn_uid1");
+    REQUIRE(info.targetAddress == "uid1/1");
+    REQUIRE(info.cfgFlag == GroupUserConfigPushType::NORMAL);
+    // the message id is not part of the push info
+    REQUIRE(info.last_mid == 42);
+
+    GroupUserMessageIdInfo noConfig;
+    noConfig.cfgFlag = GroupUserConfigPushType::NO_CONFIG;
+    cache.put("uid1", noConfig);
+    REQUIRE(cache.get("uid1", info));
+    REQUIRE(info.cfgFlag == GroupUserConfigPushType::NO_CONFIG);
+    REQUIRE(info.gcmId.empty());
+
+    cache.invalidate("uid1");
+    REQUIRE_FALSE(cache.get("uid1", info));
+    REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("PushInfoCacheExpireAndCapacity")
+{
+    PushInfoCache expiring(100, 20);
+    expiring.put("uid1", makePushInfo("uid1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    GroupUserMessageIdInfo info;
+    REQUIRE_FALSE(expiring.get("uid1", info));
+
+    PushInfoCache bounded(160, 60000);
+    for (int i = 0; i < 1000; ++i) {
+        bounded.put("uid" + std::to_string(i), makePushInfo(std::to_string(i)));
+    }
+    REQUIRE(bounded.size() <= 160);
+
+    PushInfoCache disabled(0, 60000);
+    disabled.put("uid1", makePushInfo("uid1"));
+    REQUIRE_FALSE(disabled.get("uid1", info));
+    REQUIRE(disabled.size() == 0);
+}
+
+TEST_CASE("PushInfoCacheLookup", "[.][benchmark]")
+{
+    // one large group push served from cache, compare with ~250 serial dao batches of 20
+    const int kMembers = 5000;
+    PushInfoCache cache(200000, 600000);
+    std::vector<std::string> uids;
+    for (int i = 0; i < kMembers; ++i) {
+        uids.emplace_back("uid_" + std::to_string(i));
+        cache.put(uids.back(), makePushInfo(uids.back()));
+    }
+
+    const int kRounds = 100;
+    int64_t start = nowInMicro();
+    size_t hits = 0;
+    for (int r = 0; r < kRounds; ++r) {
+        for (const auto& uid : uids) {
+            GroupUserMessageIdInfo info;
+            hits += cache.get(uid, info) ? 1 : 0;
+        }
+    }
+    int64_t spent = nowInMicro() - start;
+    REQUIRE(hits == static_cast<size_t>(kMembers * kRounds));
+    TLOG << kMembers << " members from cache: " << spent / kRounds << " us per group";
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../test_common.h"
+#include "config/redis_config.h"
+#include "redis/async_conn.h"
+#include "utils/time.h"
+
+#include <hiredis/hiredis.h>
+#include <boost/core/ignore_unused.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+
+// a redis-server started and stopped by a test, on a port of its own so the tests
+// owning a server do not disturb each other or the shared one on 6379.
+// needs redis-server and redis-cli in PATH
+class LocalRedis {
+public:
+    explicit LocalRedis(int port) : m_port(port) {}
+
+    int port() const
+    {
+        return m_port;
+    }
+
+    bcm::RedisConfig config() const
+    {
+        return bcm::RedisConfig{"127.0.0.1", m_port, "", ""};
+    }
+
+    // an empty server, one left over by an aborted run is shut down first
+    void start()
+    {
+        stop();
+        std::string cmd = "redis-server --port " + std::to_string(m_port) + " --save '' --daemonize yes";
+        REQUIRE(std::system(cmd.c_str()) == 0);
+        REQUIRE(waitFor([this]() { return ping(); }, 2000));
+    }
+
+    void stop()
+    {
+        cli("shutdown nosave");
+    }
+
+    void cli(const std::string& args) const
+    {
+        std::string cmd = "redis-cli -p " + std::to_string(m_port) + " " + args + " > /dev/null 2>&1";
+        std::system(cmd.c_str());
+    }
+
+    static bool waitFor(const std::function<bool()>& cond, int64_t timeoutInMilli)
+    {
+        int64_t deadline = bcm::nowInMilli() + timeoutInMilli;
+        while (!cond()) {
+            if (bcm::nowInMilli() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+private:
+    bool ping() const
+    {
+        redisContext* ctx = redisConnect("127.0.0.1", m_port);
+        if (ctx == nullptr) {
+            return false;
+        }
+        bool ok = false;
+        if (ctx->err == 0) {
+            auto reply = static_cast<redisReply*>(redisCommand(ctx, "PING"));
+            ok = (reply != nullptr && reply->type == REDIS_REPLY_STATUS);
+            freeReplyObject(reply);
+        }
+        redisFree(ctx);
+        return ok;
+    }
+
+    int m_port;
+};
+
+// counts what arrives on the channels it is subscribed to
+class CountingHandler : public bcm::redis::AsyncConn::ISubscriptionHandler {
+public:
+    void onSubscribe(const std::string& chan) override
+    {
+        boost::ignore_unused(chan);
+        ++subscribed;
+    }
+    void onUnsubscribe(const std::string& chan) override
+    {
+        boost::ignore_unused(chan);
+    }
+    void onMessage(const std::string& chan, const std::string& msg) override
+    {
+        boost::ignore_unused(chan, msg);
+        ++messages;
+    }
+    void onError(int code) override
+    {
+        TLOG << "subscribe error: " << code;
+    }
+
+    std::atomic<int> subscribed{0};
+    std::atomic<int> messages{0};
+};
@@ -0,0 +1,52 @@
+#include "local_redis.h"
+#include <event2/thread.h>
+#include "redis/online_redis_manager.h"
+
+using namespace bcm;
+
+// the server is killed and restarted under the subscriptions
+static LocalRedis gs_redis(6380);
+static const int kChannels = 20000;
+
+TEST_CASE("online_redis_resubscribe")
+{
+    evthread_use_pthreads();
+    gs_redis.start();
+
+    std::map<std::string, std::vector<RedisConfig>> pRedis;
+    pRedis["p0"] = {gs_redis.config()};
+
+    CountingHandler h;
+    OnlineRedisManager::Instance()->init(pRedis);
+    OnlineRedisManager::Instance()->start();
+    // subscribed as soon as the connection is up
+    OnlineRedisManager::Instance()->subscribe("group_ready", &h);
+    REQUIRE(LocalRedis::waitFor([&h]() { return h.subscribed > 0; }, 2000));
+    OnlineRedisManager::Instance()->unsubscribe("group_ready");
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    h.subscribed = 0;
+
+    std::vector<std::string> chans;
+    for (int i = 0; i < kChannels; ++i) {
+        chans.push_back("group_" + std::to_string(i));
+    }
+    REQUIRE(OnlineRedisManager::Instance()->subscribeBatch(chans, &h));
+    REQUIRE(LocalRedis::waitFor([&h]() { return h.subscribed == kChannels; }, 2000));
+
+    // every channel comes back after the server restarts
+    h.subscribed = 0;
+    gs_redis.stop();
+    gs_redis.start();
+    int64_t start = nowInMilli();
+    REQUIRE(LocalRedis::waitFor([&h]() { return h.subscribed == kChannels; }, 3000));
+    TLOG << "resubscribed " << kChannels << " channels in " << (nowInMilli() - start) << "ms";
+
+    for (int i = 0; i < kChannels; i += kChannels / 10) {
+        OnlineRedisManager::Instance()->publish(chans[i], "hello");
+    }
+    REQUIRE(LocalRedis::waitFor([&h]() { return h.messages == 10; }, 1000));
+
+    REQUIRE(OnlineRedisManager::Instance()->unsubscribeBatch(chans));
+    REQUIRE_FALSE(OnlineRedisManager::Instance()->isSubscribed(chans[0]));
+    gs_redis.stop();
+}
@@ -29,6 +29,15 @@ void init(std::unordered_map<std::string, std::unordered_map<std::string, RedisC
     redisDb["p1"] = m1;
 }
 
+// the manager keeps its partitions, they are set once per process
+static void configure(const std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig> >& redisDb) {
+    static bool configured = false;
+    if (!configured) {
+        RedisDbManager::Instance()->setRedisDbConfig(redisDb);
+        configured = true;
+    }
+}
+
 TEST_CASE("redis_mgr") {
     std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig> > redisDb;
     init(redisDb);
@@ -40,7 +49,7 @@ TEST_CASE("redis_mgr") {
     REQUIRE(6378 == redisDb["p1"]["0"].port);
     REQUIRE(6379 == redisDb["p1"]["1"].port);
 
-    RedisDbManager::Instance()->setRedisDbConfig(redisDb);
+    configure(redisDb);
 
     // hset
     std::string setValue = "{'from_uid':'000000000002','last_mid': 55}";
@@ -103,3 +112,67 @@ TEST_CASE("redis_mgr") {
     REQUIRE(1 == new_value);
     
 }
+
+TEST_CASE("redis_mgr_pipeline") {
+    std::unordered_map<std::string, std::unordered_map<std::string, RedisConfig> > redisDb;
+    init(redisDb);
+    configure(redisDb);
+
+    // gids and hash keys spread over both partitions
+    std::vector<RedisDbCmd> cmds;
+    for (uint64_t gid = 20000; gid < 20010; ++gid) {
+        cmds.push_back(RedisDbCmd::gidCmd(gid, {"HSET", "pipeline_test_" + std::to_string(gid), "f", "v"}));
+        cmds.push_back(RedisDbCmd::gidCmd(gid, {"HGET", "pipeline_test_" + std::to_string(gid), "f"}));
+    }
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"SET", "uid:pipeline", "a"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"INCR", "uid:pipeline"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"GET", "uid:pipeline"}));
+
+    std::vector<RedisCmdResult> results;
+    REQUIRE(RedisDbManager::Instance()->pipeline(cmds, results));
+    REQUIRE(results.size() == cmds.size());
+    for (size_t i = 0; i < 20; i += 2) {
+        REQUIRE(results[i].ok);
+        REQUIRE(results[i + 1].ok);
+        REQUIRE(results[i + 1].str == "v");
+    }
+    // an error reply only fails its own command
+    REQUIRE_FALSE(results[21].ok);
+    REQUIRE(results[22].ok);
+    REQUIRE(results[22].str == "a");
+
+    // a transaction per partition
+    cmds.clear();
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"DEL", "uid:pipeline"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"INCR", "uid:pipeline"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"EXPIRE", "uid:pipeline", "10"}));
+    REQUIRE(RedisDbManager::Instance()->pipeline(cmds, results, true));
+    REQUIRE(results[1].type == REDIS_REPLY_INTEGER);
+    REQUIRE(results[1].integer == 1);
+    REQUIRE(results[2].integer == 1);
+    REQUIRE(RedisDbManager::Instance()->ttl("uid:pipeline", "uid:pipeline") > 8);
+
+    // a command rejected while queuing aborts the transaction of its partition
+    cmds.clear();
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"INCR", "uid:pipeline"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"INCR"}));
+    REQUIRE(RedisDbManager::Instance()->pipeline(cmds, results, true));
+    REQUIRE_FALSE(results[0].ok);
+    REQUIRE_FALSE(results[1].ok);
+    std::string value;
+    REQUIRE(RedisDbManager::Instance()->get("uid:pipeline", "uid:pipeline", value));
+    REQUIRE(value == "1");
+
+    // a malformed batch is rejected before anything is sent
+    cmds.clear();
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {"INCR", "uid:pipeline"}));
+    cmds.push_back(RedisDbCmd::keyCmd("uid:pipeline", {}));
+    REQUIRE_FALSE(RedisDbManager::Instance()->pipeline(cmds, results));
+    REQUIRE(RedisDbManager::Instance()->get("uid:pipeline", "uid:pipeline", value));
+    REQUIRE(value == "1");
+
+    RedisDbManager::Instance()->del("uid:pipeline", "uid:pipeline");
+    for (uint64_t gid = 20000; gid < 20010; ++gid) {
+        RedisDbManager::Instance()->hdel(gid, "pipeline_test_" + std::to_string(gid), {"f"});
+    }
+}
@@ -0,0 +1,240 @@
+#include "local_redis.h"
+#include "redis/hiredis_client.h"
+#include "redis/redis_manager.h"
+#include "utils/time.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using namespace bcm;
+
+static LocalRedis gs_redis(6381);
+// the second redis of the partition in RedisPoolExhaustedNoFailover
+static LocalRedis gs_backupRedis(6384);
+
+static std::shared_ptr<RedisServer> makeServer(const RedisPoolConfig& config)
+{
+    auto server = std::make_shared<RedisServer>("127.0.0.1", gs_redis.port(), "", "");
+    server->setPoolConfig(config);
+    return server;
+}
+
+static std::shared_ptr<RedisServer> makeServer(int32_t maxConns, int64_t maxWaitInMilli)
+{
+    RedisPoolConfig config;
+    config.maxConns = maxConns;
+    config.maxWaitInMilli = maxWaitInMilli;
+    return makeServer(config);
+}
+
+static void waitForWaiters(std::shared_ptr<RedisServer> server, uint32_t waiters)
+{
+    int64_t deadline = nowInMilli() + 1000;
+    while (server->poolStats().waiters < waiters) {
+        REQUIRE(nowInMilli() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST_CASE("RedisPoolBounded")
+{
+    gs_redis.start();
+
+    auto server = makeServer(4, 2000);
+    // nobody is answered for 300ms
+    gs_redis.cli("client pause 300");
+
+    std::atomic<int> succeeded(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 20; ++i) {
+        threads.emplace_back([server, &succeeded]() {
+            std::shared_ptr<RedisConn> conn = server->getRedisConn();
+            if (conn == nullptr) {
+                return;
+            }
+            if (conn->set("pool_key", "value")) {
+                ++succeeded;
+            }
+            server->freeRedisConn(conn);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    RedisServer::PoolStats stats = server->poolStats();
+    TLOG << "created " << stats.created << ", waits " << stats.waits
+         << ", wait " << stats.waitMicros / 1000 << "ms";
+    REQUIRE(succeeded == 20);
+    REQUIRE(stats.created <= 4);
+    REQUIRE(stats.peakInUse <= 4);
+    REQUIRE(stats.waits > 0);
+    REQUIRE(stats.waitTimeouts == 0);
+    REQUIRE(stats.inUse == 0);
+    REQUIRE(stats.idle == stats.total);
+
+    gs_redis.stop();
+}
+
+TEST_CASE("RedisPoolWaitTimeout")
+{
+    gs_redis.start();
+
+    auto server = makeServer(1, 50);
+    std::shared_ptr<RedisConn> held = server->getRedisConn();
+    REQUIRE(held != nullptr);
+
+    int64_t start = nowInMilli();
+    REQUIRE(server->getRedisConn() == nullptr);
+    REQUIRE(nowInMilli() - start >= 50);
+    REQUIRE(server->poolStats().waitTimeouts == 1);
+    REQUIRE(server->poolStats().waiters == 0);
+
+    server->freeRedisConn(held);
+    held = server->getRedisConn();
+    REQUIRE(held != nullptr);
+    server->freeRedisConn(held);
+
+    gs_redis.stop();
+}
+
+TEST_CASE("RedisPoolExhaustedNoFailover")
+{
+    gs_redis.start();
+    gs_backupRedis.start();
+
+    // the servers of the partition get the default pool config
+    RedisPoolConfig config;
+    config.maxConns = 1;
+    config.maxWaitInMilli = 50;
+    RedisServer::setDefaultPoolConfig(config);
+    REQUIRE(RedisDbManager::Instance()->setRedisDbConfig({{"p0", {{"0", gs_redis.config()},
+                                                                  {"1", gs_backupRedis.config()}}}}));
+    RedisServer::setDefaultPoolConfig(RedisPoolConfig());
+
+    // a slow call holds the only connection of the first redis
+    gs_redis.cli("client pause 300");
+    std::atomic<bool> slow(false);
+    std::thread t([&slow]() {
+        slow = RedisDbManager::Instance()->set("pool_slow", "value");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // the busy pool fails the call, the partition stays on the first redis
+    REQUIRE_FALSE(RedisDbManager::Instance()->set("pool_busy", "value"));
+    t.join();
+    REQUIRE(slow);
+    REQUIRE(RedisDbManager::Instance()->set("pool_after", "value"));
+
+    RedisServer first("127.0.0.1", gs_redis.port(), "", "");
+    RedisServer backup("127.0.0.1", gs_backupRedis.port(), "", "");
+    std::shared_ptr<RedisConn> firstConn = first.getRedisConn();
+    std::shared_ptr<RedisConn> backupConn = backup.getRedisConn();
+    REQUIRE(firstConn != nullptr);
+    REQUIRE(backupConn != nullptr);
+    auto valueOf = [](std::shared_ptr<RedisConn> conn, const std::string& key) {
+        std::string value;
+        REQUIRE(conn->get(key, value));
+        return value;
+    };
+    REQUIRE(valueOf(firstConn, "pool_slow") == "value");
+    REQUIRE(valueOf(firstConn, "pool_after") == "value");
+    REQUIRE(valueOf(firstConn, "pool_busy").empty());
+    REQUIRE(valueOf(backupConn, "pool_after").empty());
+    REQUIRE(valueOf(backupConn, "pool_busy").empty());
+    first.freeRedisConn(firstConn);
+    backup.freeRedisConn(backupConn);
+
+    gs_backupRedis.stop();
+    gs_redis.stop();
+}
+
+TEST_CASE("RedisPoolFifo")
+{
+    gs_redis.start();
+
+    auto server = makeServer(1, 2000);
+    std::shared_ptr<RedisConn> held = server->getRedisConn();
+    REQUIRE(held != nullptr);
+
+    std::mutex mtx;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 5; ++i) {
+        threads.emplace_back([server, i, &mtx, &order]() {
+            std::shared_ptr<RedisConn> conn = server->getRedisConn();
+            {
+                std::lock_guard<std::mutex> l(mtx);
+                order.push_back(conn != nullptr ? i : -1);
+            }
+            server->freeRedisConn(conn);
+        });
+        waitForWaiters(server, i + 1);
+    }
+    server->freeRedisConn(held);
+    for (auto& t : threads) {
+        t.join();
+    }
+    REQUIRE(order == std::vector<int>({0, 1, 2, 3, 4}));
+    REQUIRE(server->poolStats().created == 1);
+
+    gs_redis.stop();
+}
+
+TEST_CASE("RedisPoolIdleClose")
+{
+    gs_redis.start();
+
+    RedisPoolConfig config;
+    config.maxIdleInMilli = 50;
+    auto server = makeServer(config);
+
+    std::vector<std::shared_ptr<RedisConn>> conns;
+    for (int i = 0; i < 3; ++i) {
+        conns.push_back(server->getRedisConn());
+        REQUIRE(conns.back() != nullptr);
+    }
+    for (auto& conn : conns) {
+        server->freeRedisConn(conn);
+    }
+    conns.clear();
+    server->maintainPool();
+    REQUIRE(server->poolStats().idle == 3);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    server->maintainPool();
+    RedisServer::PoolStats stats = server->poolStats();
+    REQUIRE(stats.idle == 0);
+    REQUIRE(stats.total == 0);
+    REQUIRE(stats.closed == 3);
+
+    gs_redis.stop();
+}
+
+TEST_CASE("RedisPoolValidateOnBorrow")
+{
+    gs_redis.start();
+
+    RedisPoolConfig config;
+    config.maxConns = 1;
+    config.validateAfterInMilli = 0;
+    auto server = makeServer(config);
+
+    std::shared_ptr<RedisConn> conn = server->getRedisConn();
+    REQUIRE(conn != nullptr);
+    server->freeRedisConn(conn);
+
+    // the pooled connection is closed by the server
+    gs_redis.cli("client kill type normal");
+    conn = server->getRedisConn();
+    REQUIRE(conn != nullptr);
+    std::string value;
+    REQUIRE(conn->set("pool_key", "validated"));
+    REQUIRE(conn->get("pool_key", value));
+    REQUIRE(value == "validated");
+    server->freeRedisConn(conn);
+    REQUIRE(server->poolStats().created == 1);
+
+    gs_redis.stop();
+}
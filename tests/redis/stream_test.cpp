@@ -0,0 +1,264 @@
+#include "../test_common.h"
+
+#include "redis/hiredis_client.h"
+#include "../../src/config/group_store_format.h"
+#include "../../src/utils/time.h"
+
+#include <hiredis/hiredis.h>
+#include <thread>
+
+using namespace bcm;
+
+static const std::string kStreamKey = "test_group_msg_stream";
+static const std::string kStreamGroup = "test_offline_push";
+
+static void resetStream(RedisConn& conn)
+{
+    redisContext* ctx = redisConnect("127.0.0.1", 6379);
+    REQUIRE(ctx != nullptr);
+    REQUIRE(ctx->err == 0);
+    freeReplyObject(redisCommand(ctx, "DEL %s", kStreamKey.c_str()));
+    redisFree(ctx);
+    REQUIRE(conn.xgroupCreate(kStreamKey, kStreamGroup));
+}
+
+static int64_t redisCpuMicros()
+{
+    redisContext* ctx = redisConnect("127.0.0.1", 6379);
+    redisReply* reply = static_cast<redisReply*>(redisCommand(ctx, "INFO cpu"));
+    std::string info(reply->str, reply->len);
+    freeReplyObject(reply);
+    redisFree(ctx);
+
+    double sys = 0, user = 0;
+    auto pos = info.find("used_cpu_sys:");
+    if (pos != std::string::npos) {
+        sys = std::stod(info.substr(pos + 13));
+    }
+    pos = info.find("used_cpu_user:");
+    if (pos != std::string::npos) {
+        user = std::stod(info.substr(pos + 14));
+    }
+    return static_cast<int64_t>((sys + user) * 1000000);
+}
+
+TEST_CASE("GroupMsgField")
+{
+    std::string field = formatGroupMsgField(1234567, 89, 2);
+    REQUIRE(field.size() == kGroupMsgFieldSize);
+    REQUIRE(field == "00000000000001234567_00000000000000000089_02");
+
+    uint64_t gid = 0;
+    uint64_t mid = 0;
+    int32_t type = 0;
+    REQUIRE(parseGroupMsgField(field, gid, mid, type));
+    REQUIRE(gid == 1234567);
+    REQUIRE(mid == 89);
+    REQUIRE(type == 2);
+
+    REQUIRE_FALSE(parseGroupMsgField("1234567_89_2", gid, mid, type));
+    REQUIRE_FALSE(parseGroupMsgField("00000000000001234567-00000000000000000089_02", gid, mid, type));
+    REQUIRE_FALSE(parseGroupMsgField("0000000000000123456a_00000000000000000089_02", gid, mid, type));
+}
+
+TEST_CASE("StreamConsumerGroup")
+{
+    RedisConn conn("127.0.0.1", 6379, "");
+    resetStream(conn);
+    // creating an existing group is not an error
+    REQUIRE(conn.xgroupCreate(kStreamKey, kStreamGroup));
+
+    std::vector<std::string> ids;
+    for (int i = 0; i < 3; ++i) {
+        std::string id;
+        std::vector<HField> values;
+        values.emplace_back(REDISDB_GROUP_MSG_STREAM_FIELD_MSG, formatGroupMsgField(1, i, 1));
+        REQUIRE(conn.xadd(kStreamKey, values, 100, id));
+        REQUIRE_FALSE(id.empty());
+        ids.emplace_back(id);
+    }
+
+    std::vector<RedisStreamEntry> entries;
+    REQUIRE(conn.xreadgroup(kStreamKey, kStreamGroup, "c1", ">", 2, 0, entries));
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].id == ids[0]);
+    REQUIRE(entries[1].fields[REDISDB_GROUP_MSG_STREAM_FIELD_MSG] == formatGroupMsgField(1, 1, 1));
+
+    // delivered but not acked entries are handed out again from "0"
+    entries.clear();
+    REQUIRE(conn.xreadgroup(kStreamKey, kStreamGroup, "c1", "0", 10, 0, entries));
+    REQUIRE(entries.size() == 2);
+
+    REQUIRE(conn.xack(kStreamKey, kStreamGroup, {ids[0], ids[1]}));
+    entries.clear();
+    REQUIRE(conn.xreadgroup(kStreamKey, kStreamGroup, "c1", "0", 10, 0, entries));
+    REQUIRE(entries.empty());
+
+    entries.clear();
+    REQUIRE(conn.xreadgroup(kStreamKey, kStreamGroup, "c1", ">", 10, 100, entries));
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].id == ids[2]);
+
+    // nothing new: the blocking read times out with an empty result
+    entries.clear();
+    REQUIRE(conn.xreadgroup(kStreamKey, kStreamGroup, "c1", ">", 10, 100, entries));
+    REQUIRE(entries.empty());
+}
+
+TEST_CASE("StreamNotifyLatency", "[.][benchmark]")
+{
+    const int kMessages = 200;
+    const int kPollMillis = 1000;
+
+    RedisConn producer("127.0.0.1", 6379, "");
+    RedisConn consumer("127.0.0.1", 6379, "");
+    resetStream(producer);
+
+    std::vector<int64_t> sentAt(kMessages, 0);
+    int64_t cpuStart = redisCpuMicros();
+    std::thread writer([&]() {
+        for (int i = 0; i < kMessages; ++i) {
+            std::string id;
+            std::vector<HField> values;
+            values.emplace_back(REDISDB_GROUP_MSG_STREAM_FIELD_MSG, formatGroupMsgField(1, i, 1));
+            sentAt[i] = nowInMicro();
+            producer.xadd(kStreamKey, values, 0, id);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    int received = 0;
+    int64_t totalLag = 0;
+    while (received < kMessages) {
+        std::vector<RedisStreamEntry> entries;
+        REQUIRE(consumer.xreadgroup(kStreamKey, kStreamGroup, "bench", ">", 100, 1000, entries));
+        int64_t now = nowInMicro();
+        std::vector<std::string> ids;
+        for (auto& e : entries) {
+            uint64_t gid = 0;
+            uint64_t mid = 0;
+            int32_t type = 0;
+            REQUIRE(parseGroupMsgField(e.fields[REDISDB_GROUP_MSG_STREAM_FIELD_MSG], gid, mid, type));
+            totalLag += now - sentAt[mid];
+            ids.emplace_back(e.id);
+        }
+        consumer.xack(kStreamKey, kStreamGroup, ids);
+        received += static_cast<int>(entries.size());
+    }
+    writer.join();
+    int64_t cpuUsed = redisCpuMicros() - cpuStart;
+
+    TLOG << "stream: avg notify latency " << totalLag / kMessages << " us, redis cpu " << cpuUsed
+         << " us for " << kMessages << " messages";
+
+    // the same messages through the zset the offline server timer polls every kPollMillis
+    const std::string zkey = "test_group_msg_list_poll";
+    {
+        redisContext* ctx = redisConnect("127.0.0.1", 6379);
+        REQUIRE(ctx != nullptr);
+        freeReplyObject(redisCommand(ctx, "DEL %s", zkey.c_str()));
+        redisFree(ctx);
+    }
+
+    cpuStart = redisCpuMicros();
+    std::thread zsetWriter([&]() {
+        for (int i = 0; i < kMessages; ++i) {
+            sentAt[i] = nowInMicro();
+            producer.zadd(zkey, formatGroupMsgField(1, i, 1), nowInSec());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+
+    received = 0;
+    totalLag = 0;
+    while (received < kMessages) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kPollMillis));
+        // drains like dbGetAndDeleteOneRedisGroupMsg, a page at a time
+        for (;;) {
+            std::vector<ZSetMemberScore> mems;
+            REQUIRE(consumer.getMemsByScoreWithLimit(zkey, 0, nowInSec(), 0, 100, mems));
+            int64_t now = nowInMicro();
+            std::vector<std::string> fields;
+            for (auto& m : mems) {
+                uint64_t gid = 0;
+                uint64_t mid = 0;
+                int32_t type = 0;
+                REQUIRE(parseGroupMsgField(m.member, gid, mid, type));
+                totalLag += now - sentAt[mid];
+                fields.emplace_back(m.member);
+            }
+            if (!fields.empty()) {
+                consumer.zrem(zkey, fields);
+            }
+            received += static_cast<int>(mems.size());
+            if (mems.size() < 100) {
+                break;
+            }
+        }
+    }
+    zsetWriter.join();
+    cpuUsed = redisCpuMicros() - cpuStart;
+
+    TLOG << "zset polling every " << kPollMillis << " ms: avg notify latency " << totalLag / kMessages
+         << " us, redis cpu " << cpuUsed << " us for " << kMessages << " messages";
+}
+
+TEST_CASE("GroupMsgShardKey")
+{
+    REQUIRE(groupMsgShard(1234567, 1) == 0);
+    REQUIRE(groupMsgShard(1234567, 0) == 0);
+    REQUIRE(groupMsgShard(1234567, 8) == 1234567 % 8);
+    REQUIRE(groupMsgShardKey(REDISDB_KEY_GROUP_MSG_INFO, 0) == "group_msg_list");
+    REQUIRE(groupMsgShardKey(REDISDB_KEY_GROUP_MSG_INFO, 3) == "group_msg_list_3");
+}
+
+TEST_CASE("HsetZadd")
+{
+    const std::string hkey = "test_group_multi_msg_list";
+    const std::string zkey = "test_group_msg_list";
+    RedisConn conn("127.0.0.1", 6379, "");
+    std::string field = formatGroupMsgField(1, 2, 2);
+    REQUIRE(conn.hsetZadd(hkey, "multi", zkey, field, 100));
+
+    std::string value;
+    REQUIRE(conn.hget(hkey, field, value));
+    REQUIRE(value == "multi");
+    std::vector<ZSetMemberScore> mems;
+    REQUIRE(conn.getMemsByScoreWithLimit(zkey, 100, 100, 0, 10, mems));
+    REQUIRE(mems.size() == 1);
+    REQUIRE(mems[0].member == field);
+
+    // the connection stays usable after both replies are read
+    REQUIRE(conn.zrem(zkey, {field}));
+    REQUIRE(conn.hdel(hkey, {field}));
+}
+
+// send path of a designated push message: hset + zadd on one key against the pipelined write
+TEST_CASE("HsetZaddLatency", "[.][benchmark]")
+{
+    const int kMessages = 10000;
+    const std::string hkey = "test_group_multi_msg_list";
+    const std::string zkey = "test_group_msg_list";
+    RedisConn conn("127.0.0.1", 6379, "");
+
+    int64_t start = nowInMicro();
+    for (int i = 0; i < kMessages; ++i) {
+        std::string field = formatGroupMsgField(1, i, 2);
+        conn.redisCmdArgs3("HSET", hkey.c_str(), hkey.size(), field.c_str(), field.size(), "m", 1);
+        conn.zadd(zkey, field, i);
+    }
+    int64_t separate = nowInMicro() - start;
+
+    start = nowInMicro();
+    for (int i = 0; i < kMessages; ++i) {
+        conn.hsetZadd(hkey, "m", zkey, formatGroupMsgField(1, i, 2), i);
+    }
+    int64_t pipelined = nowInMicro() - start;
+
+    redisContext* ctx = redisConnect("127.0.0.1", 6379);
+    freeReplyObject(redisCommand(ctx, "DEL %s %s", hkey.c_str(), zkey.c_str()));
+    redisFree(ctx);
+
+    TLOG << "hset + zadd: avg " << separate / kMessages << " us, pipelined: avg "
+         << pipelined / kMessages << " us per message";
+}
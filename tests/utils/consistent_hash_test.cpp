@@ -0,0 +1,205 @@
+#include "../test_common.h"
+
+#include <map>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+
+#include "utils/consistent_hash.h"
+#include "utils/time.h"
+
+using namespace bcm;
+
+static const std::vector<std::string> kServers = {
+    "10.0.0.1:8080", "10.0.0.2:8080", "10.0.0.3:8080", "10.0.0.4:8080"
+};
+static const uint64_t kKeys = 100000;
+
+// the ring before it became lock free: a std::map of virtual nodes behind a
+// shared_timed_mutex, looked up by server name. kept as the benchmark baseline
+class MapConsistentHash {
+public:
+    void AddServer(const std::string& server)
+    {
+        char hashbuf[50] = {0};
+        snprintf(hashbuf, sizeof(hashbuf), "%s", server.c_str());
+        std::unique_lock<std::shared_timed_mutex> l(m_mutex);
+        for (uint32_t i = 0; i < DEFAULTNUMBEROFREPLICAS; i++) {
+            size_t len = std::min(server.length(), sizeof(hashbuf) - sizeof(i));
+            memcpy(hashbuf + len, &i, sizeof(i));
+            m_circle[FnvHashFunction::hash(hashbuf, sizeof(hashbuf))] = server;
+        }
+    }
+
+    std::string GetServer(uint64_t gid)
+    {
+        std::shared_lock<std::shared_timed_mutex> l(m_mutex);
+        if (m_circle.empty()) {
+            return "";
+        }
+        auto it = m_circle.lower_bound(FnvHashFunction::hash(gid));
+        return it == m_circle.end() ? m_circle.begin()->second : it->second;
+    }
+
+private:
+    std::shared_timed_mutex m_mutex;
+    std::map<uint32_t, std::string> m_circle;
+};
+
+TEST_CASE("ConsistentHashDistribution")
+{
+    UserConsistentFnvHash ring;
+    for (const auto& server : kServers) {
+        ring.AddServer(server);
+    }
+
+    std::map<std::string, int> counts;
+    for (uint64_t gid = 0; gid < kKeys; ++gid) {
+        int32_t node = ring.GetNode(gid);
+        REQUIRE(node >= 0);
+        REQUIRE(ring.GetServerName(node) == ring.GetServer(gid));
+        ++counts[ring.GetServerName(node)];
+    }
+    // the std::map ring placed the same keys on the same servers
+    REQUIRE(counts["10.0.0.1:8080"] == 21793);
+    REQUIRE(counts["10.0.0.2:8080"] == 26808);
+    REQUIRE(counts["10.0.0.3:8080"] == 25599);
+    REQUIRE(counts["10.0.0.4:8080"] == 25800);
+    REQUIRE(ring.GetServer(std::string("uid_1")) == "10.0.0.3:8080");
+}
+
+TEST_CASE("ConsistentHashRemapping")
+{
+    UserConsistentFnvHash ring;
+    for (const auto& server : kServers) {
+        ring.AddServer(server);
+    }
+    std::vector<int32_t> before;
+    for (uint64_t gid = 0; gid < kKeys; ++gid) {
+        before.push_back(ring.GetNode(gid));
+    }
+
+    // keys only move to the new server
+    ring.AddServer("10.0.0.5:8080");
+    int32_t added = ring.FindNode("10.0.0.5:8080");
+    REQUIRE(added == 4);
+    int moved = 0;
+    for (uint64_t gid = 0; gid < kKeys; ++gid) {
+        int32_t node = ring.GetNode(gid);
+        if (node != before[gid]) {
+            REQUIRE(node == added);
+            ++moved;
+        }
+    }
+    REQUIRE(moved == 20103);
+
+    // and back, node indexes stay
+    ring.RemoveServer("10.0.0.5:8080");
+    for (uint64_t gid = 0; gid < kKeys; ++gid) {
+        REQUIRE(ring.GetNode(gid) == before[gid]);
+    }
+    REQUIRE(ring.FindNode("10.0.0.5:8080") == added);
+    REQUIRE(ring.GetServerName(added) == "10.0.0.5:8080");
+
+    // only the keys of a removed server move
+    int32_t removed = ring.FindNode("10.0.0.2:8080");
+    ring.RemoveServer("10.0.0.2:8080");
+    for (uint64_t gid = 0; gid < kKeys; ++gid) {
+        int32_t node = ring.GetNode(gid);
+        REQUIRE(node != removed);
+        if (before[gid] != removed) {
+            REQUIRE(node == before[gid]);
+        }
+    }
+
+    ring.SetServers(kServers);
+    for (uint64_t gid = 0; gid < kKeys; gid += 7) {
+        REQUIRE(ring.GetNode(gid) == before[gid]);
+    }
+
+    ring.Clear();
+    REQUIRE(ring.GetNode(static_cast<uint64_t>(1)) < 0);
+    REQUIRE(ring.GetServer(static_cast<uint64_t>(1)).empty());
+    REQUIRE(ring.GetServerName(-1).empty());
+}
+
+TEST_CASE("ConsistentHashConcurrentUpdate")
+{
+    UserConsistentFnvHash ring;
+    ring.SetServers(kServers);
+
+    // lookups never see an empty or partial ring while it is replaced
+    std::atomic<bool> stop(false);
+    std::atomic<int> misses(0);
+    std::thread reader([&]() {
+        uint64_t gid = 0;
+        while (!stop) {
+            int32_t node = ring.GetNode(gid++);
+            if (node < 0 || ring.GetServerName(node).empty()) {
+                ++misses;
+            }
+        }
+    });
+    for (int i = 0; i < 200; ++i) {
+        std::vector<std::string> servers = kServers;
+        servers.push_back("10.0.1." + std::to_string(i % 10) + ":8080");
+        ring.SetServers(servers);
+    }
+    stop = true;
+    reader.join();
+    REQUIRE(misses == 0);
+}
+
+// lookups per second of 'lookups' keys on each of 'threads' threads
+template <class TLookup>
+static int64_t lookupRate(int threads, uint64_t lookups, TLookup lookup)
+{
+    std::atomic<int64_t> sum(0);
+    int64_t start = nowInMicro();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&lookup, &sum, t, lookups]() {
+            int64_t local = 0;
+            for (uint64_t gid = t * lookups; gid < (t + 1) * lookups; ++gid) {
+                local += lookup(gid);
+            }
+            sum += local;
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    int64_t spent = nowInMicro() - start;
+    REQUIRE(sum > 0);
+    return static_cast<int64_t>(lookups) * threads * 1000000 / spent;
+}
+
+TEST_CASE("ConsistentHashLookupThroughput", "[.][benchmark]")
+{
+    UserConsistentFnvHash ring;
+    MapConsistentHash baseline;
+    std::vector<std::string> servers;
+    for (int i = 0; i < 32; ++i) {
+        servers.push_back("10.0.0." + std::to_string(i) + ":8080");
+        baseline.AddServer(servers.back());
+    }
+    ring.SetServers(servers);
+    for (uint64_t gid = 0; gid < 1000; ++gid) {
+        REQUIRE(baseline.GetServer(gid) == ring.GetServer(gid));
+    }
+
+    const uint64_t kLookups = 10000000;
+    for (int threads : {1, 4}) {
+        int64_t getNode = lookupRate(threads, kLookups, [&ring](uint64_t gid) {
+            return ring.GetNode(gid);
+        });
+        int64_t getServer = lookupRate(threads, kLookups, [&ring](uint64_t gid) {
+            return ring.GetServer(gid).size();
+        });
+        int64_t old = lookupRate(threads, kLookups, [&baseline](uint64_t gid) {
+            return baseline.GetServer(gid).size();
+        });
+        TLOG << threads << " threads, 32 servers: " << getNode << " GetNode/s, "
+             << getServer << " GetServer/s, old std::map ring " << old << " GetServer/s";
+    }
+}
@@ -0,0 +1,210 @@
+#include "../test_common.h"
+
+#include <utils/log.h>
+#include <utils/time.h>
+#include <fiber/fiber_pool.h>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <thread>
+
+using namespace bcm;
+
+static const std::string kLogDir = "/tmp/bcm_log_test";
+
+static void initTestLog()
+{
+    static bool inited = false;
+    if (!inited) {
+        boost::filesystem::remove_all(kLogDir);
+        boost::filesystem::create_directories(kLogDir);
+        LogConfig conf;
+        conf.directory = kLogDir;
+        conf.level = LOGSEVERITY_INFO;
+        conf.asyncBufferSize = 1024;
+        Log::init(conf, "log-test");
+        inited = true;
+    }
+}
+
+static size_t countLines(const std::string& marker)
+{
+    size_t count = 0;
+    for (auto& entry : boost::filesystem::directory_iterator(kLogDir)) {
+        std::ifstream in(entry.path().string());
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.find(marker) != std::string::npos) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+static int touch(int& counter)
+{
+    return ++counter;
+}
+
+TEST_CASE("LogLevelFilter")
+{
+    Log::setLevel(LOGSEVERITY_INFO);
+
+    int evaluated = 0;
+    LOGT << "trace " << touch(evaluated);
+    LOGD << "debug " << touch(evaluated);
+    REQUIRE(evaluated == 0);
+
+    LOGI << "info " << touch(evaluated);
+    REQUIRE(evaluated == 1);
+
+    // must expand to a single expression
+    if (evaluated == 1)
+        LOGD << "then";
+    else
+        LOGD << "else";
+
+    REQUIRE_FALSE(Log::enabled(LOGSEVERITY_DEBUG));
+    REQUIRE(Log::enabled(LOGSEVERITY_WARN));
+}
+
+TEST_CASE("AsyncLogBackend")
+{
+    initTestLog();
+
+    const int kThreads = 4;
+    const int kRecords = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < kRecords; ++i) {
+                LOGI << "async_marker " << t << " " << i;
+                LOGD << "filtered_marker " << i;
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // nested record while the outer one is still streaming
+    auto nested = []() {
+        LOGI << "nested_marker inner";
+        return "outer";
+    };
+    LOGI << "nested_marker " << nested();
+
+    Log::flush();
+
+    REQUIRE(countLines("async_marker") == static_cast<size_t>(kThreads * kRecords));
+    REQUIRE(countLines("filtered_marker") == 0);
+    REQUIRE(countLines("nested_marker") == 2);
+    REQUIRE(Log::droppedRecords() == 0);
+}
+
+TEST_CASE("AsyncLogBackendBlockingFiber")
+{
+    initTestLog();
+
+    // one fiber floods the 1024 record buffer, the other fiber of the thread keeps running
+    const int kRecords = 100000;
+    bool flooded = false;
+    int progress = 0;
+    boost::fibers::fiber flooder([&flooded]() {
+        for (int i = 0; i < kRecords; ++i) {
+            LOGI << "blocking_marker " << i;
+        }
+        flooded = true;
+    });
+    boost::fibers::fiber other([&flooded, &progress]() {
+        while (!flooded) {
+            ++progress;
+            boost::this_fiber::yield();
+        }
+    });
+    flooder.join();
+    other.join();
+    Log::flush();
+
+    TLOG << "other fiber ran " << progress << " times while the buffer was full";
+    REQUIRE(progress > 0);
+    REQUIRE(countLines("blocking_marker") == static_cast<size_t>(kRecords));
+    REQUIRE(Log::droppedRecords() == 0);
+}
+
+TEST_CASE("AsyncLogBackendWorkStealing")
+{
+    initTestLog();
+
+    // migratable fibers flood the buffers, one blocked on a full buffer may resume on another
+    // thread and must push to the buffer of that thread
+    const int kFibers = 16;
+    const int kRecords = 10000;
+    FiberPool pool(4, true);
+    pool.run("log.test");
+    std::atomic<int> done{0};
+    std::atomic<int> moved{0};
+    // pinned fibers stalling their threads now and then, so the others steal the loggers
+    for (int b = 0; b < 2; ++b) {
+        FiberPool::post(pool.getIOContext(), [&done, kFibers]() {
+            while (done < kFibers) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                boost::this_fiber::yield();
+            }
+        });
+    }
+    for (int f = 0; f < kFibers; ++f) {
+        FiberPool::postMigratable(pool.getIOContext(), [&done, &moved, f, kRecords]() {
+            auto ioc = FiberPool::getThreadIOContext();
+            for (int i = 0; i < kRecords; ++i) {
+                LOGI << "stealing_marker " << f << " " << i;
+                // pthread_self may be folded out of the loop, the pool knows the thread for real
+                if (FiberPool::getThreadIOContext() != ioc) {
+                    ioc = FiberPool::getThreadIOContext();
+                    ++moved;
+                }
+            }
+            ++done;
+        });
+    }
+    int64_t deadline = nowInMilli() + 4000;
+    while (done < kFibers && nowInMilli() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pool.stop();
+    Log::flush();
+
+    TLOG << "fibers moved " << moved << " times while logging";
+    REQUIRE(done == kFibers);
+    REQUIRE(moved > 0);
+    REQUIRE(countLines("stealing_marker ") == static_cast<size_t>(kFibers * kRecords));
+    REQUIRE(Log::droppedRecords() == 0);
+}
+
+TEST_CASE("LogCallCost", "[.][benchmark]")
+{
+    initTestLog();
+
+    // bursts fit in the per thread buffer, so this is the cost seen by the caller;
+    // draining happens between bursts and is reported separately
+    const int kBurst = 512;
+    const int kRounds = 200;
+    const char* names[] = {"trace", "debug", "info", "warn", "error"};
+    for (int level = LOGSEVERITY_TRACE; level <= LOGSEVERITY_ERROR; ++level) {
+        auto severity = static_cast<LogSeverity>(level);
+        int64_t callNanos = 0;
+        int64_t drainNanos = 0;
+        for (int r = 0; r < kRounds; ++r) {
+            int64_t start = nowInNano();
+            for (int i = 0; i < kBurst; ++i) {
+                LOG2(severity) << "bench uid " << i << " gid " << 1234567890 << " spent " << 3.5;
+            }
+            int64_t flushStart = nowInNano();
+            Log::flush();
+            callNanos += flushStart - start;
+            drainNanos += nowInNano() - flushStart;
+        }
+        TLOG << names[level] << " (threshold info): " << callNanos / (kBurst * kRounds) << " ns/call, "
+             << drainNanos / (kBurst * kRounds) << " ns/record in writer";
+    }
+}